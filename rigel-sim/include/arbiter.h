@@ -40,11 +40,23 @@ namespace rigel {
 //
 // Each Cycle, grant access to each resource to one of the requestors
 //
+// Requests and grants are kept as one bit per accessor in a machine word
+// (req_mask, grant_mask), with per-accessor counts only for accessors that
+// hold more than one.  Round-robin rotates the request word to the current
+// priority and takes set bits with count-trailing-zeros; the matrix policy
+// keeps, per accessor, the word of accessors that currently beat it.
+// Clearing touches only the accessors whose bits are set.
+//
 // Parameter: Cycles until resolution
 //
 ////////////////////////////////////////////////////////////////////////////////
 class Arbiter
 {
+  public:
+
+    typedef uint64_t mask_t;
+    static const int MAX_ACCESSORS = 64; // bits in a mask_t
+
   private:
 
     int res_max;  // indicate how many of each resource is available
@@ -54,12 +66,38 @@ class Arbiter
                   // array ofcounters for resources reset to res_quantities each cycle
     int requests; // how many requests outstanding (unserviced)
 
+    mask_t all;        // one bit per accessor
+    mask_t req_mask;   // accessors with a request outstanding
+    mask_t grant_mask; // accessors holding an unclaimed grant
+
+    int *status;    // grants per accessor (valid where grant_mask is set)
+    int *reqs;      // requests per accessor (valid where req_mask is set)
+    mask_t *beaten_by; // ARB_MATRIX: accessors with priority over each accessor
+
+    static mask_t bit(int i) { return (mask_t)1 << i; }
+
+    // rotate the low 'accessors' bits of m right by k, so accessor k is bit 0
+    mask_t rotate(mask_t m, int k) const {
+      if (k == 0) { return m; }
+      return ((m >> k) | (m << (accessors - k))) & all;
+    }
+
+    // give one resource to accessor p
+    void grant(int p, mask_t &pending) {
+      assert((pending & bit(p)) && reqs[p] > 0 && "Error, grant made when no request!");
+      if (--reqs[p] == 0) { pending &= ~bit(p); }
+      requests--;   // serviced a request (track total usage)
+      // grant resource to accessor 'p'
+      status[p] = (grant_mask & bit(p)) ? status[p] + 1 : 1;
+      grant_mask |= bit(p);
+      resources--;  // took a resource  (track total usage)
+      #ifdef DEBUG_ARB
+      cerr << "  : Arb to accessor " << p << "\n";
+      #endif
+    }
+
   public:
 
-    int *status;    // indicates end resource availability externally
-                    // one entry per accessor/input to arbitrator
-    int *reqs;      // same size as status
-                    // one entry per accessor/input to arbitrator
     ARB_POLICY arb_policy;
     int backpressure; // indicates how many of the resources are stalled ahead
 
@@ -78,19 +116,26 @@ class Arbiter
   ~Arbiter() {
     delete[] reqs;
     delete[] status;
+    delete[] beaten_by;
   }
 
   // constructor
   Arbiter( int num_acc, int num_res, ARB_POLICY arb_p ) {
+    assert(num_acc > 0 && num_acc <= MAX_ACCESSORS && "Arbiter supports at most 64 accessors");
     res_max = num_res;
     accessors = num_acc;
     resources = res_max;
     requests = 0;
+    all = (num_acc == MAX_ACCESSORS) ? ~(mask_t)0 : bit(num_acc) - 1;
+    req_mask = 0;
+    grant_mask = 0;
     reqs = new int[num_acc];
     status = new int[num_acc];
+    beaten_by = new mask_t[num_acc];
     for(int i=0;i<num_acc;i++) {
       reqs[i] = 0;
       status[i] = 0;
+      beaten_by[i] = bit(i) - 1; // lower accessor ids start with priority
     }
     arb_policy = arb_p;
     next_p = 0; // next priority for round-robin
@@ -104,7 +149,12 @@ class Arbiter
 
   // request a resource for a particular accessor
   void MakeRequest(int acc_id ) {
-    reqs[acc_id]++;
+    if (req_mask & bit(acc_id)) {
+      reqs[acc_id]++;
+    } else {
+      reqs[acc_id] = 1;
+      req_mask |= bit(acc_id);
+    }
     requests++; // log a new request
     #ifdef DEBUG_ARB
     DEBUG_HEADER();
@@ -119,76 +169,58 @@ class Arbiter
 
   // arbitrate resources amound current requests based on set policy
   void Arbitrate() {
-    //printf("%d Resources\n", resources);
     #ifdef DEBUG_ARB
     cerr << "  Arbiter::Arbitrate()" << "\n";
     #endif
     //NOTE For pseudo-MT, modifying arbitration so resources are not freed until
     //ClaimResource() is called.
-    //int tempres = resources - backpressure;
-    //OLD COMMENT:
     // assumes we can grant each resource each time we arbitrate
     // will need modification to support non-unity length ownership
     resources = res_max - backpressure;
 
-    // at most, we need allocate each resource once, so iterate once per
-    // available resource
-    int p, grants=0;
+    mask_t pending = req_mask;
     switch (arb_policy) {
       case ARB_ROUND_ROBIN: {
-        for(int i=0;i<res_max;i++) {
-          // as long as we still have resources to allocate and requests to service...
-          if(resources<=0 || requests<=0){
-            break; // done
-          }
-          else {
-            // get_next_priority accessor until we find someone who wants a resource
-            p = next_p;
-            do{
-              if(reqs[p]>0) { // if next priority accessor made a request
-		#ifdef DEBUG_ARB
-                cerr << "Granting to " <<  p << std::"\n";
-		#endif
-                reqs[p]--;    // grant request
-                requests--;   // serviced a request (track total usage)
-                status[p]++;  // grant resource to accessor 'p'
-                resources--;   // took a resource  (track total usage)
-                            // bp_applied_HACK += requests;
-                assert(reqs[p]>=0 && "Error, grant made when no request!");
-                grants++;
-                #ifdef DEBUG_ARB
-                cerr << "  : Arb to accessor " << p << "\n";
-                #endif
-              }
-              p = get_next_priority(p);
-            } while( resources>0 && requests>0 );
-          }
+        // Grant in priority order starting at next_p, one per requester per
+        // pass, until the resources or the requests run out.
+        while (resources > 0 && pending) {
+          mask_t rot = rotate(pending, next_p);
+          do {
+            int p = __builtin_ctzll(rot) + next_p;
+            if (p >= accessors) { p -= accessors; }
+            rot &= rot - 1;
+            grant(p, pending);
+          } while (rot && resources > 0);
         }
         break;
       }
       case ARB_RANDOM: {
-        for (int i = 0; i < res_max; i++) {
-          if(resources<=0 || requests<=0){
-            break; // done
+        while (resources > 0 && pending) {
+          int p;
+          while (!(pending & bit(p = get_random_priority())));
+          grant(p, pending);
+        }
+        break;
+      }
+      case ARB_MATRIX: {
+        // Least-recently-granted: the winner is the requester no other
+        // requester beats; it then drops below everyone else.
+        while (resources > 0 && pending) {
+          mask_t cand = pending;
+          int p = __builtin_ctzll(cand);
+          while (beaten_by[p] & pending) {
+            cand &= cand - 1;
+            assert(cand && "Arbiter priority matrix has no winner");
+            p = __builtin_ctzll(cand);
           }
-          while( reqs[p = get_random_priority()] <= 0 );
-          assert(reqs[p] > 0 && "Error, grant made when no request!");
-          reqs[p]--;
-          requests--;
-          status[p]++;
-          resources--;
-
-          grants++;
+          grant(p, pending);
+          for (int j = 0; j < accessors; j++) { beaten_by[j] &= ~bit(p); }
+          beaten_by[p] = all & ~bit(p);
         }
         break;
       }
-  }
-
-
-    #ifdef DEBUG_ARB
-    if(grants>0)
-      cerr << "  : granted " << grants << " resources" << "\n";
-    #endif
+    }
+    req_mask = pending;
 
     assert(resources >=0 && requests >=0 && "Error in Resource Grants!");
 
@@ -196,9 +228,8 @@ class Arbiter
     // the policy may keep state from this cycle, or may not
     // current simple policy: clear all requests and restart next cycle
     // requests = 0; done in ClearArbRequests called by PerCycle
-    //resources = tempres + backpressure;
     backpressure = 0;
-    next_p = (next_p+1)%accessors; // next priority for round robin policy
+    next_p = get_next_priority(next_p); // next priority for round robin policy
     #ifdef DEBUG_ARB
     cerr << "  : next_p priority " << next_p << "\n";
     #endif
@@ -207,7 +238,8 @@ class Arbiter
 
   // Return Arbitration Status for this ID and resource request
   int GetArbStatus( int acc_id  ){
-    return status[acc_id]; // return grant count for requested resource
+    // grant count for requested resource
+    return (grant_mask & bit(acc_id)) ? status[acc_id] : 0;
   };
 
   // clear out last cycle's arb status
@@ -216,9 +248,7 @@ class Arbiter
     DEBUG_HEADER();
     cerr << "Clearing All ARB status (gnts)\n";
     #endif
-    for(int i=0;i<accessors;i++){
-      status[i]=0;
-    }
+    grant_mask = 0; // status[] is only read where grant_mask is set
   };
 
   // clear out last cycle's arb requests
@@ -227,19 +257,15 @@ class Arbiter
     DEBUG_HEADER();
     cerr << "Clearing All ARB reqs\n";
     #endif
-    for(int i=0;i<accessors;i++){   // clear all requests
-      reqs[i]=0;
-    }
+    req_mask = 0; // reqs[] is only read where req_mask is set
     requests = 0;
   };
 
   // Decrement status grant counter to "claim" an awarded resource and
   // prevent it from being used more than once
   void ClaimResource( int acc_id ){
-    assert(status[acc_id] > 0 && "Attempting to Claim Unavailable Resource");
-    //printf("%d releasing\n", acc_id);
-    status[acc_id]--;
-    //resources++;
+    assert((grant_mask & bit(acc_id)) && status[acc_id] > 0 && "Attempting to Claim Unavailable Resource");
+    if (--status[acc_id] == 0) { grant_mask &= ~bit(acc_id); }
   };
 
   void PrintStatus() {
@@ -249,7 +275,8 @@ class Arbiter
 			std::cerr << "Requests:  " << requests  << "\n";
 			std::cerr << "Accessors: " << accessors << "\n";
       for(int i=0;i<accessors;i++){
-				std::cerr << " acc: " << i << " reqs: " << reqs[i] << " status: " << status[i] << "\n";
+				std::cerr << " acc: " << i << " reqs: " << ((req_mask & bit(i)) ? reqs[i] : 0)
+				          << " status: " << GetArbStatus(i) << "\n";
       }
     }
   }
@@ -492,6 +519,8 @@ class BusArbiter {
 ////////////////////////////////////////////////////////////////////////////////
 // Arbitration wrapper for crossbar-based cluster interconnect
 // Assumes combined read/write ports
+// Each bank's ports are arbitrated with the given policy (ARB_L2_TYPE 2
+// in user.config asks for ARB_MATRIX, least-recently-granted).
 class XBarArbiter : public ArbContainer {
 
   public:
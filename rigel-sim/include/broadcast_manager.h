@@ -39,25 +39,27 @@
 
 #include <cstdio>
 #include <stdint.h>
-#include <vector>
 #include <cassert>
 #include "sim.h"
 #include "util/construction_payload.h"
+#include "util/addr_hash_map.h"
+#include "util/fixed_bitset.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // helper struct: BroadcastOp
 ////////////////////////////////////////////////////////////////////////////////
 struct BroadcastOp {
   public: 
+    // Empty op, only used as the AddrHashMap fill value.
+    BroadcastOp();
     // Constructor
     BroadcastOp(uint32_t address, uint32_t newval, int whichCluster);
 
     // Print contents of the bcast operations that have been seen.
     void dump() {
-      fprintf(stderr, "BCAST OP DUMP: addr: 0x%08x cluster: %d\n", addr, cluster);
-      for ( int i = 0; i < rigel::NUM_CLUSTERS; i++) {
-        fprintf(stderr, "seen[%d]: %d\n", i, seen[i]);
-      }
+      fprintf(stderr, "BCAST OP DUMP: addr: 0x%08x cluster: %d acked: %d (", addr, cluster, numSeen);
+      seen.print(stderr);
+      fprintf(stderr, ")\n");
     }
 
     // Check for completion of a broadcast operation.  After the check returns
@@ -73,7 +75,11 @@ struct BroadcastOp {
     }
 
     uint32_t addr;
-    unsigned char seen[rigel::MAX_CLUSTERS];
+    // Clusters that have ACKed the broadcast; numSeen is its population count.
+    ClusterBitset seen;
+    // Clusters that read the new value: seen, plus the issuing cluster, which
+    // sees the update immediately.
+    ClusterBitset updated;
     uint32_t newVal;
     int numSeen;
     int cluster;
@@ -83,55 +89,53 @@ struct BroadcastOp {
 ////////////////////////////////////////////////////////////////////////////////
 // CLASS: BroadcastManager
 ////////////////////////////////////////////////////////////////////////////////
+//
+// Outstanding broadcasts are indexed by cache line address.  At most one
+// broadcast per line may be outstanding (see insertBroadcast()), so every
+// lookup is a single hash probe.
 class BroadcastManager {
 
   public:
-    std::vector<BroadcastOp> ops;
     rigel::GlobalBackingStoreType &backing_store;
-    BroadcastManager(rigel::ConstructionPayload cp) : backing_store(*(cp.backing_store)) {}
+    BroadcastManager(rigel::ConstructionPayload cp) :
+      backing_store(*(cp.backing_store)),
+      ops(BroadcastOp())
+    { }
 
     uint32_t getData(uint32_t address, int whichCluster);
     void ack(uint32_t addr, int whichCluster);
     void insertBroadcast(uint32_t address, uint32_t newData, int whichCluster);
 
+    // checks for an outstanding broadcast to exactly this word
     bool isBroadcastOutstanding(uint32_t address) {
-      std::vector<BroadcastOp>::iterator it;
-      return isBroadcastOutstanding(address, it);
-    }
-
-    bool isBroadcastOutstanding(uint32_t address, std::vector<BroadcastOp>::iterator &it) {
-      for(it = ops.begin(); it != ops.end(); it++) {
-        if(it->addr == address) return true;
-      }
-      return false;
+      return findOp(address) != NULL;
     }
 
-    // checks for outstanding broadcast to addr
+    // checks for outstanding broadcast to addr's line
     bool isBroadcastOutstandingToLine(uint32_t address) {
-      std::vector<BroadcastOp>::iterator it;
-      return isBroadcastOutstandingToLine(address, it);
-    }
-
-    // checks for outstanding broadcast to addr, leaves iterator 'it' pointing to the op if found
-    bool isBroadcastOutstandingToLine(uint32_t address, std::vector<BroadcastOp>::iterator &it)
-    {
-      for(it = ops.begin(); it != ops.end(); it++) {
-        if ((it->addr & rigel::cache::LINE_MASK) == (address & rigel::cache::LINE_MASK)) {
-          return true;
-        }
-      }
-      return false;
+      return ops.find(address & rigel::cache::LINE_MASK) != NULL;
     }
 					
     void dump() {
-      std::vector<BroadcastOp>::iterator it;
-      for(it = ops.begin(); it != ops.end(); it++) {
+      for (size_t i = 0; i < ops.capacity(); i++) {
+        if (!ops.slot_used(i)) { continue; }
+        const BroadcastOp &op = ops.slot_value(i);
         fprintf(stderr, "Broadcast Manager has a BCAST pending at "
           "0x%x from cluster %d (data %u)\n",
-        it->addr, it->cluster, it->newVal);
+        op.addr, op.cluster, op.newVal);
       }
     }
 
+  private:
+    // the op for exactly this word, or NULL
+    BroadcastOp *findOp(uint32_t address) {
+      BroadcastOp *op = ops.find(address & rigel::cache::LINE_MASK);
+      return (op != NULL && op->addr == address) ? op : NULL;
+    }
+
+    // outstanding broadcasts keyed by line address
+    AddrHashMap<BroadcastOp> ops;
+
 };
 
 
@@ -17,6 +17,7 @@ class TileBase;
 class GlobalCache;
 class BroadcastManager;
 class GlobalNetworkNew;
+class LockstepEngine;
 
 class ChipTiled : public ComponentBase, public rigelsim::Checkpointable {
 
@@ -68,6 +69,8 @@ class ChipTiled : public ComponentBase, public rigelsim::Checkpointable {
 
     rigelsim::ChipState             *_chip_state;
 
+    LockstepEngine                  *_lockstep; /// NULL unless --lockstep
+
 };
 
 #endif
@@ -34,7 +34,7 @@ class ClusterFunctional : public ClusterBase {
 
   private:
 
-    CoreFunctional** cores; /// array of cores
+    CoreBase** cores; /// array of cores (CoreFunctional or CoreTracePlayer)
 
     ClusterCacheFunctional *ccache; /// cluster cache object
 
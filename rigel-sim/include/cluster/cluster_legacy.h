@@ -50,10 +50,11 @@ class ClusterLegacy : public ClusterBase {
     void     Heartbeat();               /// print heartbeat status message
     void     EndSim();                  /// called at termination of simulation for wrapup
     void     ProfileCycles(int i);      /// 
-    void     ProfileStuckBehind(int i); /// 
     uint32_t GetCorePC(int c);          ///
     void     SleepCore(int i);          /// 
     void     WakeCore(int i);           /// 
+    void     SleepCoreOnTaskQueue(int i); /// sleep until the task queue changes
+    void     CoreHalted() { num_halted_cores++; } /// a core has halted all of its threads
 
     // simple accessor implementations
     rigel::GlobalBackingStoreType * getBackingStore() { return backing_store; }
@@ -106,6 +107,7 @@ class ClusterLegacy : public ClusterBase {
   // private methods
   //////////////////////////////////////////////////////////////////////////////
   private:
+    bool TaskQueueWakeReady(int i);
 
   //////////////////////////////////////////////////////////////////////////////
   // private data
@@ -114,6 +116,13 @@ class ClusterLegacy : public ClusterBase {
     CoreInOrderLegacy ** cores;
     int id_num; // Cluster ID number assigned as constructor "id" input
 	std::bitset<rigel::CORES_PER_CLUSTER> core_sleeping;
+    // Subset of core_sleeping that is blocked on an empty task queue rather
+    // than an MSHR, and the cycle each one went to sleep.
+    std::bitset<rigel::CORES_PER_CLUSTER> core_tq_sleeping;
+    uint64_t tq_sleep_cycle[rigel::CORES_PER_CLUSTER];
+    // Cores with every thread halted.  Maintained by CoreHalted() so that
+    // halted() does not walk the cores every cycle.
+    int num_halted_cores;
     //Used for pseudo-MT to track which cores should be clocked next cycle.
     unsigned int *which_cores_to_clock;
     //Use this to make sure we switch threads at least once every 200 cycles or so.
@@ -34,7 +34,7 @@ class ClusterStructural : public ClusterBase {
 
   private:
 
-    CoreFunctional** cores; /// array of cores
+    CoreBase** cores; /// array of cores (CoreFunctional or CoreTracePlayer)
 
     ClusterCacheStructural *ccache; /// cluster cache object
 
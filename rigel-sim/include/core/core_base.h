@@ -11,6 +11,9 @@
 #include "util/util.h"
 #include <bitset>
 
+class Packet;
+template<class T> class InPortBase;
+template<class T> class OutPortBase;
 namespace rigel {
   class ConstructionPayload;
 }
@@ -40,6 +43,14 @@ class CoreBase : public ComponentBase, public rigelsim::Checkpointable {
 
     virtual void save_state() const = 0;
     virtual void restore_state() = 0;
+
+    /// current pc of a thread (heartbeats, debugging)
+    virtual uint32_t pc(int tid) { return 0; }
+
+    /// ports to the cluster cache, for cores that talk to it through ports
+    virtual OutPortBase<Packet*>* getOutPort() { return NULL; }
+    virtual InPortBase<Packet*>*  getInPort()  { return NULL; }
+
     /// 
     virtual int halted()        { return halted_; }
     virtual int halted(int tid) { return !active_tids[tid]; }
@@ -64,6 +64,17 @@ class CoreFunctional : public CoreBase {
     /// accessors 
     uint32_t pc(int tid)     { return thread_state[tid]->pc_; } 
 
+    /// lockstep execution (see core/lockstep_engine.h)
+    /// thread that would start a new instruction this cycle, or -1 if none
+    int lockstep_thread();
+    /// read a general register of thread tid
+    const regval32_t lockstep_read(int tid, uint32_t reg) const {
+      return thread_state[tid]->rf[reg];
+    }
+    /// retire the instruction at tid's PC, executed by the engine, writing
+    /// value to register dest; the core then sits out this cycle
+    void lockstep_retire(int tid, uint32_t dest, rword32_t value);
+
     /// FIXME TODO REMOVE ME HACK: replace with general connection interface
     OutPortBase<Packet*>* getOutPort() { return to_ccache;   }
     InPortBase<Packet*>*  getInPort()  { return from_ccache; }
@@ -107,6 +118,8 @@ class CoreFunctional : public CoreBase {
 
     int current_tid; // local thread id
 
+    uint64_t lockstep_cycle; /// cycle the lockstep engine last retired for us
+
     //ClusterCacheFunctional* ccache;
 
     // TODO FIXME: this should be a core base class member...
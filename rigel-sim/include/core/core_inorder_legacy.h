@@ -225,6 +225,7 @@ class CoreInOrderLegacy : public CoreBase {
     InstrSlot regfile_read(InstrSlot instr, int pipe);
 
     int  PerCycle();           // step the core through one cycle of execution
+    void SamplePC();       // -per-pc-sample: charge a sample to the oldest instruction
     void UpdateLatches();  // update the latches at the end of a cycle
 
     ////////////////////////////////////////////////////
@@ -316,9 +317,13 @@ class CoreInOrderLegacy : public CoreBase {
       return true;
     }
 
-    void halt(int tid) {
-      PipeThreadState[tid]._halt = true;
-    }
+    void halt(int tid);
+
+    // Set by the memory stage when TQ_DEQUEUE blocks on an empty queue.
+    void set_blocked_on_task_queue() { blocked_on_task_queue = true; }
+    // Clears the flag and returns true if the core blocked on the task queue
+    // this cycle and has nothing in flight past the stalled dequeue.
+    bool CheckBlockedOnTaskQueue();
 
     bool is_fetch_stalled() const;
 
@@ -534,6 +539,9 @@ class CoreInOrderLegacy : public CoreBase {
     // BEGIN MultiThreading
     int fetch_thread_id; // current thread for MT in FETCH (always 0 for single threaded)
 
+    // TQ_DEQUEUE blocked this cycle (only tracked with --sleepy-cores)
+    bool blocked_on_task_queue;
+
   // end Private Data
   ////////////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,131 @@
+#ifndef __CORE_TRACE_PLAYER_H__
+#define __CORE_TRACE_PLAYER_H__
+
+#include "core_base.h"
+#include "sim.h"
+#include "port/port.h"
+#include "read_mem_trace_c.h"
+
+#include <string>
+#include <vector>
+
+// forward declarations
+class Packet;
+template<class T> class InPortBase;
+template<class T> class OutPortBase;
+namespace rigel {
+    class ConstructionPayload;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// TracePlayerSource
+///////////////////////////////////////////////////////////////////////////////
+///
+/// One gzipped memory trace (see read_mem_trace_c.h) shared by every
+/// CoreTracePlayer in the chip.  Software threads in the trace are handed out
+/// in trace order to whichever hardware thread runs out of work first, so any
+/// number of hardware threads can be fed from a single trace.
+class TracePlayerSource {
+
+  public:
+    /// exits if the trace cannot be opened
+    TracePlayerSource(const std::string &filename);
+    ~TracePlayerSource();
+
+    /// get the next access for hardware thread gtid, pulling the next unclaimed
+    /// software thread out of the trace when gtid's current one is used up.
+    /// returns false once the trace is exhausted
+    bool next(int gtid, extended_info &ei);
+
+    uint64_t sw_threads() const { return _sw_threads; }
+
+  private:
+    mem_trace_reader *mtr;
+    uint64_t _sw_threads; /// software threads handed out so far
+
+    // No copies.
+    TracePlayerSource(const TracePlayerSource &);
+    TracePlayerSource & operator=(const TracePlayerSource &);
+};
+
+namespace rigel {
+  // Non-NULL iff --trace-player was given.  Created before the chip is built
+  // and deleted at exit, see sim.cpp.
+  extern TracePlayerSource *TRACE_PLAYER;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// CoreTracePlayer
+///////////////////////////////////////////////////////////////////////////////
+///
+/// A core that executes no instructions.  Each hardware thread replays the
+/// loads and stores of a memory trace into the cluster cache through the same
+/// ports as CoreFunctional, waiting out the recorded number of non-memory
+/// instructions (one per cycle) between its accesses.  A thread has at most
+/// one access outstanding and the core issues at most one access per cycle.
+class CoreTracePlayer : public CoreBase {
+
+  public:
+    /// constructor
+    CoreTracePlayer(rigel::ConstructionPayload cp);
+
+    /// destructor
+    ~CoreTracePlayer();
+
+    /// retire a reply and issue one ready access
+    int PerCycle();
+
+    /// dump useful internal information about this object
+    void Dump();
+
+    /// heartbeat
+    void Heartbeat();
+
+    /// called at termination of simulation
+    void EndSim();
+
+    /// traces carry no architectural state to checkpoint
+    virtual void save_state() const { }
+    virtual void restore_state() { }
+
+    int halted()        { return (threads_done == numthreads); }
+    int halted(int tid) { return thread_state[tid].done; }
+
+    /// pc of the last access issued by this thread
+    uint32_t pc(int tid) { return thread_state[tid].pc; }
+
+    OutPortBase<Packet*>* getOutPort() { return to_ccache;   }
+    InPortBase<Packet*>*  getInPort()  { return from_ccache; }
+
+  private:
+
+    /// pull the next access for a thread from the trace, or finish the thread
+    void fetch_next(int tid);
+
+    int numthreads;   /// hardware threads on this core
+    int threads_done; /// threads whose trace is exhausted
+    int last_issued;  /// round-robin issue pointer
+
+    struct TracePlayerThreadState {
+      TracePlayerThreadState() :
+        ready_cycle(0), pc(0), pending(NULL), done(false)
+      { }
+
+      extended_info next;   /// access to issue once ready_cycle is reached
+      uint64_t ready_cycle; /// earliest issue cycle for next
+      uint32_t pc;          /// pc of the last issued access
+      Packet*  pending;     /// outstanding request, if any
+      bool     done;
+    };
+
+    std::vector<TracePlayerThreadState> thread_state;
+
+    uint64_t reads;
+    uint64_t writes;
+
+    OutPortBase<Packet*>* to_ccache;
+    InPortBase<Packet*>*  from_ccache;
+
+};
+
+#endif
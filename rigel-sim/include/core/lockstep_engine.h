@@ -0,0 +1,109 @@
+#ifndef __LOCKSTEP_ENGINE_H__
+#define __LOCKSTEP_ENGINE_H__
+
+#include "sim.h"
+#include "util/addr_hash_map.h"
+#include "sim/build_slot.h"
+
+#include <stdint.h>
+#include <vector>
+
+// forward declarations
+class CoreFunctional;
+class StaticDecodeInfo;
+
+///////////////////////////////////////////////////////////////////////////////
+/// LockstepEngine
+///////////////////////////////////////////////////////////////////////////////
+///
+/// Cross-core lockstep execution for the functional core model (--lockstep).
+///
+/// SPMD kernels leave many functional cores at the same PC running the same
+/// code on different data.  Once per cycle, before any core is clocked, the
+/// engine groups every CoreFunctional that is about to start a new
+/// instruction by PC.  When two or more threads share a PC and the
+/// instruction there only reads and writes general registers (the ALU,
+/// shift, compare and FPU ops, minus the SPRF moves), the instruction is
+/// decoded once (and cached per PC), the group's source operands are gathered
+/// into one array per operand, the operation runs as a single loop over the
+/// arrays that the host compiler vectorizes, and the results are scattered
+/// back to each thread's register file.  Those cores then skip their own
+/// PerCycle() for the cycle.
+///
+/// Everything else -- memory, branches, SPRF and sim-special instructions,
+/// and threads whose PC no other thread shares -- runs through
+/// CoreFunctional::PerCycle() as usual.  Groups are rebuilt every cycle, so a
+/// group splits as soon as its threads diverge and re-forms when they
+/// reconverge on the same PC.
+///
+/// Every core still retires at most one instruction per cycle and writes the
+/// same registers in the same cycle, so results, cycle counts and register
+/// traces (up to the order of writes within a cycle) match a run without
+/// --lockstep.  Architectural state stays in the per-thread register files;
+/// only the operands of the instruction being executed are laid out across
+/// threads.
+class LockstepEngine {
+
+  public:
+    LockstepEngine();
+
+    /// register a core; every CoreFunctional joins at construction
+    void add(CoreFunctional *core) { rigel::BuildSlot::push_back(cores, core); }
+
+    /// execute this cycle's groups; call before the cores are clocked
+    void PerCycle();
+
+    /// print how much of the run was executed in groups
+    void EndSim();
+
+  private:
+
+    /// an instruction as the engine executes it, decoded once per PC
+    struct Op {
+      Op() : raw(0), type(I_NULL), ok(false), imm(0), dest(0), sdi(NULL) {
+        src[0] = src[1] = src[2] = simconst::NULL_REG;
+      }
+      uint32_t raw;     /// instruction word this was decoded from
+      instr_t  type;
+      bool     ok;      /// the engine can execute it
+      uint32_t imm;     /// zimm16, simm16 or imm5, whichever the op uses
+      uint32_t src[3];  /// SREG_T, SREG_S and DREG inputs (NULL_REG if unused)
+      uint32_t dest;    /// destination register
+      const StaticDecodeInfo *sdi; /// decode table entry, for SD_BREAKPOINT
+    };
+
+    /// a thread ready to start an instruction this cycle
+    struct Lane {
+      CoreFunctional *core;
+      int tid;
+      int next; /// next lane in the same group, or -1
+    };
+
+    /// threads at one PC this cycle
+    struct Group {
+      uint32_t pc;
+      int head; /// first lane
+      int size;
+    };
+
+    const Op &decode(uint32_t pc);
+    void execute(const Op &op, const Group &g);
+
+    std::vector<CoreFunctional*> cores;
+
+    AddrHashMap<Op> ops;          /// PC -> decoded instruction
+
+    // rebuilt every cycle
+    std::vector<Lane>  lanes;
+    std::vector<Group> groups;
+    AddrHashMap<int>   group_of;  /// PC -> index into groups
+
+    // operands and results of the group being executed, one element per lane
+    std::vector<rword32_t> opnd[3];
+    std::vector<rword32_t> result;
+
+    uint64_t stat_groups;         /// groups executed
+    uint64_t stat_instrs;         /// instructions retired in groups
+};
+
+#endif
@@ -115,8 +115,8 @@ class RegisterFile {
     /// Dump, print RF contents
     void Dump(unsigned int cols = 8);
 
-    /// set trace file
-    void setTraceFile( const char* filename );
+    /// trace writes to rigel::REG_TRACE as global thread gtid
+    void setTraceThread( int gtid );
 
     virtual void save_to_protobuf(RepeatedWord *ru) const {
       for(unsigned int i = 0; i < numregs; i++)
@@ -136,7 +136,7 @@ class RegisterFile {
     unsigned int numregs;
     regval32_t* rf; /// the register file 
 
-    FILE* tracefile;
+    int trace_gtid; /// -1 if not tracing
 
   private:
    
@@ -36,6 +36,15 @@ typedef struct ScoreBoardEntry {
 // Class: ScoreBoard
 ////////////////////////////////////////////////////////////////////////////////
 // Base class, is this used in practice for anything?
+//
+// Besides the per-register entries, the scoreboard keeps one bit per register
+// in each of three masks so a check is an AND against the registers an
+// instruction reads or writes:
+//   use_mask    - use_count != 0
+//   busy_mask   - ready_cycle may still be in the future (a set bit is
+//                 rechecked against the entry and cleared once it has passed)
+//   locked_mask - locked
+// so at most 64 registers per scoreboard.
 ////////////////////////////////////////////////////////////////////////////////
 class ScoreBoard {
 
@@ -49,6 +58,18 @@ class ScoreBoard {
     uint32_t num_regs;
     bool _wait_for_clear;
 
+    typedef uint64_t mask_t;
+    static const uint32_t MAX_REGS = 64; // bits in a mask_t
+
+    mask_t use_mask;
+    mask_t busy_mask;
+    mask_t locked_mask;
+
+    mask_t reg_bit(uint32_t reg) const {
+      assert(reg < num_regs && "scoreboard register out of range");
+      return (mask_t)1 << reg;
+    }
+
   /////////////////////////////////////////////////////////////////////////////
   // public methods/accessors
   /////////////////////////////////////////////////////////////////////////////
@@ -73,11 +94,24 @@ class ScoreBoard {
     // alter later to account for feedback paths
     virtual bool check_reg(uint32_t reg0, bool skip_reg_zero = true) {
       if (reg0 == 0 && skip_reg_zero) return true;
-      return (scoreboard[reg0].use_count == 0);
+      return check_mask(reg_bit(reg0));
     }
 
     virtual bool check_reg(uint32_t reg0, uint32_t reg1) {
-      return ((scoreboard[reg0].use_count == 0) && (scoreboard[reg1].use_count == 0));
+      return check_mask(reg_bit(reg0) | reg_bit(reg1));
+    }
+
+    // Check every register whose bit is set in regs at once.  regfile_read
+    // passes all of an instruction's general-register sources (see
+    // LegacySBMasks) in one call.
+    virtual bool check_mask(mask_t regs) {
+      return (regs & use_mask) == 0;
+    }
+
+    // true if any register in regs other than r0 is locked; regfile_read's
+    // check of all of an instruction's destinations
+    bool any_locked(mask_t regs) const {
+      return (regs & locked_mask & ~(mask_t)1) != 0;
     }
 
     // Used to stall access to a register for an indeterminate amount of time.
@@ -93,6 +127,7 @@ class ScoreBoard {
     virtual void get_reg(uint32_t reg0, instr_t type, bool skip_reg_zero = true) {
       if (reg0 == 0 && skip_reg_zero) return;
       scoreboard[reg0].use_count++;
+      use_mask |= reg_bit(reg0);
     }
 
     // Done with register 
@@ -101,19 +136,19 @@ class ScoreBoard {
     // reg 0 for accumulator file
     virtual void put_reg(uint32_t reg0, instr_t type = I_NULL, bool skip_reg_zero = true) {
       if (reg0 == 0 && skip_reg_zero) return;
-      assert(scoreboard[reg0].use_count > 0);
-      scoreboard[reg0].use_count--;
+      release_use(reg0);
     }
     virtual void put_reg(RegisterBase reg, instr_t type = I_NULL, bool skip_reg_zero = true) {
       if (reg.addr == 0 && skip_reg_zero) return;
-      assert(scoreboard[reg.addr].use_count > 0);
-      scoreboard[reg.addr].use_count--;
+      release_use(reg.addr);
     }
     // Done with register completely 
     virtual void clear_reg(uint32_t reg0,bool skip_reg_zero = true) {
       if (reg0 == 0) return;
       scoreboard[reg0].use_count = 0;
       scoreboard[reg0].locked = false;
+      use_mask    &= ~reg_bit(reg0);
+      locked_mask &= ~reg_bit(reg0);
     }
 
     virtual void clear() {
@@ -140,6 +175,15 @@ class ScoreBoard {
       _wait_for_clear = true;
     }
 
+  protected:
+
+    // drop one use of reg, clearing its use_mask bit on the last one
+    void release_use(uint32_t reg) {
+      assert(scoreboard[reg].use_count > 0);
+      if (--scoreboard[reg].use_count == 0) {
+        use_mask &= ~reg_bit(reg);
+      }
+    }
 
 };
 
@@ -165,37 +209,17 @@ class ScoreBoardBypass : public ScoreBoard {
     
     virtual bool check_reg(uint32_t reg, bool skip_reg_zero = true) {
       //if (reg == 0 && skip_reg_zero) { printf("check_reg(%d) returning true\n", reg); return true; }
-      // waits for whole pipeline to flush before dispatching instructions again
-      if (rigel::core::FORCE_SB_FLUSH) {
-        //printf("Waiting for SB Flush\n");
-        if (this->_wait_for_clear) {
-          //printf("Waiting for Clear\n");
-          // If all are clear, we can clear flag, otherwise check fails
-          for (uint32_t i = 0; i < this->num_regs; i++) {
-            if (scoreboard[i].use_count != 0) {
-              //fprintf(stderr, "Reg %d has use count %d, failing\n", i, scoreboard[i].use_count);
-              return false;
-            }
-          }
-          // All regs are finally cleared, pipeline has drained
-          _wait_for_clear = false;
-          this->clear();
-        }
-      }
-
-      //cerr << "check_reg:  checking availability" << endl;
-      uint64_t avail = scoreboard[reg].ready_cycle;
-      bool locked = scoreboard[reg].locked;
-      //if(!(rigel::CURR_CYCLE >= avail && !locked))
-      // printf("CurrCycle %"PRIu64", Avail %"PRIu64", locked %01d\n", rigel::CURR_CYCLE, avail, locked);
-      //printf("check_reg(%d) returning %s\n", reg, ((rigel::CURR_CYCLE >= avail && !locked)) ? "true" : "false");
-      return (rigel::CURR_CYCLE >= avail && !locked);
+      return check_mask(reg_bit(reg));
     }
 
     virtual bool check_reg(uint32_t reg0, uint32_t reg1) {
-      return check_reg(reg0) && check_reg(reg1);
+      return check_mask(reg_bit(reg0) | reg_bit(reg1));
     }
 
+    // A register is available once CURR_CYCLE reaches its ready_cycle and it
+    // is not locked.  Implemented in scoreboard.cpp
+    virtual bool check_mask(mask_t regs);
+
     // Called when a memory value is returned in MEM or CC. It turns a locked
     // reg into a normal bypassed reg
     virtual void UpgradeMemAccess(uint32_t reg) {
@@ -205,6 +229,7 @@ class ScoreBoardBypass : public ScoreBoard {
         unlockReg(reg);
       }
       scoreboard[reg].ready_cycle = rigel::CURR_CYCLE;
+      busy_mask &= ~reg_bit(reg);
     }
 
     // Locking allows for register to be unavailable for variable amount of time
@@ -215,11 +240,12 @@ class ScoreBoardBypass : public ScoreBoard {
       assert(!scoreboard[reg].locked 
         && "Trying to lock a reg that is already locked");
       scoreboard[reg].locked = true;
+      locked_mask |= reg_bit(reg);
     }
 
     virtual bool isLocked(uint32_t reg,bool skip_reg_zero = true) {
       if (reg == 0 && skip_reg_zero) return false;
-      return scoreboard[reg].locked;
+      return (locked_mask & reg_bit(reg)) != 0;
     }
 
     virtual void unlockReg(uint32_t reg,bool skip_reg_zero = true) {
@@ -231,6 +257,7 @@ class ScoreBoardBypass : public ScoreBoard {
           && "Trying to unlock a reg that is not locked");
       }
       scoreboard[reg].locked = false;
+      locked_mask &= ~reg_bit(reg);
     }
 
     // Lock a register for writing.  Implemented in scoreboard.cpp
@@ -238,8 +265,7 @@ class ScoreBoardBypass : public ScoreBoard {
     
     virtual void put_reg(RegisterBase reg, instr_t type = I_NULL, bool skip_reg_zero = true) {
       if (reg.addr == 0 && skip_reg_zero) return;
-      assert(scoreboard[reg.addr].use_count > 0);
-      scoreboard[reg.addr].use_count--;
+      release_use(reg.addr);
       // Saturates at zero --> go to regfile.
       if (scoreboard[reg.addr].bypass_count > 0) scoreboard[reg.addr].bypass_count--;
     }
@@ -248,8 +274,7 @@ class ScoreBoardBypass : public ScoreBoard {
     // option of using register zero
     virtual void put_reg(uint32_t reg, instr_t type = I_NULL, bool skip_reg_zero = true) {
       if (reg == 0 && skip_reg_zero) return;
-      assert(scoreboard[reg].use_count > 0);
-      scoreboard[reg].use_count--;
+      release_use(reg);
       // Saturates at zero --> go to regfile.
       if (scoreboard[reg].bypass_count > 0) scoreboard[reg].bypass_count--;
     }
@@ -259,6 +284,8 @@ class ScoreBoardBypass : public ScoreBoard {
       scoreboard[reg].ready_cycle = 0;
       scoreboard[reg].bypass_count = 0;
       scoreboard[reg].locked = false;
+      busy_mask   &= ~reg_bit(reg);
+      locked_mask &= ~reg_bit(reg);
     }
 
     // Member functions for handling bypass logic.  EX needs to set these bits
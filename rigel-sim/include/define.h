@@ -73,7 +73,8 @@ typedef union {
 // Arbitration policies for arbiters.  (used in arbiter.[h|cpp])
 enum ARB_POLICY {
   ARB_ROUND_ROBIN = 1,
-  ARB_RANDOM
+  ARB_RANDOM,
+  ARB_MATRIX  // least-recently-granted
 };
 // For determining port resource ids for arbitration. (used in arbiter.[h|cpp])
 enum RES_TYPE {
@@ -11,14 +11,13 @@
 #include "sim.h"
 #include "interconnect.h"
 #include "memory/address_mapping.h"
-#include <set>
 #include <list>
 #include "util/debug.h"
 #include "util/dynamic_bitset.h"
+#include "util/fixed_bitset.h"
+#include "util/addr_hash_map.h"
 #include "profile/profile.h"
-#include <ext/hash_map>
 #include <queue>
-using namespace __gnu_cxx; //For hash_map
 
 
 class OverflowCacheDirectory;
@@ -100,7 +99,9 @@ namespace directory
     // Default constructor.  Note the max_sharers is initialized to -1 so we can
     // hook reset() to do stats gathering without muddying the waters with this
     // initial reset() calls or needing to pull out a third init-type function.
-    dir_entry_t() : sharer_vec(rigel::NUM_CLUSTERS), valid_bits(NULL), max_sharers(-1) { } 
+    dir_entry_t() : sharer_vec(rigel::NUM_CLUSTERS), nak_waitlist(rigel::NUM_CLUSTERS),
+                    fill_pending(rigel::NUM_CLUSTERS), bcast_valid_sharers(rigel::NUM_CLUSTERS),
+                    bcast_outstanding(false), valid_bits(NULL), max_sharers(-1) { } 
     //reset() must go in init
     // Overloaded assignment operator.
     dir_entry_t& operator=(const dir_entry_t &other);
@@ -168,21 +169,22 @@ namespace directory
       // We set a bit when access to an entry is granted that is not cleared
       // until the G$ can respond with the data.
       void clear_fill_pending(int cluster_num) { 
-        if (0 == fill_pending.erase(cluster_num)) { 
+        if (!fill_pending.test(cluster_num)) { 
           rigel::GLOBAL_debug_sim.dump_all();
           dump();
           assert(0 && "Trying to clear fill pending bit that was never set."); 
         }
+        fill_pending.clear(cluster_num);
       }
       void set_fill_pending(int cluster_num) { 
-        if (0 < fill_pending.count(cluster_num)) { 
+        if (fill_pending.test(cluster_num)) { 
           rigel::GLOBAL_debug_sim.dump_all();
           dump();
           assert(0 && "Trying to set fill pending bit that was set."); 
         }
-        fill_pending.insert(cluster_num) ; 
+        fill_pending.set(cluster_num); 
       }
-      bool check_fill_pending() const { return !fill_pending.empty(); }
+      bool check_fill_pending() const { return !fill_pending.allClear(); }
       bool check_bcast() const { return bcast_set; }
       // Lock the entry until the pending request gets data.
       void set_atomic_lock(int cluster) { lock_bit = true; }
@@ -199,8 +201,8 @@ namespace directory
       // Address of the line being tracked.  The LINESIZE_ORDER low-order bits
       // are always assumed to be zeroed.
       uint32_t addr;
-      // Array of sharers
-      DynamicBitset sharer_vec;
+      // Array of sharers.  Stored inline (no heap allocation per entry).
+      ClusterBitset sharer_vec;
       // Each entry can be of a configurable size to allow for region tracking.
       // The size is measured in bytes.
       size_t entry_size;
@@ -212,13 +214,16 @@ namespace directory
       int waiting_cluster;
       // Save the list of NAKs for matching NAKS/RELEASE messages on an
       // invalidate request from the directory
-      std::set<int> nak_waitlist;
-      std::set<int> fill_pending;
+      ClusterBitset nak_waitlist;
+      ClusterBitset fill_pending;
       // Track the sharers as part of the BCAST reply that hold the line.  Used
       // by the probe filter directory.
-      std::set<int> bcast_valid_sharers;
+      ClusterBitset bcast_valid_sharers;
       // Set when a broadcast must occur.
       bool bcast_set;
+      // Set while the entry holds one of the directory's outstanding
+      // coherence broadcasts (see CacheDirectory::add_outstanding_bcast()).
+      bool bcast_outstanding;
       // Denotes perm->access window is open.
       bool lock_bit;
       // Next state and sharer after the bcast finishes for probe filtering.
@@ -354,20 +359,17 @@ class CacheDirectory
     // The L2 Overflow directory.
     OverflowCacheDirectory *overflow_directory;
     // The set of invalidates that have been performed as a result of evictions
-    // (to track rerequests). Holds a uint64_t which is composed of {address, cluster number}.
+    // (to track rerequests).  Maps a line address to the clusters invalidated.
     // Only use add_eviction_invalidate() to add to this set, and remove_eviction_invalidate()
     // to remove from it.
-    hash_map<uint32_t, DynamicBitset *> eviction_invalidates;
+    AddrHashMap<ClusterBitset> eviction_invalidates;
     // The sequence numbers for cluster/gcache pairings.
     seq_num_t *seq_num;
     // Separate valid bits for all directory entries.
     // The densification should help out cache behavior quite a bit.
     DynamicBitset valid_bits;
-    // A set of pointers to directory entries with an outstanding
-    // coherence-related broadcast.
-    // For now, only used for statistics gathering.
-    std::set<directory::dir_entry_t *> pending_bcasts;
-    // The current count of outstanding broadcasts.
+    // The current count of outstanding coherence-related broadcasts.  Entries
+    // with a broadcast in flight are marked with dir_entry_t::bcast_outstanding.
     int outstanding_bcasts;
 
   private: /* PRIVATE METHODS */
@@ -404,18 +406,18 @@ class CacheDirectory
     // Sample the distribution of entries among different code segmenets
     void gather_statistics();
     // Get number of outstanding broadcasts
-    size_t get_num_outstanding_bcasts() { return pending_bcasts.size(); }
+    size_t get_num_outstanding_bcasts() const { return outstanding_bcasts; }
     // Add outstanding broadcast
     void add_outstanding_bcast(directory::dir_entry_t *entry) {
       assert (outstanding_bcasts >= 0);
-      assert(pending_bcasts.count(entry) == 0);
-      pending_bcasts.insert(entry);
+      assert(!entry->bcast_outstanding);
+      entry->bcast_outstanding = true;
       outstanding_bcasts++;
     }
     void remove_outstanding_bcast(directory::dir_entry_t *entry) {
       assert (outstanding_bcasts > 0);
-      assert(pending_bcasts.count(entry) == 1);
-      pending_bcasts.erase(entry);
+      assert(entry->bcast_outstanding);
+      entry->bcast_outstanding = false;
       outstanding_bcasts--;
     }
 };
@@ -467,9 +469,8 @@ namespace directory
       fprintf(stderr, "owner: %4d ", get_owner());
     }
     fprintf(stderr, "nak_waitlist: ");
-    for (std::set<int>::iterator iter = nak_waitlist.begin(); 
-          iter != nak_waitlist.end(); iter++) {
-      fprintf(stderr, "%3d ", *iter);
+    for (int i = nak_waitlist.findFirstSet(); i != -1; i = nak_waitlist.findNextSet(i)) {
+      fprintf(stderr, "%3d ", i);
     }
     fprintf(stderr, "\n");
   }
@@ -514,10 +515,10 @@ namespace directory
     // Set the waiting cluster to some invalid value.
     waiting_cluster = -1;
     // Clear the NAK set for next eviction/state change.
-    nak_waitlist.clear();
+    nak_waitlist.clearAll();
     // Every entry has its fill_pending bit set until the response is offered to
     // the cluster(s) requesting.
-    fill_pending.clear();
+    fill_pending.clearAll();
     // No broadcast by default.
     bcast_set = false;
     // Line is unlocked by default.
@@ -526,7 +527,7 @@ namespace directory
     pf_bcast_next_sharer = -1237;
     pf_bcast_next_state = DIR_STATE_INVALID;
     // The reseter is responsible for clearing the BCAST sharers.
-    bcast_valid_sharers.clear();
+    bcast_valid_sharers.clearAll();
     // Reset number of touches to 0
     num_touches = 0;
     // Reset max sharers to -1.  This way, if we do 2 reset()s before
@@ -592,34 +593,25 @@ CacheDirectory::get_set(uint32_t addr) const
 inline bool
 CacheDirectory::was_invalidated_early(uint32_t addr, unsigned int cluster)
 {
-  if(eviction_invalidates.find(addr) == eviction_invalidates.end()) { return false; }
-  else { return (eviction_invalidates[addr]->test(cluster)); }
+  const ClusterBitset *clusters = eviction_invalidates.find(addr);
+  return (clusters != NULL) && clusters->test(cluster);
 }
 
 inline void
 CacheDirectory::add_eviction_invalidate(uint32_t addr, unsigned int cluster)
 {
-  //If entry for addr does not exist, make a new one
-  if(eviction_invalidates.count(addr) == 0)
-  {
-    DynamicBitset *newEntry = new DynamicBitset(rigel::NUM_CLUSTERS);
-    newEntry->set(cluster);
-    eviction_invalidates[addr] = newEntry;
-  }
-  else //If it does exist, set the bit for this cluster
-  {
-    eviction_invalidates[addr]->set(cluster);
-  }
+  //Creates an empty entry for addr if it does not exist yet
+  eviction_invalidates.insert(addr).set(cluster);
 }
 
 inline void
 CacheDirectory::remove_eviction_invalidate(uint32_t addr, unsigned int cluster)
 {
-  assert(eviction_invalidates.find(addr) != eviction_invalidates.end());
-  DynamicBitset* &entryPtr = eviction_invalidates[addr];
-  entryPtr->clear(cluster);
+  ClusterBitset *clusters = eviction_invalidates.find(addr);
+  assert(clusters != NULL);
+  clusters->clear(cluster);
   //If all cluster bits are cleared, remove the entry
-  if(entryPtr->allClear()) { free(entryPtr); eviction_invalidates.erase(addr); }
+  if(clusters->allClear()) { eviction_invalidates.erase(addr); }
 }
 
 inline void
@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////////
+// decode_table.h
+////////////////////////////////////////////////////////////////////////////////
+//
+//  DecodeTable holds the StaticDecodeInfo of every instruction decoded so far,
+//  one array of entries per 4 KB code page, so each static instruction is
+//  decoded once and a lookup is a page-number hash (skipped when the fetch is
+//  on the same page as the last one) plus an array index.
+//
+//  Each entry remembers the instruction word it was decoded from.  A lookup
+//  whose word differs (code rewritten since it was decoded) decodes the entry
+//  again in place, so writes to executable memory invalidate stale entries
+//  without hooking the store path.
+//
+//  References returned by lookup() stay valid for the life of the table, but a
+//  re-decode of the same PC changes what they refer to.  PipePacket therefore
+//  copies its entry, so an instruction already in flight keeps the decode it
+//  was fetched with; only users that re-lookup every fetch (the lockstep
+//  engine, DecodeStage) may hold a reference.
+//
+//  rigel::DECODE_TABLE is the one table every core shares.  Besides the
+//  StaticDecodeInfo decode, an entry caches the functional unit, latency and
+//  RigelISA exec handler for the instruction, the legacy core's own decode of
+//  the word once DecodeStage has recorded it, and the legacy scoreboard's
+//  register masks for it once regfile_read has.
+//
+//  set_breakpoint() marks an entry SD_BREAKPOINT, decoded yet or not; the
+//  mark survives re-decodes, so a core can test for a PC breakpoint with the
+//  flags it already reads.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __DECODE_TABLE_H__
+#define __DECODE_TABLE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "instr/static_decode_info.h"
+#include "util/addr_hash_map.h"
+
+class DecodeTable {
+
+  public:
+
+    static const uint32_t PAGE_BITS   = 12;
+    static const uint32_t PAGE_INSTRS = 1 << (PAGE_BITS - 2);
+
+    DecodeTable();
+    ~DecodeTable();
+
+    /// decoded info for the instruction word raw at pc
+    StaticDecodeInfo &lookup(uint32_t pc, uint32_t raw) {
+      const uint32_t page_num = pc >> PAGE_BITS;
+      if (last_page == NULL || page_num != last_page_num) {
+        last_page = page(page_num);
+        last_page_num = page_num;
+      }
+      StaticDecodeInfo &e = last_page->entries[(pc >> 2) & (PAGE_INSTRS - 1)];
+      if (!e.valid() || e.raw() != raw) {
+        e.decode(pc, raw);
+        decodes++;
+      }
+      return e;
+    }
+
+    /// set or clear SD_BREAKPOINT on the entry for pc
+    void set_breakpoint(uint32_t pc, bool on) {
+      page(pc >> PAGE_BITS)->entries[(pc >> 2) & (PAGE_INSTRS - 1)].setBreakpoint(on);
+    }
+
+    /// size the page index for a binary with num_instrs static instructions
+    void reserve(size_t num_instrs);
+
+    size_t num_pages() const { return pages.size(); }
+    uint64_t num_decodes() const { return decodes; }
+
+  private:
+
+    struct Page {
+      StaticDecodeInfo entries[PAGE_INSTRS];
+    };
+
+    Page *page(uint32_t page_num);
+
+    AddrHashMap<Page*> pages;  /// page number -> entries
+    uint32_t last_page_num;
+    Page *last_page;
+    uint64_t decodes;
+
+    // pages are owned by the table
+    DecodeTable(const DecodeTable &);
+    DecodeTable &operator=(const DecodeTable &);
+};
+
+namespace rigel {
+  // Decoded static instructions shared by every core, see decode_table.cpp.
+  extern DecodeTable DECODE_TABLE;
+}
+
+#endif
@@ -18,6 +18,7 @@
 // not worth the effort.
 #include "core/regfile_legacy.h"
 #include "instr_base.h"
+#include "instr/static_decode_info.h"  // for LegacySBMasks
 #include <string>
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -52,6 +53,12 @@ class InstrLegacy : public InstrBase {
     InstrLegacy(uint32_t _pc, int _tid, uint32_t _pred_pc, uint32_t _raw_instr,  instr_t i_type);
     ~InstrLegacy() { }
 
+    // Every fetch slot, including wrong-path ones, allocates an instruction
+    // that dies at writeback or on a flush.  Recycle them through a free list
+    // instead of going to the heap each time (see instr_legacy.cpp).
+    static void * operator new(size_t size);
+    static void operator delete(void *p, size_t size);
+
     void dump();     // Dump the state for debugging purposes
 
     // required by InstrBase
@@ -141,6 +148,9 @@ class InstrLegacy : public InstrBase {
     // Used to determine how many regfile read ports this instruction uses
     uint32_t get_num_read_ports() { return num_read_ports;}
     void set_num_read_ports(uint32_t num_ports){ num_read_ports = num_ports; }
+    // Scoreboard checks of this word as register masks (see LegacySBMasks)
+    const LegacySBMasks &get_sb_masks() { return sb_masks; }
+    void set_sb_masks(const LegacySBMasks &m) { sb_masks = m; }
     // immediate value accessors
     int32_t get_simm() {
       if (src_imm & 0x8000)
@@ -321,9 +331,6 @@ class InstrLegacy : public InstrBase {
     static uint64_t *LAST_INSTR_NUMBER;
     uint64_t        last_instr_on_core;
 
-    // Track statistics on a per-instruction basis
-    InstrStats stats; // TODO: see file ??? for info on this class
-
     int spec_list_idx;
     struct {
       uint32_t v1;
@@ -344,8 +351,6 @@ class InstrLegacy : public InstrBase {
   private:
 
     // XXX BEGIN MEMBER *DATA* XXX 
-    disassemble_info dis_info;
-
     uint32_t pc;                // the PC for this instruction
     uint32_t next_pc;           // the (correct?) next PC?
     uint32_t pred_next_pc;      // predicted next PC
@@ -398,6 +403,9 @@ class InstrLegacy : public InstrBase {
     uint64_t first_memaccess_cycle, last_memaccess_cyle;
     // Used to determine if there are enough register ports to dual issue
     uint32_t num_read_ports;
+    // Scoreboard checks for this word as masks, copied from the decode table at
+    // decode or recorded by regfile_read
+    LegacySBMasks sb_masks;
     // XXX END MEMBER *DATA* XXX 
 
   //////////////////////////////////////////////////////////////////////////////
@@ -591,6 +599,18 @@ class InstrLegacy : public InstrBase {
     // END VECTOR OPS (REMOVE ME?)
     //////////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////////
+
+  //////////////////////////////////////////////////////////////////////////////
+  // cold data
+  //////////////////////////////////////////////////////////////////////////////
+  // Per-instruction statistics are several hundred bytes, nearly all of it
+  // counters that are only touched on stalls and at writeback.  Keep them
+  // after everything the pipeline reads every cycle so the hot fields above
+  // share a few cache lines.
+  public:
+
+    // Track statistics on a per-instruction basis
+    InstrStats stats; // TODO: see file ??? for info on this class
 ////////////
 ////////////
 
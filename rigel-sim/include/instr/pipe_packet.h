@@ -3,10 +3,10 @@
 
 #include <cstring>
 #include <cassert>
-#include <tr1/unordered_map>
 #include "instr/instr_base.h"
 #include "sim.h"
 #include "instr/static_decode_info.h"
+#include "instr/decode_table.h"
 #include "core/regfile.h" // FIXME remove this dependence on regval32_t
 #ifdef ENABLE_GPLV3
 #include <dis-asm.h>                    // for disassemble_info, etc
@@ -49,6 +49,27 @@ class PipePacket { // : public InstrBase { // maybe later...
       //_sdInfo = decode(); 
     }
 
+    /// constructor for callers off the simulator thread, which must not touch
+    /// the shared decode table: sdi is their own decode of raw at pc
+    PipePacket(
+      uint32_t pc,
+      uint32_t raw,
+      int      tid,
+      const StaticDecodeInfo &sdi
+    ) :
+      _valid(true),
+      _completed(false),
+      _request_pending(false),
+      _pc(pc),
+      raw_instr_bits(raw),
+      _tid(tid),
+      _mem_request(0),
+      _sdInfo(sdi),
+      _target_addr(0),
+      _branch_predicate(0),
+      _nextPC(0)
+    { }
+
     ///
     /// accessors
     ///
@@ -71,38 +92,41 @@ class PipePacket { // : public InstrBase { // maybe later...
     instr_t type() const { return _sdInfo.type(); }  
 
     // passthrough to static decode packet
-    bool    isBranch() const         { return _sdInfo.isBranch();         };
-    bool    isBranchIndirect() const { return _sdInfo.isBranchIndirect(); };
-    bool    isBranchDirect() const   { return _sdInfo.isBranchDirect();   };
-    bool    isStoreLinkRegister() const   { return _sdInfo.isStoreLinkRegister();   };
-    bool    isALU() const            { return _sdInfo.isALU();            };
-    bool    isFPU() const            { return _sdInfo.isFPU();            };
+    bool    isBranch() const         { return _sdInfo.is(SD_BRANCH);         };
+    bool    isBranchIndirect() const { return _sdInfo.is(SD_BRANCH_INDIRECT); };
+    bool    isBranchDirect() const   { return _sdInfo.is(SD_BRANCH_DIRECT);  };
+    bool    isStoreLinkRegister() const   { return _sdInfo.is(SD_STORE_LINK_REG);      };
+    bool    isALU() const            { return _sdInfo.is(SD_ALU);            };
+    bool    isFPU() const            { return _sdInfo.is(SD_FPU);            };
     /// memory
-    bool    isMem() const            { return _sdInfo.isMem();            };
-    bool    isGlobal() const         { return _sdInfo.isGlobal();         };
-    bool    isLocalMem() const       { return _sdInfo.isLocalMem();       };
-    bool    isCacheControl() const   { return _sdInfo.isCacheControl();   };
+    bool    isMem() const            { return _sdInfo.is(SD_MEM);            };
+    bool    isGlobal() const         { return _sdInfo.is(SD_GLOBAL);         };
+    bool    isLocalMem() const       { return _sdInfo.is(SD_LOCAL_MEM);      };
+    bool    isCacheControl() const   { return _sdInfo.is(SD_CACHE_CONTROL);  };
     //bool    isLocalLoad() const      { return _sdInfo.isLocalLoad();      }; // (local? global?)
     //bool    isLocalStore() const     { return _sdInfo.isLocalStore();     }; // (local? global?)
     /// atomics
-    bool    isAtomic() const         { return _sdInfo.isAtomic();         };
-    bool    isStore() const          { return _sdInfo.isStore();          };
-    bool    isLoad() const           { return _sdInfo.isLoad();           };
+    bool    isAtomic() const         { return _sdInfo.is(SD_ATOMIC);         };
+    bool    isStore() const          { return _sdInfo.is(SD_STORE);          };
+    bool    isLoad() const           { return _sdInfo.is(SD_LOAD);           };
     //bool    isLocalAtomic() const    { return _sdInfo.isLocalAtomic();    };
     //bool    isGlobalAtomic() const   { return _sdInfo.isGlobalAtomic();   };
     /// other
-    bool    isPrefetch() const       { return _sdInfo.isPrefetch();       };
+    bool    isPrefetch() const       { return _sdInfo.is(SD_PREFETCH);       };
     //bool    isSimOp() const          { return _sdInfo.isSimOp();          }; 
-    bool    isOther() const          { return _sdInfo.isOther();          }; 
-    bool    isNOP() const            { return _sdInfo.isNOP();            }; 
-    bool    isSPRFSrc() const        { return _sdInfo.isSPRFSrc();        }; 
-    bool    isDREGSrc() const        { return _sdInfo.isDREGSrc();        }; 
-    bool    isDREGDest() const       { return (! _sdInfo.isDREGNotDest());}; 
-    bool    isSPRFDest() const       { return _sdInfo.isSPRFDest();       }; 
-    bool    isShift() const          { return _sdInfo.isShift();          }; 
-    bool    isCompare() const        { return _sdInfo.isCompare();        }; 
+    bool    isOther() const          { return _sdInfo.is(SD_OTHER);          }; 
+    bool    isNOP() const            { return _sdInfo.is(SD_NOP);            }; 
+    bool    isSPRFSrc() const        { return _sdInfo.is(SD_SPRF_SRC);       }; 
+    bool    isDREGSrc() const        { return _sdInfo.is(SD_DREG_SRC);       }; 
+    bool    isDREGDest() const       { return !_sdInfo.is(SD_DREG_NOT_DEST); }; 
+    bool    isSPRFDest() const       { return _sdInfo.is(SD_SPRF_DEST);      }; 
+    bool    isShift() const          { return _sdInfo.is(SD_SHIFT);          }; 
+    bool    isCompare() const        { return _sdInfo.is(SD_COMPARE);        }; 
     //
-    bool    isSimSpecial() const     { return _sdInfo.isSimSpecial();     }; 
+    bool    isSimSpecial() const     { return _sdInfo.is(SD_SIM_SPECIAL);    }; 
+    bool    isBreakpoint() const     { return _sdInfo.is(SD_BREAKPOINT);     }; 
+
+    const StaticDecodeInfo &sdInfo() const { return _sdInfo; }
 
   ///
   /// public methods
@@ -157,7 +181,7 @@ class PipePacket { // : public InstrBase { // maybe later...
       dis_priv.target_addr = _target_addr; 
       dis_info.private_data = &dis_priv;
    
-      if (_sdInfo.isBranch()) {
+      if (_sdInfo.is(SD_BRANCH)) {
           dis_info.insn_type = dis_branch;
           dis_info.target = _pc;
       } else {
@@ -240,10 +264,15 @@ class PipePacket { // : public InstrBase { // maybe later...
     Packet* memRequest() { return _mem_request; }
     void memRequest(Packet* p) { _mem_request = p; }
     
-		///Resize decodedInstructions to the expected size
-		static void rehashInstrTable(size_t num_buckets) {
-			decodedInstructions.rehash(num_buckets);
-		}
+    /// Size the decode table for a binary with num_instrs static instructions
+    static void reserveDecodeTable(size_t num_instrs) {
+      rigel::DECODE_TABLE.reserve(num_instrs);
+    }
+
+    /// Set or clear a PC breakpoint in the shared decode table
+    static void setBreakpoint(uint32_t pc, bool on) {
+      rigel::DECODE_TABLE.set_breakpoint(pc, on);
+    }
 
   /// private methods
   private:
@@ -253,14 +282,7 @@ class PipePacket { // : public InstrBase { // maybe later...
     static const StaticDecodeInfo& decode(uint32_t pc, uint32_t raw_instr_bits) {
       // use pre-existing decoded info when it exists
       // otherwise, decode the instruction
-			std::tr1::unordered_map<uint32_t, StaticDecodeInfo>::const_iterator it; 
-			if((it = decodedInstructions.find(pc)) == decodedInstructions.end()) {
-				StaticDecodeInfo sdi(pc, raw_instr_bits);
-				DPRINT(DB_INSTR,"SDInfo:Decoding unseen pc %08x\n", pc);
-				return decodedInstructions.insert(it, std::pair<uint32_t,StaticDecodeInfo>(pc, sdi))->second;
-			}
-			else
-        return it->second;
+      return rigel::DECODE_TABLE.lookup(pc, raw_instr_bits);
     }
 
   /// private member data
@@ -278,8 +300,9 @@ class PipePacket { // : public InstrBase { // maybe later...
 
     Packet* _mem_request; ///< pointer to outstanding memory request
 
-    /// pointer to static decode information
-    const StaticDecodeInfo &_sdInfo;
+    /// static decode information, copied from the shared table so a
+    /// re-decode of this PC cannot change an instruction already in flight
+    StaticDecodeInfo _sdInfo;
 
 
     ///////////////////////////////////////////////////////////////////////////
@@ -295,9 +318,6 @@ class PipePacket { // : public InstrBase { // maybe later...
     /// input values
     regval32_t regvals[NUM_ISA_OPERAND_REGS]; /// for storing temporary register values
 
-    /// static structure for holding STATIC instruction decode data
-    static std::tr1::unordered_map<uint32_t,StaticDecodeInfo> decodedInstructions;
-
     ///////////////////////////////////////////////////////////////////////////
 
 };
@@ -1,3 +1,6 @@
+#ifndef __STATIC_DECODE_INFO_H__
+#define __STATIC_DECODE_INFO_H__
+
 #include "autogen/autogen_isa_sim.h"
 #include <stdint.h>
 #include "sim.h" // ugh, this dependence...
@@ -9,6 +12,74 @@ enum isa_reg_t {
   NUM_ISA_OPERAND_REGS
 };
 
+/// instruction classes, evaluated once per decode (see StaticDecodeInfo::is())
+enum sd_flag_t {
+  SD_BRANCH          = 1 << 0,
+  SD_BRANCH_INDIRECT = 1 << 1,
+  SD_BRANCH_DIRECT   = 1 << 2,
+  SD_STORE_LINK_REG  = 1 << 3,
+  SD_ALU             = 1 << 4,
+  SD_FPU             = 1 << 5,
+  SD_MEM             = 1 << 6,
+  SD_GLOBAL          = 1 << 7,
+  SD_LOCAL_MEM       = 1 << 8,
+  SD_CACHE_CONTROL   = 1 << 9,
+  SD_ATOMIC          = 1 << 10,
+  SD_STORE           = 1 << 11,
+  SD_LOAD            = 1 << 12,
+  SD_PREFETCH        = 1 << 13,
+  SD_OTHER           = 1 << 14,
+  SD_NOP             = 1 << 15,
+  SD_SPRF_SRC        = 1 << 16,
+  SD_DREG_SRC        = 1 << 17,
+  SD_DREG_NOT_DEST   = 1 << 18,
+  SD_SPRF_DEST       = 1 << 19,
+  SD_SHIFT           = 1 << 20,
+  SD_COMPARE         = 1 << 21,
+  SD_SIM_SPECIAL     = 1 << 22,
+  // not a property of the instruction: set by the debugger on a PC
+  // breakpoint and kept when the entry is decoded again
+  SD_BREAKPOINT      = 1 << 23
+};
+
+class PipePacket;
+
+/// RigelISA function that executes an instruction class on a PipePacket
+typedef void (*exec_handler_t)(PipePacket *);
+
+/// how the legacy core's regfile_read checks one instruction word
+enum legacy_sb_t {
+  LEGACY_SB_UNKNOWN = 0, /// not recorded yet
+  LEGACY_SB_MASKS,       /// src/dst below stand for every check
+  LEGACY_SB_SWITCH       /// vector, SPRF or accumulator operands: run the
+                         /// generated scoreboard_read.h/scoreboard_write.h
+};
+
+/// the legacy scoreboard's hazard checks for one instruction word, as
+/// recorded from the generated switches the first time it issues (see
+/// regfile_read.cpp): general registers checked as sources, general registers
+/// checked for a lock, and the register file read ports it takes
+struct LegacySBMasks {
+  LegacySBMasks() : state(LEGACY_SB_UNKNOWN), src(0), dst(0), read_ports(0) { }
+  legacy_sb_t state;
+  uint64_t    src;
+  uint64_t    dst;
+  uint32_t    read_ports;
+};
+
+/// what the legacy core's generated decoder (decode_switch.h) does for one
+/// instruction word: InstrLegacy::set_regs() arguments, then update_type()
+struct LegacyDecode {
+  instr_t  type;
+  uint32_t acc_src;
+  uint32_t sreg0;
+  uint32_t sreg1;
+  uint32_t dreg;
+  uint32_t acc_dest;
+  bool     has_acc;  /// decoded with the accumulator form of set_regs()
+  LegacySBMasks sb;  /// scoreboard checks, once regfile_read has recorded them
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// holds statically-known decode information to avoid repetetive decodes
 /// make this static decode packet structure per pc, set at first decode
@@ -21,10 +92,17 @@ class StaticDecodeInfo {
     StaticDecodeInfo() 
       :
       valid_(0),
-      type_(I_PRE_DECODE)
+      type_(I_PRE_DECODE),
+      flags_(0),
+      src_mask_(0),
+      dst_mask_(0),
+      funit_(FU_NONE),
+      latency_(0),
+      exec_(NULL),
+      legacy_valid_(false)
     { };
 
-		StaticDecodeInfo(uint32_t pc, uint32_t raw) {
+		StaticDecodeInfo(uint32_t pc, uint32_t raw) : flags_(0) {
 			decode(pc, raw);
 		}
 
@@ -37,6 +115,11 @@ class StaticDecodeInfo {
       sim_decode_type();
       StaticDecode();
       setRegs();
+      setFlags();
+      funit_   = INSTR_FUNIT[type_];
+      latency_ = INSTR_LAT[type_];
+      setExecHandler();
+      legacy_valid_ = false;
     }
 
     /// print useful information about the instruction
@@ -71,8 +154,40 @@ class StaticDecodeInfo {
     uint32_t simm16() const { return int32_t(int16_t(imm16()));}
 
     bool valid() const  { return valid_; }
+    uint32_t raw() const { return raw_instr_bits; }
     instr_t type() const { return type_; }
 
+    /// precomputed class test: true if any of the sd_flag_t bits in f is set
+    bool is(uint32_t f) const { return (flags_ & f) != 0; }
+
+    /// mark or unmark this PC as a breakpoint (SD_BREAKPOINT)
+    void setBreakpoint(bool on) {
+      if (on) { flags_ |= SD_BREAKPOINT; } else { flags_ &= ~SD_BREAKPOINT; }
+    }
+
+    /// general registers in input_deps/output_deps, one bit per register
+    /// (SPRF operands are not included)
+    uint32_t src_mask() const { return src_mask_; }
+    uint32_t dst_mask() const { return dst_mask_; }
+
+    /// functional unit class and execute latency (INSTR_FUNIT/INSTR_LAT)
+    funit_t funit() const   { return funit_; }
+    int     latency() const { return latency_; }
+
+    /// RigelISA::exec*() for this instruction's class, NULL for instructions
+    /// the core executes itself (sim specials, NOPs, ...)
+    exec_handler_t exec() const { return exec_; }
+
+    /// The legacy core's decode of this word, once DecodeStage has recorded it
+    /// (see DecodeStage::decode()).  Cleared when the entry is re-decoded.
+    bool legacyValid() const { return legacy_valid_; }
+    const LegacyDecode &legacy() const { return legacy_; }
+    void setLegacy(const LegacyDecode &l) { legacy_ = l; legacy_valid_ = true; }
+    /// keep the scoreboard masks regfile_read recorded for this word
+    void setLegacySB(const LegacySBMasks &m) {
+      if (legacy_valid_) { legacy_.sb = m; }
+    }
+
     /// TODO or not TODO:
     /// memoize some of these calls???
     /// functional units (or pipelines)
@@ -109,6 +224,9 @@ class StaticDecodeInfo {
     // 
     bool    isSimSpecial() const; 
 
+    /// pick exec_ from the class flags; in static_decode_info.cpp
+    void setExecHandler();
+
     void setType(instr_t t) {
       type_ = t;
     }
@@ -164,6 +282,47 @@ class StaticDecodeInfo {
       }
     }
 
+    /// evaluate the class helpers and register masks once per decode
+    void setFlags() {
+      flags_ &= SD_BREAKPOINT;
+      if (isBranch())            { flags_ |= SD_BRANCH; }
+      if (isBranchIndirect())    { flags_ |= SD_BRANCH_INDIRECT; }
+      if (isBranchDirect())      { flags_ |= SD_BRANCH_DIRECT; }
+      if (isStoreLinkRegister()) { flags_ |= SD_STORE_LINK_REG; }
+      if (isALU())               { flags_ |= SD_ALU; }
+      if (isFPU())               { flags_ |= SD_FPU; }
+      if (isMem())               { flags_ |= SD_MEM; }
+      if (isGlobal())            { flags_ |= SD_GLOBAL; }
+      if (isLocalMem())          { flags_ |= SD_LOCAL_MEM; }
+      if (isCacheControl())      { flags_ |= SD_CACHE_CONTROL; }
+      if (isAtomic())            { flags_ |= SD_ATOMIC; }
+      if (isStore())             { flags_ |= SD_STORE; }
+      if (isLoad())              { flags_ |= SD_LOAD; }
+      if (isPrefetch())          { flags_ |= SD_PREFETCH; }
+      if (isOther())             { flags_ |= SD_OTHER; }
+      if (isNOP())               { flags_ |= SD_NOP; }
+      if (isSPRFSrc())           { flags_ |= SD_SPRF_SRC; }
+      if (isDREGSrc())           { flags_ |= SD_DREG_SRC; }
+      if (isDREGNotDest())       { flags_ |= SD_DREG_NOT_DEST; }
+      if (isSPRFDest())          { flags_ |= SD_SPRF_DEST; }
+      if (isShift())             { flags_ |= SD_SHIFT; }
+      if (isCompare())           { flags_ |= SD_COMPARE; }
+      if (isSimSpecial())        { flags_ |= SD_SIM_SPECIAL; }
+
+      src_mask_ = 0;
+      dst_mask_ = 0;
+      if (!isSPRFSrc()) {
+        for (int r = 0; r < NUM_ISA_OPERAND_REGS; r++) {
+          if (input_deps[r] != (int32_t)simconst::NULL_REG) {
+            src_mask_ |= 1U << input_deps[r];
+          }
+        }
+      }
+      if (!isSPRFDest() && output_deps[DREG] != (int32_t)simconst::NULL_REG) {
+        dst_mask_ |= 1U << output_deps[DREG];
+      }
+    }
+
     uint32_t StaticDecode();
 
     int32_t regnums[NUM_ISA_OPERAND_REGS];
@@ -193,4 +352,16 @@ class StaticDecodeInfo {
 
     uint32_t decode_flags;
 
+    uint32_t flags_;     /// sd_flag_t bits
+    uint32_t src_mask_;  /// general registers read
+    uint32_t dst_mask_;  /// general register written
+    funit_t  funit_;
+    int      latency_;
+    exec_handler_t exec_;
+
+    bool         legacy_valid_;
+    LegacyDecode legacy_;
+
 };
+
+#endif
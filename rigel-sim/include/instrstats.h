@@ -101,7 +101,7 @@ struct InstrCycleStats {
     gc_write_allocate = 0;
     gc_pending = 0;
   }
-  void add_cycles(struct InstrCycleStats other)
+  void add_cycles(const struct InstrCycleStats &other)
   {
     fetch += other.fetch;
     decode += other.decode;
@@ -154,7 +154,7 @@ struct InstrCycleStats {
     gc_pending += other.gc_pending;
   }
 
-  void add_core(InstrCycleStats other)
+  void add_core(const InstrCycleStats &other)
   {
     if(other.fetch != 0) fetch++;
     if(other.decode != 0) decode++;
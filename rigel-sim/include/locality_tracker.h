@@ -2,12 +2,16 @@
 #define __LOCALITY_TRACKER_H__
 
 #include "memory/address_mapping.h"
+#include "util/addr_hash_map.h"
 #include <string>
 #include <iostream>
-#include <list>
+#include <vector>
+#include <cassert>
 #include <cstdio>
 #include <cstring>
 #include <climits>
+#include <inttypes.h>
+#include <stdint.h>
 
 typedef enum {
   LT_POLICY_MAP,
@@ -16,15 +20,153 @@ typedef enum {
   LT_POLICY_RR
 } lt_policy_t;
 
-typedef struct _lt_entry
+// Per-row state of one bank's window.  Every entry to a row is drained at the
+// same time, so the entries of a row can be tracked together: how many there
+// are, the MAP penalty counter they share, and the sequence number of the
+// oldest (which orders rows for FIFO and for MAP tie-breaking).
+typedef struct _lt_row
 {
-  _lt_entry() : row(0),mapCounter(0),accessCounter(0) {}
-  _lt_entry(unsigned int _row, unsigned int _accessCounter) : row(_row),
-    mapCounter(0), accessCounter(_accessCounter) {}
-  unsigned int row;
+  _lt_row() : count(0), mapCounter(0), firstSeq(0) {}
+  unsigned int count;
   unsigned int mapCounter;
-  unsigned int accessCounter;
-} lt_entry;
+  uint64_t firstSeq;
+} lt_row;
+
+// One access in a window's arrival-order ring.
+typedef struct _lt_slot
+{
+  unsigned int row;
+  uint64_t seq;
+} lt_slot;
+
+////////////////////////////////////////////////////////////////////////////////
+// LTWindow
+////////////////////////////////////////////////////////////////////////////////
+// The window of one bank.  Accesses are appended to a fixed-size ring and
+// counted by row in a small open-addressed table.  Draining a row only
+// removes it from the table: its ring slots become dead (row absent, or
+// older than the row's current firstSeq) and are dropped from the head or
+// squeezed out when the ring fills.  The ring holds twice the window size,
+// so a compaction is always followed by at least windowSize appends and
+// adding or draining stays O(1) amortized.
+////////////////////////////////////////////////////////////////////////////////
+class LTWindow
+{
+  public:
+    LTWindow(unsigned int windowSize, unsigned int closedRow) :
+      openRow(closedRow), live(0), head(0), used(0),
+      ring(windowSize < 1 ? 2 : 2*windowSize),
+      rowTable(lt_row(), 2*windowSize)
+    { }
+
+    unsigned int size() const { return live; }
+    bool empty() const { return live == 0; }
+
+    const lt_row *findRow(unsigned int row) const { return rowTable.find(row); }
+
+    // Returns the row's state, which the caller may update.
+    lt_row &add(unsigned int row, uint64_t seq)
+    {
+      if(used == ring.size())
+        compact();
+      lt_slot &s = ring[(head + used) % ring.size()];
+      s.row = row;
+      s.seq = seq;
+      used++;
+      live++;
+      lt_row &r = rowTable.insert(row);
+      if(r.count == 0)
+        r.firstSeq = seq;
+      r.count++;
+      return r;
+    }
+
+    // Service (remove) every entry to row.  Returns how many there were.
+    unsigned int drainRow(unsigned int row)
+    {
+      const lt_row *r = rowTable.find(row);
+      if(r == NULL)
+        return 0;
+      unsigned int n = r->count;
+      rowTable.erase(row);
+      live -= n;
+      return n;
+    }
+
+    // Row of the oldest entry.
+    unsigned int oldestRow()
+    {
+      assert(live != 0 && "oldestRow() of an empty window");
+      while(!isLive(ring[head]))
+      {
+        head = (head + 1) % ring.size();
+        used--;
+      }
+      return ring[head].row;
+    }
+
+    // Row of the index'th entry in arrival order (index < size()).
+    unsigned int rowAt(unsigned int index) const
+    {
+      for(unsigned int i = 0; i < used; i++)
+      {
+        const lt_slot &s = ring[(head + i) % ring.size()];
+        if(isLive(s) && index-- == 0)
+          return s.row;
+      }
+      assert(0 && "rowAt() past the end of the window");
+      return 0;
+    }
+
+    // Row of the newest entry.
+    unsigned int newestRow() const
+    {
+      for(unsigned int i = used; i > 0; i--)
+      {
+        const lt_slot &s = ring[(head + i - 1) % ring.size()];
+        if(isLive(s))
+          return s.row;
+      }
+      assert(0 && "newestRow() of an empty window");
+      return 0;
+    }
+
+    // Slot-level access to the row table, for the policies that look at
+    // every row in the window.
+    size_t rowSlots() const { return rowTable.capacity(); }
+    bool rowSlotUsed(size_t i) const { return rowTable.slot_used(i); }
+    unsigned int rowSlotRow(size_t i) const { return rowTable.slot_key(i); }
+    lt_row &rowSlotState(size_t i) { return rowTable.slot_value(i); }
+
+    unsigned int openRow;
+
+  private:
+    bool isLive(const lt_slot &s) const
+    {
+      const lt_row *r = rowTable.find(s.row);
+      return r != NULL && s.seq >= r->firstSeq;
+    }
+
+    // Squeeze dead slots out of the ring, keeping arrival order.
+    void compact()
+    {
+      unsigned int n = 0;
+      for(unsigned int i = 0; i < used; i++)
+      {
+        const lt_slot s = ring[(head + i) % ring.size()];
+        if(isLive(s))
+          ring[(head + n++) % ring.size()] = s;
+      }
+      used = n;
+      assert(used < ring.size() && "LTWindow ring full of live entries");
+    }
+
+    unsigned int live;
+    unsigned int head;
+    unsigned int used;    // ring slots in use, live or dead
+    std::vector<lt_slot> ring;
+    AddrHashMap<lt_row> rowTable;
+};
 
 class LocalityTracker
 {
@@ -39,49 +181,11 @@ class LocalityTracker
                     lastRank(UINT_MAX), lastBank(UINT_MAX), lastRow(UINT_MAX),
                     consecutiveRowHits(0UL)
     {
-      if(policy == LT_POLICY_MCF || policy == LT_POLICY_MAP)
-      {
-        histogramScratch = (unsigned int *)calloc(_rows, sizeof(*histogramScratch));
-        if(histogramScratch == NULL)
-        {
-          printf("Error: Could not calloc() histogramScratch (Out Of Memory?)\n");
-          exit(1);
-        }
-      }
-      openRow = new unsigned int**[channels];
-      window = new std::list<lt_entry> **[channels];
-      for(unsigned int i = 0; i < channels; i++)
-      {
-        openRow[i] = new unsigned int *[ranks];
-        window[i] = new std::list<lt_entry> *[ranks];
-        for(unsigned int j = 0; j < ranks; j++)
-        {
-          openRow[i][j] = new unsigned int[banks];
-          window[i][j] = new std::list<lt_entry> [banks];
-          //Initialize all entries to "rows" so that the first access of each bank will be a conflict
-          //(row indices are in [0,N-1] )
-          for(unsigned int k = 0; k < banks; k++)
-            openRow[i][j][k] = rows;
-        }
-      }
-    }
-
-    ~LocalityTracker()
-    {
-      if(policy == LT_POLICY_MCF || policy == LT_POLICY_MAP)
-        free(histogramScratch);
-      for(unsigned int i = 0; i < channels; i++)
-      {
-        for(unsigned int j = 0; j < ranks; j++)
-        {
-          delete[] openRow[i][j];
-          delete[] window[i][j];
-        }
-        delete[] openRow[i];
-        delete[] window[i];
-      }
-      delete[] openRow;
-      delete[] window;
+      //Open rows start at "rows" so that the first access of each bank will be a conflict
+      //(row indices are in [0,N-1] )
+      window.reserve(channels*ranks*banks);
+      for(unsigned int i = 0; i < channels*ranks*banks; i++)
+        window.push_back(LTWindow(windowSize, rows));
     }
 
     void addAccess(uint32_t addr)
@@ -92,30 +196,14 @@ class LocalityTracker
       unsigned int bank = AddressMapping::GetBank(addr);
       unsigned int row = AddressMapping::GetRow(addr);
 
-      if(window[controller][rank][bank].size() >= windowSize) //Full
+      LTWindow &w = getWindow(controller, rank, bank);
+      if(w.size() >= windowSize) //Full
       {
-        handleFull(window[controller][rank][bank], openRow[controller][rank][bank]);
+        handleFull(w);
       }
-      lt_entry newEntry(row, accessCounter++);
-      //Fill in MAP counter if necessary
-      if(policy == LT_POLICY_MAP)
-      {
-        bool found = false;
-        for(std::list<lt_entry>::iterator it = window[controller][rank][bank].begin();
-                                     it != window[controller][rank][bank].end();
-                                     ++it)
-        {
-          if((*it).row == row)
-          {
-            found = true;
-            newEntry.mapCounter = (*it).mapCounter;
-            break;
-          }
-        }
-        if(!found)
-          newEntry.mapCounter = 0;
-      }
-      window[controller][rank][bank].push_back(newEntry);
+      //A new entry shares the MAP counter of any entries to its row already in
+      //the window, which LTWindow keeps per row.
+      w.add(row, accessCounter++);
       if(lastController == controller && lastRank == rank && lastBank == bank && lastRow == row)
       {
         //printf("%s CRH!\n", name.c_str());
@@ -131,51 +219,25 @@ class LocalityTracker
       }
     }
 
-    void handleFull(std::list<lt_entry> &thisWindow, unsigned int &thisOpenRow)
+    void handleFull(LTWindow &thisWindow)
     {
       //Drain hits
-      std::list<lt_entry>::iterator it = thisWindow.begin();
-      unsigned int numHits = 0;
-      while(true)
-      {
-        if(it == thisWindow.end()) break;
-        if((*it).row == thisOpenRow) //Hit, service it
-        {
-          it = thisWindow.erase(it);
-          numHits++;
-        }
-        else //Miss, keep looking
-          ++it;
-      }
-      if(numHits != 0) //If we got some hits, we have free window entries to fill.
+      if(thisWindow.drainRow(thisWindow.openRow) != 0) //If we got some hits, we have free window entries to fill.
         return;
       //If we got no hits, we need to open a new row to drain some requests.
       numConflicts++;
-      thisOpenRow = findNewRow(thisWindow);
-      numHits = 0;
-      it = thisWindow.begin();
-      while(true)
-      {
-        if(it == thisWindow.end()) break;
-        if((*it).row == thisOpenRow) //Hit, service it
-        {
-          it = thisWindow.erase(it);
-          numHits++;
-        }
-        else //Miss, keep looking
-          ++it;
-      }
+      thisWindow.openRow = findNewRow(thisWindow);
+      unsigned int numHits = thisWindow.drainRow(thisWindow.openRow);
       assert(numHits != 0 && "no row hits on secondary drain");
+      (void)numHits;
     }
 
     void reset(bool closeAllRows)
     {
       if(closeAllRows)
       {
-        for(unsigned int i = 0; i < channels; i++)
-          for(unsigned int j = 0; j < ranks; j++)
-            for(unsigned int k = 0; k < banks; k++)
-              openRow[i][j][k] = rows;
+        for(size_t i = 0; i < window.size(); i++)
+          window[i].openRow = rows;
       }
       numAccesses = 0UL;
       numConflicts = 0UL;
@@ -190,11 +252,9 @@ class LocalityTracker
 
     inline void drain()
     {
-      for(unsigned int i = 0; i < channels; i++)
-        for(unsigned int j = 0; j < ranks; j++)
-          for(unsigned int k = 0; k < banks; k++)
-            while(!window[i][j][k].empty())
-              handleFull(window[i][j][k], openRow[i][j][k]);
+      for(size_t i = 0; i < window.size(); i++)
+        while(!window[i].empty())
+          handleFull(window[i]);
     }
 
     inline uint64_t getNumAccesses() const { return numAccesses; }
@@ -203,14 +263,22 @@ class LocalityTracker
     inline float getHitRate() const { return (float)((double)(numAccesses - numConflicts)/(numAccesses))*100.0f; }
     inline float getConsecutiveHitRate() const { return (float)((double)(consecutiveRowHits)/(numAccesses))*100.0f; }
 
-    unsigned int findNewRow(std::list<lt_entry> &thisWindow )
+    // Number of accesses to a row waiting in its bank's window.  Used by the
+    // locality-aware DRAM scheduler (-mem-sched-locality).
+    inline unsigned int getRowCount(unsigned int controller, unsigned int rank,
+                                    unsigned int bank, unsigned int row) const
+    {
+      const lt_row *r = window[(controller*ranks + rank)*banks + bank].findRow(row);
+      return (r == NULL) ? 0 : r->count;
+    }
+
+    unsigned int findNewRow(LTWindow &thisWindow)
     {
       switch(policy)
       {
         case LT_POLICY_FIFO:
         {
-          std::list<lt_entry>::iterator it = thisWindow.begin();
-          return ((*it).row);
+          return thisWindow.oldestRow();
         }
         case LT_POLICY_RR:
         {
@@ -219,66 +287,55 @@ class LocalityTracker
           //This is also why we % by thisWindow.size() instead of windowSize at the end.
           if(roundRobinIndex >= thisWindow.size())
           {
-            std::list<lt_entry>::iterator it = thisWindow.end();
-            --it;
-            return (*it).row;
+            return thisWindow.newestRow();
           }
-          std::list<lt_entry>::iterator it = thisWindow.begin();
-          for(unsigned int i = 0; i < roundRobinIndex; i++)
-            ++it;
+          unsigned int row = thisWindow.rowAt(roundRobinIndex);
           roundRobinIndex = (roundRobinIndex + 1) % thisWindow.size();
-          return (*it).row;
+          return row;
         }
         case LT_POLICY_MCF:
         {
-          //Clear histogram scratch area
-          memset(histogramScratch, 0, rows*sizeof(*histogramScratch));
-          //Build histogram of row frequencies in buffer, select most common
-          for(std::list<lt_entry>::iterator it = thisWindow.begin();
-                                       it != thisWindow.end();
-                                       ++it)
-          {
-            histogramScratch[(*it).row]++;
-          }
-          unsigned int max = 0, maxrow = thisWindow.begin()->row;
-          for(unsigned int i = 0; i < rows; i++)
+          //Select the most common row in the window, lowest row number on ties
+          unsigned int max = 0, maxrow = 0;
+          for(size_t i = 0; i < thisWindow.rowSlots(); i++)
           {
-            if(histogramScratch[i] > max)
+            if(!thisWindow.rowSlotUsed(i))
+              continue;
+            unsigned int row = thisWindow.rowSlotRow(i);
+            unsigned int count = thisWindow.rowSlotState(i).count;
+            if(count > max || (count == max && row < maxrow))
             {
-              max = histogramScratch[i];
-              maxrow = i;
+              max = count;
+              maxrow = row;
             }
           }
           return maxrow;
         }
         case LT_POLICY_MAP:
         {
-          //Clear histogram scratch area
-          memset(histogramScratch, 0, rows*sizeof(*histogramScratch));
-          //Choose row w/ highest penalty counter
-          unsigned int max = 0, maxrow = thisWindow.begin()->row;
-          for(std::list<lt_entry>::iterator it = thisWindow.begin();
-                              it != thisWindow.end();
-                              ++it)
+          //Choose row w/ highest penalty counter, oldest on ties
+          unsigned int max = 0, maxrow = thisWindow.oldestRow();
+          uint64_t maxSeq = UINT64_MAX;
+          for(size_t i = 0; i < thisWindow.rowSlots(); i++)
           {
-            if((*it).mapCounter > max)
+            if(!thisWindow.rowSlotUsed(i))
+              continue;
+            const lt_row &r = thisWindow.rowSlotState(i);
+            if(r.mapCounter > max || (r.mapCounter == max && max != 0 && r.firstSeq < maxSeq))
             {
-              max = (*it).mapCounter;
-              maxrow = (*it).row;
+              max = r.mapCounter;
+              maxSeq = r.firstSeq;
+              maxrow = thisWindow.rowSlotRow(i);
             }
           }
-          //Build histogram of row frequencies, add to running penalty counters
-          for(std::list<lt_entry>::iterator it = thisWindow.begin();
-                                       it != thisWindow.end();
-                                       ++it)
-          {
-            histogramScratch[(*it).row]++;
-          }
-          for(std::list<lt_entry>::iterator it = thisWindow.begin();
-                                       it != thisWindow.end();
-                                       ++it)
+          //Add each row's frequency to its running penalty counter
+          for(size_t i = 0; i < thisWindow.rowSlots(); i++)
           {
-            (*it).mapCounter += histogramScratch[(*it).row];
+            if(thisWindow.rowSlotUsed(i))
+            {
+              lt_row &r = thisWindow.rowSlotState(i);
+              r.mapCounter += r.count;
+            }
           }
           return maxrow;
         }
@@ -290,9 +347,13 @@ class LocalityTracker
     }
 
   private:
+    LTWindow &getWindow(unsigned int controller, unsigned int rank, unsigned int bank)
+    {
+      return window[(controller*ranks + rank)*banks + bank];
+    }
+
 		std::string name;
-    unsigned int *** openRow;
-    std::list<lt_entry> ***window;
+    std::vector<LTWindow> window;   // [channel][rank][bank]
     unsigned int windowSize;
     lt_policy_t policy;
     uint64_t numAccesses;
@@ -302,8 +363,7 @@ class LocalityTracker
     unsigned int banks;
     unsigned int rows;
     unsigned int roundRobinIndex;
-    unsigned int *histogramScratch;
-    unsigned int accessCounter;
+    uint64_t accessCounter;
     unsigned int lastController;
     unsigned int lastRank;
     unsigned int lastBank;
@@ -5,8 +5,12 @@
 #include <cstdio>   //For *printf()
 #include <cassert>
 #include <queue>
+#include <map>
 #include <inttypes.h>
+#include <cerrno>   //For errno, EINTR
+#include <cstring>  //For memcpy(), memset()
 #include <sstream> //For strinstream
+#include <unistd.h> //For read(), pread()
 
 #include "define.h" //For rigel_log2()
 #include "sim.h"    //For rigel::WARN_ON_UNINITIALIZED_MEMORY_ACCESSES
@@ -50,6 +54,23 @@ class BackingStore : public rigelsim::Checkpointable {
     ///satisfy user queries in interactive mode, because it bypasses error checking.
     WORD_T read_host_word(const ADDR_T addr) const;
 
+    ///Block transfers.  These copy whole chunks at a time instead of going
+    ///through write_word()/read_data_word() per word, and check permissions
+    ///once per chunk.  Bytes are laid out as in memory (host byte order
+    ///within each WORD_T), the same as filling a WordByte union by hand.
+    void write_bytes(const ADDR_T addr, const void *src, size_t num_bytes);
+    void read_bytes(const ADDR_T addr, void *dst, size_t num_bytes) const;
+    ///Read up to num_bytes from host file descriptor fd straight into target
+    ///memory at addr, stopping early at EOF.  If offset is negative the
+    ///descriptor's current position is used (and advanced), as with read();
+    ///otherwise pread() from offset.  Chunks past EOF are never allocated.
+    ///Returns the number of bytes read, or -1 with errno set on error.
+    int64_t read_from_fd(int fd, const ADDR_T addr, size_t num_bytes, int64_t offset = -1);
+    ///Zero num_bytes at addr.  Chunks that have not been allocated yet are
+    ///left alone when init_val is already zero, so large BSS ranges cost
+    ///nothing until they are touched.
+    void zero_bytes(const ADDR_T addr, size_t num_bytes);
+
     void set_readable_region(const ADDR_T low, const ADDR_T high);
     void set_writable_region(const ADDR_T low, const ADDR_T high);
     void set_executable_region(const ADDR_T low, const ADDR_T high);
@@ -57,6 +78,18 @@ class BackingStore : public rigelsim::Checkpointable {
     bool is_writable(const ADDR_T addr) const;
     bool is_executable(const ADDR_T addr) const;
 
+    ///Watchpoints.  A watched word is left out of the regions the access
+    ///checks test, so a data read or write of it takes the permission
+    ///failure path, which calls the watch callback (if any) and then lets
+    ///the access go ahead.  Unwatched accesses run exactly the checks they
+    ///always did, so having the feature costs nothing until a word is
+    ///watched.  Instruction fetches and read_host_word() are not watched.
+    enum { WATCH_READ = 1, WATCH_WRITE = 2 };
+    ///Watch the word containing addr for the accesses in mask (WATCH_READ,
+    ///WATCH_WRITE or both); a mask of 0 stops watching it.
+    void set_watchpoint(const ADDR_T addr, unsigned int mask);
+    void set_watch_callback(BSWatchCallbackBase<ADDR_T> *cb) { watch_cb = cb; }
+
     // Dump state to a file.
     void dump_to_file(const char *file_name) const;
     void dump_to_file(FILE *f) const;
@@ -70,6 +103,16 @@ class BackingStore : public rigelsim::Checkpointable {
     void traverse_helper(void * const *ptrptr, ADDR_T addr, unsigned int level, BSCallbackBase<ADDR_T, WORD_T> &cb) const;
     WORD_T *get_word_pointer_or_null(ADDR_T addr) const;
     WORD_T &get_or_create_word_reference(ADDR_T addr);
+    WORD_T *get_chunk_or_null(ADDR_T addr) const;
+    WORD_T *get_or_create_chunk(ADDR_T addr);
+    //Radix tree slot holding the chunk for addr (creating inner nodes, not the chunk).
+    WORD_T **get_or_create_chunk_slot(ADDR_T addr);
+    static const size_t CHUNK_BYTES = sizeof(WORD_T) << WORDS_PER_CHUNK_SHIFT;
+    //Bytes from addr to the end of its chunk, capped at num_bytes.
+    static size_t chunk_span(const ADDR_T addr, size_t num_bytes) {
+      const size_t left = CHUNK_BYTES - (addr & (CHUNK_BYTES - 1));
+      return (num_bytes < left) ? num_bytes : left;
+    }
     WORD_T *get_initialized_chunk();
     void **get_initialized_radix_tree_node(unsigned int level);
     void clean(void * node, unsigned int level);
@@ -88,16 +131,33 @@ class BackingStore : public rigelsim::Checkpointable {
     typedef std::vector<interval_type> interval_set_type;
     static bool is_in_interval_set(const ADDR_T addr, const interval_set_type &set);
     static void throw_access_exception(const ADDR_T addr, const char *property, const interval_set_type &set);
+    //Slow path of a data access to a word outside read_check/write_check:
+    //report a watch hit, or throw if the word really is not accessible.
+    void access_fault(const ADDR_T addr, unsigned int access) const;
+    //Calls access_fault() on each word of [addr, addr+num_bytes) outside the
+    //check regions for access, so the first inaccessible word throws.
+    void check_range(const ADDR_T addr, size_t num_bytes, unsigned int access) const;
+    //Recompute read_check and write_check.
+    void update_check_regions();
     interval_set_type readable_regions;
     interval_set_type writable_regions;
     interval_set_type executable_regions;
+    //What the data access checks test: readable_regions/writable_regions
+    //minus the words watched for reads/writes.  Copies of them when nothing
+    //is watched.
+    interval_set_type read_check;
+    interval_set_type write_check;
+    typedef std::map<ADDR_T, unsigned int> watch_map_type;
+    watch_map_type watched;   //word address -> WATCH_* mask
+    BSWatchCallbackBase<ADDR_T> *watch_cb;
 };
 
 BS_TEMPLATE_DECL
 BS_TEMPLATE_CLASSNAME::BackingStore(rigel::ConstructionPayload cp, const WORD_T _init_val)
                                        : init_val(_init_val),
                                          tree_levels((ADDRESS_SPACE_BITS-WORDS_PER_CHUNK_SHIFT-rigel_log2(sizeof(WORD_T))+RADIX_SHIFT-1) / RADIX_SHIFT),
-                                         memory_state(cp.memory_state)
+                                         memory_state(cp.memory_state),
+                                         watch_cb(NULL)
 {
   traversal_data = new shift_mask[tree_levels+1];
   unsigned int word_shift = rigel_log2(sizeof(WORD_T));
@@ -150,8 +210,8 @@ BS_TEMPLATE_DECL
 void BS_TEMPLATE_CLASSNAME::write_word(const ADDR_T addr, const WORD_T value)
 {
   assert((((ADDRESS_SPACE_BITS/8) == sizeof(ADDR_T)) || (rigel_log2(addr) <= (ADDRESS_SPACE_BITS-1))) && "Address too big!");
-  if(!is_writable(addr))
-    throw_access_exception(addr, "writable", writable_regions);
+  if(!is_in_interval_set(addr, write_check))
+    access_fault(addr, WATCH_WRITE);
   WORD_T &slot = get_or_create_word_reference(addr);
   slot = value;
 }
@@ -159,8 +219,8 @@ void BS_TEMPLATE_CLASSNAME::write_word(const ADDR_T addr, const WORD_T value)
 BS_TEMPLATE_DECL
 WORD_T BS_TEMPLATE_CLASSNAME::read_data_word(const ADDR_T addr) const
 {
-  if(!is_readable(addr))
-    throw_access_exception(addr, "readable", readable_regions);
+  if(!is_in_interval_set(addr, read_check))
+    access_fault(addr, WATCH_READ);
   return internal_read_word(addr);
 }
 
@@ -194,6 +254,109 @@ WORD_T BS_TEMPLATE_CLASSNAME::internal_read_word(const ADDR_T addr) const
 
 
 
+BS_TEMPLATE_DECL
+void BS_TEMPLATE_CLASSNAME::write_bytes(const ADDR_T addr, const void *src, size_t num_bytes)
+{
+  check_range(addr, num_bytes, WATCH_WRITE);
+  const char *from = reinterpret_cast<const char *>(src);
+  ADDR_T a = addr;
+  while(num_bytes > 0) {
+    const size_t n = chunk_span(a, num_bytes);
+    char *chunk = reinterpret_cast<char *>(get_or_create_chunk(a));
+    memcpy(chunk + (a & (CHUNK_BYTES - 1)), from, n);
+    from += n;
+    a += n;
+    num_bytes -= n;
+  }
+}
+
+BS_TEMPLATE_DECL
+void BS_TEMPLATE_CLASSNAME::read_bytes(const ADDR_T addr, void *dst, size_t num_bytes) const
+{
+  check_range(addr, num_bytes, WATCH_READ);
+  char *to = reinterpret_cast<char *>(dst);
+  ADDR_T a = addr;
+  while(num_bytes > 0) {
+    const size_t n = chunk_span(a, num_bytes);
+    const char *chunk = reinterpret_cast<const char *>(get_chunk_or_null(a));
+    if(chunk != NULL) {
+      memcpy(to, chunk + (a & (CHUNK_BYTES - 1)), n);
+    }
+    else {
+      if(rigel::WARN_ON_UNINITIALIZED_MEMORY_ACCESSES)
+        fprintf(stderr, "Warning: Reading words 0x%08x-0x%08x which have not been written yet\n",
+                (uint32_t)a, (uint32_t)(a + n - 1));
+      //Fill with init_val, keeping its byte position within each word.
+      const char *iv = reinterpret_cast<const char *>(&init_val);
+      for(size_t i = 0; i < n; i++)
+        to[i] = iv[(a + i) % sizeof(WORD_T)];
+    }
+    to += n;
+    a += n;
+    num_bytes -= n;
+  }
+}
+
+BS_TEMPLATE_DECL
+int64_t BS_TEMPLATE_CLASSNAME::read_from_fd(int fd, const ADDR_T addr, size_t num_bytes, int64_t offset)
+{
+  check_range(addr, num_bytes, WATCH_WRITE);
+  int64_t total = 0;
+  ADDR_T a = addr;
+  while(num_bytes > 0) {
+    const size_t n = chunk_span(a, num_bytes);
+    //A chunk that does not exist yet is read into off the tree and only
+    //linked in once it holds data, so nothing is allocated past EOF.
+    WORD_T *fresh = NULL;
+    WORD_T *chunk = get_chunk_or_null(a);
+    if(chunk == NULL)
+      chunk = fresh = get_initialized_chunk();
+    char *dst = reinterpret_cast<char *>(chunk) + (a & (CHUNK_BYTES - 1));
+    size_t got = 0;
+    ssize_t r = 0;
+    while(got < n) {
+      r = (offset < 0) ? read(fd, dst + got, n - got)
+                       : pread(fd, dst + got, n - got, offset + total + got);
+      if(r < 0 && errno == EINTR)
+        continue;
+      if(r <= 0)
+        break;
+      got += r;
+    }
+    if(fresh != NULL) {
+      if(got > 0)
+        *get_or_create_chunk_slot(a) = fresh;
+      else
+        delete[] fresh;
+    }
+    if(r < 0)
+      return -1;
+    total += got;
+    if(got < n)
+      return total; //EOF
+    a += n;
+    num_bytes -= n;
+  }
+  return total;
+}
+
+BS_TEMPLATE_DECL
+void BS_TEMPLATE_CLASSNAME::zero_bytes(const ADDR_T addr, size_t num_bytes)
+{
+  check_range(addr, num_bytes, WATCH_WRITE);
+  ADDR_T a = addr;
+  while(num_bytes > 0) {
+    const size_t n = chunk_span(a, num_bytes);
+    char *chunk = reinterpret_cast<char *>(get_chunk_or_null(a));
+    if(chunk == NULL && init_val != 0)
+      chunk = reinterpret_cast<char *>(get_or_create_chunk(a));
+    if(chunk != NULL)
+      memset(chunk + (a & (CHUNK_BYTES - 1)), 0, n);
+    a += n;
+    num_bytes -= n;
+  }
+}
+
 BS_TEMPLATE_DECL
 void BS_TEMPLATE_CLASSNAME::throw_access_exception(const ADDR_T addr, const char *property, const BS_TEMPLATE_CLASSNAME::interval_set_type &set) {
   std::stringstream error;
@@ -206,14 +369,95 @@ void BS_TEMPLATE_CLASSNAME::throw_access_exception(const ADDR_T addr, const char
   throw ExitSim(error.str().c_str());
 }
 
+BS_TEMPLATE_DECL
+void BS_TEMPLATE_CLASSNAME::access_fault(const ADDR_T addr, unsigned int access) const {
+  const bool write = (access == WATCH_WRITE);
+  const interval_set_type &set = write ? writable_regions : readable_regions;
+  if(!is_in_interval_set(addr, set))
+    throw_access_exception(addr, write ? "writable" : "readable", set);
+  //Accessible, so it was left out of the check regions because it is watched.
+  if(watch_cb != NULL)
+    watch_cb->watch_hit(addr, write);
+}
+
+BS_TEMPLATE_DECL
+void BS_TEMPLATE_CLASSNAME::check_range(const ADDR_T addr, size_t num_bytes, unsigned int access) const {
+  const interval_set_type &set = (access == WATCH_WRITE) ? write_check : read_check;
+  if(set.empty() || num_bytes == 0)
+    return;
+  const ADDR_T first = addr & ~(ADDR_T)(sizeof(WORD_T)-1);
+  const ADDR_T last = (addr + (num_bytes - 1)) & ~(ADDR_T)(sizeof(WORD_T)-1);
+  //Common case: one region covers the whole range.
+  for(typename BS_TEMPLATE_CLASSNAME::interval_set_type::const_iterator it = set.begin(), end = set.end(); it != end; ++it)
+    if(first >= it->first && last <= it->second)
+      return;
+  //Otherwise fall back to per-word checks so we report the first bad word
+  //(and every watched one).
+  for(ADDR_T a = first; ; a += sizeof(WORD_T)) {
+    if(!is_in_interval_set(a, set))
+      access_fault(a, access);
+    if(a == last)
+      break;
+  }
+}
+
+BS_TEMPLATE_DECL
+void BS_TEMPLATE_CLASSNAME::set_watchpoint(const ADDR_T addr, unsigned int mask) {
+  const ADDR_T word = addr & ~(ADDR_T)(sizeof(WORD_T)-1);
+  if(mask == 0)
+    watched.erase(word);
+  else
+    watched[word] = mask;
+  update_check_regions();
+}
+
+BS_TEMPLATE_DECL
+void BS_TEMPLATE_CLASSNAME::update_check_regions() {
+  read_check = readable_regions;
+  write_check = writable_regions;
+  if(watched.empty())
+    return;
+  for(unsigned int access = WATCH_READ; access <= WATCH_WRITE; access <<= 1) {
+    interval_set_type &check = (access == WATCH_WRITE) ? write_check : read_check;
+    //An empty set means everything is accessible; make that explicit so
+    //there is something to cut the watched words out of.
+    if(check.empty())
+      check.push_back(interval_type(0, ~(ADDR_T)0));
+    for(typename watch_map_type::const_iterator w = watched.begin(), wend = watched.end(); w != wend; ++w) {
+      if(!(w->second & access))
+        continue;
+      const ADDR_T lo = w->first;
+      const ADDR_T hi = w->first + (sizeof(WORD_T)-1);
+      interval_set_type cut;
+      for(typename interval_set_type::const_iterator it = check.begin(), end = check.end(); it != end; ++it) {
+        if(hi < it->first || lo > it->second) {
+          cut.push_back(*it);
+          continue;
+        }
+        if(it->first < lo)
+          cut.push_back(interval_type(it->first, lo - 1));
+        if(it->second > hi)
+          cut.push_back(interval_type(hi + 1, it->second));
+      }
+      //Nothing left must not read as "no restriction": keep an interval
+      //that contains no address.
+      if(cut.empty())
+        cut.push_back(interval_type(1, 0));
+      check.swap(cut);
+    }
+  }
+}
+
 BS_TEMPLATE_DECL
 void BS_TEMPLATE_CLASSNAME::set_readable_region(const ADDR_T low, const ADDR_T high) {
   readable_regions.push_back(interval_type(low, high));
+  update_check_regions();
 }
 
 BS_TEMPLATE_DECL
 void BS_TEMPLATE_CLASSNAME::set_writable_region(const ADDR_T low, const ADDR_T high) {
   writable_regions.push_back(interval_type(low, high));
+  update_check_regions();
 }
 
 BS_TEMPLATE_DECL
@@ -275,10 +519,42 @@ WORD_T * BS_TEMPLATE_CLASSNAME::get_word_pointer_or_null(ADDR_T addr) const
 
 
 
+BS_TEMPLATE_DECL
+WORD_T * BS_TEMPLATE_CLASSNAME::get_chunk_or_null(ADDR_T addr) const
+{
+  WORD_T *ptr = get_word_pointer_or_null(addr);
+  if(ptr == NULL)
+    return NULL;
+  const ADDR_T idx = (addr & traversal_data[tree_levels].mask) >> traversal_data[tree_levels].shift;
+  return ptr - idx;
+}
+
+BS_TEMPLATE_DECL
+WORD_T * BS_TEMPLATE_CLASSNAME::get_or_create_chunk(ADDR_T addr)
+{
+  WORD_T &word = get_or_create_word_reference(addr);
+  const ADDR_T idx = (addr & traversal_data[tree_levels].mask) >> traversal_data[tree_levels].shift;
+  return &word - idx;
+}
+
 BS_TEMPLATE_DECL
 WORD_T & BS_TEMPLATE_CLASSNAME::get_or_create_word_reference(ADDR_T addr)
 {
   //printf("get_or_create %08X:\n-------\n", addr);
+  WORD_T **dataptrptr = get_or_create_chunk_slot(addr);
+  if(*dataptrptr == NULL) {
+    //printf("Allocating chunk at 0x%08x\n", addr);
+    *dataptrptr = get_initialized_chunk();
+  }
+  const ADDR_T idx = (addr & traversal_data[tree_levels].mask) >> traversal_data[tree_levels].shift;
+  //printf("Data Idx = %08X\n", idx);
+  WORD_T *dataptr = *dataptrptr;
+  return dataptr[idx];
+}
+
+BS_TEMPLATE_DECL
+WORD_T ** BS_TEMPLATE_CLASSNAME::get_or_create_chunk_slot(ADDR_T addr)
+{
   void ***ptrptr = reinterpret_cast<void ***>(&TOT);
   //Traverse radix tree RADIX_SHIFT bits at a time.
   for(unsigned int i = 0; i < tree_levels; i++) {
@@ -291,15 +567,7 @@ WORD_T & BS_TEMPLATE_CLASSNAME::get_or_create_word_reference(ADDR_T addr)
     void **ptr = *ptrptr;
     ptrptr = reinterpret_cast<void ***>(&(ptr[idx]));
   }
-  WORD_T **dataptrptr = reinterpret_cast<WORD_T **>(ptrptr);
-  if(*dataptrptr == NULL) {
-    //printf("Allocating chunk at 0x%08x\n", addr);
-    *dataptrptr = get_initialized_chunk();
-  }
-  const ADDR_T idx = (addr & traversal_data[tree_levels].mask) >> traversal_data[tree_levels].shift;
-  //printf("Data Idx = %08X\n", idx);
-  WORD_T *dataptr = *dataptrptr;
-  return dataptr[idx];
+  return reinterpret_cast<WORD_T **>(ptrptr);
 }
 
 BS_TEMPLATE_DECL
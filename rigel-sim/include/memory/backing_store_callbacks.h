@@ -15,6 +15,14 @@ public:
   virtual void operator()(ADDR_T startaddr, size_t numwords, const WORD_T data[]) {}
 };
 
+// told about reads/writes of watched words (BackingStore::set_watchpoint())
+template <typename ADDR_T>
+class BSWatchCallbackBase {
+public:
+  virtual ~BSWatchCallbackBase() {}
+  virtual void watch_hit(ADDR_T addr, bool write) = 0;
+};
+
 BSCB_TEMPLATE_DECL
 class BSFileCallback : public BSCB_TEMPLATE_CLASSNAME
 {
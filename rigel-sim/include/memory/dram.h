@@ -27,6 +27,15 @@ namespace rigel {
     extern unsigned int OPEN_ROWS; //Number of open rows per bank (used to implement WC-DRAM)
     const char DRAM_OPEN_ROWS_DEFAULT[] = "1"; //This is a normal DRAM (1-entry cache)
 
+    // Timing model behind MemoryTimingDRAM (--dram-model).
+    enum DRAMModel {
+      dram_model_command,  // DRAMController, clocked every DRAM cycle
+      dram_model_analytic, // DRAMAnalyticModel, bank/bus state, no clocking
+      dram_model_ideal     // fixed latency (--ideal-dram-lat)
+    };
+    extern DRAMModel MODEL;
+    const char DRAM_MODEL_DEFAULT[] = "command";
+
     const int PHYSICALLY_ALLOWED_RANKS = 2;
     const bool ALWAYS_4GB = false;
 
@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+// dram_analytic_model.h
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Analytic DRAM timing (--dram-model analytic|ideal).
+//
+//  DRAMController steps a command scheduler every DRAM clock.  This model
+//  instead keeps a queue of requests per bank and only does work when a bank
+//  can take its next request: it picks one first-ready first-come (a request
+//  to the open row, else the oldest, which may precharge once tRAS/tRTP/tWR
+//  allow; a request waiting MC_FORCE_SCHEDULE_SOFT clocks goes first) and
+//  computes each of its lines' completion time from a small amount of state
+//  kept per bank (open row, earliest next activate, precharge and read), per
+//  rank (earliest next activate and column command) and per channel (data
+//  bus transfers not yet finished), with the same timing parameters as the
+//  cycle-level model (rigel::DRAM::LATENCY):
+//
+//    row hit       CAS (a read after tWTR)
+//    row closed    ACT, tRCD, CAS
+//    row conflict  PRE (after tRAS/tRTP/tWR), tRP, ACT, tRCD, CAS
+//
+//  and data occupies the channel's bus for BURST/2 clocks after tCL (tWL for
+//  writes), in the first gap the bus has from then on.  A bank takes its
+//  next request the clock after the previous one's column command.  tFAW,
+//  the row cache and the batching policies are not modeled.  Bank occupancy
+//  is bounded by PENDING_PER_BANK (per channel with
+//  -mem-monolithic-scheduler) so the caller sees backpressure.
+//
+//  In ideal mode every line returns a fixed CMDLINE_IDEALIZED_DRAM_LATENCY
+//  after it is scheduled, plus one clock per earlier line of the request.
+//
+//  Bank wakeups and completions wait in time-ordered queues; PerCycle() only
+//  compares their heads against the DRAM clock, so the cost is O(log n) per
+//  line and nothing per idle cycle.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __DRAM_ANALYTIC_MODEL_H__
+#define __DRAM_ANALYTIC_MODEL_H__
+
+#include <stdint.h>
+#include <deque>
+#include <functional>
+#include <map>
+#include <queue>
+#include <set>
+#include <vector>
+
+class CallbackInterface;
+
+////////////////////////////////////////////////////////////////////////////////
+// Class: DRAMAnalyticModel
+////////////////////////////////////////////////////////////////////////////////
+class DRAMAnalyticModel {
+
+  public:
+    /// ideal: ignore bank and bus state, fixed latency of ideal_latency clocks
+    DRAMAnalyticModel(bool ideal, uint32_t ideal_latency);
+
+    /// Queue a request for the lines in addrs (which all map to one
+    /// controller/rank/bank/row); it is issued at once if its bank is free.
+    /// Returns false, with no state changed, if the bank already holds
+    /// PENDING_PER_BANK requests.
+    bool Schedule(const std::set<uint32_t> &addrs, bool read,
+                  CallbackInterface *requester, int requestIdentifier);
+    /// Issue to banks that have come free and deliver the callbacks of lines
+    /// ready by the current DRAM cycle.
+    void PerCycle();
+    /// Print row-buffer and latency statistics to stderr.
+    void Dump() const;
+
+  private:
+    struct Request {
+      uint64_t inserted;
+      CallbackInterface *requester;
+      int      requestIdentifier;
+      uint32_t row;
+      bool     read;
+      std::vector<uint32_t> addrs;
+    };
+    // Times are the earliest clock the next command of that kind may issue.
+    struct Bank {
+      Bank() : row_open(false), row(0), next_act(0), pre_ready(0),
+               next_read(0), next_issue(0), waking(false), wake(0),
+               pending(0) { }
+      bool     row_open;
+      uint32_t row;
+      uint64_t next_act;   // tRC
+      uint64_t pre_ready;  // tRAS, tRTP, tWR for the open row
+      uint64_t next_read;  // tWTR
+      uint64_t next_issue; // clock after the last column command
+      bool     waking;     // a Wakeup for this bank is queued, at 'wake'
+      uint64_t wake;
+      int      pending;    // requests not yet complete
+      std::deque<Request> queue;  // not yet issued, oldest first
+    };
+    struct Rank {
+      uint64_t next_act;   // tRRD
+      uint64_t next_cas;   // tCCD
+    };
+    struct Channel {
+      std::map<uint64_t, uint64_t> bus;  // data transfers, first -> end clock
+      int      pending;
+      std::vector<Rank> ranks;
+      std::vector<Bank> banks;  // rank-major
+    };
+    struct Wakeup {
+      uint64_t time;
+      unsigned int controller;
+      unsigned int bank;
+      bool operator>(const Wakeup &w) const { return time > w.time; }
+    };
+    struct Completion {
+      uint64_t ready;
+      uint64_t seq;        // breaks ties in schedule order
+      uint64_t inserted;
+      CallbackInterface *requester;
+      int      requestIdentifier;
+      uint32_t addr;
+      unsigned int controller;
+      unsigned int bank;   // index into Channel::banks
+      bool     last;       // last line of its request
+      bool operator>(const Completion &c) const {
+        return ready != c.ready ? ready > c.ready : seq > c.seq;
+      }
+    };
+
+    /// schedule one line; returns the clock its last data beat arrives and
+    /// sets cas to the clock of its column command
+    uint64_t ServiceLine(Channel &ch, Rank &rk, Bank &bk, uint32_t row,
+                         bool read, uint64_t now, uint64_t &cas);
+    /// reserve the data bus for len clocks from the first gap at or after
+    /// earliest; returns the first clock reserved
+    uint64_t ReserveBus(Channel &ch, uint64_t earliest, uint64_t len,
+                        uint64_t now);
+    /// issue queued requests of one bank for as long as it can take them at
+    /// now, then queue a Wakeup for when it next can
+    void Issue(unsigned int controller, unsigned int bank, uint64_t now);
+    /// queue completions for every line of r, the first issued at now
+    void Complete(const Request &r, unsigned int controller,
+                  unsigned int bank, uint64_t now);
+
+    const bool ideal;
+    const uint32_t ideal_latency;
+    std::vector<Channel> channels;
+    std::priority_queue<Wakeup, std::vector<Wakeup>,
+                        std::greater<Wakeup> > wakeups;
+    std::priority_queue<Completion, std::vector<Completion>,
+                        std::greater<Completion> > completions;
+    uint64_t seq;
+
+    // statistics
+    uint64_t requests;
+    uint64_t lines;
+    uint64_t row_hits;
+    uint64_t row_empty;
+    uint64_t row_conflicts;
+    uint64_t rejected;
+    uint64_t completed;
+    uint64_t total_latency;   // DRAM clocks, summed over completed requests
+};
+
+#endif
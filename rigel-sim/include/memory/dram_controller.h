@@ -11,10 +11,12 @@
 #include "memory/dram_channel_model.h"
 #include "caches_legacy/mshr_legacy.h"
 #include "memory/address_mapping.h"
+#include "util/value_tracker.h"
 
 // Forward declarations
 class GlobalCache;
 class CallbackInterface;
+class LocalityTracker;
 
 template<int T> class MissHandlingEntry;
 
@@ -90,6 +92,12 @@ struct PendingRequestEntry {
 
     ReadyLinesEntry rle(addr, DRAMChannelModel::GetDRAMCycle()+cyclesFromNow);
     ReadyLines.insert(rle);
+
+    //Every line read from or written to DRAM passes through here exactly once.
+    if(rigel::TRACK_LINE_VALUES) {
+      GLOBAL_LINE_TRACKER_PTR->addLine(ReadNOTWrite ? LineValueTracker::DRAM_READ
+                                                    : LineValueTracker::DRAM_WRITE, addr);
+    }
   }
 
   bool HasReadyLine() const
@@ -589,6 +597,8 @@ class DRAMController
     //Number of requests ever assigned to current batch.  Used in Schedule() to figure out when to cut off a batch
     //When we are using the perchannel policy.
     unsigned int requestsInCurrentBatch;
+    // Recent requests by bank and row, for -mem-sched-locality (else NULL).
+    LocalityTracker *rowTracker;
   public:
     PendingRequestEntry *** requestBuffer;
     int ** requestBufferOccupancy;
@@ -612,6 +622,9 @@ class DRAMController
     bool helper_FindRowHit(unsigned int rank, unsigned int bank, PendingRequestEntry* &rowHit);
     // Helper function for testing if any of the WDTs have expired
     bool helper_FindTimeout(unsigned int rank, unsigned int bank, PendingRequestEntry* &oldRequest);
+    // Returns true if a schedulable request is found, pointing request at the
+    // one whose row rowTracker has seen the most of lately.
+    bool helper_FindLocalityRequest(unsigned int rank, unsigned int bank, PendingRequestEntry* &request);
     //Helper function to gather per-cycle, per-controller statistics
     void helper_GatherStatistics();
     bool helper_IsRowHit(PendingRequestEntry* const &request) const;
@@ -21,6 +21,7 @@
 class ComponentBase;
 class DRAMController;
 class DRAMChannelModel;
+class DRAMAnalyticModel;
 class LocalityTracker;
 //class TLB; //Forward declaration won't do; since we have a vector<TLB>, we need a destructor definition.
 
@@ -54,7 +55,8 @@ class MemoryTimingDRAM : MemoryTimingBase {
     void dump_locality() const;
 
     virtual int  PerCycle();
-    virtual void EndSim() { } ///< FIXME Push stats dumps into here
+    /// Print end-of-simulation statistics of the analytic/ideal model.
+    virtual void EndSim();
     virtual void PreSimInit() { } ///< FIXME Push most of constructor into here
     /// Dump current state of the memory controller for debugging purposes.
     virtual void Dump();
@@ -62,6 +64,9 @@ class MemoryTimingDRAM : MemoryTimingBase {
   private:
     DRAMController **Controllers;
     DRAMChannelModel **DRAMModelArray;
+    /// Non-NULL unless rigel::DRAM::MODEL is dram_model_command, in which
+    /// case it services every request and the controllers are not clocked.
+    DRAMAnalyticModel *analytic;
 
     FILE *FILE_memory_trace;
     LocalityTracker *aggregateLocalityTracker;
@@ -8,6 +8,7 @@
 #include <string>
 #include <iostream>
 #include <cassert>
+#include <cstring>
 
 class ComponentBase;
 
@@ -20,8 +21,32 @@ class PortBase {
     private:
 };
 
+/// identifies a port by its owning component, a suffix and an optional index
+/// no string is built at construction; str() formats the name
+/// ("<owner name>_<owner id>_<suffix>[_<index>]") only when it is printed
+struct PortID {
+  PortID(ComponentBase *o, const char *s, int i = -1) :
+    owner(o), suffix(s), index(i) { }
+
+  std::string str() const;
+
+  bool operator<(const PortID &o) const {
+    if (owner != o.owner) { return owner < o.owner; }
+    int c = strcmp(suffix, o.suffix);
+    if (c != 0) { return c < 0; }
+    return index < o.index;
+  }
+  bool operator==(const PortID &o) const {
+    return owner == o.owner && index == o.index && 0 == strcmp(suffix, o.suffix);
+  }
+
+  ComponentBase *owner;
+  const char    *suffix; ///< must outlive the port (use a string literal)
+  int            index;  ///< -1 if the port is not one of an array
+};
+
 //FIXME Use a function naming convention, not a class naming convention
-std::string PortName( std::string parent, int id, std::string suffix, int index = -1);
+PortID PortName( ComponentBase *parent, const char *suffix, int index = -1);
 
 // forward declarations
 template <class T> class OutPortBase;
@@ -40,10 +65,11 @@ class InPortBase : public PortBase {
 
   public:
 
-    InPortBase(std::string name) : 
+    InPortBase(PortID id) : 
+      _id(id),
+      _owner(id.owner),
       _valid(false),
-      _ready(true),
-      _name(name)
+      _ready(true)
     { 
       PortManager<T>::registerInPort(this);
     }
@@ -75,11 +101,12 @@ class InPortBase : public PortBase {
     }
 
     virtual void attach( OutPortBase<T>* op ) { 
-      DPRINT(DEBUG_PORT,"%s %s\n", __PRETTY_FUNCTION__, _name.c_str());   
+      DPRINT(DEBUG_PORT,"%s %s\n", __PRETTY_FUNCTION__, name().c_str());   
       op->attach(this); 
     }
 
-    std::string name() { return _name; }
+    std::string name() { return _id.str(); }
+    const PortID &port_id() const { return _id; }
     
     friend class PortManager<T>;
 
@@ -90,7 +117,7 @@ class InPortBase : public PortBase {
 
   private:
     T    data;             ///< templated data payload
-    std::string _name;     ///< port name
+    PortID _id;            ///< port identity (name built on demand)
     ComponentBase* _owner; ///< owning Component
     bool _valid;           ///< data is valid
     bool _ready;           ///< ready to accept a message
@@ -104,9 +131,9 @@ class InPortCallback : public InPortBase<T> {
   
   public:
 
-    InPortCallback( std::string name, 
+    InPortCallback( PortID id, 
                     CallbackWrapper<T,port_status_t>* handler 
-    ) : InPortBase<T>(name),
+    ) : InPortBase<T>(id),
         handler(handler)
     { }
 
@@ -130,8 +157,9 @@ class OutPortBase : public PortBase {
 
   public:
 
-    OutPortBase(std::string name) : 
-      _name(name),
+    OutPortBase(PortID id) : 
+      _owner(id.owner),
+      _id(id),
       _connection(NULL) // no connections
     {
       PortManager<T>::registerOutPort(this);
@@ -144,14 +172,15 @@ class OutPortBase : public PortBase {
     }
 
     virtual void attach( InPortBase<T>* op ) {
-      DPRINT(DEBUG_PORT,"%s %s\n", __func__, _name.c_str());   
+      DPRINT(DEBUG_PORT,"%s %s\n", __func__, name().c_str());   
       if (_connection) {
         throw ExitSim("OutPort already connected, this port does not support >1 connection");
       }
       _connection = op;
     }
 
-    std::string name() { return _name; }
+    std::string name() { return _id.str(); }
+    const PortID &port_id() const { return _id; }
 
     ComponentBase* owner() { return _owner; }
     void owner(ComponentBase* o) { _owner = o; }
@@ -168,7 +197,7 @@ class OutPortBase : public PortBase {
 
   private:
     ComponentBase*  _owner;
-    std::string     _name; ///< port name
+    PortID          _id;   ///< port identity (name built on demand)
     InPortBase<T>* _connection;
 
 };
@@ -1,13 +1,19 @@
-
+#include <vector>
 #include <map>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include "util/util.h" // for ExitSim
+#include "sim/build_slot.h"
 
 // forward declarations
 template<class T> class InPortBase;
 template<class T> class OutPortBase;
 
+/// registry of every port of payload type T
+/// ports register by pointer as they are constructed; names are only
+/// formatted by Dump() and DumpGraphviz(), and name conflicts are found
+/// by CheckUnique() once construction is done
 template <typename T>
 class PortManager {
 
@@ -16,19 +22,27 @@ class PortManager {
     static void Dump() {
 
       // inports
-      #if 0 
+      #if 0
       {
+        std::map< std::string, InPortBase<T>* > byname;
+        for ( size_t i = 0; i < InPorts.size(); ++i ) {
+          byname[InPorts[i]->name()] = InPorts[i];
+        }
         typename std::map< std::string, InPortBase<T>* >::iterator it;
-        for ( it = InPorts.begin(); it != InPorts.end(); ++it ) {
+        for ( it = byname.begin(); it != byname.end(); ++it ) {
           std::cout << "InPort: " << (*it).first << std::endl;
         }
       }
       #endif
 
-      // outports
+      // outports, in name order
+      std::map< std::string, OutPortBase<T>* > byname;
+      for ( size_t i = 0; i < OutPorts.size(); ++i ) {
+        byname[OutPorts[i]->name()] = OutPorts[i];
+      }
       typename std::map< std::string, OutPortBase<T>* >::iterator it;
       {
-        for ( it = OutPorts.begin(); it != OutPorts.end(); ++it ) {
+        for ( it = byname.begin(); it != byname.end(); ++it ) {
           std::cout << "OutPort: " << (*it).first << " -> " << (*it).second->connection_name() << std::endl;
         }
       }
@@ -44,17 +58,17 @@ class PortManager {
       portgraph << "digraph PortGraph {" << std::endl;
 
       {
-        typename std::map< std::string, OutPortBase<T>* >::iterator it;
-        for ( it = OutPorts.begin(); it != OutPorts.end(); ++it ) {
-          portgraph << (*it).second->owner()->name() << "_" << (*it).second->owner()->id() << " -> ";
-          portgraph << (*it).first << " -> " << (*it).second->connection_name() << std::endl;
+        for ( size_t i = 0; i < OutPorts.size(); ++i ) {
+          OutPortBase<T>* p = OutPorts[i];
+          portgraph << p->owner()->name() << "_" << p->owner()->id() << " -> ";
+          portgraph << p->name() << " -> " << p->connection_name() << std::endl;
         }
       }
       {
-        typename std::map< std::string, InPortBase<T>* >::iterator it;
-        for ( it = InPorts.begin(); it != InPorts.end(); ++it ) {
-          portgraph << (*it).second->owner()->name() << "_" << (*it).second->owner()->id() << " -> ";
-          portgraph << (*it).first << std::endl;
+        for ( size_t i = 0; i < InPorts.size(); ++i ) {
+          InPortBase<T>* p = InPorts[i];
+          portgraph << p->owner()->name() << "_" << p->owner()->id() << " -> ";
+          portgraph << p->name() << std::endl;
         }
       }
 
@@ -64,44 +78,45 @@ class PortManager {
 
     }
 
+    /// registration order is kept under a parallel tile build
     static void registerInPort( InPortBase<T>* p ) {
-
-      typename std::map< std::string, InPortBase<T>* >::iterator it;
-      it = InPorts.find(p->name());
-
-      // register this port by name
-      if (it == InPorts.end()) {
-        InPorts[p->name()] = p;
-      } else {
-        printf("port name exists: %s\n", p->name().c_str());
-        throw ExitSim("port name conflict!");
-      }
-
+      rigel::BuildSlot::push_back(InPorts, p);
     }
 
     static void registerOutPort( OutPortBase<T>* p ) {
-
-      typename std::map< std::string, OutPortBase<T>* >::iterator it;
-      it = OutPorts.find(p->name());
-
-      if (it == OutPorts.end()) {
-        OutPorts[p->name()] = p;
-      } else {
-        printf("port name exists: %s\n", p->name().c_str());
-        throw ExitSim("port name conflict!");
-      }
-
+      rigel::BuildSlot::push_back(OutPorts, p);
     }
 
+    /// throw if two ports of the same direction share an ID
+    /// compares IDs, not formatted names, so nothing is printed unless
+    /// there is a conflict
+    static void CheckUnique() {
+      checkUnique(InPorts);
+      checkUnique(OutPorts);
+    }
 
   private:
 
-    static std::map< std::string, InPortBase<T>* >  InPorts;
-    static std::map< std::string, OutPortBase<T>* > OutPorts;
+    template <class P>
+    static bool lessID( P* a, P* b ) { return a->port_id() < b->port_id(); }
+
+    template <class P>
+    static void checkUnique( const std::vector<P*> &ports ) {
+      std::vector<P*> sorted(ports);
+      std::sort(sorted.begin(), sorted.end(), lessID<P>);
+      for ( size_t i = 1; i < sorted.size(); ++i ) {
+        if (sorted[i-1]->port_id() == sorted[i]->port_id()) {
+          printf("port name exists: %s\n", sorted[i]->name().c_str());
+          throw ExitSim("port name conflict!");
+        }
+      }
+    }
 
-};
+    static std::vector< InPortBase<T>* >  InPorts;
+    static std::vector< OutPortBase<T>* > OutPorts;
 
-template <class T> std::map< std::string, InPortBase<T>* >  PortManager<T>::InPorts;
-template <class T> std::map< std::string, OutPortBase<T>* > PortManager<T>::OutPorts;
+};
 
+template <class T> std::vector< InPortBase<T>* >  PortManager<T>::InPorts;
+template <class T> std::vector< OutPortBase<T>* > PortManager<T>::OutPorts;
 
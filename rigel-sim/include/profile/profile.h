@@ -15,6 +15,7 @@
 #include "sim.h"
 #include "profile_names.h"
 #include "instrstats.h"
+#include "util/addr_hash_map.h"
 #include <string>
 #include <set>
 #include <cstring>
@@ -197,6 +198,7 @@ struct ProfileStat {
     void print();
 
     uint64_t total() {return count.total;}
+    const std::string &name() const { return stat_name; }
 
     void set_num_items(uint32_t i) { num_items = i; }
 
@@ -730,10 +732,22 @@ typedef struct profile_instr_stall_t {
     }
 
     // Add per-instruction stall cycle information.
-    void add_stalls(InstrCycleStats stalls) {
+    void add_stalls(const InstrCycleStats &stalls) {
       cycles.add_cycles(stalls);
       counts.add_core(stalls);
     }
+    // Fold in the statistics another cluster gathered for the same PC.
+    void merge(const profile_instr_stall_t &other) {
+      dynamic_count += other.dynamic_count;
+      stall_cycle_count += other.stall_cycle_count;
+      l1d_hits += other.l1d_hits;
+      l2d_hits += other.l2d_hits;
+      l3d_hits += other.l3d_hits;
+      l1i_hits += other.l1i_hits;
+      l2i_hits += other.l2i_hits;
+      cycles.add_cycles(other.cycles);
+      counts.add_cycles(other.counts);
+    }
 
     // Dump the average latency for the PC
     float get_latency() const { 
@@ -774,12 +788,36 @@ typedef struct profile_instr_stall_t {
 
 } profile_instr_stall_t; 
 
+// Where the oldest instruction in a core was when the per-PC sampler
+// (-per-pc-sample) looked.  PC_SAMPLE_FETCH means the pipeline was empty and
+// the sample went to the PC being fetched; the others follow the pipeline
+// latch order (IF2DC holds the instruction in decode, and so on).
+typedef enum {
+  PC_SAMPLE_FETCH,
+  PC_SAMPLE_DECODE,
+  PC_SAMPLE_EXECUTE,
+  PC_SAMPLE_MEM,
+  PC_SAMPLE_FP,
+  PC_SAMPLE_CC,
+  PC_SAMPLE_WB,
+  PC_SAMPLE_NUM_REASONS
+} pc_sample_reason_t;
+
+// Per-PC sample counts, one per reason.
+typedef struct profile_pc_samples_t {
+  profile_pc_samples_t() { memset(count, 0, sizeof(count)); }
+  uint64_t count[PC_SAMPLE_NUM_REASONS];
+} profile_pc_samples_t;
+
 class Profile {
   public:
 
     static void handle_network_stats(uint32_t addr, icmsg_type_t type);
 
     Profile(rigel::GlobalBackingStoreType *Memory, int cluster_id);
+    // Set up the statics shared by every cluster's Profile; call once, on
+    // the main thread, before the tiles are built.
+    static void init();
 
     void start_sim();
     void end_sim();
@@ -850,35 +888,71 @@ static void PRINT_HEADER(const char *name, FILE *out = stderr);
     static NetworkStat global_network_stats;
     // Data particular to the global cache shared by all
     static GlobalCacheStat global_cache_stats;
-    // Track stall time on a per-PC basis
+    // Track stall time on a per-PC basis.  Each cluster's profiler records
+    // its own cores' instructions in per_pc_table as they retire (so clusters
+    // never share a table); accumulate_stats() merges them into per_pc_stats
+    // for the end-of-run dump.
     static std::map< uint32_t, profile_instr_stall_t> per_pc_stats;
-    static void per_pc_stat_add_icache(uint32_t pc, bool l1i_hit, bool l2i_hit) {
-      if (ProfileStat::is_active()) { 
-        per_pc_stats[pc].add_icache(l1i_hit, l2i_hit); 
+    // True when every retirement is recorded per PC, i.e. per-PC profiling
+    // is on and not sampled.
+    static bool per_pc_exact() {
+      return rigel::profiler::CMDLINE_DUMP_PER_PC_STATS
+          && rigel::profiler::PER_PC_SAMPLE_PERIOD == 0;
+    }
+    void per_pc_stat_add_icache(uint32_t pc, bool l1i_hit, bool l2i_hit) {
+      if (per_pc_exact() && ProfileStat::is_active()) { 
+        per_pc_entry(pc).add_icache(l1i_hit, l2i_hit); 
       }
     }
-    static void per_pc_stat_add_dcache(uint32_t pc, bool l1d_hit, bool l2d_hit, bool l3d_hit) {
-      if (ProfileStat::is_active()) { 
-        per_pc_stats[pc].add_mem(l1d_hit, l2d_hit, l3d_hit);
+    void per_pc_stat_add_dcache(uint32_t pc, bool l1d_hit, bool l2d_hit, bool l3d_hit) {
+      if (per_pc_exact() && ProfileStat::is_active()) { 
+        per_pc_entry(pc).add_mem(l1d_hit, l2d_hit, l3d_hit);
       }
     }
-    static void per_pc_stat_add_latency(uint32_t pc, uint32_t latency) {
-      if (ProfileStat::is_active()) { 
-        per_pc_stats[pc].add_latency(latency);
+    void per_pc_stat_add_latency(uint32_t pc, uint32_t latency) {
+      if (per_pc_exact() && ProfileStat::is_active()) { 
+        per_pc_entry(pc).add_latency(latency);
       }
     }
-    static void per_pc_stat_add_stalls(uint32_t pc, InstrCycleStats stalls) {
+    void per_pc_stat_add_stalls(uint32_t pc, const InstrCycleStats &stalls) {
+      if (per_pc_exact() && ProfileStat::is_active()) {
+        per_pc_entry(pc).add_stalls(stalls);
+      }
+    }
+    // Sampled per-PC profile (-per-pc-sample): one count per sample, by where
+    // the sampled instruction was.  Merged like per_pc_stats.
+    static std::map< uint32_t, profile_pc_samples_t> per_pc_samples;
+    void per_pc_sample(uint32_t pc, pc_sample_reason_t reason) {
       if (ProfileStat::is_active()) {
-        per_pc_stats[pc].add_stalls(stalls);
+        per_pc_sample_table.insert(pc).count[reason]++;
       }
     }
     static void accumulate_per_pc_stall_cycles();
-    static void accumulate_stall_cycles(InstrCycleStats ics);
+    static void accumulate_stall_cycles(const InstrCycleStats &ics);
+    // Write per_pc_stats or per_pc_samples as flamegraph folded stacks.
+    static void dump_per_pc_folded();
 
 
   private:
     int cluster_num;
     bool active;
+
+    // This cluster's share of per_pc_stats/per_pc_samples.  All of a
+    // retiring instruction's updates hit the same PC, so the last entry
+    // looked up is kept to skip the hash probe.  The pointer stays valid
+    // because only a lookup of a new PC can grow the table, and that
+    // replaces it.
+    AddrHashMap<profile_instr_stall_t> per_pc_table;
+    uint32_t per_pc_last_pc;
+    profile_instr_stall_t *per_pc_last;
+    AddrHashMap<profile_pc_samples_t> per_pc_sample_table;
+    profile_instr_stall_t & per_pc_entry(uint32_t pc) {
+      if (per_pc_last == NULL || pc != per_pc_last_pc) {
+        per_pc_last = &per_pc_table.insert(pc);
+        per_pc_last_pc = pc;
+      }
+      return *per_pc_last;
+    }
     InstrMix fetch_instr_mix;
     InstrMix retire_instr_mix;
 
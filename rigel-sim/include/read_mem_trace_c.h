@@ -33,6 +33,7 @@ struct extended_info {
 
 struct mem_trace_reader;
 
+// returns NULL if the file cannot be opened
 struct mem_trace_reader* init_trace_reader(const char* filename);
 void destroy_mem_trace_reader(struct mem_trace_reader* mtr);
 // sequential stream read
@@ -53,6 +54,11 @@ int buffer_one_sw_thread(struct mem_trace_reader* mtr, int hw_thread);
 int buffer_a_thread_max(struct mem_trace_reader* mtr, int hw_thread, int max_insts);
 // returns 1 if success
 int get_next_thread_access(struct mem_trace_reader* mtr, int thread, struct extended_info* ei);
+// same, but returns a pointer to the buffered record (NULL if none).  The
+// pointer is valid until the next call that buffers into this thread
+const struct extended_info* next_thread_access(struct mem_trace_reader* mtr, int thread);
+// returns 1 once the whole trace has been read (buffered accesses may remain)
+int trace_reader_eof(struct mem_trace_reader* mtr);
 
 #endif
 
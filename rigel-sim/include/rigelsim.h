@@ -18,6 +18,7 @@
 #include "sim/component_base.h"
 
 #include "util/construction_payload.h"
+#include "util/startup_timer.h"
 #include "rigelsim.pb.h"
 #include "util/syscall.h"
 #include "RandomLib/Random.hpp"
@@ -53,11 +54,12 @@ class RigelSim : ComponentBase {
       cp.component_count = NULL;
       
       // beware of order dependencies between initialization steps
-      init_protobuf(cp); // Initialize protobuf object (possibly from a file), create ChipState
-      setup_dram();      // Initialize parameters for the DRAM.
-      init_memory(cp);   // initialize the main memory model (GDDR, etc)
-      init_sim(cp);      // other simulator initialization steps
-      init_chip(cp);     // initialize the Chip object, holds chip components
+      // (each step is timed for --startup-report)
+      { StartupPhase t("protobuf"); init_protobuf(cp); } // Initialize protobuf object (possibly from a file), create ChipState
+      { StartupPhase t("dram");     setup_dram();      } // Initialize parameters for the DRAM.
+      { StartupPhase t("memory");   init_memory(cp);   } // initialize the main memory model (GDDR, etc)
+      { StartupPhase t("sim");      init_sim(cp);      } // other simulator initialization steps
+      { StartupPhase t("chip");     init_chip(cp);     } // initialize the Chip object, holds chip components
       load_checkpoint(); // optionally, load a checkpoint
       init_shell();
     };
@@ -281,7 +283,8 @@ class RigelSim : ComponentBase {
 
       //Load binary into backing store
       ELFAccess Elf;
-      Elf.LoadELF(_cmdline->get_val((char *)"objfile"), backing_store);
+      Elf.LoadELF(_cmdline->get_val((char *)"objfile"), backing_store,
+                  _cmdline->get_val((char *)"ELF_CACHE_DIR"));
       //Initialize timing model
       memory_timing = new rigel::MemoryTimingType(this, ///< We are the parent object
 					                                        true); ///< We *do* want collision checking
@@ -0,0 +1,154 @@
+////////////////////////////////////////////////////////////////////////////////
+// control_server.h
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Remote control of a running simulation over a Unix domain socket
+//  (--control-socket <path>).
+//
+//  A local client connects to the socket and exchanges one JSON object per
+//  line.  Every request gets exactly one reply, {"ok":true,...} or
+//  {"ok":false,"error":"..."}; when the simulation stops (pause, end of a
+//  step, breakpoint) the server also sends {"event":"stopped",...}.
+//
+//    {"cmd":"status"}                      cycle, state, retired instructions
+//    {"cmd":"pause"}                       stop at once
+//    {"cmd":"continue"}                    run until a breakpoint
+//    {"cmd":"step","cycles":N}             run N cycles (default 1), stop
+//    {"cmd":"break","cycle":C}             stop when CURR_CYCLE reaches C
+//    {"cmd":"break","pc":P[,"thread":T]}   stop after an instruction at P
+//                                          retires (on global thread T only)
+//    {"cmd":"break","addr":A[,"access":X]} stop after the word at A is read
+//                                          ("r"), written ("w") or either
+//                                          ("rw", the default)
+//    {"cmd":"delete","id":I}               remove breakpoint I
+//    {"cmd":"breakpoints"}                 list breakpoints
+//    {"cmd":"hierarchy"}                   printHierarchy() of every root
+//    {"cmd":"dump","component":ID}         that component's Dump() output
+//    {"cmd":"stats","prefix":"..."}        nonzero profiler totals
+//    {"cmd":"exit"}                        end the simulation (ExitSim)
+//
+//  PCs and addresses may be numbers or strings ("0x1000").
+//
+//  Breakpoints are checked where the simulator already makes a decision, so
+//  none costs anything until it is set:
+//
+//    cycle  Tick() compares CURR_CYCLE with the next poll; the poll is
+//           scheduled no later than the earliest cycle breakpoint.
+//    pc     SD_BREAKPOINT in the shared decode table, tested at writeback
+//           with the flags already loaded (the lockstep engine leaves such
+//           PCs to the cores).  The legacy core has no decode table and
+//           looks retired PCs up in pc_breaks, only while it is non-empty.
+//    addr   BackingStore::set_watchpoint(): the word drops out of the
+//           permission regions the store checks on every data access, and
+//           the failed check calls watch_hit().  Which thread made the
+//           access is not known there.
+//
+//  The socket is only looked at every --control-poll cycles, at cycle
+//  breakpoints and after a PC/address breakpoint fires, so a command sent to
+//  a running simulation takes effect at the next poll.  While stopped, the
+//  simulator blocks on the socket; a client may disconnect and another
+//  reconnect.  With --control-wait the simulation stops before cycle 0.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __CONTROL_SERVER_H__
+#define __CONTROL_SERVER_H__
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include "sim.h"
+#include "memory/backing_store_callbacks.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Class: ControlServer
+////////////////////////////////////////////////////////////////////////////////
+class ControlServer : public BSWatchCallbackBase<uint32_t> {
+
+  public:
+    /// Listen on path (an existing socket file there is replaced).  Polls
+    /// every poll_interval cycles; stops before cycle 0 if wait.
+    ControlServer(const std::string &path, uint64_t poll_interval, bool wait);
+    /// Tells the client the simulation ended, closes and unlinks the socket.
+    ~ControlServer();
+
+    /// Called by the main loop at the top of every cycle.
+    void Tick() {
+      if (rigel::CURR_CYCLE >= next_check) {
+        Check();
+      }
+    }
+
+    /// Called by the legacy core for every retired instruction.
+    void Retire(int gtid, uint32_t pc) {
+      if (!pc_breaks.empty() && pc_breaks.count(pc)) {
+        PCHit(gtid, pc);
+      }
+    }
+
+    /// An instruction at a breakpoint PC retired on thread gtid.
+    void PCHit(int gtid, uint32_t pc);
+    /// A watched word was read or written (BSWatchCallbackBase).
+    virtual void watch_hit(uint32_t addr, bool write);
+
+  private:
+    struct Breakpoint {
+      std::string kind;    // "cycle", "pc" or "addr"
+      uint64_t value;      // addr: the word address
+      int thread;          // pc: global thread, -1 for any
+      unsigned int access; // addr: rigel::GlobalBackingStoreType::WATCH_* mask
+      uint64_t hits;
+    };
+
+    /// handle pending connections and commands; block while stopped
+    void Check();
+    /// a PC or address breakpoint fired; stop at the next Tick()
+    void Hit(const std::string &reason);
+    void Stop(const std::string &reason);
+    /// earliest cycle Tick() has to call Check()
+    void Reschedule();
+
+    /// take a waiting connection, if any
+    void Accept();
+    /// read what the client sent; false if it disconnected
+    bool Receive();
+    void Disconnect();
+    /// run every complete line received
+    void Dispatch();
+    void Handle(const std::string &line);
+    void Send(const std::string &json);
+
+    int  AddBreakpoint(const Breakpoint &b);
+    bool DeleteBreakpoint(int id);
+    /// push the union of the addr breakpoints on word to the backing store
+    void UpdateWatch(uint32_t word);
+
+    const std::string path;
+    const uint64_t poll_interval;
+    int listen_fd;
+    int client_fd;
+    std::string inbuf;
+
+    bool running;
+    uint64_t next_check;
+    uint64_t step_until;        // stop at this cycle, 0 if not stepping
+    std::string stop_reason;    // why the next Tick() stops, if set
+
+    int next_id;
+    std::map<int, Breakpoint> breakpoints;
+    std::multiset<uint64_t> cycle_breaks;
+    std::multiset<uint32_t> pc_breaks;
+
+    // No copies.
+    ControlServer(const ControlServer &);
+    ControlServer & operator=(const ControlServer &);
+};
+
+namespace rigel {
+  // Non-NULL iff --control-socket was given.  Created before the chip is
+  // built and deleted at exit, see sim.cpp.
+  extern ControlServer *CONTROL;
+}
+
+#endif //#ifndef __CONTROL_SERVER_H__
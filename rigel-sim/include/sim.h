@@ -35,6 +35,11 @@
 #error You must copy user.config.default to user.config before building
 #endif
 
+// user.config files copied before ARB_L2_POLICY existed use BusArbiter
+#ifndef ARB_L2_POLICY
+#define ARB_L2_POLICY ARB_ROUND_ROBIN
+#endif
+
 //
 // System specific includes
 //
@@ -121,6 +126,8 @@ class GlobalCache;
 extern class GlobalCache ** GLOBAL_CACHE_PTR;
 // Global register file zero tracker
 extern class ZeroTracker * GLOBAL_ZERO_TRACKER_PTR;
+// Line compressibility tracker, NULL unless --track-line-values
+extern class LineValueTracker * GLOBAL_LINE_TRACKER_PTR;
 
 class InstrLegacy;
 namespace rigel {
@@ -173,6 +180,9 @@ namespace rigel {
   extern uint64_t CYC_COUNT_MAX;
   // Incremented every cycle.  (defined in: sim.cpp)
   extern uint64_t CURR_CYCLE;
+  // Instructions retired by every core, profiler on or off; only used to
+  // report host simulation speed (--run-summary).  (defined in cmdline_parse.cpp)
+  extern uint64_t RETIRED_INSTRS_TOTAL;
   // Place holder for memory output filename. (defined in sim.cpp)
   extern char MEM_DUMP_FILE[1024];
   // Path set for dump files. (defined in util.cpp)
@@ -236,6 +246,10 @@ namespace rigel {
   // Could be useful data to motivate a scheme along the lines of "Dynamic Zero Compression for Cache Energy Reduction"
   // by L Villa (K. Asanovic's student).
   extern bool TRACK_BIT_PATTERNS;
+  // Size the lines moved by G$ fills, DRAM reads/writes and cluster cache
+  // writebacks under zero-line, BDI and FPC compression and report the
+  // potential DRAM bandwidth savings (see LineValueTracker).
+  extern bool TRACK_LINE_VALUES;
   // Sparse directory replacement policy
   enum PipelineBypassPaths
   {
@@ -303,11 +317,29 @@ namespace rigel {
   extern bool INIT_REGISTER_FILE;
   // Print the register file to STDERR at exit.
   extern bool DUMP_REGISTER_FILE;
-  // Print the register write trace to a file rf.<corenum>.<threadnum>.trace,
-  // defined in core.cpp
+  // Record register writes to rf.trace.bin (see util/reg_trace.h); the legacy
+  // core still writes rf.<corenum>.<threadnum>.trace directly.
   extern bool DUMP_REGISTER_TRACE;
   // Dump an ELF code image to file in <addr,data> format
   extern bool DUMP_ELF_IMAGE;
+  // Execute functional cores at the same PC as a group (--lockstep, see
+  // core/lockstep_engine.h)
+  extern bool LOCKSTEP_FUNCTIONAL;
+  // Print the component tree and port connections before cycle 0
+  // (--dump-hierarchy)
+  extern bool DUMP_HIERARCHY;
+  // Print host time per startup phase before cycle 0 (--startup-report, see
+  // util/startup_timer.h)
+  extern bool STARTUP_REPORT;
+  // Host threads that build the tiles (--startup-threads, see
+  // sim/build_slot.h)
+  extern int STARTUP_THREADS;
+  // Check every instruction the legacy core retires against the functional
+  // ISA on a host thread (--cosim, see util/cosim_checker.h)
+  extern bool COSIM_CHECK;
+  // Stop before cycle 0 until a control socket client continues
+  // (--control-wait, see shell/control_server.h)
+  extern bool CONTROL_WAIT;
   // Load a checkpoint
   extern bool LOAD_CHECKPOINT;
   // When set, all cores but core zero are halted.  This will put the simulator
@@ -468,6 +500,10 @@ namespace rigel {
     // try again.
     const uint32_t MC_PENDING_WDT = 80000;
     extern bool MONOLITHIC_SCHEDULER;
+    // When no row hit is pending in a bank, start a new row for the request
+    // whose row has the most recent demand, as measured by a per-controller
+    // LocalityTracker over the incoming requests, instead of an arbitrary one.
+    extern bool LOCALITY_AWARE_SCHEDULING;
   }
 }
 
@@ -860,6 +896,13 @@ namespace rigel {
     // Turn on to enable printing of per-pc statistics.  Defined in profile.cpp.
     extern bool CMDLINE_DUMP_PER_PC_STATS;
     const char per_pc_filename[] = "per-pc-profile.out";
+    // Sample the PC and pipeline stage of the oldest instruction in each core
+    // every PER_PC_SAMPLE_PERIOD cycles instead of recording exact per-PC
+    // stalls at retirement.  0 (the default) disables sampling.  Defined in
+    // profile.cpp.
+    extern uint64_t PER_PC_SAMPLE_PERIOD;
+    // Flamegraph folded-stack dump of the per-PC profile.
+    const char per_pc_folded_filename[] = "per-pc-profile.folded";
     // Prefix to prepend to all dump files.  Defined in profile.cpp, set in
     // util.cpp.
     extern std::string DUMPFILE_PREFIX;
@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+// build_slot.h
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Parallel construction of identical component subtrees (--startup-threads).
+//
+//  Every tile is built by the same constructor from the same configuration,
+//  so once tile 0 exists the IDs tile i will be given are known: the global
+//  component ID and each ComponentCount advance by the same amount per tile.
+//  BuildSlot::build() constructs item 0 serially while recording those
+//  amounts, then constructs the other items on host threads, each in a slot
+//  that hands out IDs from its own precomputed range.  Side effects on
+//  shared registries (addChild, port registration, debug lists) go through
+//  BuildSlot::run(), which queues them per slot; the queues are replayed in
+//  item order after the join, so the component tree, every ID and every
+//  registry are the same as after a serial build.  If an item draws from a
+//  counter differently than item 0 did, build() throws ExitSim.
+//
+//  Code reachable from a tile constructor must not modify any other shared
+//  state directly; route it through run() or push_back().
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __BUILD_SLOT_H__
+#define __BUILD_SLOT_H__
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class ComponentBase;
+
+namespace rigel {
+
+  class ComponentCount;
+
+  class BuildSlot {
+
+    public:
+
+      /// constructs item i of a build
+      typedef ComponentBase *(*make_fn_t)(void *ctx, int i);
+      /// a side effect on shared state
+      typedef void (*action_fn_t)(void *a, void *b);
+
+      /// construct out[0..n-1] with make(ctx, i), using up to 'threads' host
+      /// threads; with one thread (or one item) this is a plain serial loop
+      static void build(ComponentBase **out, int n, make_fn_t make, void *ctx,
+                        int threads);
+
+      /// f(a, b), now or, when building on a worker, after the join
+      static void run(action_fn_t f, void *a, void *b);
+
+      /// v.push_back(p) through run()
+      template <class T, class U>
+      static void push_back(std::vector<T *> &v, U *p) {
+        T *elem = p;
+        run(&pushBack<T>, &v, elem);
+      }
+
+      /// true while this host thread is building an item of a parallel build
+      static bool building();
+
+      /// true while this host thread is building an item other than item 0
+      static bool worker();
+
+      /// next value of count for the item being built (see ComponentCount)
+      static int draw(ComponentCount &count);
+
+      /// give c the next global component ID of a worker item
+      static void place(ComponentBase *c);
+
+    private:
+
+      /// first value drawn and number of draws, per counter
+      struct Range {
+        Range() : first(0), draws(0) { }
+        int first;
+        int draws;
+      };
+
+      struct Action {
+        action_fn_t f;
+        void *a;
+        void *b;
+      };
+
+      BuildSlot(int index, const BuildSlot *shape) :
+        index_(index), shape_(shape), first_component_(0), num_components_(0),
+        mismatch_(false)
+      { }
+
+      /// check this worker drew exactly what item 0 did
+      bool sameShape() const;
+
+      static void *workerMain(void *arg);
+
+      template <class T>
+      static void pushBack(void *v, void *p) {
+        static_cast<std::vector<T *> *>(v)->push_back(static_cast<T *>(p));
+      }
+
+      int index_;                   ///< item being built; item 0 records
+      const BuildSlot *shape_;      ///< item 0's slot, NULL while recording
+      uint32_t first_component_;    ///< item 0: first global component ID
+      uint32_t num_components_;     ///< components built (so far)
+      std::map<ComponentCount *, Range> counts_; ///< draws per counter
+      std::vector<Action> deferred_; ///< run() calls to replay after the join
+      bool mismatch_;               ///< drew more than item 0 did
+      std::string error_;           ///< ExitSim reason thrown while building
+
+  };
+
+}
+
+#endif //#ifndef __BUILD_SLOT_H__
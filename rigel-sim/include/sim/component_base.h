@@ -13,6 +13,7 @@ using rigel::ComponentCount;
 extern ComponentCount UnspecifiedCount;
 
 // forward declarations
+namespace rigel { class BuildSlot; }
 
 ////////////////////////////////////////////////////////////////////////////////
 /// class Componentbase
@@ -103,6 +104,12 @@ class ComponentBase {
 
   private:
 
+    /// assigns IDs and replays addChild for parallel tile builds
+    friend class rigel::BuildSlot;
+
+    /// addChild() as a BuildSlot action
+    static void adopt( void* parent, void* child );
+
   // private data members
   private:
 
@@ -1,6 +1,8 @@
 #ifndef __COMPONENT_COUNT_H__
 #define __COMPONENT_COUNT_H__
 
+#include "sim/build_slot.h"
+
 /// could alternately use the CRTP (curiously recurring template pattern) to let objects count
 /// instances for ID assignment
 namespace rigel {
@@ -12,7 +14,11 @@ namespace rigel {
       ComponentCount() : ID_COUNT(0) { }
    
       /// return next ID and increment 
+      /// (a parallel tile build hands out IDs per tile, see sim/build_slot.h)
       int operator()() {
+        if (BuildSlot::building()) {
+          return BuildSlot::draw(*this);
+        }
         return ID_COUNT++;
       }
    
@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+// addr_hash_map.h
+////////////////////////////////////////////////////////////////////////////////
+//
+//  AddrHashMap is an open-addressed (linear probing) hash table keyed by 32-bit
+//  target addresses.  It is meant for hot side tables in the memory model
+//  where std::map/hash_map node allocation and pointer chasing dominate.
+//  Keys and values are stored inline in a single power-of-two array, deletion
+//  uses backward-shift so no tombstones accumulate, and the table doubles when
+//  it passes half full.
+//
+//  V must be copy-assignable.  Pointers/references returned by find() and
+//  insert() are invalidated by any later insert() or erase().
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ADDR_HASH_MAP_H__
+#define __ADDR_HASH_MAP_H__
+
+#include <cassert>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+template <typename V>
+class AddrHashMap
+{
+  public:
+    // 'initial_capacity' is rounded up to a power of two.  'empty_value' is
+    // copied into every newly inserted slot.
+    AddrHashMap(const V &empty_value, size_t initial_capacity = 64) :
+      empty(empty_value), num_used(0)
+    {
+      size_t cap = 8;
+      while (cap < initial_capacity) { cap <<= 1; }
+      alloc(cap);
+    }
+
+    // Return a pointer to the value for 'key', or NULL if it is not present.
+    V * find(uint32_t key)
+    {
+      for (size_t i = home(key); used[i]; i = (i + 1) & mask) {
+        if (keys[i] == key) { return &vals[i]; }
+      }
+      return NULL;
+    }
+    const V * find(uint32_t key) const
+    {
+      return const_cast<AddrHashMap<V> *>(this)->find(key);
+    }
+
+    // Return the value for 'key', inserting a copy of the empty value first
+    // if it is not present.
+    V & insert(uint32_t key)
+    {
+      if ((num_used + 1) * 2 > keys.size()) { grow(); }
+      size_t i = home(key);
+      for (; used[i]; i = (i + 1) & mask) {
+        if (keys[i] == key) { return vals[i]; }
+      }
+      used[i] = true;
+      keys[i] = key;
+      vals[i] = empty;
+      num_used++;
+      return vals[i];
+    }
+
+    // Remove 'key'.  Returns false if it was not present.
+    bool erase(uint32_t key)
+    {
+      size_t i = home(key);
+      for (; used[i]; i = (i + 1) & mask) {
+        if (keys[i] == key) { break; }
+      }
+      if (!used[i]) { return false; }
+      // Backward-shift deletion: pull later members of the probe run into the
+      // hole so that lookups never need tombstones.
+      size_t hole = i;
+      for (size_t j = (i + 1) & mask; used[j]; j = (j + 1) & mask) {
+        const size_t h = home(keys[j]);
+        // Entry at j may move into the hole only if its home slot is not in
+        // the (cyclic) range (hole, j].
+        const bool can_move = (hole <= j) ? (h <= hole || h > j) : (h <= hole && h > j);
+        if (can_move) {
+          keys[hole] = keys[j];
+          vals[hole] = vals[j];
+          hole = j;
+        }
+      }
+      used[hole] = false;
+      num_used--;
+      return true;
+    }
+
+    // Size the table for 'n' keys without growing.  Existing entries are
+    // kept; never shrinks.
+    void reserve(size_t n)
+    {
+      size_t cap = keys.size();
+      while (n * 2 > cap) { cap <<= 1; }
+      if (cap != keys.size()) { rehash(cap); }
+    }
+
+    void clear()
+    {
+      for (size_t i = 0; i < used.size(); i++) { used[i] = false; }
+      num_used = 0;
+    }
+
+    size_t size() const { return num_used; }
+
+    // Slot-level iteration for dumps and end-of-run statistics.
+    size_t capacity() const { return keys.size(); }
+    bool slot_used(size_t i) const { return used[i]; }
+    uint32_t slot_key(size_t i) const { return keys[i]; }
+    V & slot_value(size_t i) { return vals[i]; }
+    const V & slot_value(size_t i) const { return vals[i]; }
+
+  private:
+    size_t home(uint32_t key) const
+    {
+      // Fibonacci hashing.  Line-aligned addresses have zero low bits, so take
+      // the high bits of the product.
+      return (size_t)((key * UINT32_C(2654435769)) >> shift) & mask;
+    }
+
+    void alloc(size_t cap)
+    {
+      keys.assign(cap, 0);
+      vals.assign(cap, empty);
+      used.assign(cap, false);
+      mask = cap - 1;
+      shift = 32;
+      while (((size_t)1 << (32 - shift)) < cap) { shift--; }
+    }
+
+    void grow() { rehash(keys.size() * 2); }
+
+    void rehash(size_t cap)
+    {
+      std::vector<uint32_t> old_keys;
+      std::vector<V> old_vals;
+      std::vector<bool> old_used;
+      old_keys.swap(keys);
+      old_vals.swap(vals);
+      old_used.swap(used);
+      alloc(cap);
+      num_used = 0;
+      for (size_t i = 0; i < old_keys.size(); i++) {
+        if (old_used[i]) { insert(old_keys[i]) = old_vals[i]; }
+      }
+    }
+
+    const V empty;
+    std::vector<uint32_t> keys;
+    std::vector<V> vals;
+    std::vector<bool> used;
+    size_t num_used;
+    size_t mask;
+    unsigned int shift;
+};
+
+#endif //#ifndef __ADDR_HASH_MAP_H__
@@ -8,6 +8,7 @@ class ComponentBase; //FIXME Relocate ComponentBase to rigel namespace
 class BroadcastManager;
 class TileInterconnectBase;
 class Syscall;
+class LockstepEngine;
 
 namespace rigelsim {
   class MemoryState;
@@ -57,6 +58,7 @@ namespace rigel {
         TileInterconnectBase *tile_network;
         BroadcastManager *broadcast_manager;
         Syscall *syscall;
+        LockstepEngine *lockstep; // NULL unless --lockstep (set by ChipTiled)
 
         //Protocol buffer object pointers
         rigelsim::MemoryState *memory_state;
@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////
+// cosim_checker.h
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Golden-model co-simulation of the legacy core (--cosim).
+//
+//  WriteBackStage reports every retired instruction: its PC and instruction
+//  word, the architectural values of its source registers just before it
+//  commits, the register it writes and the value written, and its effective
+//  address.  A checker thread replays each hardware thread's retirement
+//  stream through the functional ISA (isa/rigel_isa.h) against a shadow copy
+//  of that thread's PC and register file, and stops at the first instruction
+//  where the detailed core disagrees with it:
+//
+//    - the PC does not follow from the previous instruction (branch outcome,
+//      branch target or a lost/duplicated retirement),
+//    - a source register holds a value the shadow did not expect (a write to
+//      the wrong register, or a write that never committed),
+//    - the destination value differs (ALU, shift, compare, FPU, link), or
+//    - a load or store address, or the data stored, differs.
+//
+//  Loaded and atomic values come from the stream, since the checker has no
+//  memory of its own.  Instructions the functional ISA does not model
+//  (special registers, task queue, vector and accumulator operations,
+//  syscalls, ...) are not checked: the shadow adopts their results and
+//  relearns any register they may have clobbered from later source values.
+//
+//  The stream is buffered like the register trace (util/reg_trace.h): each
+//  hardware thread fills a private buffer with no locking, and full buffers
+//  are handed to the checker.  A divergence is reported (to stderr) and ends
+//  the simulation at the next handoff, so the simulator may run at most a
+//  buffer past the offending instruction; the report names the instruction
+//  itself.  The detailed core must commit in order (no -nbl).
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __COSIM_CHECKER_H__
+#define __COSIM_CHECKER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include "instr/decode_table.h"
+
+class InstrLegacy;
+class RegisterFileLegacy;
+
+/// one retired instruction as seen by the detailed core
+struct CosimRecord {
+  uint64_t cycle;
+  uint32_t gtid;
+  uint32_t pc;
+  uint32_t raw;
+  uint32_t ea;                          // effective address, memory ops
+  uint32_t store_value;                 // data written by a store
+  uint32_t src[NUM_ISA_OPERAND_REGS];   // source values before commit
+  uint32_t dest_reg;                    // simconst::NULL_REG if none
+  uint32_t dest_value;                  // value committed to dest_reg
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Class: CosimChecker
+////////////////////////////////////////////////////////////////////////////////
+class CosimChecker {
+
+  public:
+    // Records per thread buffer.  Kept small so a divergence stops the
+    // simulation soon after it retires.
+    static const size_t BUFFER_RECORDS = 256;
+    // Full buffers allowed in flight before producers wait on the checker.
+    static const size_t MAX_PENDING = 1024;
+    // Retired instructions kept per thread for the divergence report.
+    static const size_t HISTORY = 8;
+
+    CosimChecker(int threads_total, int threads_per_core);
+    // Checks all partial buffers, joins the checker thread and prints the
+    // divergence report or a summary.
+    ~CosimChecker();
+
+    // Called by WriteBackStage around writeback() of a retiring instruction:
+    // Begin() reads its source registers from rf before it commits, Commit()
+    // reads its destination after.  Commit() throws ExitSim once the checker
+    // has found a divergence.
+    void Begin(InstrLegacy *instr, RegisterFileLegacy *rf);
+    void Commit(InstrLegacy *instr, RegisterFileLegacy *rf);
+
+  private:
+    struct ThreadBuffer {
+      CosimRecord *recs;
+      size_t count;
+    };
+
+    // checker-side state for one hardware thread
+    struct Shadow {
+      bool     started;
+      bool     pc_known;     // next_pc is meaningful
+      uint32_t next_pc;
+      uint32_t known;        // registers whose value the shadow is sure of
+      uint32_t rf[rigel::NUM_REGS];
+      uint32_t writer[rigel::NUM_REGS]; // PC of the last write, for reports
+      CosimRecord history[HISTORY];
+      uint64_t retired;
+    };
+
+    void Submit(ThreadBuffer &b);
+    static void *CheckerMain(void *arg);
+    void CheckerLoop();
+    // replay one record; false (with report filled in) on a divergence
+    bool Check(const CosimRecord &r);
+    void Diverge(const CosimRecord &r, const std::string &what);
+
+    int threads_per_core;
+    std::vector<ThreadBuffer> buffers;
+    DecodeTable decode;          // producer (simulator thread) side
+
+    // Checker thread only.
+    DecodeTable check_decode;
+    std::vector<Shadow> shadows;
+    uint64_t checked;            // instructions replayed through the ISA
+    uint64_t adopted;            // instructions taken from the stream
+
+    // Shared with the checker thread, protected by lock.
+    pthread_t       checker;
+    pthread_mutex_t lock;
+    pthread_cond_t  work_ready;
+    pthread_cond_t  work_done;
+    std::deque<ThreadBuffer>   pending;
+    std::vector<CosimRecord *> free_bufs;
+    bool done;
+    bool diverged;
+    bool reported;
+    std::string report;
+
+    // No copies.
+    CosimChecker(const CosimChecker &);
+    CosimChecker & operator=(const CosimChecker &);
+};
+
+namespace rigel {
+  // Non-NULL iff --cosim was given.  Created before the chip is built and
+  // deleted at exit, see sim.cpp.
+  extern CosimChecker *COSIM;
+}
+
+#endif //#ifndef __COSIM_CHECKER_H__
@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+// fixed_bitset.h
+////////////////////////////////////////////////////////////////////////////////
+//
+//  FixedBitset is a drop-in replacement for DynamicBitset for hot structures
+//  that are replicated many times (e.g., one per directory entry).  Storage is
+//  inline and bounded at compile time by MAX_BITS, but the logical size is set
+//  at runtime (typically rigel::NUM_CLUSTERS) and only the words covering the
+//  logical size are ever walked.  No heap allocation occurs, so copies are a
+//  memcpy and arrays of objects containing a FixedBitset stay dense.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __FIXED_BITSET_H__
+#define __FIXED_BITSET_H__
+
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <stddef.h>
+#include <stdint.h>
+#include "rigellib.h" // for __MAX_NUM_CLUSTERS
+
+template <size_t MAX_BITS>
+class FixedBitset
+{
+  public:
+    static const size_t MAX_WORDS = (MAX_BITS + 63) / 64;
+
+    FixedBitset(size_t numBits) : size(numBits), numWords((numBits + 63) / 64)
+    {
+      assert(numBits <= MAX_BITS && "FixedBitset is too small for requested size");
+      memset(data, 0, sizeof(data));
+    }
+
+    //Small bitsets can print in binary, otherwise in hex.  Output format
+    //matches DynamicBitset so that traces do not change.
+    void print(FILE *stream, bool alwaysInHex = false) const
+    {
+      if (size == 0) { return; }
+      if(size <= 64 && !alwaysInHex)
+      {
+        for (size_t i = size; i-- > 0; ) { fprintf(stream, "%s", (test(i) ? "1" : "0")); }
+      }
+      else
+      {
+        fprintf(stream, "0x");
+        for (size_t nib = (size + 3) / 4; nib-- > 0; ) {
+          unsigned int digit = (unsigned int)((data[(nib*4) / 64] >> ((nib*4) % 64)) & 0xF);
+          fprintf(stream, "%01x", digit);
+        }
+      }
+    }
+
+    void clearAll() { memset(data, 0, numWords * sizeof(uint64_t)); }
+    void setAll()
+    {
+      memset(data, 0xFF, numWords * sizeof(uint64_t));
+      maskLastWord();
+    }
+    void clear(const size_t pos) { assert(pos < size); data[pos / 64] &= ~(UINT64_C(1) << (pos % 64)); }
+    void set(const size_t pos) { assert(pos < size); data[pos / 64] |= (UINT64_C(1) << (pos % 64)); }
+    void toggle(const size_t pos) { assert(pos < size); data[pos / 64] ^= (UINT64_C(1) << (pos % 64)); }
+    bool test(const size_t pos) const
+    {
+      assert(pos < size);
+      return ((data[pos / 64] >> (pos % 64)) & 1) != 0;
+    }
+
+    bool allClear() const
+    {
+      for (size_t i = 0; i < numWords; i++) { if (data[i] != 0) { return false; } }
+      return true;
+    }
+    bool allSet() const { return getNumSetBits() == size; }
+
+    size_t getNumSetBits() const
+    {
+      size_t count = 0;
+      for (size_t i = 0; i < numWords; i++) { count += __builtin_popcountll(data[i]); }
+      return count;
+    }
+    size_t getNumClearBits() const { return size - getNumSetBits(); }
+    size_t getSize() const { return size; }
+
+    int findFirstSet() const { return findSetFromWord(0, ~UINT64_C(0)); }
+
+    // Return the first set bit strictly after lastSet, or -1 if there is none.
+    int findNextSet(size_t lastSet) const
+    {
+      const size_t pos = lastSet + 1;
+      if (pos >= size) { return -1; }
+      return findSetFromWord(pos / 64, ~UINT64_C(0) << (pos % 64));
+    }
+
+    int findNextSetInclusive(size_t lastSet) const
+    {
+      if (lastSet >= size) { return -1; }
+      return findSetFromWord(lastSet / 64, ~UINT64_C(0) << (lastSet % 64));
+    }
+
+    // In-place set operations.  Both operands must have the same logical size.
+    FixedBitset & operator|=(const FixedBitset &other)
+    {
+      for (size_t i = 0; i < numWords; i++) { data[i] |= other.data[i]; }
+      return *this;
+    }
+    FixedBitset & operator&=(const FixedBitset &other)
+    {
+      for (size_t i = 0; i < numWords; i++) { data[i] &= other.data[i]; }
+      return *this;
+    }
+    bool operator==(const FixedBitset &other) const
+    {
+      return (size == other.size) && (0 == memcmp(data, other.data, numWords * sizeof(uint64_t)));
+    }
+    bool operator!=(const FixedBitset &other) const { return !(*this == other); }
+
+  private:
+    // Search for a set bit starting at word 'w', with bits of that first word
+    // filtered through 'firstMask'.
+    int findSetFromWord(size_t w, uint64_t firstMask) const
+    {
+      if (w >= numWords) { return -1; }
+      uint64_t word = data[w] & firstMask;
+      while (word == 0) {
+        if (++w >= numWords) { return -1; }
+        word = data[w];
+      }
+      // Bits past 'size' are never set, so no range check is needed.
+      return (int)(w * 64 + __builtin_ctzll(word));
+    }
+
+    void maskLastWord()
+    {
+      if ((size % 64) != 0) { data[numWords - 1] &= (UINT64_C(1) << (size % 64)) - 1; }
+    }
+
+    uint64_t data[MAX_WORDS];
+    uint32_t size;
+    uint32_t numWords;
+};
+
+// Bitset with one bit per cluster.  Sized at runtime with rigel::NUM_CLUSTERS.
+typedef FixedBitset<__MAX_NUM_CLUSTERS> ClusterBitset;
+
+#endif //#ifndef __FIXED_BITSET_H__
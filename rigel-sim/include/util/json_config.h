@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+// json_config.h
+////////////////////////////////////////////////////////////////////////////////
+//
+//  JSON configuration files (--config, --sweep).
+//
+//  A configuration is a JSON object whose members are command-line flags,
+//  spelled exactly as on the command line:
+//
+//    {
+//      "-t": 2,
+//      "-c": 4,
+//      "--elf-cache": "/tmp/elfcache",
+//      "-regfile-trace-dump": true,
+//      "-targetargs": [2, "input.dat", "-v"]
+//    }
+//
+//  Each member becomes command-line tokens: a bare flag for true, nothing
+//  for false or null, the flag and its value for a number or string, and the
+//  flag followed by every element for an array (for flags that take several
+//  values).  Tokens are produced in member order, so the same file always
+//  gives the same command line.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __JSON_CONFIG_H__
+#define __JSON_CONFIG_H__
+
+#include <string>
+#include <vector>
+#include "rapidjson/document.h"
+
+namespace rigel {
+namespace config {
+
+  // Read and parse the JSON file at path into doc.  On failure, returns false
+  // with a message naming the file (and byte offset of a syntax error) in err.
+  bool LoadJSONFile(const std::string &path, rapidjson::Document &doc,
+                    std::string &err);
+
+  // Append the command-line tokens for an object of flags (see above) to
+  // tokens.  Returns false with a message in err for a non-object or a value
+  // that has no command-line spelling (e.g. a nested object).
+  bool FlagsToTokens(const rapidjson::Value &flags,
+                     std::vector<std::string> &tokens, std::string &err);
+
+  // Append the tokens for a single flag with value v, as above.
+  bool FlagToTokens(const std::string &flag, const rapidjson::Value &v,
+                    std::vector<std::string> &tokens, std::string &err);
+
+  // Command-line spelling of a number or string value; false for any other
+  // type.
+  bool ScalarToToken(const rapidjson::Value &v, std::string &token);
+
+} // end namespace config
+} // end namespace rigel
+
+#endif
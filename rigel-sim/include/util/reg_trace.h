@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+// reg_trace.h
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Binary register-write trace (-regfile-trace-dump).
+//
+//  All hardware threads append fixed-size records to one per-run file,
+//  rf.trace.bin in the dump directory.  Each thread fills a private buffer;
+//  full buffers are handed to a writer thread so the simulator never blocks
+//  on file I/O in the common case.  Records for one thread appear in program
+//  order, but records of different threads are interleaved in buffer-sized
+//  chunks.  The rftrace tool splits the file back into the old per-thread
+//  rf.<core>.<thread>.trace text files.
+//
+//  The file format is a RegTraceFileHeader followed by RegTraceRecords, both
+//  in host byte order.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __REG_TRACE_H__
+#define __REG_TRACE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+namespace rigel {
+namespace regtrace {
+  static const char     MAGIC[8]     = { 'R','G','L','R','F','T','R','C' };
+  static const uint32_t VERSION      = 1;
+  // Set in RegTraceRecord::reg for SPRF writes.
+  static const uint32_t SPRF_FLAG    = 0x80000000U;
+}
+}
+
+struct RegTraceFileHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t record_size;       // sizeof(RegTraceRecord), checked by readers
+  uint32_t threads_per_core;  // to map gtid back to <core>.<thread>
+  uint32_t threads_total;
+};
+
+struct RegTraceRecord {
+  uint64_t cycle;
+  uint32_t gtid;
+  uint32_t pc;
+  uint32_t reg;    // register number, | SPRF_FLAG for special-purpose regs
+  uint32_t value;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Class: RegTraceWriter
+////////////////////////////////////////////////////////////////////////////////
+class RegTraceWriter {
+
+  public:
+    // Records per thread buffer.  24B records, so 48KB per hardware thread.
+    static const size_t BUFFER_RECORDS = 2048;
+    // Full buffers allowed in flight before producers wait on the writer.
+    static const size_t MAX_PENDING = 256;
+
+    RegTraceWriter(const std::string &filename, int threads_total,
+                   int threads_per_core);
+    // Flushes all partial buffers and joins the writer thread.
+    ~RegTraceWriter();
+
+    void Append(int gtid, uint64_t cycle, uint32_t pc, uint32_t reg,
+                uint32_t value)
+    {
+      ThreadBuffer &b = buffers[gtid];
+      RegTraceRecord &r = b.recs[b.count];
+      r.cycle = cycle;
+      r.gtid  = gtid;
+      r.pc    = pc;
+      r.reg   = reg;
+      r.value = value;
+      if (++b.count == BUFFER_RECORDS) { Submit(b); }
+    }
+
+  private:
+    struct ThreadBuffer {
+      RegTraceRecord *recs;
+      size_t count;
+    };
+
+    void Submit(ThreadBuffer &b);
+    static void *WriterMain(void *arg);
+    void WriterLoop();
+
+    FILE *out;
+    std::vector<ThreadBuffer> buffers;
+
+    // Shared with the writer thread, protected by lock.
+    pthread_t       writer;
+    pthread_mutex_t lock;
+    pthread_cond_t  work_ready;
+    pthread_cond_t  work_done;
+    std::deque<ThreadBuffer>      pending;
+    std::vector<RegTraceRecord *> free_bufs;
+    bool done;
+
+    // No copies.
+    RegTraceWriter(const RegTraceWriter &);
+    RegTraceWriter & operator=(const RegTraceWriter &);
+};
+
+namespace rigel {
+  // Non-NULL iff -regfile-trace-dump was given.  Created before the chip is
+  // built and deleted (flushed) at exit, see sim.cpp.
+  extern RegTraceWriter *REG_TRACE;
+}
+
+#endif //#ifndef __REG_TRACE_H__
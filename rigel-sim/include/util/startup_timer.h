@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////////
+// startup_timer.h
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Host time spent building the simulator, by phase (--startup-report).
+//
+//  A StartupPhase times the scope it lives in.  Phases nest: a phase
+//  started while another is open is reported indented under it, and its
+//  time is included in its parent's.  Recording costs one gettimeofday()
+//  per phase boundary, so phases are always recorded; the report is only
+//  printed (to stderr, before cycle 0) when --startup-report is given:
+//
+//    startup: 3.412 s before cycle 0
+//      setup                           0.201 s   5.9%
+//      RigelSim                        3.105 s  91.0%
+//        memory                        0.052 s   1.5%
+//        chip                          2.990 s  87.6%
+//          tiles                       2.981 s  87.4%
+//      ...
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __STARTUP_TIMER_H__
+#define __STARTUP_TIMER_H__
+
+#include <cstdio>
+
+namespace rigel {
+namespace startup {
+
+  /// open a phase; phases must be closed in reverse order
+  void begin(const char *name);
+  /// close the innermost open phase
+  void end();
+  /// print every closed phase
+  void report(FILE *out);
+
+} // namespace startup
+} // namespace rigel
+
+/// times the enclosing scope as a startup phase
+class StartupPhase {
+  public:
+    explicit StartupPhase(const char *name) { rigel::startup::begin(name); }
+    ~StartupPhase() { rigel::startup::end(); }
+  private:
+    StartupPhase(const StartupPhase &);
+    StartupPhase &operator=(const StartupPhase &);
+};
+
+#endif
@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////////////////
+// sweep.h
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Parameter sweeps (--sweep <sweep.json>).
+//
+//  The simulator parses the command line and reads the target binary once,
+//  then forks a child per parameter point.  Each child re-parses the base
+//  command line with the point's flags added and runs one simulation; the
+//  binary's bytes are shared copy-on-write with the parent instead of being
+//  read again.  A sweep file looks like:
+//
+//    {
+//      "output": "SWEEP_OUTPUT",      // results directory (default shown)
+//      "jobs": 4,                     // points run at once (default 1)
+//      "base": { "-no-stats-dump": true },
+//      "points": [ { "-t": 1 }, { "-t": 2, "-c": 2 } ],
+//      "axes": { "-mem-sched-policy": ["single", "perbank"],
+//                "--row-cache": [1, 4] }
+//    }
+//
+//  Flags are written as in a --config file (see util/json_config.h).  "base"
+//  applies to every point.  The points are every entry of "points" combined
+//  with every combination of "axes" values (first axis slowest), so the
+//  example runs 2 x 2 x 2 = 8 simulations; either may be left out.
+//
+//  Point N runs with -dumpfile-path <output>/pNNNN, where its stdout and
+//  stderr also go (sim.log).  As each point finishes, one JSON line is
+//  appended to <output>/results.jsonl:
+//
+//    {"point": 3, "args": [...], "status": 0, "exit_reason": "...",
+//     "cycles": 123456, "seconds": 12.5}
+//
+//  "args" are the flags the point added to the base command line.
+//  "exit_reason" and "cycles" are null if the simulation did not finish
+//  normally; "status" is the exit status, or -N if killed by signal N.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SWEEP_H__
+#define __SWEEP_H__
+
+#include <stdint.h>
+#include <string>
+
+class CommandLineArgs;
+
+// Outcome of one simulation, reported by the child to the sweep runner.
+struct SweepResult {
+  SweepResult() : finished(false), cycles(0) { }
+
+  bool finished;            // reached the end of simulation (caught ExitSim)
+  uint64_t cycles;
+  std::string exit_reason;
+};
+
+// Runs one simulation from a parsed command line and returns its exit status.
+// argc/argv are the equivalent command line, for the stats dump.
+typedef int (*SweepPointFn)(CommandLineArgs &cmdline, int argc, char *argv[],
+                            SweepResult &result);
+
+namespace rigel {
+  // Run every point of base's --sweep file through run_point, each in a
+  // forked child.  Returns 0 if every point exited with status 0, 1 otherwise.
+  // Exits on a malformed sweep file before anything is run.
+  int RunSweep(CommandLineArgs &base, const char *argv0,
+               SweepPointFn run_point);
+}
+
+#endif
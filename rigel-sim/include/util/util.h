@@ -14,6 +14,7 @@
 #include <cstdlib>
 #include <cassert>
 #include <string>
+#include <vector>
 
 //Use e.g. "STRINGIZE(__LINE__)" to emit the current line as a string literal
 #define STRINGIZE(x) STRINGIZE2(x)
@@ -159,6 +160,7 @@ class CommandLineArgs
 		static std::string exec_name;
 		CommandLineArgs();
 		CommandLineArgs(int argc, char * argv[]);
+		CommandLineArgs(const std::vector<std::string> &tokens);
 
 		bool get_val_bool(char *s);
 		int get_val_int(char *s);
@@ -166,6 +168,10 @@ class CommandLineArgs
 
 		static void print_help();
 
+		// The command line as parsed: -argfile read in and --config files
+		// expanded, without the program name.
+		const std::vector<std::string> & args() const { return arg_tokens; }
+
 
 		class CommandLineError {
 			public:
@@ -183,7 +189,14 @@ class CommandLineArgs
 
   //private data members
 	private:
+		void parse(const std::vector<std::string> &tokens);
+		void expand_configs(const std::vector<std::string> &tokens,
+		                    std::vector<std::string> &out, int depth);
+
+		static const int MAX_CONFIG_DEPTH = 8;
+
 		std::map<std::string, std::string> cmdline_table;
+		std::vector<std::string> arg_tokens;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -193,9 +206,24 @@ class CommandLineArgs
 // Used for loading the binary Elf file into the simulator.
 //
 ////////////////////////////////////////////////////////////////////////////////
+// A function symbol from a target binary.
+struct ELFSymbol {
+  uint32_t addr;
+  uint32_t size;
+  std::string name;
+};
+
 class ELFAccess {
 	public:
-		void LoadELF(std::string bin_name, rigel::GlobalBackingStoreType *mem);
+		void LoadELF(std::string bin_name, rigel::GlobalBackingStoreType *mem,
+		             const std::string &cache_dir = std::string());
+		// Read a binary into host memory ahead of LoadELF() (see elf_loader.cpp).
+		static void Preload(const std::string &bin_name);
+		// The function symbols of a binary, sorted by address, with sizes
+		// filled in up to the next function where the symbol table has none.
+		// Returns false (and no symbols) if the file cannot be read.
+		static bool ReadFunctionSymbols(const std::string &bin_name,
+		                                std::vector<ELFSymbol> &syms);
 
 };
 
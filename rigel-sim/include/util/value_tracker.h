@@ -56,6 +56,56 @@ class ZeroTracker : public ValueTracker {
     size_t numReads;
     size_t numWrites;
 };
+
+////////////////////////////////////////////////////////////////////////////////
+// LineValueTracker
+////////////////////////////////////////////////////////////////////////////////
+// Compressibility of the 32-byte lines moved by the memory system
+// (--track-line-values), to evaluate link and DRAM compression in one run.
+// Each line is read from the backing store as it moves and sized under
+//   - zero-line: all zero, 1 byte
+//   - base-delta-immediate (Pekhimenko et al., PACT'12): repeated 8-byte
+//     value (8 bytes), or 8/4/2-byte elements stored as 1/2/4-byte deltas
+//     from one base or from zero (B8D1 12, B8D2 16, B8D4 24, B4D1 12,
+//     B4D2 20, B2D1 18 bytes), whichever is smallest
+//   - frequent-pattern compression (Alameldeen and Wood, 2004): a 3-bit
+//     prefix per word plus 0-32 data bits, zero words coded as runs
+// Uncompressible lines cost the full 32 bytes.  The checks are fixed-length,
+// branch-free loops over the line so the compiler vectorizes them.
+class LineValueTracker {
+  public:
+    const static size_t LINE_BYTES = 32;
+    const static size_t LINE_WORDS = LINE_BYTES / 4;
+
+    // where a line was seen moving
+    enum source_t {
+      GCACHE_FILL,      // G$ fill from memory
+      DRAM_READ,        // line read from DRAM
+      DRAM_WRITE,       // line written to DRAM
+      CCACHE_WRITEBACK, // dirty cluster cache eviction to the G$
+      NUM_SOURCES
+    };
+
+    LineValueTracker() { reset(); }
+    // analyze the line containing addr as it is in the backing store now
+    void addLine(source_t src, uint32_t addr);
+    // analyze the LINE_WORDS words of one line
+    void addLine(source_t src, const uint32_t *words);
+    void report(std::ostream &str);
+    void reset();
+
+  private:
+    struct LineStats {
+      uint64_t lines;
+      uint64_t zeroLines;
+      uint64_t bdiLines;  // lines BDI compresses
+      uint64_t fpcLines;  // lines FPC compresses
+      uint64_t bdiBytes;  // total size under each scheme
+      uint64_t fpcBytes;
+      uint64_t bestBytes; // smaller of BDI and FPC, per line
+    };
+    LineStats stats[NUM_SOURCES];
+};
     
 
 #endif //#ifndef __VALUE_TRACKER_H__
@@ -13,7 +13,6 @@
 #include <cstdio>                      // for fprintf, stderr
 #include <iostream>                     // for operator<<, basic_ostream, etc
 #include <string>                       // for char_traits
-#include <vector>                       // for vector, vector<>::iterator
 #include "broadcast_manager.h"          // for BroadcastOp, etc
 #include "define.h"                     // for DEBUG_HEADER
 #include "sim.h"                        // for LINE_MASK, NUM_CLUSTERS, etc
@@ -21,22 +20,26 @@
 
 /// Constructor
 /// Structure for holding broadcast operation info - cacheline address and cluster num
-BroadcastOp::BroadcastOp(uint32_t address, uint32_t newval, int whichCluster) 
+BroadcastOp::BroadcastOp() :
+  addr(0),
+  seen(rigel::NUM_CLUSTERS),
+  updated(rigel::NUM_CLUSTERS),
+  newVal(0),
+  numSeen(0),
+  cluster(-1)
+{
+}
+
+BroadcastOp::BroadcastOp(uint32_t address, uint32_t newval, int whichCluster) :
+  addr(address),
+  seen(rigel::NUM_CLUSTERS),
+  updated(rigel::NUM_CLUSTERS),
+  newVal(newval),
+  numSeen(0),
+  cluster(whichCluster)
 {
-  for(int i = 0; i < rigel::NUM_CLUSTERS; i++) { 
-    seen[i] = 0; 
-  }
-  // Debug state is now 0xCC since none of these seen[i] values should ever be
-  // touched
-  for (int i = rigel::NUM_CLUSTERS; i < rigel::MAX_CLUSTERS; i++) {
-    seen[i] = 0xCC;
-  }
   // The cluster that does the broadcast sees the update immediately.
-  seen[whichCluster] = 0xFE;    
-  numSeen = 0;
-  newVal = newval;
-  addr = address;
-  cluster = whichCluster;
+  updated.set(whichCluster);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -59,22 +62,20 @@ BroadcastOp::BroadcastOp(uint32_t address, uint32_t newval, int whichCluster)
 uint32_t 
 BroadcastManager::getData(uint32_t address, int whichCluster) 
 {
-  std::vector<BroadcastOp>::iterator it;
-  for(it = ops.begin(); it != ops.end(); it++) {
-    if(it->addr == address) {
-      // If the requesting cluster has already gotten the invalidate/update
-      // message or the requesting cluster was the one that triggered the
-      // initial broadcast, return the new data.
-      if(it->seen[whichCluster] != 0) { return it->newVal; }
-      // Otherwise, return the old data still present in memory.
-      else {
-        return backing_store.read_data_word(address);
-      }
+  BroadcastOp *op = findOp(address);
+  if (op != NULL) {
+    // If the requesting cluster has already gotten the invalidate/update
+    // message or the requesting cluster was the one that triggered the
+    // initial broadcast, return the new data.
+    if (op->updated.test(whichCluster)) { return op->newVal; }
+    // Otherwise, return the old data still present in memory.
+    else {
+      return backing_store.read_data_word(address);
     }
   }
   // Any call to getData() should be to a line that is presently being handled
-  // by a broad cast. If the search through ops doesnot return a value,
-  // something went awry.
+  // by a broad cast. If the lookup does not return a value, something went
+  // awry.
   DEBUG_HEADER();
   std::cerr << "Error!  Cluster " << whichCluster << " wants data from a BCAST";
         std::cerr << "which doesn't exist at address 0x" << std::hex << address << "\n";
@@ -95,8 +96,6 @@ BroadcastManager::getData(uint32_t address, int whichCluster)
 void 
 BroadcastManager::ack(uint32_t addr, int whichCluster)  {
   uint32_t line_addr = addr & rigel::cache::LINE_MASK;
-  std::vector<BroadcastOp>::iterator it;
-  bool found = false;
 
   // Sanity check
   if (whichCluster >= rigel::NUM_CLUSTERS) {
@@ -105,43 +104,32 @@ BroadcastManager::ack(uint32_t addr, int whichCluster)  {
     assert(0);
   }
 
-  for(it = ops.begin(); it != ops.end(); it++)
-  {
-    if((it->addr & rigel::cache::LINE_MASK) == line_addr)
-    {
-      // The seen[] array is initialized to zero for all clusters that need
-      // to be updated.  The one that issued the broadcast has already seen
-      // the update and has seen[] set to 0xFE.
-      if (it->seen[whichCluster] == 0) { 
-        it->seen[whichCluster] = 0xFF;
-        (it->numSeen)++;
-      } else if (it->seen[whichCluster] == 0xFE) {
-        // This is the cluster that triggered the BCAST to begin with.
-        it->seen[whichCluster] = 0xFF;
-        (it->numSeen)++;
-      } else {
-        std::cerr << "Error!  Cluster " << whichCluster << " already saw BCAST at address 0x" 
-              << std::hex << addr << "\n";
-        assert(0 && "BCAST seen multiple times by same cluster");
-      }
-      //printf("%d clusters have ACKED bcast at 0x%x (cluster
-      //%d)\n",it->numSeen, it->addr,whichCluster);
-      if(it->isDone()) //Update the memory model, take it out of the vector
-      {
-        //printf("bcast at 0x%x is done\n",it->addr);
-        backing_store.write_word(it->addr, it->newVal);
-        it = ops.erase(it);
-      }
-
-      found = true;
-      break;
-    }
-  }
-  if(!found)
+  BroadcastOp *op = ops.find(line_addr);
+  if (op == NULL)
   {
     std::cerr << "Error!  Cluster " << whichCluster << " said it saw a BCAST "
          << "which doesn't exist at address 0x" << std::hex << addr << "\n";
     assert(0 && "Cluster saw the ghost of a BCAST");
+    return;
+  }
+
+  // Every cluster, including the one that triggered the BCAST, ACKs exactly
+  // once.
+  if (op->seen.test(whichCluster)) {
+    std::cerr << "Error!  Cluster " << whichCluster << " already saw BCAST at address 0x" 
+          << std::hex << addr << "\n";
+    assert(0 && "BCAST seen multiple times by same cluster");
+  }
+  op->seen.set(whichCluster);
+  op->updated.set(whichCluster);
+  (op->numSeen)++;
+  //printf("%d clusters have ACKED bcast at 0x%x (cluster
+  //%d)\n",op->numSeen, op->addr,whichCluster);
+  if(op->isDone()) //Update the memory model, take it out of the index
+  {
+    //printf("bcast at 0x%x is done\n",op->addr);
+    backing_store.write_word(op->addr, op->newVal);
+    ops.erase(line_addr);
   }
   return;
 }
@@ -162,16 +150,16 @@ BroadcastManager::ack(uint32_t addr, int whichCluster)  {
 void 
 BroadcastManager::insertBroadcast(uint32_t address, uint32_t newData, int whichCluster)
 {
-  std::vector<BroadcastOp>::iterator it;
-  if(isBroadcastOutstanding(address, it)) {
+  uint32_t line_addr = address & rigel::cache::LINE_MASK;
+  BroadcastOp *op = ops.find(line_addr);
+  if (op != NULL) {
     DEBUG_HEADER();
     fprintf(stderr, "MULTIPLE OUTSTANDING BCASTS! line_addr: %08x addr: %08x "
                     "whichCluster: %d\n",
-                    address & rigel::cache::LINE_MASK, address, whichCluster);
-    (*it).dump();
+                    line_addr, address, whichCluster);
+    op->dump();
     assert(0 && "Multiple outstanding BCASTs to the same cache line not currently supported\n");
   }  
   
-  BroadcastOp newop(address, newData, whichCluster);
-  ops.push_back(newop);
+  ops.insert(line_addr) = BroadcastOp(address, newData, whichCluster);
 }
@@ -21,6 +21,7 @@
 #include "caches_legacy/l2d.h"     // for L2Cache, Profile (ptr only), etc
 #include "caches_legacy/l2i.h"     // for L2ICache
 #include "util/debug.h"          // for DebugSim, GLOBAL_debug_sim
+#include "sim/build_slot.h"      // for BuildSlot
 #include "define.h"         // for RES_TYPE, icmsg_type_t, etc
 #include "icmsg.h"          // for ICMsg
 #include "instr.h"          // for InstrLegacy
@@ -52,19 +53,19 @@ CacheModel::CacheModel(rigel::ConstructionPayload cp, Profile *profile, ClusterL
         rigel::cache::L2D_BANKS,
         rigel::cache::L2D_PORTS_PER_BANK,
         rigel::CORES_PER_CLUSTER,
-        ARB_ROUND_ROBIN ),
+        ARB_L2_POLICY ),
   ArbL2I(rigel::cache::L2I_BANKS,
         rigel::cache::L2I_PORTS_PER_BANK,
         rigel::cache::L2I_BANKS,
         rigel::cache::L2I_PORTS_PER_BANK,
         rigel::CORES_PER_CLUSTER,
-        ARB_ROUND_ROBIN ),
+        ARB_L2_POLICY ),
   ArbL2Return(rigel::cache::L2D_BANKS,
         rigel::cache::L2D_PORTS_PER_BANK,
         rigel::cache::L2D_BANKS,
         rigel::cache::L2D_PORTS_PER_BANK,
         rigel::CORES_PER_CLUSTER,
-        ARB_ROUND_ROBIN ),
+        ARB_L2_POLICY ),
         cluster(cl)
 {
 
@@ -110,7 +111,7 @@ CacheModel::CacheModel(rigel::ConstructionPayload cp, Profile *profile, ClusterL
   thread_arb_complete = new bool[rigel::THREADS_PER_CLUSTER];
   for (int i = 0; i < rigel::THREADS_PER_CLUSTER; i++) { thread_arb_complete[i] = false; }
 
-  rigel::GLOBAL_debug_sim.cluster_cache_models.push_back(this);
+  rigel::BuildSlot::push_back(rigel::GLOBAL_debug_sim.cluster_cache_models, this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
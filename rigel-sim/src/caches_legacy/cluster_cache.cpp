@@ -32,6 +32,7 @@
 #include "seqnum.h"         // for seq_num_t
 #include "sim.h"
 #include "tlb.h"            // for TLBs
+#include "util/value_tracker.h"  // for LineValueTracker
 #include "memory/backing_store.h" // FIXME used for is_executable()
 
 using namespace rigel;
@@ -1015,6 +1016,9 @@ try_pend:
     profiler::stats[STATNAME_DIR_L2D_DIRTY_EVICTS].inc();
     ca.set_icmsg_type( IC_MSG_EVICT_REQ );
     pend(ca, true /* is eviction! */ ) ;
+    if (rigel::TRACK_LINE_VALUES) {
+      GLOBAL_LINE_TRACKER_PTR->addLine(LineValueTracker::CCACHE_WRITEBACK, victim_addr);
+    }
   } else if (rigel::ENABLE_EXPERIMENTAL_DIRECTORY) {
     assert(!incoherent && "We should never try to pend a clean line with incoherence set\n");
     ca.set_icmsg_type( IC_MSG_CC_RD_RELEASE_REQ );
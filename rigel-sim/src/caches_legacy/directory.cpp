@@ -31,7 +31,8 @@ static int MIN_OVERFLOW_LISTS = 512;
 //  the C$ appropriately.  Maybe a W -> R/W permission updates the G$ or it does
 //  not?
 
-CacheDirectory::CacheDirectory() : valid_bits(rigel::COHERENCE_DIR_WAYS *
+CacheDirectory::CacheDirectory() : eviction_invalidates(ClusterBitset(rigel::NUM_CLUSTERS)),
+                                   valid_bits(rigel::COHERENCE_DIR_WAYS *
                                               rigel::COHERENCE_DIR_SETS)
 {
   dir_array = NULL; 
@@ -1296,7 +1297,7 @@ CacheDirectory::check_read_permission(uint32_t req_addr, int req_clusterid,
         DEBUG_HEADER();
         fprintf(stderr, "[CHECK PERM] READ num_sharers: %d addr: %08x "
                         " nak_waitlist.count(): %2zu state: %s\n", 
-          entry.get_num_sharers(), req_addr, entry.nak_waitlist.count(req_clusterid), 
+          entry.get_num_sharers(), req_addr, (size_t)entry.nak_waitlist.test(req_clusterid), 
           dir_state_string[entry.get_state()]);
       }
       #endif
@@ -1313,7 +1314,7 @@ CacheDirectory::check_read_permission(uint32_t req_addr, int req_clusterid,
               req_clusterid, req_addr, dir_state_string[entry.get_state()]);
           }
           #endif
-          if (0 == entry.fill_pending.count(req_clusterid)) { entry.set_fill_pending(req_clusterid); }
+          if (!entry.fill_pending.test(req_clusterid)) { entry.set_fill_pending(req_clusterid); }
           entry.set_last_touch();
           return true;
         } else { return false; }
@@ -1427,7 +1428,7 @@ CacheDirectory::check_write_permission(uint32_t req_addr, int req_clusterid,
         DEBUG_HEADER();
         fprintf(stderr, "[CHECK PERM] WRITE num_sharers: %d addr: %08x "
                         " nak_waitlist.count(): %2zu state: %s\n", 
-          entry.get_num_sharers(), req_addr, entry.nak_waitlist.count(req_clusterid), 
+          entry.get_num_sharers(), req_addr, (size_t)entry.nak_waitlist.test(req_clusterid), 
           dir_state_string[entry.get_state()]);
       }
       #endif
@@ -1445,7 +1446,7 @@ CacheDirectory::check_write_permission(uint32_t req_addr, int req_clusterid,
               req_clusterid, req_addr, dir_state_string[entry.get_state()]);
           }
           #endif
-          if (0 == entry.fill_pending.count(req_clusterid)) { entry.set_fill_pending(req_clusterid); }
+          if (!entry.fill_pending.test(req_clusterid)) { entry.set_fill_pending(req_clusterid); }
           entry.set_last_touch();
           return true; 
         } else { return false; }
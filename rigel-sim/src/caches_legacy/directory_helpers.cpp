@@ -367,7 +367,7 @@ CacheDirectory::helper_release_read_ownership( uint32_t rel_addr,
         case IC_MSG_SPLIT_BCAST_SHR_REPLY:
         case IC_MSG_SPLIT_BCAST_OWNED_REPLY:
           // Track the bcast replies that found the line valid in the L2.
-          if (bcast_found_valid_line) { entry.bcast_valid_sharers.insert(rel_clusterid); }
+          if (bcast_found_valid_line) { entry.bcast_valid_sharers.set(rel_clusterid); }
         case IC_MSG_CC_BCAST_ACK:
         case IC_MSG_SPLIT_BCAST_INV_REPLY:
         {
@@ -379,7 +379,7 @@ CacheDirectory::helper_release_read_ownership( uint32_t rel_addr,
             
             dir_state_t state = entry.get_pf_bcast_next_state();
             int sharer = entry.get_pf_bcast_next_sharer();
-            std::set<int> bcast_valid_sharers = entry.bcast_valid_sharers;
+            ClusterBitset bcast_valid_sharers = entry.bcast_valid_sharers;
 
             // Added to make sure we clean up broadcasts before installing new entry
             entry.reset();
@@ -392,12 +392,12 @@ CacheDirectory::helper_release_read_ownership( uint32_t rel_addr,
             if (ENABLE_BCAST_NETWORK && ENABLE_PROBE_FILTER_DIRECTORY && state == DIR_STATE_READ_SHARED)
             {
               // Add broadcast ack's that are sharing line to the list.
-              for ( std::set<int>::iterator it = bcast_valid_sharers.begin(); 
-                    it != bcast_valid_sharers.end(); it++) 
+              for (int it = bcast_valid_sharers.findFirstSet(); it != -1;
+                   it = bcast_valid_sharers.findNextSet(it))
               { 
                 assert(entry.get_state() == DIR_STATE_READ_SHARED);
-                assert (sharer != *it && "The requester should not be currently sharing the line.");
-                entry.inc_sharers(*it); 
+                assert (sharer != it && "The requester should not be currently sharing the line.");
+                entry.inc_sharers(it); 
               }
             }
           }
@@ -453,11 +453,11 @@ CacheDirectory::helper_release_read_ownership( uint32_t rel_addr,
           #if 0
           // We need to wait for the NAK/REL pair before we decrement the
           // count.  This is only an issue in the evict state.
-          if (entry.nak_waitlist.count(rel_clusterid)) {
+          if (entry.nak_waitlist.test(rel_clusterid)) {
             entry.dec_sharers(rel_clusterid);
             if (0 == entry.get_num_sharers()) { entry.reset(); }
           } else {
-            entry.nak_waitlist.insert(rel_clusterid);
+            entry.nak_waitlist.set(rel_clusterid);
           }
           break;
           #endif
@@ -487,7 +487,7 @@ CacheDirectory::helper_release_read_ownership( uint32_t rel_addr,
                         "num_sharers: %d addr: %08x "
                         "msg: %2d nak_waitlist.count(): %2d state: %s\n", 
           waiting_cluster, entry.get_num_sharers(), rel_addr, ic_type, 
-          entry.nak_waitlist.count(rel_clusterid), dir_state_string[entry.get_state()]);
+          (int)entry.nak_waitlist.test(rel_clusterid), dir_state_string[entry.get_state()]);
       }
       #endif
 
@@ -515,7 +515,7 @@ CacheDirectory::helper_release_read_ownership( uint32_t rel_addr,
         case IC_MSG_CC_RD_RELEASE_REQ:
           // We need to wait for the NAK/REL pair before we decrement the
           // count.  This is only an issue in the evict state.
-          if (1 == entry.nak_waitlist.count(rel_clusterid)) 
+          if (entry.nak_waitlist.test(rel_clusterid)) 
           {
             #ifdef __DEBUG_ADDR
             if (__DEBUG_ADDR == rel_addr && (__DEBUG_CYCLE < rigel::CURR_CYCLE)) {
@@ -524,7 +524,7 @@ CacheDirectory::helper_release_read_ownership( uint32_t rel_addr,
                               "addr: %08x "
                               "msg: %2d nak_waitlist.count(): %2d state: %s\n", 
                 waiting_cluster, entry.get_num_sharers(), rel_addr, ic_type, 
-                entry.nak_waitlist.count(rel_clusterid), dir_state_string[entry.get_state()]);
+                (int)entry.nak_waitlist.test(rel_clusterid), dir_state_string[entry.get_state()]);
             }
             #endif
             entry.dec_sharers(rel_clusterid);
@@ -552,11 +552,11 @@ CacheDirectory::helper_release_read_ownership( uint32_t rel_addr,
                               " num_sharers: %d addr: %08x "
                               " msg: %2d nak_waitlist.count(): %2d state: %s rel_clusterid: %d\n", 
                 waiting_cluster, entry.get_num_sharers(), rel_addr, ic_type, 
-                entry.nak_waitlist.count(rel_clusterid),
+                (int)entry.nak_waitlist.test(rel_clusterid),
                   dir_state_string[entry.get_state()], rel_clusterid);
             }
             #endif
-            entry.nak_waitlist.insert(rel_clusterid);
+            entry.nak_waitlist.set(rel_clusterid);
             return;
           }
 
@@ -680,7 +680,7 @@ CacheDirectory::helper_release_write_ownership( uint32_t rel_addr,
         fprintf(stderr, "[RELEASE] WRITE waiting_cluster: %d num_sharers: %d addr: %08x "
                         " msg: %2d nak_waitlist.count(): %2d state: %s\n", 
           waiting_cluster, entry.get_num_sharers(), rel_addr, ic_type, 
-          entry.nak_waitlist.count(rel_clusterid), dir_state_string[entry.get_state()]);
+          (int)entry.nak_waitlist.test(rel_clusterid), dir_state_string[entry.get_state()]);
       }
       #endif
 
@@ -691,7 +691,7 @@ CacheDirectory::helper_release_write_ownership( uint32_t rel_addr,
         case IC_MSG_CC_WR_RELEASE_ACK:
         case IC_MSG_CC_WR_RELEASE_NAK:
         {
-          if ( (1 == entry.nak_waitlist.count(rel_clusterid)) ||
+          if ( entry.nak_waitlist.test(rel_clusterid) ||
                (IC_MSG_CC_WR_RELEASE_ACK == ic_type)
             ) 
           {
@@ -723,9 +723,9 @@ CacheDirectory::helper_release_write_ownership( uint32_t rel_addr,
             entry.set_state(new_state);
             entry.set_fill_pending(waiting_cluster);
             break;
-          } else if (0 == entry.nak_waitlist.count(rel_clusterid)) {
+          } else if (!entry.nak_waitlist.test(rel_clusterid)) {
             // Still waiting on the NAK/actual writeback from the cluster.
-            entry.nak_waitlist.insert(rel_clusterid);
+            entry.nak_waitlist.set(rel_clusterid);
             break;
           } else {
             rigel::GLOBAL_debug_sim.dump_all();
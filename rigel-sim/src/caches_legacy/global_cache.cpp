@@ -40,6 +40,7 @@
 #include "memory_timing.h"  // for MemoryTimingDRAM
 #include "tlb.h"            // for TLB
 #include "util/construction_payload.h"
+#include "util/value_tracker.h"  // for LineValueTracker
 using namespace rigel;
 
 GlobalCache ** GLOBAL_CACHE_PTR;
@@ -1065,6 +1066,9 @@ GlobalCache::helper_handle_pending_requests(int myQueueNum)
           }
           else
           {
+            if (rigel::TRACK_LINE_VALUES) {
+              GLOBAL_LINE_TRACKER_PTR->addLine(LineValueTracker::GCACHE_FILL, fill_address);
+            }
             pendingMiss[i].notify_fill(fill_address);
           }
         }
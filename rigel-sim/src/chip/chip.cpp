@@ -13,6 +13,11 @@
 #include "util/value_tracker.h"
 #include "caches_legacy/cache_model.h" //For poking into L2s for TLB aggregation :(
 #include "util/construction_payload.h"
+#include "core/lockstep_engine.h"
+#include "util/startup_timer.h"
+#include "core/core_trace_player.h" // for TRACE_PLAYER
+#include "sim/build_slot.h"
+#include "profile/profile.h"
 
 /// chip constructor
 ChipTiled::ChipTiled(rigel::ConstructionPayload cp) :
@@ -25,7 +30,8 @@ ChipTiled::ChipTiled(rigel::ConstructionPayload cp) :
   _gnet_replies(NULL),
   _memory_timing(cp.memory_timing),
   _backing_store(cp.backing_store),
-  _chip_state(cp.chip_state)
+  _chip_state(cp.chip_state),
+  _lockstep(NULL)
 {
   cp.parent = this;
 	cp.component_name.clear();
@@ -34,6 +40,13 @@ ChipTiled::ChipTiled(rigel::ConstructionPayload cp) :
 
   init_global_cache(cp); // initialize the global cache
   init_gnet(cp);         // initialize the global tile-gcache interconnect
+
+  // functional cores register with the lockstep engine as they are built
+  if (rigel::LOCKSTEP_FUNCTIONAL) {
+    _lockstep = new LockstepEngine();
+  }
+  cp.lockstep = _lockstep;
+
   init_tiles(cp);        // finally, init tiles (depends on some above)
 
   for (int i = 0; i < rigel::NUM_TILES; i++) {
@@ -51,6 +64,7 @@ ChipTiled::~ChipTiled() {
   for(int i = 0; i < rigel::NUM_TILES; i++) {
     delete _tiles[i];
   }
+  delete _lockstep;
 }
 
 /// chip PerCycle()
@@ -77,18 +91,18 @@ ChipTiled::PerCycle() {
   _gnet_requests->PerCycle();
   _gnet_replies->PerCycle();
  
-
-  // Clock each of the tiles.
-  for(int t = 0; t < rigel::NUM_TILES; t++) { 
-    _tiles[t]->PerCycle(); 
+  // Execute groups of cores at the same PC before the cores are clocked.
+  if (_lockstep) {
+    _lockstep->PerCycle();
   }
 
-  // Clock each cluster, check for halted clusters.  
-  // Each cluster clocks each of its own cores recursively.
-  // check if all tiles(clusters,cores) are halted
+
+  // Clock each of the tiles.
+  // Each tile clocks its clusters, which clock their cores, and reports
+  // whether all of them are halted.
   int halted_count = 0;
-  for(int tile = 0; tile < rigel::NUM_TILES; tile++) {
-    halted_count += _tiles[tile]->halted();
+  for(int t = 0; t < rigel::NUM_TILES; t++) { 
+    halted_count += _tiles[t]->PerCycle(); 
   }
 
   _halted = halted_count;
@@ -120,6 +134,14 @@ ChipTiled::EndSim() {
     _tiles[t]->EndSim();
   }
 
+  if (_lockstep) {
+    _lockstep->EndSim();
+  }
+
+  if (TRACK_LINE_VALUES) {
+    GLOBAL_LINE_TRACKER_PTR->report(std::cout);
+  }
+
   // if (_global_cache) {
   //   for(int i = 0; i < NUM_GCACHE_BANKS; i++) {
   //     _global_cache[i]->gather_end_of_simulation_stats();
@@ -128,15 +150,38 @@ ChipTiled::EndSim() {
 
 }
 
+/// BuildSlot constructor for tile i; ctx is the chip's ConstructionPayload
+static ComponentBase *
+make_tile(void *ctx, int i) {
+  rigel::ConstructionPayload cp = *static_cast<rigel::ConstructionPayload *>(ctx);
+  cp.component_index = i;
+  return new rigel::TileType(cp);
+}
+
 /// allocate and initialize tiles
 void 
 ChipTiled::init_tiles(rigel::ConstructionPayload &cp) {
 
+  StartupPhase t("tiles");
+
   _tiles = new TileBase *[rigel::NUM_TILES];
 
+  // tiles are built on --startup-threads host threads (see
+  // sim/build_slot.h), except that a trace player hands its trace out to
+  // cores in construction order
+  int threads = rigel::TRACE_PLAYER ? 1 : rigel::STARTUP_THREADS;
+  if (threads > 1) {
+    // tiles then fill in their clusters' state by index instead of appending
+    for (int i = 0; i < rigel::NUM_CLUSTERS; i++) {
+      _chip_state->add_clusters();
+    }
+  }
+  // shared profiler state is set up here, not by each cluster's Profile
+  Profile::init();
+  std::vector<ComponentBase *> built(rigel::NUM_TILES);
+  rigel::BuildSlot::build(&built[0], rigel::NUM_TILES, make_tile, &cp, threads);
   for (int i = 0; i < rigel::NUM_TILES; i++) {
-    cp.component_index = i;
-    _tiles[i] = new rigel::TileType(cp);
+    _tiles[i] = static_cast<TileBase *>(built[i]);
   }
 
 }
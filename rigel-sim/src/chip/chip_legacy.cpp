@@ -13,6 +13,10 @@
 #include "util/value_tracker.h"
 #include "caches_legacy/cache_model.h" //For poking into L2s for TLB aggregation :(
 #include "util/construction_payload.h"
+#include "util/startup_timer.h"
+#include "core/core_trace_player.h" // for TRACE_PLAYER
+#include "sim/build_slot.h"
+#include "profile/profile.h"
 
 /// chip constructor
 ChipLegacy::ChipLegacy(rigel::ConstructionPayload cp) :
@@ -32,10 +36,10 @@ ChipLegacy::ChipLegacy(rigel::ConstructionPayload cp) :
   GLOBAL_CACHE_PTR = NULL; // in case we never init
   if (RIGEL_CFG_NUM == 1) {
     init_bm(cp);           // initialize broadcast manager (FIXME: make conditional)
-    init_global_cache(cp); // initialize the global cache
+    { StartupPhase t("global cache"); init_global_cache(cp); } // initialize the global cache
     init_gnet(cp);         // initialize the global tile-gcache interconnect
   }
-  init_tiles(cp);        // finally, init tiles (depends on some above)
+  { StartupPhase t("tiles"); init_tiles(cp); } // finally, init tiles (depends on some above)
 }
 
 // chip destructor
@@ -86,16 +90,11 @@ ChipLegacy::PerCycle() {
   // Due to the way per-instruction profiling (particularly
   // InstrLegacy.stats.cycles.stall_accounted_for) is implemented, the cores
   // (Cluster::PerCycle()) must be the last thing to be clocked.
-  for(int t = 0; t < rigel::NUM_TILES; t++) { 
-    _tiles[t]->PerCycle(); 
-  }
-
-  // Clock each cluster, check for halted clusters.  Each cluster clocks
-  // each of its own cores recursively.
-  // check if all tiles(clusters,cores) are halted
+  // Each tile clocks its clusters, which clock their cores, and reports
+  // whether all of them are halted.
   int halted_count = 0;
-  for(int tile = 0; tile < rigel::NUM_TILES; tile++) {
-    halted_count += _tiles[tile]->halted();
+  for(int t = 0; t < rigel::NUM_TILES; t++) { 
+    halted_count += _tiles[t]->PerCycle(); 
   }
 
   halted_ = halted_count;
@@ -137,6 +136,9 @@ ChipLegacy::EndSim() {
   if(TRACK_BIT_PATTERNS) {
     GLOBAL_ZERO_TRACKER_PTR->report(std::cout);
   }
+  if(TRACK_LINE_VALUES) {
+    GLOBAL_LINE_TRACKER_PTR->report(std::cout);
+  }
 
   if (_global_cache) {
     for(int i = 0; i < NUM_GCACHE_BANKS; i++) {
@@ -145,6 +147,7 @@ ChipLegacy::EndSim() {
   }
 
   if (RIGEL_CFG_NUM == 1) {
+    _memory_timing->EndSim();
     if(ENABLE_LOCALITY_TRACKING) {
       _gnet->dump_locality();
       for (int i = 0; i < NUM_GCACHE_BANKS; i++) {
@@ -226,14 +229,35 @@ ChipLegacy::EndSim() {
   
 }
 
+/// BuildSlot constructor for tile i; ctx is the chip's ConstructionPayload
+static ComponentBase *
+make_tile(void *ctx, int i) {
+  rigel::ConstructionPayload cp = *static_cast<rigel::ConstructionPayload *>(ctx);
+  cp.component_index = i;
+  return new rigel::TileType(cp);
+}
+
 /// allocate and initialize tiles
 void 
 ChipLegacy::init_tiles(rigel::ConstructionPayload &cp) {
   _tiles = new TileBase *[rigel::NUM_TILES];
 
-  for(int i = 0; i < rigel::NUM_TILES; i++) {
-    cp.component_index = i;
-    _tiles[i] = new rigel::TileType(cp);
+  // tiles are built on --startup-threads host threads (see
+  // sim/build_slot.h), except that a trace player hands its trace out to
+  // cores in construction order
+  int threads = rigel::TRACE_PLAYER ? 1 : rigel::STARTUP_THREADS;
+  if (threads > 1) {
+    // tiles then fill in their clusters' state by index instead of appending
+    for (int i = 0; i < rigel::NUM_CLUSTERS; i++) {
+      _chip_state->add_clusters();
+    }
+  }
+  // shared profiler state is set up here, not by each cluster's Profile
+  Profile::init();
+  std::vector<ComponentBase *> built(rigel::NUM_TILES);
+  rigel::BuildSlot::build(&built[0], rigel::NUM_TILES, make_tile, &cp, threads);
+  for (int i = 0; i < rigel::NUM_TILES; i++) {
+    _tiles[i] = static_cast<TileBase *>(built[i]);
   }
 }
 
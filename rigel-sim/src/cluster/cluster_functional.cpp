@@ -3,6 +3,7 @@
 #include "cluster/cluster_cache_functional.h"
 #include "sim.h"
 #include "util/construction_payload.h"
+#include "core/core_trace_player.h"
 
 /// constructor
 ClusterFunctional::ClusterFunctional(
@@ -22,22 +23,26 @@ ClusterFunctional::ClusterFunctional(
   // this just assigns the ccache ports to be the cluster's ports
   // we like this because the cluster is contained, but the ccache is a separate object
   // we could instead try to use a DUMMY port object that basically does this assignment via attach
-  from_interconnect = new InPortBase<Packet*>(  PortName(name(), id(), "in") );
+  from_interconnect = new InPortBase<Packet*>(  PortName(this, "in") );
   from_interconnect->owner(this);
-  to_interconnect   = new OutPortBase<Packet*>( PortName(name(), id(), "out") );
+  to_interconnect   = new OutPortBase<Packet*>( PortName(this, "out") );
   to_interconnect->owner(this);
 
   // the ccache will actually be responsible for reading, writing to the cluster's ports
   ccache = new ClusterCacheFunctional(cp, from_interconnect, to_interconnect);
 
-	cores = new CoreFunctional*[numcores];
+	cores = new CoreBase*[numcores];
 
   // make port connections:
   // TODO: do this somewhere more generic
   for (int i = 0; i < numcores; ++i) {
     cp.core_state = cp.cluster_state->add_cores();
     cp.component_index = i;
-    cores[i] = new CoreFunctional(cp);     
+    if (rigel::TRACE_PLAYER) {
+      cores[i] = new CoreTracePlayer(cp);
+    } else {
+      cores[i] = new CoreFunctional(cp);     
+    }
     ccache->getCoreSideInPort(i)->attach( cores[i]->getOutPort() );
     cores[i]->getInPort()->attach( ccache->getCoreSideOutPort(i) );
   }
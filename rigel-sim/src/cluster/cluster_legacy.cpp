@@ -22,6 +22,7 @@
 #include "instrstats.h"     // for InstrCycleStats, InstrStats
 #include "profile/profile.h"        // for Profile, InstrStat
 #include "sim.h"            // for CORES_PER_CLUSTER, etc
+#include "util/task_queue.h"      // for TaskSystemBaseline, etc
 #include "util/ui_legacy.h"             // for UserInterfaceLegacy
 #include "util/construction_payload.h"
 
@@ -36,7 +37,9 @@ using namespace rigel;
 ClusterLegacy::ClusterLegacy(ConstructionPayload cp) :
   ClusterBase(cp.change_name("ClusterLegacy")),
   id_num(cp.component_index),
-  core_sleeping(0)
+  core_sleeping(0),
+  core_tq_sleeping(0),
+  num_halted_cores(0)
 {
   cp.parent = this;
   cp.component_name.clear();
@@ -62,6 +65,9 @@ ClusterLegacy::ClusterLegacy(ConstructionPayload cp) :
     cp.core_state = cp.cluster_state->add_cores();
     cp.component_index = id_num * rigel::CORES_PER_CLUSTER + i; // globally unique core ID
     cores[i] = new CoreInOrderLegacy(cp, this);
+    // Cores may come up halted (e.g., -st).
+    num_halted_cores += cores[i]->is_halted();
+    tq_sleep_cycle[i] = 0;
   }
 
   // Inititialize the pipeline latches for the cluster.
@@ -125,6 +131,39 @@ void ClusterLegacy::WakeCore(int i)
   //}
   //printf("Cycle %"PRIu64": Cluster %d: %d, wake up!\n", rigel::CURR_CYCLE, GetClusterID(), i);
   core_sleeping.reset(i);
+  if (core_tq_sleeping[i]) {
+    // The core would have retried the dequeue and stalled every cycle it was
+    // asleep.  Charge those cycles now.
+    uint64_t slept = rigel::CURR_CYCLE - tq_sleep_cycle[i];
+    Profile::global_task_stats.cycles_blocked += slept;
+    profiler->timing_stats.tq_stall += slept;
+    core_tq_sleeping.reset(i);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SleepCoreOnTaskQueue(int i)
+////////////////////////////////////////////////////////////////////////////////
+// puts core i (local core number) to sleep while it is blocked in TQ_DEQUEUE
+// on an empty queue.  It is woken by TaskQueueWakeReady() rather than by an
+// MSHR fill.
+void ClusterLegacy::SleepCoreOnTaskQueue(int i)
+{
+  core_sleeping.set(i);
+  core_tq_sleeping.set(i);
+  tq_sleep_cycle[i] = rigel::CURR_CYCLE + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TaskQueueWakeReady(int i)
+////////////////////////////////////////////////////////////////////////////////
+// A core blocked on the task queue can only make progress once a task shows
+// up or its TQ state leaves TQ_STATE_BLOCKING (sync or TQ_End).  Until then a
+// retried TQ_DEQUEUE just blocks again.
+bool ClusterLegacy::TaskQueueWakeReady(int i)
+{
+  const TQ_CoreStateDesc &tq = GlobalTaskQueue->TQ_CoreState[cores[i]->get_core_num_global()];
+  return !GlobalTaskQueue->TaskQueue.empty() || tq.CurrState != TQ_STATE_BLOCKING;
 }
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -135,11 +174,7 @@ void ClusterLegacy::WakeCore(int i)
 int
 ClusterLegacy::halted() {
   // Check if all cores are halted.
-  int halt = CORES_PER_CLUSTER;
-  for (int k = 0; k < CORES_PER_CLUSTER; k++) {
-    halt -= cores[k]->is_halted();
-  }
-  if (halt == 0) { return 1; /* Halts */ }
+  if (num_halted_cores == CORES_PER_CLUSTER) { return 1; /* Halts */ }
   return 0;
 }
 ////////////////////////////////////////////////////////////////////////////////
@@ -168,10 +203,8 @@ ClusterLegacy::PerCycle() {
   ClockClusterCache();
 
   // FIXME: move profiler stuff out of here
-  for (int i = 0; i < CORES_PER_CLUSTER; i++) {
-    // Add the total number of slots that are halted
-    profiler->timing_stats.halt_stall +=  (cores[i]->is_halted() * rigel::ISSUE_WIDTH);
-  }
+  // Add the total number of slots that are halted
+  profiler->timing_stats.halt_stall += (num_halted_cores * rigel::ISSUE_WIDTH);
 
   // early exit if halted
   if (halted()) return 1;
@@ -186,7 +219,10 @@ ClusterLegacy::PerCycle() {
     // it wakes up?
     if(core_sleeping[i] && rigel::SLEEPY_CORES)
     {
-      continue;
+      // Cores blocked on the task queue poll for a change in the queue instead
+      // of running the pipeline just to block again.
+      if (!core_tq_sleeping[i] || !TaskQueueWakeReady(i)) { continue; }
+      WakeCore(i);
     }
 
     // SIM_SLEEP: Simulator hack allows for fast simulation. Turned on/off by writing
@@ -212,19 +248,21 @@ ClusterLegacy::PerCycle() {
     //It doesn't matter if these instructions are null or not.
     //We just won't count null instructions at the end.
     for (int j = 0; j < rigel::ISSUE_WIDTH; j++) {
-      cores[i]->nlatches[IF2DC][j]->stats.cycles.fetch++;
+      InstrSlot instr = cores[i]->nlatches[IF2DC][j];
+      if (instr != rigel::NullInstr) { instr->stats.cycles.fetch++; }
     }
 
     if (halted()) { return 1; }
 
-    //TODO: what does this collect, why here?
-    ProfileStuckBehind(i);
-
-    // clock the latches to update state
+    // clock the latches to update state.  This also charges
+    // stuck_behind_other_instr to everything left behind a stall.
     cores[i]->UpdateLatches();
 
+    if (rigel::SLEEPY_CORES && cores[i]->CheckBlockedOnTaskQueue()) {
+      SleepCoreOnTaskQueue(i);
+    }
   }
-  return 0; // Not halted
+  return halted();
 }
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -235,56 +273,23 @@ ClusterLegacy::PerCycle() {
 // FIXME: this may be busted for MT!
 inline void
 ClusterLegacy::ProfileCycles(int i) {
-  //Profiling
-  //It doesn't matter if these instructions are null or not.
-  //We just won't count null instructions at the end.
-
-  //int tid = cores[i]->get_thread_id_core();
-
-  //
-  for (int j = 0; j < rigel::ISSUE_WIDTH; j++) {
-    cores[i]->latches[IF2DC][j]->stats.cycles.decode++;
-    cores[i]->latches[DC2EX][j]->stats.cycles.execute++;
-    cores[i]->latches[EX2MC][j]->stats.cycles.mem++;
-    cores[i]->latches[MC2FP][j]->stats.cycles.fp++;
-    cores[i]->latches[FP2CC][j]->stats.cycles.cc++;
-    cores[i]->latches[CC2WB][j]->stats.cycles.wb++;
-  }
-}
-////////////////////////////////////////////////////////////////////////////////
-
-
-////////////////////////////////////////////////////////////////////////////////
-// ProfileStuckBehind()
-////////////////////////////////////////////////////////////////////////////////
-// helper function for profiling in cluster.step
-inline void
-ClusterLegacy::ProfileStuckBehind(int i) {
-  //For per-instruction profiling
-  //At this point, all instructions which themselves stalled have had the appropriate
-  //counters incremented.
-  //Now, we increment instr->stats.cycles.stuck_behind_other_instr for all instructions
-  //which did not stall themselves, //but are stuck behind another instruction which did stall.
-  //To accomplish this, we increment the counter for *all* instructions in the core,
-  //then decrement them for all the latches we clock forward.
-  //Once we short-circuit out of the latch-clocking code, the remaining instructions
-  //(earlier in the pipeline) will still have their stuck_behind_other_instr counter incremented.
-
-  // VIM does not like it when you leave these uncommented out since GCC gives a
-  // warning.
-  //int tid = cores[i]->get_thread_id_core();
-  // pointer to core state
-  //pipeline_per_thread_state_t *ts = cores[i]->get_thread_state(tid);
-
-  for(int k = 0; k < rigel::ISSUE_WIDTH; k++)
-  {
-    cores[i]->nlatches[IF2DC][k]->stats.cycles.stuck_behind_other_instr++;
-    cores[i]->nlatches[DC2EX][k]->stats.cycles.stuck_behind_other_instr++;
-    cores[i]->nlatches[EX2MC][k]->stats.cycles.stuck_behind_other_instr++;
-    cores[i]->nlatches[MC2FP][k]->stats.cycles.stuck_behind_other_instr++;
-    cores[i]->nlatches[FP2CC][k]->stats.cycles.stuck_behind_other_instr++;
-    //For now, these will always be decremented since WB never stalls.  In the future, it might.
-    cores[i]->nlatches[CC2WB][k]->stats.cycles.stuck_behind_other_instr++;
+  // Per-instruction stage occupancy, one counter per latch.  Empty slots all
+  // point at NullInstr, whose counters are never reported, so skip them
+  // rather than hammering the same object twelve times a cycle.
+  static uint64_t InstrCycleStats::* const occupancy[] = {
+    &InstrCycleStats::decode,   // IF2DC
+    &InstrCycleStats::execute,  // DC2EX
+    &InstrCycleStats::mem,      // EX2MC
+    &InstrCycleStats::fp,       // MC2FP
+    &InstrCycleStats::cc,       // FP2CC
+    &InstrCycleStats::wb        // CC2WB
+  };
+
+  for (int l = IF2DC; l <= CC2WB; l++) {
+    for (int j = 0; j < rigel::ISSUE_WIDTH; j++) {
+      InstrSlot instr = cores[i]->latches[l][j];
+      if (instr != rigel::NullInstr) { (instr->stats.cycles.*occupancy[l])++; }
+    }
   }
 }
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,1216 @@
+////////////////////////////////////////////////////////////////////////////////
+// cohtest.cpp
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Standalone coherence stress driver.  Instantiates one CacheDirectory per
+//  global cache bank (plus the global HybridDirectory and, with
+//  --overflow-directory, each directory's OverflowCacheDirectory) and drives
+//  them with synthetic cluster agents that issue random loads, stores,
+//  evictions and atomics.  Every load is checked against a golden shadow
+//  memory and single-writer/multiple-reader is checked on every state change.
+//  At the end of the run the time spent is reported as directory transactions
+//  per host second so that protocol changes can be benchmarked in seconds.
+//
+//  The G$ side of the protocol (GlobalCache::helper_handle_directory_access()
+//  and friends) is mirrored by DirProxy since GlobalCache cannot be built
+//  without the full global network.  Cluster agents follow the cluster cache
+//  probe rules in cluster_cache_coherence.cpp.  The network is point-to-point
+//  ordered between each cluster/bank pair with a random latency.
+//
+//  All of the usual coherence switches (--limited-directory,
+//  --probe-filter-directory, --bcast-network, --overflow-directory,
+//  --enable-hybrid-coherence, --directory-sets/ways, ...) apply.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>                      // for assert
+#include <cmath>                        // for ceil
+#include <stdint.h>                     // for uint32_t, uint64_t
+#include <cstdio>                       // for fprintf, NULL, stderr
+#include <cstdlib>                      // for exit, srand
+#include <cstring>                      // for memcpy
+#include <sys/time.h>                   // for gettimeofday, timeval
+#include <list>                         // for list
+#include <map>                          // for map
+#include <set>                          // for set
+#include <utility>                      // for pair
+#include <vector>                       // for vector
+#include "../user.config"
+#include "RandomLib/Random.hpp"         // for Random
+#include "caches_legacy/hybrid_directory.h"  // for hybrid_directory
+#include "define.h"                     // for icmsg_type_t, etc
+#include "directory.h"                  // for CacheDirectory
+#include "icmsg.h"                      // for ICMsg
+#include "instr.h"                      // for InstrLegacy
+#include "memory/address_mapping.h"     // for AddressMapping
+#include "memory/backing_store.h"       // for GlobalBackingStoreType
+#include "memory/dram.h"                // for CONTROLLERS, ROWS, BANKS, etc
+#include "overflow_directory.h"         // for dir_of_timing_t
+#include "profile/profile.h"            // for ProfileStat
+#include "profile/profile_names.h"      // for STATNAME_DIRECTORY_*
+#include "sim.h"                        // for NUM_CLUSTERS, CURR_CYCLE, etc
+#include "util/fixed_bitset.h"          // for ClusterBitset
+#include "util/task_queue.h"            // for TaskSystemBaseline
+#include "util/util.h"                  // for CommandLineArgs, ExitSim
+
+                  // PC        tid  pred_pc     raw_instr   i_type
+InstrLegacy TempInstr(0xF000000F, -1, 0xF000000F, 0x00000000, I_NULL); // this is the NullInstr
+InstrLegacy * rigel::NullInstr;
+
+namespace rigel {
+  RandomLib::Random RNG(0);
+	RandomLib::Random TargetRNG(0);
+}
+
+rigel::GlobalBackingStoreType * rigel::GLOBAL_BACKING_STORE_PTR;
+
+namespace cohtest {
+
+  using rigel::cache::LINESIZE;
+
+  const int WORDS_PER_LINE = LINESIZE / sizeof(uint32_t);
+  // Region touched by every cluster.
+  const uint32_t SHARED_BASE = 0x10000000;
+  // Word-per-line region only touched by global operations (atomics).
+  const uint32_t ATOMIC_BASE = 0x20000000;
+  const int NUM_ATOMIC_WORDS = 64;
+  // Per-cluster private lines.  Placed in the stack region so that
+  // --enable-hybrid-coherence treats them as incoherent.
+  const uint32_t PRIVATE_BASE = 0xC0000000;
+  const int PRIVATE_LINES_PER_CLUSTER = 4;
+  // Contended subset of the shared region.
+  const int HOT_LINES = 8;
+  // Agent behaviour.
+  const double ISSUE_PROBABILITY = 0.5;
+  const int MAX_OUTSTANDING = 4;
+  const int RECENT_LINES = 16;
+  // A request outstanding for this many cycles is reported as a deadlock.
+  const uint64_t WDT_CYCLES = 200000;
+  const uint64_t WDT_SCAN_INTERVAL = 4096;
+
+  enum line_state_t { LINE_I, LINE_S, LINE_M };
+  enum line_pend_t { PEND_NONE, PEND_READ, PEND_WRITE, PEND_RD_REL, PEND_WB };
+
+  // One message in flight between a cluster and a G$ bank.  Only the fields
+  // the protocol needs are carried; ICMsg is only used at the directory API.
+  struct Msg {
+    icmsg_type_t type;
+    uint32_t addr;
+    int cluster;        // Source cluster (to the G$) or destination (to a cluster).
+    bool to_gcache;
+    bool has_data;      // data[] holds dirty data being given up (or a fill).
+    bool valid;         // Broadcast response found the line valid.
+    bool incoherent;    // Set by the hybrid directory check.
+    int word;           // Word touched by an uncached store or atomic.
+    uint32_t value;     // Store value or atomic result.
+    bool shootdown;     // Probe filter write shootdown riding on a broadcast.
+    uint32_t shootdown_addr;
+    uint32_t data[WORDS_PER_LINE];
+  };
+
+  // Ordered point-to-point network.  Each (cluster, bank, direction) channel
+  // delivers in order with a random latency of 1..max_latency cycles.
+  class Network {
+    public:
+      Network(int num_clusters, int num_banks, int max_latency) :
+        num_banks(num_banks), max_latency(max_latency), in_flight(0),
+        ring(max_latency + 1), last_ready(num_clusters * num_banks * 2, 0) { }
+      void send(const Msg &m, int bank) {
+        size_t chan = ((m.cluster * num_banks) + bank) * 2 + (m.to_gcache ? 1 : 0);
+        uint64_t ready = rigel::CURR_CYCLE + 1 + rigel::RNG.Integer<unsigned int>(max_latency);
+        if (ready < last_ready[chan]) { ready = last_ready[chan]; }
+        last_ready[chan] = ready;
+        ring[ready % ring.size()].push_back(m);
+        in_flight++;
+      }
+      // Messages due this cycle.  The caller owns them and must clear().
+      void take_due(std::vector<Msg> &out) {
+        out.swap(ring[rigel::CURR_CYCLE % ring.size()]);
+        in_flight -= out.size();
+      }
+      size_t get_in_flight() const { return in_flight; }
+    private:
+      int num_banks;
+      unsigned int max_latency;
+      size_t in_flight;
+      std::vector< std::vector<Msg> > ring;
+      std::vector<uint64_t> last_ready;
+  };
+
+  struct Stats {
+    uint64_t loads, load_hits, stores, store_hits, evicts, atomics, uncached;
+    uint64_t dir_transactions, probes, bcast_probes, retries;
+    uint64_t dirty_invalidates;
+  };
+
+  // Shared state of the test: golden model, G$/memory contents and the
+  // per-line holders used for the SWMR check.
+  size_t num_shared_lines;
+  size_t num_lines;
+  std::vector<uint32_t> golden;
+  std::vector<uint32_t> gmem;
+  std::vector<int> readers;
+  std::vector<int> writer;
+  std::vector<uint32_t> atomic_mem;
+  std::vector<uint64_t> atomic_issued;
+  Stats test_stats;
+  uint64_t ops_issued;
+  uint64_t last_progress;
+  Network *network;
+
+  class ClusterAgent;
+  class DirProxy;
+  std::vector<ClusterAgent *> agents;
+  std::vector<DirProxy *> proxies;
+
+  inline uint32_t line_addr(size_t idx) {
+    if (idx < num_shared_lines) { return SHARED_BASE + idx * LINESIZE; }
+    return PRIVATE_BASE + (idx - num_shared_lines) * LINESIZE;
+  }
+  // num_lines for an address outside both regions, e.g. an atomic word a
+  // probe filter entry was tracking
+  inline size_t line_index(uint32_t addr) {
+    if (addr >= PRIVATE_BASE) {
+      size_t idx = num_shared_lines + (addr - PRIVATE_BASE) / LINESIZE;
+      return idx < num_lines ? idx : num_lines;
+    }
+    if (addr >= SHARED_BASE && addr - SHARED_BASE < num_shared_lines * LINESIZE) {
+      return (addr - SHARED_BASE) / LINESIZE;
+    }
+    return num_lines;
+  }
+  inline bool is_atomic_addr(uint32_t addr) {
+    return addr >= ATOMIC_BASE && addr < ATOMIC_BASE + NUM_ATOMIC_WORDS * LINESIZE;
+  }
+  inline int gcache_bank(uint32_t addr) { return AddressMapping::GetGCacheBank(addr); }
+
+  void report_error(uint32_t addr, const char *what, int cluster);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // DirProxy
+  //////////////////////////////////////////////////////////////////////////////
+  // Stands in for one GlobalCache bank: owns the bank's CacheDirectory and
+  // makes the same calls into it, in the same order, as global_cache.cpp and
+  // global_cache_coherence.cpp.
+  class DirProxy {
+    public:
+      DirProxy(int bank) : bank_id(bank) { dir.init(bank); }
+      void receive(const Msg &m);
+      void PerCycle();
+      bool quiescent();
+      void print_sharing_vector(uint32_t addr) { dir.DEBUG_print_sharing_vector(addr, stderr); }
+    private:
+      // Replies from one tile to a split broadcast, combined the way the tile
+      // network hands them to the G$.
+      struct SplitTile {
+        int remaining;
+        icmsg_type_t type;
+        std::set<int> skip;
+        std::set<int> valid;
+      };
+      bool helper_handle_directory_access(Msg &req, int replies, int requests);
+      bool helper_handle_probe_responses();
+      void helper_handle_directory_responses(int &replies);
+      void helper_split_reply(const Msg &m);
+      void send(Msg m, int cluster) {
+        m.to_gcache = false;
+        m.cluster = cluster;
+        network->send(m, bank_id);
+      }
+
+      int bank_id;
+      CacheDirectory dir;
+      // Functional only: overflow/hybrid lookups complete immediately.
+      directory::dir_of_timing_t timer;
+      std::list<Msg> request_buf;
+      std::list<Msg> probe_buf;
+      std::map< std::pair<uint32_t, int>, SplitTile > split_bcasts;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // ClusterAgent
+  //////////////////////////////////////////////////////////////////////////////
+  // Synthetic cluster with an unbounded cluster cache.  Requests, probe
+  // responses and the NAK bit follow L2Cache.
+  class ClusterAgent {
+    public:
+      ClusterAgent(int id);
+      void PerCycle();
+      void receive(const Msg &m);
+      int get_outstanding() const { return outstanding; }
+      // Report any request outstanding for longer than the watchdog.
+      void check_watchdog() const;
+      // End of run: every valid copy must match the golden model.
+      void check_final() const;
+      void dump_line(size_t idx) const;
+      line_state_t get_state(size_t idx) const { return (line_state_t)lines[idx].state; }
+
+    private:
+      struct Line {
+        uint8_t state;
+        uint8_t pend;
+        bool nak;           // Probe NAKed while a request was pending.
+        bool upgrade;       // Read release is the first half of an S->M upgrade.
+        bool ack_held;      // Broadcast ACK held until the read release returns.
+        bool op_is_store;
+        int op_word;
+        uint32_t op_value;
+        uint64_t pend_cycle;
+        uint32_t data[WORDS_PER_LINE];
+      };
+
+      void issue_load(size_t idx);
+      void issue_store(size_t idx);
+      void issue_evict(size_t idx);
+      void issue_atomic();
+      void helper_send(icmsg_type_t type, uint32_t addr, const Line *with_data);
+      void helper_pend(Line &l, line_pend_t p);
+      void helper_unpend(Line &l);
+      void helper_set_state(size_t idx, line_state_t s);
+      void helper_check_load(size_t idx, int word, uint32_t value);
+      void helper_do_store(size_t idx, int word, uint32_t value);
+      void helper_fill(const Msg &m);
+      void helper_release_done(const Msg &m);
+      void helper_handle_probe(const Msg &m);
+      void helper_handle_bcast_probe(const Msg &m);
+      void helper_send_bcast_ack(const Msg &probe, bool valid, const Line *with_data);
+
+      int id;
+      int outstanding;
+      int atomics_pending;
+      std::vector<Line> lines;
+      size_t recent[RECENT_LINES];
+      size_t recent_head;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // ClusterAgent implementation
+  //////////////////////////////////////////////////////////////////////////////
+  ClusterAgent::ClusterAgent(int id) :
+    id(id), outstanding(0), atomics_pending(0), lines(num_lines), recent_head(0)
+  {
+    for (size_t i = 0; i < lines.size(); i++) {
+      lines[i].state = LINE_I;
+      lines[i].pend = PEND_NONE;
+      lines[i].nak = lines[i].upgrade = lines[i].ack_held = false;
+    }
+    for (int i = 0; i < RECENT_LINES; i++) { recent[i] = 0; }
+  }
+
+  void
+  ClusterAgent::PerCycle()
+  {
+    using rigel::RNG;
+    if (outstanding >= MAX_OUTSTANDING) { return; }
+    if (!RNG.Prob(ISSUE_PROBABILITY)) { return; }
+
+    // Pick a line: mostly shared, biased toward a small contended set.
+    size_t idx;
+    unsigned int sel = RNG.Integer<unsigned int>(100);
+    if (sel < 10) {
+      idx = num_shared_lines + id * PRIVATE_LINES_PER_CLUSTER
+          + RNG.Integer<unsigned int>(PRIVATE_LINES_PER_CLUSTER);
+    } else if (sel < 35) {
+      idx = RNG.Integer<unsigned int>(HOT_LINES < (int)num_shared_lines ? HOT_LINES : num_shared_lines);
+    } else {
+      idx = RNG.Integer<unsigned int>(num_shared_lines);
+    }
+
+    unsigned int op = RNG.Integer<unsigned int>(100);
+    ops_issued++;
+    if (op < 50) { issue_load(idx); }
+    else if (op < 80) { issue_store(idx); }
+    else if (op < 95) { issue_evict(recent[RNG.Integer<unsigned int>(RECENT_LINES)]); }
+    else { issue_atomic(); }
+  }
+
+  void
+  ClusterAgent::issue_load(size_t idx)
+  {
+    Line &l = lines[idx];
+    test_stats.loads++;
+    if (l.state != LINE_I) {
+      test_stats.load_hits++;
+      helper_check_load(idx, rigel::RNG.Integer<unsigned int>(WORDS_PER_LINE), 0);
+      return;
+    }
+    if (l.pend != PEND_NONE) { test_stats.retries++; return; }
+    l.op_is_store = false;
+    l.op_word = rigel::RNG.Integer<unsigned int>(WORDS_PER_LINE);
+    helper_pend(l, PEND_READ);
+    helper_send(IC_MSG_READ_REQ, line_addr(idx), NULL);
+  }
+
+  void
+  ClusterAgent::issue_store(size_t idx)
+  {
+    Line &l = lines[idx];
+    int word = rigel::RNG.Integer<unsigned int>(WORDS_PER_LINE);
+    uint32_t value = rigel::RNG.Integer<uint32_t>();
+    test_stats.stores++;
+    if (l.state == LINE_M) {
+      test_stats.store_hits++;
+      helper_do_store(idx, word, value);
+      return;
+    }
+    if (l.pend != PEND_NONE) { test_stats.retries++; return; }
+    l.op_is_store = true;
+    l.op_word = word;
+    l.op_value = value;
+    if (l.state == LINE_S) {
+      // Same as cache_model_write.cpp: check the line back in and send the
+      // write once the read release returns.
+      l.upgrade = true;
+      helper_set_state(idx, LINE_I);
+      helper_pend(l, PEND_RD_REL);
+      helper_send(IC_MSG_CC_RD_RELEASE_REQ, line_addr(idx), NULL);
+      return;
+    }
+    helper_pend(l, PEND_WRITE);
+    Msg m;
+    m.type = IC_MSG_WRITE_REQ;
+    m.addr = line_addr(idx);
+    m.cluster = id;
+    m.to_gcache = true;
+    m.has_data = m.valid = m.incoherent = m.shootdown = false;
+    m.word = word;
+    m.value = value;
+    network->send(m, gcache_bank(m.addr));
+  }
+
+  void
+  ClusterAgent::issue_evict(size_t idx)
+  {
+    Line &l = lines[idx];
+    if (l.state == LINE_I || l.pend != PEND_NONE) { return; }
+    test_stats.evicts++;
+    if (l.state == LINE_S) {
+      l.upgrade = false;
+      helper_set_state(idx, LINE_I);
+      helper_pend(l, PEND_RD_REL);
+      helper_send(IC_MSG_CC_RD_RELEASE_REQ, line_addr(idx), NULL);
+    } else {
+      helper_set_state(idx, LINE_I);
+      helper_pend(l, PEND_WB);
+      helper_send(IC_MSG_LINE_WRITEBACK_REQ, line_addr(idx), &l);
+    }
+  }
+
+  void
+  ClusterAgent::issue_atomic()
+  {
+    Msg m;
+    int word = rigel::RNG.Integer<unsigned int>(NUM_ATOMIC_WORDS);
+    m.type = IC_MSG_ATOMINC_REQ;
+    m.addr = ATOMIC_BASE + word * LINESIZE;
+    m.cluster = id;
+    m.to_gcache = true;
+    m.has_data = m.valid = m.incoherent = m.shootdown = false;
+    m.word = word;
+    m.value = 0;
+    atomic_issued[word]++;
+    atomics_pending++;
+    outstanding++;
+    test_stats.atomics++;
+    network->send(m, gcache_bank(m.addr));
+  }
+
+  void
+  ClusterAgent::helper_send(icmsg_type_t type, uint32_t addr, const Line *with_data)
+  {
+    Msg m;
+    m.type = type;
+    m.addr = addr;
+    m.cluster = id;
+    m.to_gcache = true;
+    m.has_data = (with_data != NULL);
+    m.valid = m.incoherent = m.shootdown = false;
+    m.word = 0;
+    m.value = 0;
+    if (with_data) { memcpy(m.data, with_data->data, sizeof(m.data)); }
+    network->send(m, gcache_bank(addr));
+  }
+
+  void
+  ClusterAgent::helper_pend(Line &l, line_pend_t p)
+  {
+    if (PEND_NONE == l.pend) { outstanding++; }
+    l.pend = p;
+    l.pend_cycle = rigel::CURR_CYCLE;
+  }
+
+  void
+  ClusterAgent::helper_unpend(Line &l)
+  {
+    assert(PEND_NONE != l.pend);
+    l.pend = PEND_NONE;
+    outstanding--;
+    last_progress = rigel::CURR_CYCLE;
+  }
+
+  void
+  ClusterAgent::helper_set_state(size_t idx, line_state_t s)
+  {
+    Line &l = lines[idx];
+    if (LINE_S == l.state) { readers[idx]--; }
+    else if (LINE_M == l.state) { writer[idx] = -1; }
+    l.state = s;
+    if (LINE_S == s) {
+      readers[idx]++;
+      if (writer[idx] != -1) { report_error(line_addr(idx), "S copy granted while another cluster holds M", id); }
+    } else if (LINE_M == s) {
+      if (writer[idx] != -1 || readers[idx] != 0) {
+        report_error(line_addr(idx), "M copy granted while other copies are valid", id);
+      }
+      writer[idx] = id;
+    }
+  }
+
+  void
+  ClusterAgent::helper_check_load(size_t idx, int word, uint32_t value)
+  {
+    const Line &l = lines[idx];
+    uint32_t seen = (LINE_I == l.state) ? value : l.data[word];
+    if (seen != golden[idx * WORDS_PER_LINE + word]) {
+      fprintf(stderr, "[COHTEST] load of word %d returned 0x%08x, expected 0x%08x\n",
+        word, seen, golden[idx * WORDS_PER_LINE + word]);
+      report_error(line_addr(idx), "load returned a stale value", id);
+    }
+  }
+
+  void
+  ClusterAgent::helper_do_store(size_t idx, int word, uint32_t value)
+  {
+    Line &l = lines[idx];
+    assert(LINE_M == l.state);
+    if (writer[idx] != id) { report_error(line_addr(idx), "store without write ownership", id); }
+    l.data[word] = value;
+    golden[idx * WORDS_PER_LINE + word] = value;
+  }
+
+  void
+  ClusterAgent::receive(const Msg &m)
+  {
+    switch (m.type)
+    {
+      case IC_MSG_READ_REQ:
+      case IC_MSG_WRITE_REQ:
+        helper_fill(m);
+        break;
+      case IC_MSG_ATOMINC_REQ:
+        // Each fetch-and-increment result must be below the number issued.
+        if (m.value >= atomic_issued[m.word]) {
+          report_error(m.addr, "atomic returned a value that was never reached", id);
+        }
+        atomics_pending--;
+        outstanding--;
+        last_progress = rigel::CURR_CYCLE;
+        break;
+      case IC_MSG_CC_RD_RELEASE_REQ:
+      case IC_MSG_EVICT_REQ:
+      case IC_MSG_LINE_WRITEBACK_REQ:
+        helper_release_done(m);
+        break;
+      case IC_MSG_CC_INVALIDATE_PROBE:
+      case IC_MSG_CC_WR_RELEASE_PROBE:
+      case IC_MSG_CC_RD_RELEASE_PROBE:
+      case IC_MSG_CC_WR2RD_DOWNGRADE_PROBE:
+        helper_handle_probe(m);
+        break;
+      case IC_MSG_CC_BCAST_PROBE:
+      case IC_MSG_SPLIT_BCAST_INV_REQ:
+      case IC_MSG_SPLIT_BCAST_SHR_REQ:
+        helper_handle_bcast_probe(m);
+        break;
+      default:
+        // The G$ bounces probe responses for incoherent lines; nothing to do.
+        if (m.incoherent) { break; }
+        fprintf(stderr, "[COHTEST] unexpected message type %d\n", m.type);
+        report_error(m.addr, "unexpected message at cluster", id);
+    }
+  }
+
+  void
+  ClusterAgent::helper_fill(const Msg &m)
+  {
+    size_t idx = line_index(m.addr);
+    Line &l = lines[idx];
+    const bool is_write = (IC_MSG_WRITE_REQ == m.type);
+    if ((is_write ? PEND_WRITE : PEND_READ) != l.pend) {
+      report_error(m.addr, "fill without a matching request", id);
+    }
+    helper_unpend(l);
+    // Incoherent accesses are not cached.  The G$ performed any store.
+    if (m.incoherent) {
+      test_stats.uncached++;
+      if (!is_write) { helper_check_load(idx, l.op_word, m.data[l.op_word]); }
+      return;
+    }
+    memcpy(l.data, m.data, sizeof(l.data));
+    helper_set_state(idx, is_write ? LINE_M : LINE_S);
+    if (is_write) { helper_do_store(idx, l.op_word, l.op_value); }
+    else { helper_check_load(idx, l.op_word, 0); }
+    recent[recent_head++ % RECENT_LINES] = idx;
+
+    // A probe was NAKed while this request was in flight.  Use the line once
+    // and then give it back, as L2Cache does for set_probe_nak_bit().
+    if (l.nak) {
+      l.nak = false;
+      if (is_write) {
+        helper_set_state(idx, LINE_I);
+        helper_pend(l, PEND_WB);
+        helper_send(IC_MSG_EVICT_REQ, m.addr, &l);
+      } else {
+        l.upgrade = false;
+        helper_set_state(idx, LINE_I);
+        helper_pend(l, PEND_RD_REL);
+        helper_send(IC_MSG_CC_RD_RELEASE_REQ, m.addr, NULL);
+      }
+    }
+  }
+
+  void
+  ClusterAgent::helper_release_done(const Msg &m)
+  {
+    size_t idx = line_index(m.addr);
+    Line &l = lines[idx];
+    const bool is_read = (IC_MSG_CC_RD_RELEASE_REQ == m.type);
+    if ((is_read ? PEND_RD_REL : PEND_WB) != l.pend) {
+      report_error(m.addr, "release reply without a matching release", id);
+    }
+    helper_unpend(l);
+    // A broadcast arrived while the release was in flight.  Send the ACK now
+    // that the directory has seen the release.
+    if (l.ack_held) {
+      l.ack_held = false;
+      Msg probe;
+      probe.type = rigel::cache::ENABLE_BCAST_NETWORK ? IC_MSG_SPLIT_BCAST_INV_REQ : IC_MSG_CC_BCAST_PROBE;
+      probe.addr = m.addr;
+      helper_send_bcast_ack(probe, false, NULL);
+    }
+    if (is_read && l.upgrade) {
+      l.upgrade = false;
+      helper_pend(l, PEND_WRITE);
+      Msg w;
+      w.type = IC_MSG_WRITE_REQ;
+      w.addr = m.addr;
+      w.cluster = id;
+      w.to_gcache = true;
+      w.has_data = w.valid = w.incoherent = w.shootdown = false;
+      w.word = l.op_word;
+      w.value = l.op_value;
+      network->send(w, gcache_bank(m.addr));
+    }
+  }
+
+  void
+  ClusterAgent::helper_handle_probe(const Msg &m)
+  {
+    size_t idx = line_index(m.addr);
+    Line &l = lines[idx];
+    test_stats.probes++;
+    icmsg_type_t ack, nak;
+    switch (m.type) {
+      case IC_MSG_CC_INVALIDATE_PROBE: ack = IC_MSG_CC_INVALIDATE_ACK; nak = IC_MSG_CC_INVALIDATE_NAK; break;
+      case IC_MSG_CC_WR_RELEASE_PROBE: ack = IC_MSG_CC_WR_RELEASE_ACK; nak = IC_MSG_CC_WR_RELEASE_NAK; break;
+      default:                         ack = IC_MSG_CC_RD_RELEASE_ACK; nak = IC_MSG_CC_RD_RELEASE_NAK; break;
+    }
+    if (LINE_I == l.state) {
+      // Demand request already in the network: remember to give the line back
+      // when it arrives.
+      if (PEND_READ == l.pend || PEND_WRITE == l.pend) { l.nak = true; }
+      helper_send(nak, m.addr, NULL);
+      return;
+    }
+    const bool dirty = (LINE_M == l.state);
+    if (dirty && IC_MSG_CC_WR_RELEASE_PROBE != m.type) {
+      // Only a write release should find a dirty line.  Keep the data so the
+      // golden check stays meaningful, but count it.
+      test_stats.dirty_invalidates++;
+    }
+    if (IC_MSG_CC_WR2RD_DOWNGRADE_PROBE == m.type) { helper_set_state(idx, LINE_S); }
+    else { helper_set_state(idx, LINE_I); }
+    helper_send(ack, m.addr, dirty ? &l : NULL);
+  }
+
+  void
+  ClusterAgent::helper_handle_bcast_probe(const Msg &m)
+  {
+    using namespace rigel::cache;
+    test_stats.bcast_probes++;
+    // Probe filter shootdown of the line whose entry was taken for this
+    // broadcast.
+    if (ENABLE_PROBE_FILTER_DIRECTORY && m.shootdown) {
+      size_t sidx = line_index(m.shootdown_addr);
+      if (sidx < num_lines && LINE_M == lines[sidx].state) {
+        // L2Cache keeps a clean copy the directory no longer tracks.  Drop it
+        // here so the SWMR check does not trip on it.
+        helper_set_state(sidx, LINE_I);
+        helper_send(IC_MSG_CC_WR_RELEASE_ACK, m.shootdown_addr, &lines[sidx]);
+      }
+    }
+    size_t idx = line_index(m.addr);
+    if (idx == num_lines) {
+      // Not a line the agents cache (atomics are performed at the G$).
+      helper_send_bcast_ack(m, false, NULL);
+      return;
+    }
+    Line &l = lines[idx];
+    if (PEND_RD_REL == l.pend) {
+      l.ack_held = true;
+      return;
+    }
+    const bool valid = (LINE_I != l.state);
+    const bool dirty = (LINE_M == l.state);
+    if (IC_MSG_SPLIT_BCAST_SHR_REQ == m.type) {
+      if (dirty) { helper_set_state(idx, LINE_S); }
+    } else if (valid) {
+      if (dirty) { test_stats.dirty_invalidates++; }
+      helper_set_state(idx, LINE_I);
+    }
+    helper_send_bcast_ack(m, valid, dirty ? &l : NULL);
+  }
+
+  void
+  ClusterAgent::helper_send_bcast_ack(const Msg &probe, bool valid, const Line *with_data)
+  {
+    Msg r;
+    if (!rigel::cache::ENABLE_BCAST_NETWORK) { r.type = IC_MSG_CC_BCAST_ACK; }
+    else if (IC_MSG_SPLIT_BCAST_SHR_REQ == probe.type && valid) {
+      r.type = with_data ? IC_MSG_SPLIT_BCAST_OWNED_REPLY : IC_MSG_SPLIT_BCAST_SHR_REPLY;
+    } else { r.type = IC_MSG_SPLIT_BCAST_INV_REPLY; }
+    r.addr = probe.addr;
+    r.cluster = id;
+    r.to_gcache = true;
+    r.has_data = (with_data != NULL);
+    r.valid = valid;
+    r.incoherent = r.shootdown = false;
+    r.word = 0;
+    r.value = 0;
+    if (with_data) { memcpy(r.data, with_data->data, sizeof(r.data)); }
+    network->send(r, gcache_bank(r.addr));
+  }
+
+  void
+  ClusterAgent::check_watchdog() const
+  {
+    for (size_t i = 0; i < lines.size(); i++) {
+      if (PEND_NONE != lines[i].pend && rigel::CURR_CYCLE - lines[i].pend_cycle > WDT_CYCLES) {
+        report_error(line_addr(i), "request outstanding past the watchdog (deadlock?)", id);
+      }
+    }
+  }
+
+  void
+  ClusterAgent::check_final() const
+  {
+    for (size_t i = 0; i < lines.size(); i++) {
+      if (LINE_I == lines[i].state) { continue; }
+      if (0 != memcmp(lines[i].data, &golden[i * WORDS_PER_LINE], sizeof(lines[i].data))) {
+        report_error(line_addr(i), "cached copy differs from golden memory at end of run", id);
+      }
+    }
+  }
+
+  void
+  ClusterAgent::dump_line(size_t idx) const
+  {
+    const Line &l = lines[idx];
+    if (LINE_I == l.state && PEND_NONE == l.pend) { return; }
+    fprintf(stderr, "  cluster %3d: state %c pend %d nak %d upgrade %d ack_held %d since %llu\n",
+      id, "ISM"[l.state], l.pend, l.nak, l.upgrade, l.ack_held,
+      (unsigned long long)l.pend_cycle);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // DirProxy implementation
+  //////////////////////////////////////////////////////////////////////////////
+  void
+  DirProxy::receive(const Msg &m)
+  {
+    switch (m.type) {
+      case IC_MSG_READ_REQ:
+      case IC_MSG_WRITE_REQ:
+      case IC_MSG_ATOMINC_REQ:
+        request_buf.push_back(m);
+        break;
+      case IC_MSG_SPLIT_BCAST_INV_REPLY:
+      case IC_MSG_SPLIT_BCAST_SHR_REPLY:
+      case IC_MSG_SPLIT_BCAST_OWNED_REPLY:
+        helper_split_reply(m);
+        break;
+      default:
+        probe_buf.push_back(m);
+    }
+  }
+
+  void
+  DirProxy::helper_split_reply(const Msg &m)
+  {
+    using rigel::CLUSTERS_PER_TILE;
+    int tile = m.cluster / CLUSTERS_PER_TILE;
+    std::map< std::pair<uint32_t, int>, SplitTile >::iterator it =
+      split_bcasts.find(std::make_pair(m.addr, tile));
+    if (it == split_bcasts.end()) { report_error(m.addr, "split broadcast reply with no broadcast", m.cluster); }
+    SplitTile &st = it->second;
+    if (m.has_data) { memcpy(&gmem[line_index(m.addr) * WORDS_PER_LINE], m.data, sizeof(m.data)); }
+    if (m.valid) { st.valid.insert(m.cluster); }
+    if (IC_MSG_SPLIT_BCAST_OWNED_REPLY == m.type) { st.type = m.type; }
+    else if (IC_MSG_SPLIT_BCAST_SHR_REPLY == m.type && IC_MSG_SPLIT_BCAST_INV_REPLY == st.type) { st.type = m.type; }
+    // Once the whole tile has answered, hand one reply to the G$.
+    if (0 == --st.remaining) {
+      Msg r = m;
+      r.type = st.type;
+      r.cluster = tile * CLUSTERS_PER_TILE;
+      r.has_data = false;
+      probe_buf.push_back(r);
+    }
+  }
+
+  void
+  DirProxy::PerCycle()
+  {
+    int replies = rigel::cache::GCACHE_REPLY_PORTS_PER_BANK;
+    int requests = rigel::cache::GCACHE_REQUEST_PORTS_PER_BANK;
+
+    helper_handle_directory_responses(replies);
+    if (helper_handle_probe_responses()) { requests--; }
+
+    std::list<Msg>::iterator it = request_buf.begin();
+    while (it != request_buf.end() && replies > 0)
+    {
+      Msg &req = *it;
+      // If the directory entry for the address is locked, we do not allow
+      // other requests to the line to proceed here.
+      if (dir.check_atomic_lock(req.addr, req.cluster)) { ++it; continue; }
+      if (!helper_handle_directory_access(req, replies, requests)) { ++it; continue; }
+
+      // Permission held.  Service the request and reply.
+      replies--;
+      const bool global_op = ICMsg::check_is_global_operation(req.type);
+      if (!global_op) { dir.clear_fill_pending(req.addr, req.cluster); }
+      Msg reply = req;
+      if (global_op) {
+        reply.value = atomic_mem[req.word]++;
+      } else {
+        uint32_t *line = &gmem[line_index(req.addr) * WORDS_PER_LINE];
+        if (req.incoherent && IC_MSG_WRITE_REQ == req.type) {
+          line[req.word] = req.value;
+          golden[line_index(req.addr) * WORDS_PER_LINE + req.word] = req.value;
+        }
+        memcpy(reply.data, line, sizeof(reply.data));
+      }
+      send(reply, req.cluster);
+      // Unlock pending request
+      dir.clear_atomic_lock(req.addr, req.cluster);
+      it = request_buf.erase(it);
+    }
+  }
+
+  // Mirrors GlobalCache::helper_handle_directory_access().
+  bool
+  DirProxy::helper_handle_directory_access(Msg &req, int replies, int requests)
+  {
+    using namespace rigel;
+    uint32_t addr = req.addr;
+    int cluster = req.cluster;
+
+    // Skip over global operations for coherence actions.
+    if (ICMsg::check_is_global_operation(req.type)) { return true; }
+
+    if (hybrid_directory.hybrid_coherence_enabled(addr, timer)) {
+      req.incoherent = true;
+      return true;
+    }
+
+    if (ICMsg::check_is_read(req.type))
+    {
+      if (!dir.check_read_permission(addr, cluster, timer))
+      {
+        if (!dir.check_write_permission(addr, cluster, timer)) {
+          if (dir.check_request_pending(addr)) { return false; }
+          if (replies <= 0 || requests <= 0) { return false; }
+          test_stats.dir_transactions++;
+          if (!dir.request_read_permission(addr, cluster, timer)) {
+            if (ENABLE_OVERFLOW_DIRECTORY) { dir.set_atomic_lock(addr, cluster); }
+            return false;
+          }
+        } else {
+          test_stats.dir_transactions++;
+          dir.write_to_read_perm_downgrade(addr, cluster, timer);
+        }
+      }
+    } else if (ICMsg::check_is_write(req.type)) {
+      if (!dir.check_write_permission(addr, cluster, timer)) {
+        if (dir.check_request_pending(addr)) { return false; }
+        if (replies <= 0 || requests <= 0) { return false; }
+        test_stats.dir_transactions++;
+        if (!dir.request_write_permission(addr, cluster, timer)) {
+          if (ENABLE_OVERFLOW_DIRECTORY) { dir.set_atomic_lock(addr, cluster); }
+          return false;
+        }
+      }
+    } else {
+      report_error(addr, "unknown request type for directory", cluster);
+    }
+    // We have permission, lock line state until we return data to the requestor
+    dir.set_atomic_lock(addr, cluster);
+    return true;
+  }
+
+  // Mirrors GlobalCache::helper_handle_probe_responses().
+  bool
+  DirProxy::helper_handle_probe_responses()
+  {
+    if (probe_buf.empty()) { return false; }
+    Msg &m = probe_buf.front();
+    uint32_t addr = m.addr;
+    int cluster = m.cluster;
+
+    if (hybrid_directory.hybrid_coherence_enabled(addr, timer)) {
+      Msg r = m;
+      r.incoherent = true;
+      send(r, cluster);
+      probe_buf.pop_front();
+      return true;
+    }
+
+    // Dirty data rides along with write releases and writebacks.  The G$
+    // fills it before releasing ownership.
+    if (m.has_data) { memcpy(&gmem[line_index(addr) * WORDS_PER_LINE], m.data, sizeof(m.data)); }
+
+    switch (m.type)
+    {
+      case IC_MSG_CC_WR_RELEASE_ACK:
+      case IC_MSG_CC_WR2RD_DOWNGRADE_ACK:
+      case IC_MSG_CC_WR2RD_DOWNGRADE_NAK:
+      case IC_MSG_CC_WR_RELEASE_NAK:
+        test_stats.dir_transactions++;
+        dir.release_write_ownership(addr, cluster, m.type, timer);
+        break;
+      case IC_MSG_CC_INVALIDATE_NAK:
+      case IC_MSG_CC_RD_RELEASE_NAK:
+      case IC_MSG_CC_RD_RELEASE_ACK:
+      case IC_MSG_CC_INVALIDATE_ACK:
+        test_stats.dir_transactions++;
+        dir.release_read_ownership(addr, cluster, m.type, timer);
+        break;
+      case IC_MSG_SPLIT_BCAST_SHR_REPLY:
+      case IC_MSG_SPLIT_BCAST_OWNED_REPLY:
+      case IC_MSG_SPLIT_BCAST_INV_REPLY:
+      {
+        std::pair<uint32_t, int> key(addr, cluster / rigel::CLUSTERS_PER_TILE);
+        SplitTile &st = split_bcasts[key];
+        // Iterate through skip list and release lines not skipped.
+        for (int i = 0; i < rigel::CLUSTERS_PER_TILE; i++) {
+          int cid = cluster + i;
+          if (0 == st.skip.count(cid)) {
+            test_stats.dir_transactions++;
+            dir.release_read_ownership(addr, cid, m.type, timer, st.valid.count(cid) > 0);
+          }
+        }
+        split_bcasts.erase(key);
+        break;
+      }
+      case IC_MSG_CC_BCAST_ACK:
+        test_stats.dir_transactions++;
+        dir.release_read_ownership(addr, cluster, m.type, timer, m.valid);
+        break;
+      case IC_MSG_CC_RD_RELEASE_REQ:
+        test_stats.dir_transactions++;
+        dir.release_read_ownership(addr, cluster, IC_MSG_CC_RD_RELEASE_REQ, timer);
+        send(m, cluster);
+        break;
+      case IC_MSG_EVICT_REQ:
+      case IC_MSG_LINE_WRITEBACK_REQ:
+        test_stats.dir_transactions++;
+        dir.release_write_ownership(addr, cluster, m.type, timer);
+        send(m, cluster);
+        break;
+      default:
+        report_error(addr, "unexpected probe response at G$", cluster);
+    }
+    probe_buf.pop_front();
+    return true;
+  }
+
+  // Mirrors the probe injection half of
+  // GlobalCache::helper_handle_directory_responses().
+  void
+  DirProxy::helper_handle_directory_responses(int &replies)
+  {
+    ICMsg cc_probe_msg;
+    while (dir.get_next_pending_icmsg(cc_probe_msg))
+    {
+      replies--;
+      Msg p;
+      p.type = cc_probe_msg.get_type();
+      p.addr = cc_probe_msg.get_addr();
+      p.has_data = p.valid = p.incoherent = false;
+      p.word = 0;
+      p.value = 0;
+      p.shootdown = cc_probe_msg.get_bcast_write_shootdown_required() != 0;
+      p.shootdown_addr = p.shootdown ? cc_probe_msg.get_bcast_write_shootdown_addr() : 0;
+      if (IC_MSG_SPLIT_BCAST_INV_REQ == p.type || IC_MSG_SPLIT_BCAST_SHR_REQ == p.type)
+      {
+        // One message fans out to every cluster not on the skip list, and
+        // each tile answers with a single combined reply.
+        const std::set<int> &skip = cc_probe_msg.get_bcast_skip_list();
+        for (int tile = 0; tile < rigel::NUM_TILES; tile++) {
+          SplitTile &st = split_bcasts[std::make_pair(p.addr, tile)];
+          st.remaining = 0;
+          st.type = IC_MSG_SPLIT_BCAST_INV_REPLY;
+          st.skip = skip;
+          st.valid.clear();
+          for (int i = 0; i < rigel::CLUSTERS_PER_TILE; i++) {
+            int cid = tile * rigel::CLUSTERS_PER_TILE + i;
+            if (skip.count(cid)) { continue; }
+            st.remaining++;
+            send(p, cid);
+          }
+          if (0 == st.remaining) { split_bcasts.erase(std::make_pair(p.addr, tile)); }
+        }
+      } else {
+        send(p, cc_probe_msg.get_cluster());
+      }
+      dir.remove_next_pending_icmsg();
+      if (replies <= 0) { break; }
+    }
+  }
+
+  bool
+  DirProxy::quiescent()
+  {
+    ICMsg tmp;
+    return request_buf.empty() && probe_buf.empty() && split_bcasts.empty()
+        && !dir.get_next_pending_icmsg(tmp);
+  }
+
+  void
+  report_error(uint32_t addr, const char *what, int cluster)
+  {
+    fprintf(stderr, "[COHTEST ERROR] cycle %llu cluster %d addr 0x%08x: %s\n",
+      (unsigned long long)rigel::CURR_CYCLE, cluster, addr, what);
+    if (addr >= SHARED_BASE && !is_atomic_addr(addr)) {
+      size_t idx = line_index(addr);
+      if (idx < num_lines) {
+        fprintf(stderr, "  readers %d writer %d\n", readers[idx], writer[idx]);
+        for (size_t i = 0; i < agents.size(); i++) { agents[i]->dump_line(idx); }
+      }
+    }
+    fprintf(stderr, "  directory: ");
+    proxies[gcache_bank(addr)]->print_sharing_vector(addr);
+    fprintf(stderr, "\n");
+    throw ExitSim("cohtest: coherence check failed", 1);
+  }
+
+} // namespace cohtest
+
+static void helper_setup_other(CommandLineArgs &cmdline);
+static void helper_setup_dram(int numMemoryControllers);
+
+////////////////////////////////////////////////////////////////////////////////
+/// helper_setup_other()
+/// Initialize cluster counts and the coherence configuration.
+////////////////////////////////////////////////////////////////////////////////
+static void
+helper_setup_other(CommandLineArgs &cmdline)
+{
+  using namespace rigel;
+
+  CLUSTERS_PER_TILE = cmdline.get_val_int((char *)"NUM_CLUSTERS");
+  THREADS_PER_CORE  = cmdline.get_val_int((char *)"NUM_THREADS");
+  NUM_TILES         = cmdline.get_val_int((char *)"NUM_TILES");
+
+  NUM_CLUSTERS        = CLUSTERS_PER_TILE * NUM_TILES;
+  THREADS_PER_CLUSTER = CORES_PER_CLUSTER * THREADS_PER_CORE;
+  CORES_TOTAL         = NUM_CLUSTERS * CORES_PER_CLUSTER;
+  THREADS_TOTAL       = CORES_TOTAL * THREADS_PER_CORE;
+
+  // cohtest always runs the directory.  Overflow directory timing needs the G$
+  // to chase its target-memory accesses, which is not modeled here.
+  ENABLE_EXPERIMENTAL_DIRECTORY = true;
+  ENABLE_OVERFLOW_MODEL_TIMING = false;
+}
+
+void static
+helper_setup_dram(int numMemoryControllers)
+{
+  using namespace rigel::DRAM;
+  if(numMemoryControllers == -1)
+    CONTROLLERS = rigel::NUM_TILES;
+  else
+  {
+    //cannot be negative
+    if(numMemoryControllers <= 0)
+    {
+			std::cerr << "Error: -memchannels value (" << numMemoryControllers << ") must be > 0\n";
+      assert(0);
+    }
+    CONTROLLERS = numMemoryControllers;
+  }
+  rigel::NUM_GCACHE_BANKS = rigel::cache::GCACHE_BANKS_PER_MC * CONTROLLERS;
+  ROWS = 4096;
+  // The DRAM rank bits "fill in" whatever the other bit ranges do
+  // not cover.  They go in between row and bank bits (see address_mapping.h)
+  RANKS = (unsigned int)((uint64_t)(1ULL << 32) / CONTROLLERS / BANKS / ROWS / COLS / COLSIZE);
+  ROWS = ceil(((double)(1ULL << 32)) / ((double)CONTROLLERS * BANKS * RANKS * COLS * COLSIZE));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// main()
+/// Run the coherence stress test.  Exits with 0 if every check passed.
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char ** argv)
+{
+  using namespace cohtest;
+
+  rigel::NullInstr = &TempInstr;
+
+  CommandLineArgs cmdline(argc, argv);
+
+  srand(0); //We shouldn't use rand() or rand48(), but seed it just in case.
+
+  helper_setup_other(cmdline);
+  helper_setup_dram(cmdline.get_val_int((char *)"MEMCHANNELS"));
+  const uint64_t max_ops = cmdline.get_val_int((char *)"COHTEST_OPS");
+  num_shared_lines = cmdline.get_val_int((char *)"COHTEST_LINES");
+  const int max_latency = cmdline.get_val_int((char *)"COHTEST_MAX_LATENCY");
+  if (num_shared_lines == 0 || max_latency <= 0) {
+    throw CommandLineArgs::CommandLineError("--cohtest-lines and --cohtest-latency must be > 0");
+  }
+
+  // The directory code records into these, so set them up as sim.cpp does.
+  ProfileStat::init(stderr);
+  {
+    using namespace rigel::profiler;
+    stats[STATNAME_DIRECTORY_EVICTIONS].set_num_items(
+      rigel::COHERENCE_DIR_SETS*rigel::NUM_GCACHE_BANKS);
+    stats[STATNAME_DIRECTORY_EVICTION_SHARERS].set_num_items(
+      rigel::COHERENCE_DIR_SETS*rigel::NUM_GCACHE_BANKS);
+    stats[STATNAME_DIRECTORY_REREQUESTS].set_num_items(
+      rigel::COHERENCE_DIR_SETS*rigel::NUM_GCACHE_BANKS);
+  }
+  hybrid_directory.init();
+  // Dummy, only here so the rest of the simulator links and initializes.
+  GlobalTaskQueue = new TaskSystemBaseline;
+  rigel::ConstructionPayload dummy;
+  rigel::GlobalBackingStoreType backing_store(dummy, 0);
+  rigel::GLOBAL_BACKING_STORE_PTR = &backing_store;
+
+  // Golden model and G$ contents start out identical.
+  num_lines = num_shared_lines + rigel::NUM_CLUSTERS * PRIVATE_LINES_PER_CLUSTER;
+  golden.resize(num_lines * WORDS_PER_LINE);
+  for (size_t i = 0; i < golden.size(); i++) { golden[i] = (uint32_t)(i * 2654435761u); }
+  gmem = golden;
+  readers.assign(num_lines, 0);
+  writer.assign(num_lines, -1);
+  atomic_mem.assign(NUM_ATOMIC_WORDS, 0);
+  atomic_issued.assign(NUM_ATOMIC_WORDS, 0);
+  memset(&test_stats, 0, sizeof(test_stats));
+  ops_issued = 0;
+  last_progress = 0;
+
+  network = new Network(rigel::NUM_CLUSTERS, rigel::NUM_GCACHE_BANKS, max_latency);
+  for (int b = 0; b < rigel::NUM_GCACHE_BANKS; b++) { proxies.push_back(new DirProxy(b)); }
+  for (int c = 0; c < rigel::NUM_CLUSTERS; c++) { agents.push_back(new ClusterAgent(c)); }
+
+  fprintf(stderr, "cohtest: %d clusters (%d tiles), %d G$ banks, %zu shared lines, "
+                  "%llu ops, directory %d sets x %d ways%s%s%s%s%s\n",
+    rigel::NUM_CLUSTERS, rigel::NUM_TILES, rigel::NUM_GCACHE_BANKS, num_shared_lines,
+    (unsigned long long)max_ops, rigel::COHERENCE_DIR_SETS, rigel::COHERENCE_DIR_WAYS,
+    rigel::cache::ENABLE_LIMITED_DIRECTORY ? " limited" : "",
+    rigel::cache::ENABLE_PROBE_FILTER_DIRECTORY ? " probe-filter" : "",
+    rigel::cache::ENABLE_BCAST_NETWORK ? " bcast-network" : "",
+    rigel::ENABLE_OVERFLOW_DIRECTORY ? " overflow" : "",
+    rigel::CMDLINE_ENABLE_HYBRID_COHERENCE ? " hybrid" : "");
+
+  struct timeval tv_start, tv_end;
+  gettimeofday(&tv_start, NULL);
+
+  std::vector<Msg> due;
+  try {
+    for (rigel::CURR_CYCLE = 1; ; rigel::CURR_CYCLE++)
+    {
+      // Deliver everything due this cycle, then let every agent and G$ bank
+      // take a step.  Directory PerCycle() sampling is skipped since
+      // get_num_valid_entries() currently bails out (see the FIXME there).
+      network->take_due(due);
+      for (size_t i = 0; i < due.size(); i++) {
+        const Msg &m = due[i];
+        if (m.to_gcache) { proxies[gcache_bank(m.addr)]->receive(m); }
+        else { agents[m.cluster]->receive(m); }
+      }
+      due.clear();
+
+      const bool issuing = ops_issued < max_ops;
+      int outstanding = 0;
+      for (size_t c = 0; c < agents.size(); c++) {
+        if (issuing) { agents[c]->PerCycle(); }
+        outstanding += agents[c]->get_outstanding();
+      }
+      for (size_t b = 0; b < proxies.size(); b++) { proxies[b]->PerCycle(); }
+
+      if (0 == rigel::CURR_CYCLE % WDT_SCAN_INTERVAL) {
+        for (size_t c = 0; c < agents.size(); c++) { agents[c]->check_watchdog(); }
+      }
+
+      // Drained: nothing outstanding, in flight or queued at the directories.
+      if (!issuing && 0 == outstanding && 0 == network->get_in_flight()) {
+        bool quiet = true;
+        for (size_t b = 0; b < proxies.size() && quiet; b++) { quiet = proxies[b]->quiescent(); }
+        if (quiet) { break; }
+      }
+      if (rigel::CURR_CYCLE - last_progress > WDT_CYCLES) {
+        throw ExitSim("cohtest: no request completed within the watchdog (deadlock?)", 1);
+      }
+    }
+  }
+  catch (ExitSim e)
+  {
+		std::cerr << "EXIT REASON, " << e.reason << "\n";
+    exit(1);
+  }
+
+  gettimeofday(&tv_end, NULL);
+  double secs = (tv_end.tv_sec - tv_start.tv_sec) + (tv_end.tv_usec - tv_start.tv_usec) / 1e6;
+  if (secs <= 0.0) { secs = 1e-6; }
+
+  // End of run: every cached copy and every uncached line must match.
+  try {
+    for (size_t c = 0; c < agents.size(); c++) { agents[c]->check_final(); }
+    for (size_t i = 0; i < num_lines; i++) {
+      if (writer[i] != -1) { continue; }
+      if (0 != memcmp(&gmem[i * WORDS_PER_LINE], &golden[i * WORDS_PER_LINE],
+                      WORDS_PER_LINE * sizeof(uint32_t))) {
+        report_error(line_addr(i), "G$ contents differ from golden memory at end of run", -1);
+      }
+    }
+    for (int w = 0; w < NUM_ATOMIC_WORDS; w++) {
+      if (atomic_mem[w] != atomic_issued[w]) {
+        report_error(ATOMIC_BASE + w * LINESIZE, "atomic increments were lost", -1);
+      }
+    }
+  }
+  catch (ExitSim e)
+  {
+		std::cerr << "EXIT REASON, " << e.reason << "\n";
+    exit(1);
+  }
+
+  fprintf(stderr, "cohtest: PASSED in %llu cycles, %.3f host seconds\n",
+    (unsigned long long)rigel::CURR_CYCLE, secs);
+  fprintf(stderr, "  loads %llu (%llu hits)  stores %llu (%llu hits)  evictions %llu  "
+                  "atomics %llu  uncached %llu  retries %llu\n",
+    (unsigned long long)test_stats.loads, (unsigned long long)test_stats.load_hits,
+    (unsigned long long)test_stats.stores, (unsigned long long)test_stats.store_hits,
+    (unsigned long long)test_stats.evicts, (unsigned long long)test_stats.atomics,
+    (unsigned long long)test_stats.uncached, (unsigned long long)test_stats.retries);
+  fprintf(stderr, "  probes %llu  broadcast probes %llu  dirty lines invalidated %llu\n",
+    (unsigned long long)test_stats.probes, (unsigned long long)test_stats.bcast_probes,
+    (unsigned long long)test_stats.dirty_invalidates);
+  fprintf(stderr, "  directory transactions %llu (%.0f per host second, %.0f cycles per host second)\n",
+    (unsigned long long)test_stats.dir_transactions, test_stats.dir_transactions / secs,
+    rigel::CURR_CYCLE / secs);
+  return 0;
+}
@@ -11,6 +11,8 @@
 #include "packet/packet.h"
 
 #include "isa/rigel_isa.h"
+#include "core/lockstep_engine.h"
+#include "shell/control_server.h"
 
 #include "util/rigelprint.h"
 
@@ -44,14 +46,15 @@ CoreFunctional::CoreFunctional(
   width(CF_WIDTH),
   numthreads(rigel::THREADS_PER_CORE),
   current_tid(0),
+  lockstep_cycle(UINT64_MAX),
   syscall_handler(cp.syscall),
   thread_state(numthreads)
 {
   cp.parent = this;
 	cp.component_name.clear();
 
-  std::string pname_out = PortName(name(), id(), "cache_out");
-  std::string pname_in  = PortName(name(), id(), "cache_in");
+  PortID pname_out = PortName(this, "cache_out");
+  PortID pname_in  = PortName(this, "cache_in");
   to_ccache   =  new OutPortBase<Packet*>(pname_out);
   to_ccache->owner(this);
   from_ccache =  new InPortBase<Packet*>(pname_in);
@@ -67,11 +70,9 @@ CoreFunctional::CoreFunctional(
     CoreFunctionalThreadState *ts = thread_state[t];
 
     if (rigel::DUMP_REGISTER_TRACE) {
-      char filename[128];
-      // set up RF tracing if requested
-      sprintf(filename,"%s/rf.%d.%d.trace", rigel::DUMPFILE_PATH.c_str(), id(), t);
-      ts->rf.setTraceFile(filename);
-      ts->sprf.setTraceFile(filename);
+      // set up RF tracing if requested, decode with rftrace
+      ts->rf.setTraceThread(GTID(t));
+      ts->sprf.setTraceThread(GTID(t));
     }
 
     // configure this core's SPRF settings as necessary
@@ -87,7 +88,10 @@ CoreFunctional::CoreFunctional(
     ts->sprf.assign(SPRF_CORES_TOTAL,         rigel::CORES_TOTAL);
     ts->sprf.assign(SPRF_THREADS_TOTAL,       rigel::THREADS_TOTAL);
   }
-  
+
+  if (cp.lockstep) {
+    cp.lockstep->add(this);
+  }
 
 }
 
@@ -110,6 +114,11 @@ CoreFunctional::PerCycle() {
     return halted();
   }
 
+  // the lockstep engine already executed our instruction this cycle
+  if (lockstep_cycle == rigel::CURR_CYCLE) {
+    return halted();
+  }
+
   //if (sprf[SPRF_SLEEP].u32()) {
   //  return 0;
   //}
@@ -196,6 +205,32 @@ CoreFunctional::thread_select() {
   return -1;
 }
 
+// lockstep_thread()
+// the thread PerCycle() would start a new instruction for, without selecting it
+int
+CoreFunctional::lockstep_thread() {
+  if (halted()) {
+    return -1;
+  }
+  int tid = thread_select();
+  if (tid < 0 || thread_state[tid]->instr) {
+    return -1;
+  }
+  return tid;
+}
+
+// lockstep_retire()
+// stand-in for fetch through writeback of a register-only instruction
+void
+CoreFunctional::lockstep_retire(int tid, uint32_t dest, rword32_t value) {
+  CoreFunctionalThreadState *ts = thread_state[tid];
+  current_tid = tid;
+  ts->rf.write(dest, regval32_t(value.u32), ts->pc_);
+  ts->pc_ += 4;
+  lockstep_cycle = rigel::CURR_CYCLE;
+  rigel::RETIRED_INSTRS_TOTAL++;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 PipePacket*
@@ -280,6 +315,13 @@ CoreFunctional::writeback( PipePacket* instr ) {
     }
   }
 
+  rigel::RETIRED_INSTRS_TOTAL++;
+
+  // only ever set by rigel::CONTROL
+  if (instr->isBreakpoint()) {
+    rigel::CONTROL->PCHit(GTID(instr->tid()), instr->pc());
+  }
+
   if (DB_CF) {instr->Dump();}
 
 }
@@ -316,38 +358,10 @@ CoreFunctional::execute( PipePacket* instr ) {
     instr->sreg_t().u32(), instr->sreg_s().u32(), 
     instr->imm16(), instr->simm16(), instr->imm5());
 
-  // FIXME: switch statement based on pre-decoded type in sdInfo?
-  // TODO:  switches could be on per-type enums (ALU, FPU, mem, etc) 
-  //  like RTL rather than full I_TYPE enum
-  
-  // ALU
-  if (instr->isALU()) {
-    DPRINT(DB_CF,"%s: isALU\n", __func__);
-    RigelISA::execALU(instr);
-  }
-  // shift
-  else if (instr->isShift()) {
-    DPRINT(DB_CF,"%s: isALU\n", __func__);
-    RigelISA::execShift(instr);
-  }
-  // FPU
-  else if (instr->isFPU()) {
-    DPRINT(DB_CF,"%s: isFPU\n", __func__);
-    RigelISA::execFPU(instr);
-  }
-  // Memory (address computation here)
-  else if (instr->isMem()) {
-    RigelISA::execAddressGen(instr);
-  }
-  // Comparisons
-  else if (instr->isCompare()) {
-    DPRINT(DB_CF,"%s: isCompare\n", __func__);
-    RigelISA::execCompare(instr);
-  }
-  // instructions that modify the PC in some way
-  else if (instr->isBranch()) {
-    DPRINT(DB_CF,"%s: isBranch\n", __func__);
-    RigelISA::execBranch(instr);
+  // ALU, shift, FPU, address generation, compare and branch all go through
+  // the RigelISA handler chosen once at decode (StaticDecodeInfo::exec())
+  if (exec_handler_t exec = instr->sdInfo().exec()) {
+    exec(instr);
   }
   // Sim special ops
   else if (instr->isSimSpecial()) {
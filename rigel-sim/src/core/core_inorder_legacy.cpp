@@ -27,6 +27,7 @@
 #include "instrstats.h"     // for InstrCycleStats, InstrStats
 #include "locality_tracker.h"  // for LocalityTracker, etc
 #include "core/regfile_legacy.h"        // for SpRegisterFileLegacy, etc
+#include "profile/profile.h"        // for Profile, ::PC_SAMPLE_FETCH, etc
 #include "rigellib.h"       // for ::SPRF_CLUSTER_ID, etc
 #include "core/scoreboard.h"     // for ScoreBoard, etc
 #include "sim.h"            // for THREADS_PER_CORE, NullInstr, etc
@@ -45,6 +46,36 @@ bool CoreInOrderLegacy::is_fetch_stalled() const {
   return decode_stage->is_stalled(rigel::ISSUE_WIDTH-1);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// halt()
+////////////////////////////////////////////////////////////////////////////////
+// halts thread tid.  The cluster keeps a running count of fully-halted cores so
+// that it does not have to poll every core each cycle.
+void CoreInOrderLegacy::halt(int tid) {
+  if (PipeThreadState[tid]._halt) { return; }
+  PipeThreadState[tid]._halt = true;
+  if (is_halted()) { cluster->CoreHalted(); }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CheckBlockedOnTaskQueue()
+////////////////////////////////////////////////////////////////////////////////
+// Called by the cluster after UpdateLatches().  The core is safe to put to
+// sleep only if nothing is in flight behind (older than) the blocked dequeue;
+// otherwise those instructions would be frozen along with it.
+bool CoreInOrderLegacy::CheckBlockedOnTaskQueue() {
+  if (!blocked_on_task_queue) { return false; }
+  blocked_on_task_queue = false;
+  for (int l = MC2FP; l <= CC2WB; l++) {
+    for (int k = 0; k < rigel::ISSUE_WIDTH; k++) {
+      if (latches[l][k] != rigel::NullInstr || nlatches[l][k] != rigel::NullInstr) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // get_regfile() 
 ////////////////////////////////////////////////////////////////////////////////
@@ -80,7 +111,8 @@ CoreInOrderLegacy::CoreInOrderLegacy(rigel::ConstructionPayload cp, ClusterLegac
   cluster(_cluster),
   last_fetch_instr_num(std::numeric_limits<uint64_t>::max()),
   last_commit_cycle(0),
-  fetch_thread_id(0) //set starting thread to local thread 0
+  fetch_thread_id(0), //set starting thread to local thread 0
+  blocked_on_task_queue(false)
 {
 	cp.parent = this;
 	cp.component_name.clear();
@@ -507,6 +539,11 @@ CoreInOrderLegacy::~CoreInOrderLegacy() {
 ////////////////////////////////////////////////////////////////////////////////
 int CoreInOrderLegacy::PerCycle() {
 
+  if (rigel::profiler::PER_PC_SAMPLE_PERIOD != 0
+      && rigel::CURR_CYCLE % rigel::profiler::PER_PC_SAMPLE_PERIOD == 0) {
+    SamplePC();
+  }
+
    // don't allow switch if selected core has not yet initiated a fetch to prevent starvation
    if(rigel::THREADS_PER_CORE > 1 && !get_fetch_thread_state()->waiting_to_fetch)
      thread_switch();
@@ -542,10 +579,51 @@ int CoreInOrderLegacy::PerCycle() {
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// CoreInOrderLegacy::SamplePC()
+////////////////////////////////////////////////////////////////////////////////
+// Sampled per-PC profiling.  The oldest instruction in the pipeline is the one
+// everything else is waiting on, so the sample goes to its PC and the stage it
+// is in.  With nothing in flight the core is waiting on fetch.
+////////////////////////////////////////////////////////////////////////////////
+void CoreInOrderLegacy::SamplePC() {
+  if (is_halted()) {
+    return;
+  }
+  Profile *profiler = get_cluster()->getProfiler();
+  for (int l = CC2WB; l >= IF2DC; l--) {
+    for (int w = 0; w < rigel::ISSUE_WIDTH; w++) {
+      InstrSlot instr = latches[l][w];
+      if (instr != rigel::NullInstr && instr->get_type() != I_NULL) {
+        profiler->per_pc_sample(instr->get_currPC(), (pc_sample_reason_t)(PC_SAMPLE_DECODE + l));
+        return;
+      }
+    }
+  }
+  profiler->per_pc_sample(GetCurPC(), PC_SAMPLE_FETCH);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// charge_stuck_behind()
+////////////////////////////////////////////////////////////////////////////////
+// Per-instruction profiling for an instruction that did not stall itself but
+// could not move because something downstream did.
+////////////////////////////////////////////////////////////////////////////////
+static inline void
+charge_stuck_behind(InstrSlot instr)
+{
+  if (instr != rigel::NullInstr) { instr->stats.cycles.stuck_behind_other_instr++; }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // UpdateLatches()
 ////////////////////////////////////////////////////////////////////////////////
 // updates the latches for the core (clock edge)
+//
+// Latches are clocked back to front and latching stops at the first stalled
+// stage.  Everything that did not move is charged stuck_behind_other_instr
+// once at the end instead of incrementing every latch up front and
+// decrementing the ones that moved.
 ////////////////////////////////////////////////////////////////////////////////
 void CoreInOrderLegacy::UpdateLatches() {
 
@@ -557,14 +635,16 @@ void CoreInOrderLegacy::UpdateLatches() {
   // reverse order as we attempt to latch, we could avoid executing things
   // we don't need due to stalls
   //////////////////////////////////////////////////////////////////////////
-  
+
+  // Latch and pipe where latching stopped.
+  int stall_latch, stall_pipe;
+
   // latch back to front
 
   //////////////////////////////////////////////////////////////////////////
   // CLUSTER CACHE ACCESS -> WRITEBACK
   //////////////////////////////////////////////////////////////////////////
   for (int  k = rigel::ISSUE_WIDTH-1; k >= 0; k--) {
-    nlatches[CC2WB][k]->stats.cycles.stuck_behind_other_instr--;
     latches[CC2WB][k]  = nlatches[CC2WB][k];
     nlatches[CC2WB][k] = rigel::NullInstr;
   }
@@ -578,9 +658,9 @@ void CoreInOrderLegacy::UpdateLatches() {
     // execute as well.
     if (ccache_stage->is_stalled(k)) {
       force_thread_swap(); //FIXME This is currently ignored.
+      stall_latch = FP2CC; stall_pipe = k;
       goto done_latching;
     } else {
-      nlatches[FP2CC][k]->stats.cycles.stuck_behind_other_instr--;
       latches[FP2CC][k]  = nlatches[FP2CC][k];
       nlatches[FP2CC][k] = rigel::NullInstr;
     }
@@ -596,9 +676,9 @@ void CoreInOrderLegacy::UpdateLatches() {
       //For now, it never stalls.
       //std::cout << "FP Stalling" <<"\n";
 
+      stall_latch = MC2FP; stall_pipe = k;
       goto done_latching;
     } else {
-      nlatches[MC2FP][k]->stats.cycles.stuck_behind_other_instr--;
       latches[MC2FP][k]  = nlatches[MC2FP][k];
       nlatches[MC2FP][k] = rigel::NullInstr;
     }
@@ -617,14 +697,10 @@ void CoreInOrderLegacy::UpdateLatches() {
       cerr << ") Cycle " << rigel::CURR_CYCLE << "\n";
       #endif
 
+      stall_latch = EX2MC; stall_pipe = k;
       goto done_latching;
     } else {
-     /* if (nlatches[EX2MC][k] != rigel::NullInstr){
-        fprintf(stderr, "Core: %d \n",core_num );
-        nlatches[EX2MC][k]->dump();
-      }*/
       // do the latching
-      nlatches[EX2MC][k]->stats.cycles.stuck_behind_other_instr--;
       latches[EX2MC][k]  = nlatches[EX2MC][k];
       nlatches[EX2MC][k] = rigel::NullInstr;
 
@@ -642,9 +718,9 @@ void CoreInOrderLegacy::UpdateLatches() {
       cerr << "EX Stalling - (core " << cnum << ":thr " << tnum << ") (pipe " << k;
       cerr << ") Cycle " << rigel::CURR_CYCLE << "\n";
       #endif
+      stall_latch = DC2EX; stall_pipe = k;
       goto done_latching;
     } else {
-      nlatches[DC2EX][k]->stats.cycles.stuck_behind_other_instr--;
       latches[DC2EX][k]  = nlatches[DC2EX][k];
       nlatches[DC2EX][k] = rigel::NullInstr;
     }
@@ -655,19 +731,26 @@ void CoreInOrderLegacy::UpdateLatches() {
   //////////////////////////////////////////////////////////////////////////
   for (int  k = rigel::ISSUE_WIDTH-1; k >= 0; k--) {
     if (!fetch_stage->is_stalled(k)) {
-      nlatches[IF2DC][k]->stats.cycles.stuck_behind_other_instr--;
       latches[IF2DC][k]  = nlatches[IF2DC][k];
       nlatches[IF2DC][k] = rigel::NullInstr;
+    } else {
+      charge_stuck_behind(nlatches[IF2DC][k]);
     }
-    //else
-    //std::cout << "IF Stalling" << "\n";
   }
-  // If we find a stall, all latching stops
-      
- done_latching:
- ;
- //return 0;
+  return;
 
+  // If we find a stall, all latching stops.  Pipes are clocked from
+  // ISSUE_WIDTH-1 down, so the stalled pipe and every pipe below it stay
+  // put, as does every earlier latch.
+ done_latching:
+  for (int k = stall_pipe; k >= 0; k--) {
+    charge_stuck_behind(nlatches[stall_latch][k]);
+  }
+  for (int l = stall_latch - 1; l >= IF2DC; l--) {
+    for (int k = 0; k < rigel::ISSUE_WIDTH; k++) {
+      charge_stuck_behind(nlatches[l][k]);
+    }
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,189 @@
+#include "core/core_trace_player.h"
+#include "sim.h"
+#include "memory/backing_store.h"
+#include "util/construction_payload.h"
+#include "packet/packet.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+
+#define DB_TP 0
+
+#define GTID(localtid) ( id() * numthreads + localtid )
+
+TracePlayerSource *rigel::TRACE_PLAYER = NULL;
+
+///////////////////////////////////////////////////////////////////////////////
+/// TracePlayerSource
+///////////////////////////////////////////////////////////////////////////////
+TracePlayerSource::TracePlayerSource(const std::string &filename) :
+  _sw_threads(0)
+{
+  mtr = init_trace_reader(filename.c_str());
+  if (mtr == NULL) {
+    fprintf(stderr, "Error: unable to open memory trace '%s'\n", filename.c_str());
+    exit(1);
+  }
+}
+
+TracePlayerSource::~TracePlayerSource() {
+  destroy_mem_trace_reader(mtr);
+}
+
+bool
+TracePlayerSource::next(int gtid, extended_info &ei) {
+  // a software thread can contain no accesses, so keep pulling until one
+  // turns up or the trace runs dry
+  while (!get_next_thread_access(mtr, gtid, &ei)) {
+    if (trace_reader_eof(mtr)) {
+      return false;
+    }
+    buffer_a_thread_max(mtr, gtid, INT_MAX);
+    _sw_threads++;
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// constructor
+///////////////////////////////////////////////////////////////////////////////
+CoreTracePlayer::CoreTracePlayer(
+  rigel::ConstructionPayload cp
+) :
+  CoreBase(cp.change_name("CoreTracePlayer")),
+  numthreads(rigel::THREADS_PER_CORE),
+  threads_done(0),
+  last_issued(0),
+  thread_state(numthreads),
+  reads(0),
+  writes(0)
+{
+  cp.parent = this;
+	cp.component_name.clear();
+
+  assert(rigel::TRACE_PLAYER && "CoreTracePlayer needs --trace-player <trace>");
+
+  PortID pname_out = PortName(this, "cache_out");
+  PortID pname_in  = PortName(this, "cache_in");
+  to_ccache   =  new OutPortBase<Packet*>(pname_out);
+  to_ccache->owner(this);
+  from_ccache =  new InPortBase<Packet*>(pname_in);
+  from_ccache->owner(this);
+
+  // prime every thread with its first access
+  for (int t = 0; t < numthreads; t++) {
+    fetch_next(t);
+  }
+}
+
+/// destructor
+CoreTracePlayer::~CoreTracePlayer() {
+  for (int t = 0; t < numthreads; t++) {
+    delete thread_state[t].pending;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// fetch_next
+///////////////////////////////////////////////////////////////////////////////
+/// the recorded gap counts non-memory instructions since the previous access,
+/// charged at one per cycle from the time that access completed
+void
+CoreTracePlayer::fetch_next(int tid) {
+  TracePlayerThreadState &ts = thread_state[tid];
+  if (rigel::TRACE_PLAYER->next(GTID(tid), ts.next)) {
+    ts.ready_cycle = rigel::CURR_CYCLE + ts.next.interval;
+  } else {
+    ts.done = true;
+    threads_done++;
+    if (halted()) {
+      printf("Halting Core %d (trace exhausted) @ cycle %" PRIu64 ": %" PRIu64 " reads, %" PRIu64 " writes\n",
+        id(), rigel::CURR_CYCLE, reads, writes);
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// PerCycle()
+///////////////////////////////////////////////////////////////////////////////
+int
+CoreTracePlayer::PerCycle() {
+
+  if (halted()) {
+    return halted();
+  }
+
+  // retire a reply
+  Packet* reply = from_ccache->read();
+  if (reply) {
+    int tid = reply->gtid() - GTID(0);
+    assert(tid >= 0 && tid < numthreads && thread_state[tid].pending == reply);
+    DPRINT(DB_TP,"core %d tid %d reply addr %08x\n", id(), tid, reply->addr());
+    delete reply;
+    thread_state[tid].pending = NULL;
+    fetch_next(tid);
+  }
+
+  // issue from the first ready thread after the last one to issue
+  for (int i = 1; i <= numthreads; i++) {
+    int tid = (last_issued + i) % numthreads;
+    TracePlayerThreadState &ts = thread_state[tid];
+    if (ts.done || ts.pending || ts.ready_cycle > rigel::CURR_CYCLE) {
+      continue;
+    }
+
+    // trace addresses need not be word aligned
+    uint32_t addr = ts.next.ai.addr & ~0x3U;
+    Packet* p;
+    if (ts.next.read) {
+      p = new Packet(IC_MSG_READ_REQ);
+      p->initCorePacket(addr, 0, id(), GTID(tid));
+    } else {
+      // the trace has no store data, so store back what is already there
+      p = new Packet(IC_MSG_WRITE_REQ);
+      p->initCorePacket(addr, mem_backing_store->read_data_word(addr), id(), GTID(tid));
+    }
+    p->pc(ts.next.ai.eip);
+
+    if (to_ccache->sendMsg(p) == ACK) {
+      ts.pending = p;
+      ts.pc = ts.next.ai.eip;
+      if (ts.next.read) { reads++; } else { writes++; }
+      last_issued = tid;
+    } else {
+      delete p; // retry next cycle
+    }
+    break;
+  }
+
+  return halted();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Dump
+///////////////////////////////////////////////////////////////////////////////
+void
+CoreTracePlayer::Dump() {
+  printf("%s[%d]::%s reads: %" PRIu64 " writes: %" PRIu64 "\n",
+    name().c_str(), id(), __func__, reads, writes);
+  for (int t = 0; t < numthreads; t++) {
+    TracePlayerThreadState &ts = thread_state[t];
+    printf("tid[%d] pc: %08x done: %d pending: %d ready: %" PRIu64 "\n",
+      t, ts.pc, ts.done, (ts.pending != NULL), ts.ready_cycle);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// heartbeat
+///////////////////////////////////////////////////////////////////////////////
+void
+CoreTracePlayer::Heartbeat() {
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// called at termination of simulation
+///////////////////////////////////////////////////////////////////////////////
+void
+CoreTracePlayer::EndSim() {
+}
@@ -0,0 +1,258 @@
+#include "core/lockstep_engine.h"
+#include "core/core_functional.h"
+#include "core/regfile.h"
+#include "instr.h"
+#include "instr/decode_table.h"
+#include "memory/backing_store.h"
+#include "sim.h"
+
+#include <inttypes.h>
+#include <cmath>
+#include <cstdio>
+
+// run 'stmt' once per lane of the group: one loop per operation, so each
+// case is a plain loop over the operand arrays that the compiler vectorizes
+#define LANES(stmt) for (int i = 0; i < n; i++) { stmt; } break
+
+namespace {
+
+// count leading zeros exactly as RigelISA::execALU() does (33 for zero)
+inline uint32_t rigel_clz(uint32_t val) {
+  uint32_t lz;
+  for (lz = 0; lz <= 32; ) {
+    if (val & 0x80000000) { break; }
+    val = val << 1;
+    lz++;
+  }
+  return lz;
+}
+
+} // end anonymous namespace
+
+///////////////////////////////////////////////////////////////////////////////
+/// constructor
+///////////////////////////////////////////////////////////////////////////////
+LockstepEngine::LockstepEngine() :
+  ops(Op(), 256),
+  group_of(-1, 64),
+  stat_groups(0),
+  stat_instrs(0)
+{ }
+
+///////////////////////////////////////////////////////////////////////////////
+/// PerCycle()
+///////////////////////////////////////////////////////////////////////////////
+void
+LockstepEngine::PerCycle() {
+
+  // group the threads that can start an instruction this cycle by PC
+  lanes.clear();
+  groups.clear();
+  group_of.clear();
+  for (size_t c = 0; c < cores.size(); c++) {
+    int tid = cores[c]->lockstep_thread();
+    if (tid < 0) {
+      continue;
+    }
+    uint32_t pc = cores[c]->pc(tid);
+    int &g = group_of.insert(pc);
+    if (g < 0) {
+      g = groups.size();
+      Group ng = { pc, -1, 0 };
+      groups.push_back(ng);
+    }
+    Lane l = { cores[c], tid, groups[g].head };
+    groups[g].head = lanes.size();
+    groups[g].size++;
+    lanes.push_back(l);
+  }
+
+  if (lanes.size() == groups.size()) {
+    return; // no PC shared by two threads
+  }
+
+  if (result.size() < lanes.size()) {
+    for (int r = 0; r < 3; r++) {
+      opnd[r].resize(lanes.size());
+    }
+    result.resize(lanes.size());
+  }
+
+  for (size_t g = 0; g < groups.size(); g++) {
+    if (groups[g].size < 2) {
+      continue;
+    }
+    const Op &op = decode(groups[g].pc);
+    // a breakpoint PC runs on each core so its writeback sees the flag
+    if (op.ok && !op.sdi->is(SD_BREAKPOINT)) {
+      execute(op, groups[g]);
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// decode()
+///////////////////////////////////////////////////////////////////////////////
+/// decoded instruction at pc, re-decoded if the word there has changed
+const LockstepEngine::Op &
+LockstepEngine::decode(uint32_t pc) {
+
+  uint32_t raw = rigel::GLOBAL_BACKING_STORE_PTR->read_instr_word(pc);
+  Op *cached = ops.find(pc);
+  if (cached && cached->raw == raw) {
+    return *cached;
+  }
+
+  Op op;
+  op.raw = raw;
+  PipePacket instr(pc, raw, 0);
+  op.type = instr.type();
+  switch (op.type) {
+    // immediate forms using zext(imm16)
+    case I_ANDI: case I_ORI: case I_XORI: case I_MVUI:
+      op.imm = instr.imm16();
+      op.ok = true;
+      break;
+    // immediate forms using sext(imm16)
+    case I_ADDI: case I_SUBI: case I_ADDIU: case I_SUBIU:
+      op.imm = instr.simm16();
+      op.ok = true;
+      break;
+    // immediate shifts
+    case I_SLLI: case I_SRLI: case I_SRAI:
+      op.imm = instr.imm5();
+      op.ok = true;
+      break;
+    // register forms
+    case I_ADD: case I_SUB: case I_MUL:
+    case I_AND: case I_OR: case I_XOR: case I_NOR:
+    case I_ZEXTB: case I_ZEXTS: case I_SEXTB: case I_SEXTS: case I_CLZ:
+    case I_SLL: case I_SRL: case I_SRA:
+    case I_CEQ: case I_CLT: case I_CLE: case I_CLTU: case I_CLEU:
+    case I_FADD: case I_FSUB: case I_FMUL: case I_FMADD:
+    case I_FABS: case I_FRCP: case I_FRSQ: case I_I2F: case I_F2I:
+    case I_CEQF: case I_CLTF: case I_CLTEF:
+      op.ok = true;
+      break;
+    // everything else (including the SPRF moves) runs on its own core
+    default:
+      break;
+  }
+  if (instr.isSPRFSrc() || instr.isSPRFDest() || !instr.isDREGDest()) {
+    op.ok = false;
+  }
+  if (op.ok) {
+    op.src[0] = instr.input_deps(SREG_T);
+    op.src[1] = instr.input_deps(SREG_S);
+    op.src[2] = instr.input_deps(DREG);
+    op.dest   = instr.regnum(DREG);
+    op.sdi    = &rigel::DECODE_TABLE.lookup(pc, raw);
+  }
+
+  Op &slot = ops.insert(pc);
+  slot = op;
+  return slot;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// execute()
+///////////////////////////////////////////////////////////////////////////////
+/// gather the group's operands, run op across all lanes, scatter and retire
+void
+LockstepEngine::execute(const Op &op, const Group &g) {
+
+  const int n = g.size;
+
+  // gather
+  for (int r = 0; r < 3; r++) {
+    if (op.src[r] == simconst::NULL_REG) {
+      continue;
+    }
+    rword32_t *v = &opnd[r][0];
+    int i = 0;
+    for (int l = g.head; l >= 0; l = lanes[l].next, i++) {
+      v[i].u32 = lanes[l].core->lockstep_read(lanes[l].tid, op.src[r]).u32();
+    }
+  }
+
+  const rword32_t *t = &opnd[0][0];
+  const rword32_t *s = &opnd[1][0];
+  const rword32_t *d = &opnd[2][0];
+  rword32_t *res = &result[0];
+  const uint32_t imm = op.imm;
+
+  // same semantics as RigelISA::execALU/execShift/execCompare/execFPU
+  switch (op.type) {
+    case I_ADD:   LANES(res[i].u32 = t[i].u32 + s[i].u32);
+    case I_SUB:   LANES(res[i].u32 = t[i].u32 - s[i].u32);
+    case I_MUL:   LANES(res[i].u32 = t[i].u32 * s[i].u32);
+    case I_ADDI:
+    case I_ADDIU: LANES(res[i].u32 = t[i].u32 + imm);
+    case I_SUBI:
+    case I_SUBIU: LANES(res[i].u32 = t[i].u32 - imm);
+    case I_AND:   LANES(res[i].u32 = t[i].u32 & s[i].u32);
+    case I_OR:    LANES(res[i].u32 = t[i].u32 | s[i].u32);
+    case I_XOR:   LANES(res[i].u32 = t[i].u32 ^ s[i].u32);
+    case I_NOR:   LANES(res[i].u32 = ~(t[i].u32 | s[i].u32));
+    case I_ANDI:  LANES(res[i].u32 = t[i].u32 & imm);
+    case I_ORI:   LANES(res[i].u32 = t[i].u32 | imm);
+    case I_XORI:  LANES(res[i].u32 = t[i].u32 ^ imm);
+    case I_ZEXTB: LANES(res[i].u32 = t[i].u32 & 0x000000FF);
+    case I_ZEXTS: LANES(res[i].u32 = t[i].u32 & 0x0000FFFF);
+    case I_SEXTB: LANES(res[i].i32 = int32_t(int8_t(t[i].u32)));
+    case I_SEXTS: LANES(res[i].i32 = int32_t(int16_t(t[i].u32)));
+    case I_MVUI:  LANES(res[i].u32 = imm << 16);
+    case I_CLZ:   LANES(res[i].u32 = rigel_clz(t[i].u32));
+
+    case I_SLL:   LANES(res[i].u32 = t[i].u32 << (s[i].u32 & 0x01FU));
+    case I_SRL:   LANES(res[i].u32 = t[i].u32 >> (s[i].u32 & 0x01FU));
+    case I_SRA:   LANES(res[i].i32 = t[i].i32 >> (s[i].u32 & 0x01FU));
+    case I_SLLI:  LANES(res[i].u32 = t[i].u32 << imm);
+    case I_SRLI:  LANES(res[i].u32 = t[i].u32 >> imm);
+    case I_SRAI:  LANES(res[i].i32 = t[i].i32 >> imm);
+
+    case I_CEQ:   LANES(res[i].u32 = (t[i].i32 == s[i].i32) ? 1 : 0);
+    case I_CLT:   LANES(res[i].u32 = (t[i].i32 <  s[i].i32) ? 1 : 0);
+    case I_CLE:   LANES(res[i].u32 = (t[i].i32 <= s[i].i32) ? 1 : 0);
+    case I_CLTU:  LANES(res[i].u32 = (t[i].u32 <  s[i].u32) ? 1 : 0);
+    case I_CLEU:  LANES(res[i].u32 = (t[i].u32 <= s[i].u32) ? 1 : 0);
+
+    case I_FADD:  LANES(res[i].f32 = t[i].f32 + s[i].f32);
+    case I_FSUB:  LANES(res[i].f32 = t[i].f32 - s[i].f32);
+    case I_FMUL:  LANES(res[i].f32 = t[i].f32 * s[i].f32);
+    case I_FMADD: LANES(res[i].f32 = d[i].f32 + (t[i].f32 * s[i].f32));
+    case I_FABS:  LANES(res[i].f32 = float(fabs(t[i].f32)));
+    case I_FRCP:  LANES(res[i].f32 = float(1.0 / t[i].f32));
+    case I_FRSQ:  LANES(res[i].f32 = float(1.0 / sqrtf(t[i].f32)));
+    case I_I2F:   LANES(res[i].f32 = float(t[i].i32));
+    case I_F2I:   LANES(res[i].i32 = int(t[i].f32));
+    case I_CEQF:  LANES(res[i].u32 = (t[i].f32 == s[i].f32) ? 1 : 0);
+    case I_CLTF:  LANES(res[i].u32 = (t[i].f32 <  s[i].f32) ? 1 : 0);
+    case I_CLTEF: LANES(res[i].u32 = (t[i].f32 <= s[i].f32) ? 1 : 0);
+
+    default:
+      assert(0 && "LockstepEngine: op decoded as ok but not executable");
+      return;
+  }
+
+  // scatter and retire
+  int i = 0;
+  for (int l = g.head; l >= 0; l = lanes[l].next, i++) {
+    lanes[l].core->lockstep_retire(lanes[l].tid, op.dest, res[i]);
+  }
+
+  stat_groups++;
+  stat_instrs += n;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// EndSim()
+///////////////////////////////////////////////////////////////////////////////
+void
+LockstepEngine::EndSim() {
+  uint64_t total = rigel::RETIRED_INSTRS_TOTAL;
+  fprintf(stderr, "lockstep: %" PRIu64 " of %" PRIu64 " instructions (%.1f%%) "
+    "executed in %" PRIu64 " groups (%.1f threads per group)\n",
+    stat_instrs, total, total ? 100.0 * stat_instrs / total : 0.0,
+    stat_groups, stat_groups ? (double)stat_instrs / stat_groups : 0.0);
+}
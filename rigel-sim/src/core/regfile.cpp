@@ -1,5 +1,6 @@
 
 #include "core/regfile.h"
+#include "util/reg_trace.h"
 
 #define DB_RF 0
 
@@ -10,7 +11,7 @@ namespace rigel {
 /// constructor
 RegisterFile::RegisterFile(unsigned int numregs) 
   : numregs(numregs),
-    tracefile(NULL)
+    trace_gtid(-1)
 {
   rf = new regval32_t[numregs];
   rf[0] = (uint32_t)0;
@@ -22,9 +23,6 @@ RegisterFile::RegisterFile(unsigned int numregs)
 /// destructor
 RegisterFile::~RegisterFile() {
   if (rf) { delete rf; }
-  if (tracefile) {
-    fclose(tracefile);
-  }
 }
 
 /// accessor
@@ -40,9 +38,8 @@ RegisterFile::write(unsigned int i, regval32_t rv, uint32_t pc) {
   assert(i < numregs && "attempting to write invalid register");
   if (i != 0) { // ignore writes to R0
     rf[i] = rv;
-    if (tracefile) {
-      //fprintf(tracefile,"%012"PRIu64" %08x %d %08x\n", rigel::CURR_CYCLE,pc, i, rv.u32());
-      fprintf(tracefile,"%08x %d %08x\n", pc, i, rv.u32());
+    if (trace_gtid >= 0) {
+      rigel::REG_TRACE->Append(trace_gtid, rigel::CURR_CYCLE, pc, i, rv.u32());
     }
   }
 }
@@ -59,13 +56,12 @@ RegisterFile::Dump(unsigned int cols) {
   printf("\n");
 }
 
-/// set trace file
+/// trace writes to the global register trace as thread gtid
 void 
-RegisterFile::setTraceFile( const char* filename ) {
-  DPRINT(DB_RF,"%s: %s\n",__func__,filename); 
-  tracefile = fopen(filename,"w");
-  assert(tracefile != NULL && "invalid tracefile or unable to open");
-  setbuf(tracefile,NULL); /// FIXME DELETE THIS!
+RegisterFile::setTraceThread( int gtid ) {
+  DPRINT(DB_RF,"%s: %d\n",__func__,gtid); 
+  assert(rigel::REG_TRACE != NULL && "register trace writer not created");
+  trace_gtid = gtid;
 }
 
 
@@ -86,9 +82,9 @@ SPRegisterFile::write(unsigned int i, regval32_t rv, uint32_t pc) {
   assert(i < numregs && "attempting to write invalid out-of-range register");
   if (writable.test(i)) {
     rf[i] = rv;
-    if (tracefile) {
-      //fprintf(tracefile,"%012"PRIu64" %08x %d %08x\n", rigel::CURR_CYCLE,pc, i, rv.u32());
-      fprintf(tracefile,"%08x s%d %08x\n", pc, i, rv.u32());
+    if (trace_gtid >= 0) {
+      rigel::REG_TRACE->Append(trace_gtid, rigel::CURR_CYCLE, pc,
+                               i | rigel::regtrace::SPRF_FLAG, rv.u32());
     }
   } else {
     printf("attempted to write READONLY SPRF register [%d] (%s)\n", 
@@ -21,8 +21,12 @@
 // Scoreboard Constructor
 ////////////////////////////////////////////////////////////////////////////////
 ScoreBoard::ScoreBoard(uint32_t _num_regs) : 
-  num_regs(_num_regs) 
+  num_regs(_num_regs),
+  use_mask(0),
+  busy_mask(0),
+  locked_mask(0)
 { 
+  assert(num_regs <= MAX_REGS && "scoreboard masks hold at most 64 registers");
   _wait_for_clear = false;
   scoreboard = new ScoreBoardEntry[num_regs];
   for (uint32_t i = 0; i < num_regs; i++) {
@@ -59,6 +63,51 @@ ScoreBoardBypass::get_reg(uint32_t reg, instr_t type, bool skip_reg_zero)
     rigel::CURR_CYCLE : rigel::CURR_CYCLE + INSTR_LAT[type];
   scoreboard[reg].use_count++;
   scoreboard[reg].bypass_count++;
+  use_mask |= reg_bit(reg);
+  if (scoreboard[reg].ready_cycle > rigel::CURR_CYCLE) {
+    busy_mask |= reg_bit(reg);
+  } else {
+    busy_mask &= ~reg_bit(reg);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  ScoreBoardBypass::check_mask()
+////////////////////////////////////////////////////////////////////////////////
+// true if every register in regs can be read this cycle: none is locked and
+// each has reached its ready_cycle.  The common case (none of them busy or
+// locked) is one AND; only busy registers look at their entries, and a
+// register whose ready_cycle has passed drops out of busy_mask for good.
+bool
+ScoreBoardBypass::check_mask(mask_t regs)
+{
+  // waits for whole pipeline to flush before dispatching instructions again
+  if (rigel::core::FORCE_SB_FLUSH && this->_wait_for_clear) {
+    // If all are clear, we can clear flag, otherwise check fails
+    if (use_mask != 0) {
+      return false;
+    }
+    // All regs are finally cleared, pipeline has drained
+    _wait_for_clear = false;
+    this->clear();
+  }
+
+  mask_t hazards = regs & (busy_mask | locked_mask);
+  if (hazards == 0) {
+    return true;
+  }
+  if (hazards & locked_mask) {
+    return false;
+  }
+  while (hazards) {
+    uint32_t reg = __builtin_ctzll(hazards);
+    if (rigel::CURR_CYCLE < scoreboard[reg].ready_cycle) {
+      return false;
+    }
+    busy_mask &= ~reg_bit(reg);
+    hazards &= hazards - 1;
+  }
+  return true;
 }
 ///////////////////////////////////////////////////////////////////////////////
 // ScoreBoardBypass::get_bypass()
@@ -70,6 +70,55 @@ helper_setup_other(CommandLineArgs &cmdline)
          << "  Try 'single' or 'perbank'.\n";
     assert(0);
   }
+  std::string dram_model = cmdline.get_val((char *)"DRAM_MODEL");
+  if(dram_model.compare("command") == 0)
+    rigel::DRAM::MODEL = rigel::DRAM::dram_model_command;
+  else if(dram_model.compare("analytic") == 0)
+    rigel::DRAM::MODEL = rigel::DRAM::dram_model_analytic;
+  else if(dram_model.compare("ideal") == 0)
+  {
+    rigel::DRAM::MODEL = rigel::DRAM::dram_model_ideal;
+    rigel::CMDLINE_ENABLE_IDEALIZED_DRAM = true;
+  }
+  else
+  {
+    std::cerr << "Error: " << dram_model << " is not a valid --dram-model value."
+         << "  Try 'command', 'analytic' or 'ideal'.\n";
+    assert(0);
+  }
+	std::string rowcache_rep = cmdline.get_val((char *)"ROW_CACHE_REPLACEMENT_POLICY");
+  if(rowcache_rep.compare("lru") == 0)
+    ROW_CACHE_REPLACEMENT_POLICY = rc_replace_lru;
+  else if(rowcache_rep.compare("tristage") == 0)
+    ROW_CACHE_REPLACEMENT_POLICY = rc_replace_tristage;
+  else if(rowcache_rep.compare("tristage_b") == 0)
+    ROW_CACHE_REPLACEMENT_POLICY = rc_replace_tristage_b;
+  else if(rowcache_rep.compare("mru") == 0)
+    ROW_CACHE_REPLACEMENT_POLICY = rc_replace_mru;
+  else if(rowcache_rep.compare("lfu") == 0)
+    ROW_CACHE_REPLACEMENT_POLICY = rc_replace_lfu;
+  else
+  {
+		std::cerr << "Error: " << rowcache_rep << " is not a valid row cache replacement policy "
+         << "{lru, tristage, mru}.\n";
+    assert(0);
+  }
+  DRAM_BATCHING_CAP  = cmdline.get_val_int((char *)"DRAM_BATCHING_CAP");
+	std::string batching_policy = cmdline.get_val((char *)"DRAM_BATCHING_POLICY");
+  if(batching_policy.compare("batch_none") == 0)
+    DRAM_BATCHING_POLICY = batch_none;
+  else if(batching_policy.compare("batch_perbank") == 0)
+    DRAM_BATCHING_POLICY = batch_perbank;
+  else if(batching_policy.compare("batch_perchannel") == 0)
+    DRAM_BATCHING_POLICY = batch_perchannel;
+  else
+  {
+		std::cerr << "Error: " << batching_policy << " is not a valid batching policy "
+         << "{batch_none, batch_perbank, batch_perchannel}.\n";
+    assert(0);
+  }
+  //Number of rows in per-DRAM-bank Row Cache (akin to WC-DRAM)
+  rigel::DRAM::OPEN_ROWS = (unsigned int)cmdline.get_val_int((char *)"DRAM_OPEN_ROWS");
 
   HEARTBEAT_INTERVAL = cmdline.get_val_int((char *)"HEARTBEAT_INTERVAL");
 
@@ -176,52 +225,57 @@ int main(int argc, char ** argv)
   StrideWriteGenerator srg8(0xE0000000, 32);
   struct mem_trace_reader* mtr = init_trace_reader("memstream.computeFH.gz");
 
-  FILE **dineroPipes = new FILE *[rigel::NUM_CLUSTERS];
-  printf("HI! %d %d \n", rigel::NUM_CLUSTERS, rigel::THREADS_TOTAL);
-  for(int i = 0; i < rigel::NUM_CLUSTERS; i++)
-  {
-    char command[1024];
-    sprintf(command, "/FIXME/PATH/TO/d4-7/dineroIV -informat d -l1-dsize 64k -l1-dbsize 32 -l1-dassoc 8 1>c%d.out 2>c%d.err", i, i);
-    printf("%s\n", command);
-    dineroPipes[i] = popen(command, "w");
-    if(dineroPipes[i] == NULL)
+  // With a trace in the working directory, split it into per-cluster
+  // dineroIV runs and stop.  Otherwise drive the memory controllers with the
+  // synthetic stride streams below.
+  if (mtr != NULL) {
+    FILE **dineroPipes = new FILE *[rigel::NUM_CLUSTERS];
+    printf("HI! %d %d \n", rigel::NUM_CLUSTERS, rigel::THREADS_TOTAL);
+    for(int i = 0; i < rigel::NUM_CLUSTERS; i++)
     {
-      printf("Error: dineroPipes[%d] == NULL\n", i);
-      exit(1);
+      char command[1024];
+      sprintf(command, "/FIXME/PATH/TO/d4-7/dineroIV -informat d -l1-dsize 64k -l1-dbsize 32 -l1-dassoc 8 1>c%d.out 2>c%d.err", i, i);
+      printf("%s\n", command);
+      dineroPipes[i] = popen(command, "w");
+      if(dineroPipes[i] == NULL)
+      {
+        printf("Error: dineroPipes[%d] == NULL\n", i);
+        exit(1);
+      }
     }
-  }
-  GzipRequestGenerator **gz = new GzipRequestGenerator *[rigel::THREADS_TOTAL];
-  for(int i = 0; i < rigel::THREADS_TOTAL; i++)
-     gz[i] = new GzipRequestGenerator(mtr, i, rigel::THREADS_TOTAL);
-  int *numRequests = new int[rigel::THREADS_TOTAL];
-  for(int i = 0; i < rigel::THREADS_TOTAL; i++)
-    numRequests[i] = 0;
-  while(1)
-  {
-    int numNulls = 0;
+    GzipRequestGenerator **gz = new GzipRequestGenerator *[rigel::THREADS_TOTAL];
     for(int i = 0; i < rigel::THREADS_TOTAL; i++)
+       gz[i] = new GzipRequestGenerator(mtr, i, rigel::THREADS_TOTAL);
+    int *numRequests = new int[rigel::THREADS_TOTAL];
+    for(int i = 0; i < rigel::THREADS_TOTAL; i++)
+      numRequests[i] = 0;
+    while(1)
     {
-      MemoryRequest *mr;
-      if((mr = gz[i]->getNextRequest()) == NULL)
-        numNulls++;
-      else
+      int numNulls = 0;
+      for(int i = 0; i < rigel::THREADS_TOTAL; i++)
       {
-        fprintf(dineroPipes[i/rigel::THREADS_PER_CLUSTER], "%c %8x\n", ((mr->readNotWrite) ? '0' : '1'), mr->addr);
-        free(mr);
-        numRequests[i]++;
+        MemoryRequest *mr;
+        if((mr = gz[i]->getNextRequest()) == NULL)
+          numNulls++;
+        else
+        {
+          fprintf(dineroPipes[i/rigel::THREADS_PER_CLUSTER], "%c %8x\n", ((mr->readNotWrite) ? '0' : '1'), mr->addr);
+          free(mr);
+          numRequests[i]++;
+        }
       }
+      if(numNulls == rigel::THREADS_TOTAL) break;
     }
-    if(numNulls == rigel::THREADS_TOTAL) break;
+    for(int i = 0; i < rigel::THREADS_TOTAL; i++)
+      printf("Thread %4d: %8d requests\n", i, numRequests[i]);
+    for(int i = 0; i < rigel::NUM_CLUSTERS; i++)
+      pclose(dineroPipes[i]);
+    free(dineroPipes);
+    free(numRequests);
+    exit(1);
   }
-  for(int i = 0; i < rigel::THREADS_TOTAL; i++)
-    printf("Thread %4d: %8d requests\n", i, numRequests[i]);
-  for(int i = 0; i < rigel::NUM_CLUSTERS; i++)
-    pclose(dineroPipes[i]);
-  free(dineroPipes);
-  free(numRequests);
-  exit(1);
-  
   
+  /*
   GzipRequestGenerator gz1(mtr, 0, 4);
   GzipRequestGenerator gz2(mtr, 1, 4);
   GzipRequestGenerator gz3(mtr, 2, 4);
@@ -237,7 +291,7 @@ int main(int argc, char ** argv)
   dd.addStream(&csg2);
   dd.addStream(&csg3);
   dd.addStream(&csg4);
-  /*
+  */
   ConcurrentStreamGenerator csg1(&dd, 0, srg1, 1);
   ConcurrentStreamGenerator csg2(&dd, 1, srg2, 1);
   ConcurrentStreamGenerator csg3(&dd, 2, srg3, 1);
@@ -254,9 +308,20 @@ int main(int argc, char ** argv)
   dd.addStream(&csg6);
   dd.addStream(&csg7);
   dd.addStream(&csg8);
-*/
   // Initialize the global profiler and use STDERR as the output stream.
   ProfileStat::init(stderr);
+  // There are no cores or cluster caches here, but the end-of-run dump still
+  // reads their counters.
+  ProfileStat::retired_instrs = new uint64_t[rigel::THREADS_TOTAL];
+  for(int i = 0; i < rigel::THREADS_TOTAL; i++) {
+    ProfileStat::retired_instrs[i] = 0;
+  }
+  rigel::profiler::ccache_access_histogram = new uint64_t[2*rigel::THREADS_PER_CLUSTER];
+  rigel::profiler::icache_access_histogram = new uint64_t[2*rigel::THREADS_PER_CLUSTER];
+  for (int i = 0; i < 2*rigel::THREADS_PER_CLUSTER; i++) {
+    rigel::profiler::ccache_access_histogram[i] = 0;
+    rigel::profiler::icache_access_histogram[i] = 0;
+  }
   Profile profiler(rigel::GLOBAL_BACKING_STORE_PTR, 0);
   profiler.start_sim();
   ProfileStat::activate();
@@ -296,6 +361,7 @@ int main(int argc, char ** argv)
     profiler.end_sim();
     profiler.accumulate_stats();
     profiler.global_dump_profile(argc, argv);
+    memory_timing.EndSim();
 		std::cerr << "EXIT REASON, " << e.reason << "\n";
     destroy_mem_trace_reader(mtr);
     exit(0);
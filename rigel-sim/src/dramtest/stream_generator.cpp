@@ -1,7 +1,7 @@
 #include <stddef.h>                     // for NULL
 #include <list>                         // for list, _List_iterator, etc
 #include "memory/dram_driver.h"    // for DRAMDriver
-#include "read_mem_trace_c.h"  // for get_next_thread_access, etc
+#include "read_mem_trace_c.h"  // for next_thread_access, etc
 #include "stream_generator.h"
 
 extern "C" {
@@ -42,8 +42,8 @@ void ConcurrentStreamGenerator::PerCycle()
 
 MemoryRequest * GzipRequestGenerator::getNextRequest()
 {
-  struct extended_info ei;
-  if(get_next_thread_access(mtr, thread, &ei) == 0)
+  const struct extended_info *ei = next_thread_access(mtr, thread);
+  if(ei == NULL)
   {
     if(buffer_one_sw_thread(mtr, thread) == 0)
     {
@@ -51,12 +51,12 @@ MemoryRequest * GzipRequestGenerator::getNextRequest()
     }
     else
     {
-      if(get_next_thread_access(mtr, thread, &ei) == 0)
+      if((ei = next_thread_access(mtr, thread)) == NULL)
         return NULL;
     }
   }
   //ei has a valid access
-  MemoryRequest *mr = new MemoryRequest(ei.ai.addr, (ei.read == 1));
+  MemoryRequest *mr = new MemoryRequest(ei->ai.addr, (ei->read == 1));
   //printf("R");
   return mr;
 }
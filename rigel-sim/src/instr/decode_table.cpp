@@ -0,0 +1,33 @@
+#include "instr/decode_table.h"
+
+DecodeTable rigel::DECODE_TABLE;
+
+DecodeTable::DecodeTable() :
+  pages(NULL, 64),
+  last_page_num(0),
+  last_page(NULL),
+  decodes(0)
+{ }
+
+DecodeTable::~DecodeTable() {
+  for (size_t i = 0; i < pages.capacity(); i++) {
+    if (pages.slot_used(i)) {
+      delete pages.slot_value(i);
+    }
+  }
+}
+
+/// entries for page_num, allocated on first touch
+DecodeTable::Page *
+DecodeTable::page(uint32_t page_num) {
+  Page *&p = pages.insert(page_num);
+  if (p == NULL) {
+    p = new Page;
+  }
+  return p;
+}
+
+void
+DecodeTable::reserve(size_t num_instrs) {
+  pages.reserve(num_instrs / PAGE_INSTRS + 1);
+}
@@ -199,6 +199,54 @@ InstrLegacy::InstrLegacy(uint32_t _pc, int _tid) :
 uint64_t InstrLegacy::GLOBAL_INSTR_NUMBER = 1;
 uint64_t *InstrLegacy::LAST_INSTR_NUMBER;
 
+////////////////////////////////////////////////////////////////////////////////
+// InstrLegacy free list
+////////////////////////////////////////////////////////////////////////////////
+// Instructions are carved out of slabs and returned to a LIFO free list when
+// deleted, so the most recently retired (and still cached) object is the next
+// one fetched.  Slabs are never returned to the heap; the number in flight is
+// bounded by the pipeline depth and the speculative instruction lists.  The
+// simulator is single-threaded, so no locking is needed.
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+  // Number of instructions per slab.
+  const size_t INSTR_POOL_SLAB_SIZE = 1024;
+
+  struct InstrPoolNode { InstrPoolNode *next; };
+  InstrPoolNode *instr_free_list = NULL;
+
+  void
+  instr_pool_refill(size_t size)
+  {
+    char *slab = static_cast<char *>(::operator new(size * INSTR_POOL_SLAB_SIZE));
+    for (size_t i = INSTR_POOL_SLAB_SIZE; i-- > 0; ) {
+      InstrPoolNode *n = reinterpret_cast<InstrPoolNode *>(slab + i * size);
+      n->next = instr_free_list;
+      instr_free_list = n;
+    }
+  }
+}
+
+void *
+InstrLegacy::operator new(size_t size)
+{
+  assert(size == sizeof(InstrLegacy) && "InstrLegacy pool does not handle subclasses");
+  if (NULL == instr_free_list) { instr_pool_refill(size); }
+  InstrPoolNode *n = instr_free_list;
+  instr_free_list = n->next;
+  return n;
+}
+
+void
+InstrLegacy::operator delete(void *p, size_t size)
+{
+  if (NULL == p) { return; }
+  assert(size == sizeof(InstrLegacy) && "InstrLegacy pool does not handle subclasses");
+  InstrPoolNode *n = static_cast<InstrPoolNode *>(p);
+  n->next = instr_free_list;
+  instr_free_list = n;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // InstrLegacy::update_type
 ////////////////////////////////////////////////////////////////////////////////
@@ -304,8 +352,11 @@ InstrLegacy::dis_print(FILE * stream) { //has a default param, see .h (stdout)
   if (get_type() == I_DONE) return 0;
 
   dis_priv_t dis_priv;
+  // Scratch state for the disassembler.  Kept local since it is only needed
+  // here and is large compared to the rest of the instruction.
+  disassemble_info dis_info;
 
-  memset(&(this->dis_info), 0, sizeof(this->dis_info));
+  memset(&dis_info, 0, sizeof(dis_info));
 
   string_descriptor s(64);
 
@@ -328,7 +379,7 @@ InstrLegacy::dis_print(FILE * stream) { //has a default param, see .h (stdout)
       dis_info.insn_type = dis_nonbranch;
   }
 #ifndef _WIN32
-  print_insn_little_mips((bfd_vma)0, &(this->dis_info));
+  print_insn_little_mips((bfd_vma)0, &dis_info);
   size_t num_chars = s.length();
   fprintf(stream, "%s", s.buf);
 #endif
@@ -1,4 +1,5 @@
 #include "instr/static_decode_info.h"
+#include "isa/rigel_isa.h"
 
 /// FIXME: AUTO-GENERATE ALL of THESE HELPERS (or, at least statically store flag result)
 ///
@@ -474,3 +475,18 @@ StaticDecodeInfo::isShift() const {
       { return false; }
   }
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// setExecHandler()
+////////////////////////////////////////////////////////////////////////////////
+// same precedence as the if-chain this replaced in CoreFunctional::execute()
+void
+StaticDecodeInfo::setExecHandler() {
+  if      (isALU())     { exec_ = RigelISA::execALU; }
+  else if (isShift())   { exec_ = RigelISA::execShift; }
+  else if (isFPU())     { exec_ = RigelISA::execFPU; }
+  else if (isMem())     { exec_ = RigelISA::execAddressGen; }
+  else if (isCompare()) { exec_ = RigelISA::execCompare; }
+  else if (isBranch())  { exec_ = RigelISA::execBranch; }
+  else                  { exec_ = NULL; }
+}
@@ -27,11 +27,11 @@ CrossBar::CrossBar(
   // instantiate ports
   // TODO: do elsewhere, and connect
   for (unsigned i = 0; i < inports.size(); i++) {
-    inports[i] = new InPortBase<Packet*>( PortName(name(), id(), "in", i) );
+    inports[i] = new InPortBase<Packet*>( PortName(this, "in", i) );
     inports[i]->owner(this);
   } 
   for (unsigned i = 0; i < outports.size(); i++) {
-    outports[i] = new OutPortBase<Packet*>( PortName(name(), id(), "out", i) );
+    outports[i] = new OutPortBase<Packet*>( PortName(this, "out", i) );
     outports[i]->owner(this);
   }
 }
@@ -7,6 +7,7 @@
 #include <string>                       // for string
 #include <vector>                       // for vector, vector<>::iterator
 #include "util/debug.h"          // for DebugSim, GLOBAL_debug_sim
+#include "sim/build_slot.h"      // for BuildSlot
 #include "define.h"         // for ::IC_MSG_NULL, icmsg_type_t, etc
 #include "icmsg.h"          // for ICMsg
 #include "interconnect.h"   // for TileInterconnectIdeal, etc
@@ -25,7 +26,7 @@ TileInterconnectIdeal::TileInterconnectIdeal(rigel::ConstructionPayload cp) :
 	cp.component_name.clear();
 
   // Add to the global list of tile interconnects for debug printing.
-  rigel::GLOBAL_debug_sim.tilenet.push_back(this);
+  rigel::BuildSlot::push_back(rigel::GLOBAL_debug_sim.tilenet, this);
   // Allocate message buffers
   requests.resize(VCN_LENGTH);
   replies.resize(VCN_LENGTH);
@@ -9,6 +9,7 @@
 #include <string>                       // for string
 #include <vector>                       // for vector, vector<>::reference, etc
 #include "util/debug.h"          // for DebugSim, GLOBAL_debug_sim
+#include "sim/build_slot.h"      // for BuildSlot
 #include "define.h"
 #include "icmsg.h"          // for ICMsg
 #include "interconnect.h"   // for TileInterconnectNew, etc
@@ -38,7 +39,7 @@ TileInterconnectNew::TileInterconnectNew(rigel::ConstructionPayload cp) :
 	cp.component_name.clear();
 
   // Add to the global list of tile interconnects for debug printing.
-  rigel::GLOBAL_debug_sim.tilenet.push_back(this);
+  rigel::BuildSlot::push_back(rigel::GLOBAL_debug_sim.tilenet, this);
 
   l1_request.resize(GET_NUM_L1_ROUTERS());
   for(size_t i = 0; i < GET_NUM_L1_ROUTERS(); i++)
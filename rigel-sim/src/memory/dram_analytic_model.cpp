@@ -0,0 +1,295 @@
+////////////////////////////////////////////////////////////////////////////////
+// dram_analytic_model.cpp
+////////////////////////////////////////////////////////////////////////////////
+//
+//  DRAMAnalyticModel implementation.  See dram_analytic_model.h.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <inttypes.h>                   // for PRIu64
+#include <stdint.h>                     // for uint32_t, uint64_t
+#include <stdio.h>                      // for fprintf, stderr
+#include <algorithm>                    // for max
+#include <map>                          // for map
+#include <set>                          // for set
+#include "memory/address_mapping.h"     // for AddressMapping
+#include "memory/dram.h"                // for BANKS, RANKS, LATENCY, etc
+#include "memory/dram_analytic_model.h"
+#include "memory/dram_channel_model.h"  // for DRAMChannelModel::GetDRAMCycle
+#include "profile/profile.h"            // for stats
+#include "profile/profile_names.h"
+#include "sim.h"                        // for LINESIZE, PENDING_PER_BANK
+#include "util/util.h"                  // for CallbackInterface
+
+////////////////////////////////////////////////////////////////////////////////
+// DRAMAnalyticModel()
+////////////////////////////////////////////////////////////////////////////////
+DRAMAnalyticModel::DRAMAnalyticModel(bool _ideal, uint32_t _ideal_latency) :
+  ideal(_ideal),
+  ideal_latency(_ideal_latency),
+  seq(0),
+  requests(0),
+  lines(0),
+  row_hits(0),
+  row_empty(0),
+  row_conflicts(0),
+  rejected(0),
+  completed(0),
+  total_latency(0)
+{
+  using namespace rigel::DRAM;
+  Bank b;
+  Rank r = { 0, 0 };
+  channels.resize(CONTROLLERS);
+  for (unsigned int i = 0; i < CONTROLLERS; i++) {
+    channels[i].pending = 0;
+    channels[i].ranks.assign(RANKS, r);
+    channels[i].banks.assign(RANKS * BANKS, b);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ServiceLine()
+////////////////////////////////////////////////////////////////////////////////
+// Issue the commands for one line as early as the bank, rank and data bus
+// allow, and advance their state past it.
+// RETURNS: DRAM cycle the line is ready (same convention as
+// PendingRequestEntry::SetLineReady: CAS + latency + burst - 1); cas is set
+// to the DRAM cycle of its column command
+////////////////////////////////////////////////////////////////////////////////
+uint64_t
+DRAMAnalyticModel::ServiceLine(Channel &ch, Rank &rk, Bank &bk, uint32_t row,
+                               bool read, uint64_t now, uint64_t &cas)
+{
+  using namespace rigel::DRAM::LATENCY;
+  const uint64_t burst = (rigel::cache::LINESIZE / 4) / 2;
+  uint64_t t = now;
+
+  if (bk.row_open && bk.row == row) {
+    row_hits++;
+  } else {
+    if (bk.row_open) {
+      row_conflicts++;
+      t = std::max(t, bk.pre_ready) + RP;
+    } else {
+      row_empty++;
+    }
+    const uint64_t act = std::max(t, std::max(bk.next_act, rk.next_act));
+    bk.row_open = true;
+    bk.row = row;
+    bk.next_act = act + RC;
+    bk.pre_ready = act + RAS;
+    rk.next_act = act + RRD;
+    t = act + (read ? RCDR : RCDW);
+  }
+
+  const uint64_t lat = read ? CL : WL;
+  if (read) {
+    t = std::max(t, bk.next_read);
+  }
+  // Hold the column command until its data has the bus.
+  cas = ReserveBus(ch, std::max(t, rk.next_cas) + lat, burst, now) - lat;
+  const uint64_t data_end = cas + lat + burst;
+  if (!read) {
+    bk.next_read = data_end + WTR;
+  }
+  rk.next_cas = cas + CCD;
+  bk.pre_ready = std::max(bk.pre_ready, read ? cas + RTP : data_end + WR);
+  return data_end - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ReserveBus()
+////////////////////////////////////////////////////////////////////////////////
+uint64_t
+DRAMAnalyticModel::ReserveBus(Channel &ch, uint64_t earliest, uint64_t len,
+                              uint64_t now)
+{
+  std::map<uint64_t, uint64_t> &bus = ch.bus;
+  while (!bus.empty() && bus.begin()->second <= now) {
+    bus.erase(bus.begin());
+  }
+  uint64_t t = earliest;
+  std::map<uint64_t, uint64_t>::iterator it = bus.upper_bound(t);
+  if (it != bus.begin()) {
+    std::map<uint64_t, uint64_t>::iterator prev = it;
+    --prev;
+    t = std::max(t, prev->second);
+  }
+  for ( ; it != bus.end() && it->first < t + len; ++it) {
+    t = std::max(t, it->second);
+  }
+  bus[t] = t + len;
+  return t;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Complete()
+////////////////////////////////////////////////////////////////////////////////
+void
+DRAMAnalyticModel::Complete(const Request &r, unsigned int controller,
+                            unsigned int bank, uint64_t now)
+{
+  Channel &ch = channels[controller];
+  Rank &rk = ch.ranks[bank / rigel::DRAM::BANKS];
+  Bank &bk = ch.banks[bank];
+  uint64_t cas = now;
+  for (size_t i = 0; i < r.addrs.size(); i++) {
+    Completion c;
+    c.ready = ideal ? now + ideal_latency + i
+                    : ServiceLine(ch, rk, bk, r.row, r.read, now, cas);
+    c.seq = seq++;
+    c.inserted = r.inserted;
+    c.requester = r.requester;
+    c.requestIdentifier = r.requestIdentifier;
+    c.addr = r.addrs[i];
+    c.controller = controller;
+    c.bank = bank;
+    c.last = (i + 1 == r.addrs.size());
+    completions.push(c);
+    lines++;
+  }
+  bk.next_issue = cas + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Issue()
+////////////////////////////////////////////////////////////////////////////////
+// First-ready first-come: a row hit goes ahead of older requests unless the
+// oldest has waited MC_FORCE_SCHEDULE_SOFT clocks, and a conflict is only
+// picked once the open row may be precharged, so hits that arrive meanwhile
+// still get the row.
+////////////////////////////////////////////////////////////////////////////////
+void
+DRAMAnalyticModel::Issue(unsigned int controller, unsigned int bank,
+                         uint64_t now)
+{
+  Bank &bk = channels[controller].banks[bank];
+  while (!bk.queue.empty()) {
+    uint64_t wake = bk.next_issue;
+    std::deque<Request>::iterator pick = bk.queue.begin();
+    if (now >= wake && bk.row_open && pick->row != bk.row &&
+        now - pick->inserted < rigel::mem_sched::MC_FORCE_SCHEDULE_SOFT)
+    {
+      for (std::deque<Request>::iterator it = bk.queue.begin();
+           it != bk.queue.end(); ++it)
+      {
+        if (it->row == bk.row) {
+          pick = it;
+          break;
+        }
+      }
+      wake = (pick->row == bk.row) ? now : bk.pre_ready;
+    }
+    if (now < wake) {
+      if (!bk.waking || wake < bk.wake) {
+        Wakeup w = { wake, controller, bank };
+        wakeups.push(w);
+        bk.waking = true;
+        bk.wake = wake;
+      }
+      return;
+    }
+    Complete(*pick, controller, bank, now);
+    bk.queue.erase(pick);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Schedule()
+////////////////////////////////////////////////////////////////////////////////
+bool
+DRAMAnalyticModel::Schedule(const std::set<uint32_t> &addrs, bool read,
+                            CallbackInterface *requester, int requestIdentifier)
+{
+  using namespace rigel::DRAM;
+  const uint64_t now = DRAMChannelModel::GetDRAMCycle();
+  const uint32_t first = *(addrs.begin());
+  const unsigned int controller = AddressMapping::GetController(first);
+  const unsigned int rank = AddressMapping::GetRank(first);
+  const unsigned int bank = rank * BANKS + AddressMapping::GetBank(first);
+  Channel &ch = channels[controller];
+  Bank &bk = ch.banks[bank];
+
+  const int occupancy = rigel::mem_sched::MONOLITHIC_SCHEDULER ? ch.pending
+                                                               : bk.pending;
+  if (!ideal && occupancy >= rigel::mem_sched::PENDING_PER_BANK) {
+    rejected++;
+    return false;
+  }
+
+  requests++;
+  ch.pending++;
+  bk.pending++;
+  Request r;
+  r.inserted = now;
+  r.requester = requester;
+  r.requestIdentifier = requestIdentifier;
+  r.row = AddressMapping::GetRow(first);
+  r.read = read;
+  r.addrs.assign(addrs.begin(), addrs.end());
+  if (ideal) {
+    Complete(r, controller, bank, now);
+  } else {
+    bk.queue.push_back(r);
+    Issue(controller, bank, now);
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// PerCycle()
+////////////////////////////////////////////////////////////////////////////////
+void
+DRAMAnalyticModel::PerCycle()
+{
+  const uint64_t now = DRAMChannelModel::GetDRAMCycle();
+  while (!wakeups.empty() && wakeups.top().time <= now) {
+    const Wakeup w = wakeups.top();
+    wakeups.pop();
+    Bank &bk = channels[w.controller].banks[w.bank];
+    // A bank may have been re-queued for an earlier time; act on that one.
+    if (!bk.waking || bk.wake != w.time) {
+      continue;
+    }
+    bk.waking = false;
+    Issue(w.controller, w.bank, now);
+  }
+  while (!completions.empty() && completions.top().ready <= now) {
+    const Completion c = completions.top();
+    completions.pop();
+    if (c.last) {
+      // Free the slot first so the requester may schedule from its callback.
+      Channel &ch = channels[c.controller];
+      ch.pending--;
+      ch.banks[c.bank].pending--;
+      completed++;
+      total_latency += now - c.inserted;
+      //Tell the profiler about 1 request that took N DRAM cycles to complete
+      rigel::profiler::stats[STATNAME_MC_LATENCY].inc_mem_histogram(now - c.inserted, 1);
+    }
+    c.requester->callback(c.requestIdentifier, 0, c.addr);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Dump()
+////////////////////////////////////////////////////////////////////////////////
+void
+DRAMAnalyticModel::Dump() const
+{
+  const uint64_t row_lines = row_hits + row_empty + row_conflicts;
+  fprintf(stderr, "DRAM model: %s\n", ideal ? "ideal" : "analytic");
+  fprintf(stderr, "  requests %" PRIu64 " lines %" PRIu64 " rejected %" PRIu64
+                  " in flight %zu lines\n",
+          requests, lines, rejected, completions.size());
+  if (row_lines != 0) {
+    fprintf(stderr, "  row hit %.1f%% empty %.1f%% conflict %.1f%%\n",
+            100.0 * row_hits / row_lines, 100.0 * row_empty / row_lines,
+            100.0 * row_conflicts / row_lines);
+  }
+  if (completed != 0) {
+    fprintf(stderr, "  mean request latency %.1f DRAM cycles\n",
+            (double)total_latency / completed);
+  }
+}
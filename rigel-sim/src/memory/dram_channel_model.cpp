@@ -28,6 +28,7 @@ unsigned int rigel::DRAM::ROWS;
 unsigned int rigel::DRAM::RANKS;
 unsigned int rigel::DRAM::CONTROLLERS;
 unsigned int rigel::DRAM::OPEN_ROWS;
+rigel::DRAM::DRAMModel rigel::DRAM::MODEL = rigel::DRAM::dram_model_command;
 
 /*
 #define DEBUG
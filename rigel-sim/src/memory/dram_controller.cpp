@@ -20,6 +20,7 @@
 #include "memory/dram.h"           // for BANKS, RANKS, WL, CL, etc
 #include "memory/dram_channel_model.h"  // for DRAMChannelModel
 #include "memory/dram_controller.h"  // for DRAMController, etc
+#include "locality_tracker.h"  // for LocalityTracker
 #include "caches_legacy/mshr_legacy.h"           // for MissHandlingEntry, etc
 #include "profile/profile.h"        // for ProfileStat, MemStat, etc
 #include "profile/profile_names.h"
@@ -56,10 +57,19 @@ DRAMController::DRAMController(
   issuingBatchCounter(0UL), 
   servicingBatchCounter(0UL), 
   requestsInCurrentBatch(0),
+  rowTracker(NULL),
   collisionChecking(_collisionChecking)
 {
   using namespace rigel::DRAM;
 
+  if(rigel::mem_sched::LOCALITY_AWARE_SCHEDULING)
+  {
+    //The tracker's windows model each bank's request buffer draining its
+    //most common row first, so what is left in them is recent unmet demand.
+    rowTracker = new LocalityTracker("DRAM scheduler", rigel::mem_sched::PENDING_PER_BANK,
+      LT_POLICY_MCF, CONTROLLERS, RANKS, BANKS, ROWS);
+  }
+
   //Initialize first batching map entry (the rest will be taken care of on batch boundaries in Schedule())
   outstandingBatchRequests[0] = 0;
 
@@ -328,7 +338,7 @@ void DRAMController::Schedule_SinglePendingRequest()
       pendingRequest[0] = rowHitRequest;
       rigel::profiler::stats[STATNAME_MC_SCHED_ROW_HIT].inc();
     }
-    else {
+    else if (rowTracker == NULL || !helper_FindLocalityRequest(priorityRank, priorityBank, pendingRequest[0])) {
       pendingRequest[0] = &(requestBuffer[priorityRank][priorityBank][DRAMChannelModel::GetDRAMCycle() % PENDING_PER_BANK]);
     }
   }
@@ -470,7 +480,7 @@ void DRAMController::Schedule_PerBankPendingRequests()
           temp = rowHitRequest;
           rigel::profiler::stats[STATNAME_MC_SCHED_ROW_HIT].inc();
         }
-        else {
+        else if (rowTracker == NULL || !helper_FindLocalityRequest(i, j, temp)) {
           //FIXME The k index here is implemented the same as priorityBank/Rank.  Implement it that way.
           temp = &(requestBuffer[i][j][DRAMChannelModel::GetDRAMCycle() % PENDING_PER_BANK]);
         }
@@ -612,6 +622,42 @@ bool DRAMController::helper_FindRowHit(unsigned int rank, unsigned int bank, Pen
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////
+// helper_FindLocalityRequest()
+//////////////////////////////////////////////////////////////////////////////////
+// With no row hit to take, pick the request that opens the row with the most
+// demand among the bank's recent requests, so the activation is amortized over
+// as many row hits as possible.  Ties go to the lowest slot.
+//////////////////////////////////////////////////////////////////////////////////
+bool DRAMController::helper_FindLocalityRequest(unsigned int rank, unsigned int bank, PendingRequestEntry* &request)
+{
+  using namespace rigel::DRAM;
+  using namespace rigel::mem_sched;
+
+  if (requestBufferOccupancy[rank][bank] == 0) return false;
+
+  PendingRequestEntry *best = NULL;
+  unsigned int bestCount = 0;
+  for (int slot = 0; slot < PENDING_PER_BANK; slot++) {
+    PendingRequestEntry &req = requestBuffer[rank][bank][slot];
+    if (!req.Valid || req.AllLinesPending())
+      continue;
+    if(DRAM_BATCHING_POLICY != batch_none && req.BatchNumber != servicingBatchCounter)
+      continue;
+    unsigned int row = AddressMapping::GetRow(*(req.addrs.begin()));
+    unsigned int count = rowTracker->getRowCount(id, rank, bank, row);
+    if (best == NULL || count > bestCount)
+    {
+      best = &req;
+      bestCount = count;
+    }
+  }
+  if (best == NULL) return false;
+  request = best;
+  return true;
+}
+
+
 //////////////////////////////////////////////////////////////////////////////////
 // helper_FindTimeout()
 //////////////////////////////////////////////////////////////////////////////////
@@ -1295,6 +1341,8 @@ bool DRAMController::Schedule(const std::set<uint32_t> addrs, int size,
       requestBufferOccupancy[rank][bank]++;
       totalRequestBufferOccupancy++;
       // Schedule() succeeded.  Requester is now waiting for callback.
+      if (rowTracker != NULL)
+        rowTracker->addAccess(*(addrs.begin()));
 
       if (rigel::GENERATE_DRAMTRACE) {
         for(std::set<uint32_t>::iterator it = addrs.begin(); it != addrs.end(); ++it)
@@ -25,6 +25,7 @@
 #include "memory/dram.h"           // for CONTROLLERS, BANKS, RANKS, etc
 #include "memory/dram_channel_model.h"  // for DRAMChannelModel, etc
 #include "memory/dram_controller.h"  // for DRAMController, etc
+#include "memory/dram_analytic_model.h"  // for DRAMAnalyticModel
 #include "locality_tracker.h"  // for LocalityTracker, etc
 #include "memory/memory_timing_dram.h"
 #include "caches_legacy/mshr_legacy.h"           // for MissHandlingEntry
@@ -44,7 +45,8 @@ namespace rigel {
 // RETURNS: ---
 ////////////////////////////////////////////////////////////////////////////////
 MemoryTimingDRAM::MemoryTimingDRAM(ComponentBase *parent, bool _collisionChecking) :
-  MemoryTimingBase(parent)
+  MemoryTimingBase(parent),
+  analytic(NULL)
 {
   using namespace rigel::DRAM;
   DRAMModelArray = (DRAMChannelModel **) malloc(CONTROLLERS*sizeof(*DRAMModelArray));
@@ -80,6 +82,11 @@ MemoryTimingDRAM::MemoryTimingDRAM(ComponentBase *parent, bool _collisionCheckin
     }
   }
 
+  if (MODEL != dram_model_command) {
+    analytic = new DRAMAnalyticModel(MODEL == dram_model_ideal,
+                                     rigel::CMDLINE_IDEALIZED_DRAM_LATENCY);
+  }
+
   //Make sure the block of cache lines contiguously mapped to a single G$ bank
   //is not larger than a DRAM row.  This would cause problems, since we stride across
   //memory controllers every DRAM row, and every G$ bank can only cache the address space
@@ -255,6 +262,13 @@ MemoryTimingDRAM::PerCycle() {
     if(ProfileStat::is_active())
       ProfileStat::increment_active_dram_cycles();
 
+    // The analytic model timed each line when it was scheduled; it only
+    // has to hand back the ones that are ready.
+    if (analytic) {
+      analytic->PerCycle();
+      continue;
+    }
+
     // Clock our DRAM chips and controllers
     for (unsigned int i = 0; i < CONTROLLERS; i++)
     {
@@ -367,8 +381,13 @@ bool MemoryTimingDRAM::Schedule(const std::set<uint32_t> addrs, int size,
 {
   //FIXME: Deal with addrs that spans controllers.
   //It should be an error, but it is currently checked so many other places that I don't bother here.
-  int controller = AddressMapping::GetController(*(addrs.begin()));
-  bool ret = Controllers[controller]->Schedule(addrs, size, MSHR, requestingEntity, requestIdentifier);
+  bool ret;
+  if (analytic) {
+    ret = analytic->Schedule(addrs, MSHR.IsRead(), requestingEntity, requestIdentifier);
+  } else {
+    int controller = AddressMapping::GetController(*(addrs.begin()));
+    ret = Controllers[controller]->Schedule(addrs, size, MSHR, requestingEntity, requestIdentifier);
+  }
 
   //If it was scheduled successfully, get locality stats
   if(rigel::ENABLE_LOCALITY_TRACKING)
@@ -393,6 +412,10 @@ void MemoryTimingDRAM::Dump()
   using namespace rigel::mem_sched;
 
   fprintf(stderr, "#### MEMORY MODEL #####\n");
+  if (analytic) {
+    analytic->Dump();
+    return;
+  }
   for (unsigned int ctrl = 0; ctrl < CONTROLLERS; ctrl++)
   {
     Controllers[ctrl]->dump(false);
@@ -400,6 +423,15 @@ void MemoryTimingDRAM::Dump()
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void MemoryTimingDRAM::EndSim()
+{
+  if (analytic) {
+    analytic->Dump();
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 void MemoryTimingDRAM::dump_locality() const
@@ -1,19 +1,25 @@
 #include "port/port.h"
+#include "sim/component_base.h"
 #include <string>
 #include <sstream>
 #include <iomanip>
 
 //FIXME Use a function naming convention, not a class naming convention
-std::string PortName(std::string parent, int id, std::string suffix, int index) {
+PortID PortName(ComponentBase *parent, const char *suffix, int index) {
+  return PortID(parent, suffix, index);
+}
+
+/// format the port name; only called when a port is printed
+std::string PortID::str() const {
 
     std::stringstream port_name;
 #if 0
-    port_name << parent << "[" << std::setw(4) << id << "]." << suffix;
+    port_name << owner->name() << "[" << std::setw(4) << owner->id() << "]." << suffix;
     if (index >= 0) {
       port_name << "[" << std::setw(4) << index << "]";
     }
 #endif
-    port_name << parent << "_" << id << "_" << suffix;
+    port_name << owner->name() << "_" << owner->id() << "_" << suffix;
     if (index >= 0) {
       port_name << "_" << index ;
     }
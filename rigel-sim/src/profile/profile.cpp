@@ -49,6 +49,7 @@
 #include "profile/profile_names.h"  // for ::STATNAME_L2IN_TOTAL, etc
 #include "sim.h"            // for DUMPFILE_PATH, NUM_TILES, etc
 #include "util/task_queue.h"     // for TaskSystemBaseline
+#include "util/util.h"           // for ELFAccess, ELFSymbol
 #include "memory/backing_store.h"  // for definition of GlobalBackingStoreType
 
 #ifdef ENABLE_COUCHDB
@@ -81,8 +82,10 @@ int rigel::profiler::gcacheops_histogram_bin_size;
 
 // Track per-PC statistics
 std::map< uint32_t, profile_instr_stall_t > Profile::per_pc_stats;
+std::map< uint32_t, profile_pc_samples_t > Profile::per_pc_samples;
 
 bool rigel::profiler::CMDLINE_DUMP_PER_PC_STATS;
+uint64_t rigel::profiler::PER_PC_SAMPLE_PERIOD;
 std::string rigel::profiler::DUMPFILE_PREFIX;
 
 uint64_t *rigel::profiler::ccache_access_histogram;
@@ -160,9 +163,6 @@ ProfileStat::ProfileStat(std::string name, profile_stat_t _type, uint64_t _confi
   time_hist_bin_size(1024) ,
   config(_config)
 {
-  // initialize WriteTracker 
-  // for memory access tracking, init interval number
-  currentBarrierNum = rigel::event::global_tracker.GetRTMBarrierCount();
 }
 
 ProfileStat::ProfileStat() :
@@ -174,10 +174,6 @@ ProfileStat::ProfileStat() :
   // Zero counters
   memset(&count, 0, sizeof(count));
 
-  // initialize WriteTracker 
-  // for memory access tracking, init interval number
-  currentBarrierNum = rigel::event::global_tracker.GetRTMBarrierCount();
-
 }
 
 void
@@ -502,11 +498,26 @@ timify(uint64_t count, std::string &s) {
 // constructor
 // inputs: Memory Model pointer
 //         cluster_id
-Profile::Profile(rigel::GlobalBackingStoreType *Memory, int cluster_id)
+Profile::Profile(rigel::GlobalBackingStoreType *Memory, int cluster_id) :
+  per_pc_table(profile_instr_stall_t()),
+  per_pc_last_pc(0),
+  per_pc_last(NULL),
+  per_pc_sample_table(profile_pc_samples_t())
 {
   active = rigel::PROFILER_ACTIVE;  
   this->backing_store = Memory;
   cluster_num = cluster_id;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Profile::init()
+////////////////////////////////////////////////////////////////////////////////
+// Set up the statics every cluster's Profile shares.  Called once, on the main
+// thread, before the tiles are built: clusters may be constructed on several
+// host threads (see sim/build_slot.h) and must not touch shared state.
+////////////////////////////////////////////////////////////////////////////////
+void
+Profile::init() {
   for(int i=0;i<rigel::NUM_TIMERS;i++){ // init timers
     SystemTimers[i].valid   = false;
     SystemTimers[i].enabled = false;
@@ -517,7 +528,9 @@ Profile::Profile(rigel::GlobalBackingStoreType *Memory, int cluster_id)
   }
 
   //Allocate the 3D arrays for tracking the number of reads, writes, and activates to each DRAM bank
-  mem_stats.init();
+  if (!mem_stats.initDone) {
+    mem_stats.init();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -888,7 +901,7 @@ Profile::global_dump_profile(int argc, char *argv[])
 	std::string stime;
   timify(ts->tot_usec, stime); 
 
-  if(rigel::profiler::CMDLINE_DUMP_PER_PC_STATS)
+  if(per_pc_exact())
     accumulate_per_pc_stall_cycles(); //Otherwise, the stats will be accumulated on a per-instruction basis
 
   PRINT_HEADER("SIMULATION PARAMETERS");
@@ -1281,8 +1294,12 @@ Profile::global_dump_profile(int argc, char *argv[])
   }
 
 
-  // Print out latency and hit miss counts for each PC.
   if (rigel::profiler::CMDLINE_DUMP_PER_PC_STATS) {
+    dump_per_pc_folded();
+  }
+
+  // Print out latency and hit miss counts for each PC.
+  if (per_pc_exact()) {
     FILE * filep;
 		std::string dump_filename;
 
@@ -1560,6 +1577,24 @@ Profile::accumulate_stats(){
   accum_cache_stats.L2I_cache_misses += cache_stats.L2I_cache_misses;
   accum_cache_stats.L2I_cache_hits += cache_stats.L2I_cache_hits;
 
+  //merge this cluster's per-PC tables
+  for (size_t i = 0; i < per_pc_table.capacity(); i++) {
+    if (per_pc_table.slot_used(i)) {
+      per_pc_stats[per_pc_table.slot_key(i)].merge(per_pc_table.slot_value(i));
+    }
+  }
+  per_pc_table.clear();
+  per_pc_last = NULL;
+  for (size_t i = 0; i < per_pc_sample_table.capacity(); i++) {
+    if (per_pc_sample_table.slot_used(i)) {
+      const profile_pc_samples_t &from = per_pc_sample_table.slot_value(i);
+      profile_pc_samples_t &to = per_pc_samples[per_pc_sample_table.slot_key(i)];
+      for (int r = 0; r < PC_SAMPLE_NUM_REASONS; r++) {
+        to.count[r] += from.count[r];
+      }
+    }
+  }
+  per_pc_sample_table.clear();
 }
 
 
@@ -2252,7 +2287,77 @@ void Profile::accumulate_per_pc_stall_cycles()
 }
 
 
-void Profile::accumulate_stall_cycles(InstrCycleStats ics)
+////////////////////////////////////////////////////////////////////////////////
+/// dump_per_pc_folded()
+///
+/// Write the per-PC profile as flamegraph folded stacks, one line per PC and
+/// reason:
+///
+///   <function>;0x<pc>;<reason> <cycles>
+///
+/// Function names come from the benchmark binary's symbol table.  With exact
+/// per-PC stats the reasons are the pipeline stages an instruction was held
+/// in and the cycles are exact; with -per-pc-sample they are where the
+/// sampled instruction was, and cycles are samples times the period.  Feed
+/// the file to flamegraph.pl.
+////////////////////////////////////////////////////////////////////////////////
+void Profile::dump_per_pc_folded()
+{
+  static const char *reason_names[PC_SAMPLE_NUM_REASONS] = {
+    "fetch", "decode", "execute", "mem", "fp", "cc", "wb"
+  };
+
+  std::string dump_filename = rigel::DUMPFILE_PATH + std::string("/")
+                            + rigel::profiler::DUMPFILE_PREFIX
+                            + std::string(rigel::profiler::per_pc_folded_filename);
+  FILE *filep = fopen(dump_filename.c_str(), "w");
+  if (filep == NULL) {
+    fprintf(stderr, "Error: unable to open '%s'\n", dump_filename.c_str());
+    return;
+  }
+
+  std::vector<ELFSymbol> syms;
+  ELFAccess::ReadFunctionSymbols(rigel::BENCHMARK_BINARY_PATH, syms);
+  // Both maps are in PC order, so the enclosing function only moves forward.
+  size_t sym = 0;
+  uint64_t cycles[PC_SAMPLE_NUM_REASONS];
+
+  std::map<uint32_t, profile_instr_stall_t>::const_iterator pciter = per_pc_stats.begin();
+  std::map<uint32_t, profile_pc_samples_t>::const_iterator siter = per_pc_samples.begin();
+  while (per_pc_exact() ? pciter != per_pc_stats.end() : siter != per_pc_samples.end()) {
+    uint32_t pc;
+    if (per_pc_exact()) {
+      pc = pciter->first;
+      const InstrCycleStats &c = pciter->second.cycles;
+      cycles[PC_SAMPLE_FETCH]   = c.fetch + c.instr_stall;
+      cycles[PC_SAMPLE_DECODE]  = c.decode;
+      cycles[PC_SAMPLE_EXECUTE] = c.execute;
+      cycles[PC_SAMPLE_MEM]     = c.mem;
+      cycles[PC_SAMPLE_FP]      = c.fp;
+      cycles[PC_SAMPLE_CC]      = c.cc;
+      cycles[PC_SAMPLE_WB]      = c.wb;
+      ++pciter;
+    } else {
+      pc = siter->first;
+      for (int r = 0; r < PC_SAMPLE_NUM_REASONS; r++) {
+        cycles[r] = siter->second.count[r] * rigel::profiler::PER_PC_SAMPLE_PERIOD;
+      }
+      ++siter;
+    }
+
+    while (sym < syms.size() && syms[sym].addr + syms[sym].size <= pc) { sym++; }
+    const char *func = (sym < syms.size() && syms[sym].addr <= pc) ? syms[sym].name.c_str()
+                                                       : "[unknown]";
+    for (int r = 0; r < PC_SAMPLE_NUM_REASONS; r++) {
+      if (cycles[r] != 0) {
+        fprintf(filep, "%s;0x%08x;%s %" PRIu64 "\n", func, pc, reason_names[r], cycles[r]);
+      }
+    }
+  }
+  fclose(filep);
+}
+
+void Profile::accumulate_stall_cycles(const InstrCycleStats &ics)
 {
   profiler::stats[STATNAME_INSTR_INSTR_STALL_CYCLES].inc(ics.instr_stall);
   profiler::stats[STATNAME_INSTR_IF_OCCUPANCY].inc(ics.fetch);
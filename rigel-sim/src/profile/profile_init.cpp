@@ -8,6 +8,7 @@
 #include "profile/profile.h"        // for ProfileStat, etc
 #include "profile/profile_names.h"  // for ::STATNAME_ATOMICS, etc
 #include "sim.h"            // for stats
+#include "util/event_track.h"    // for global_tracker
 #if 0
 #define __NEW_PROFILER_STAT(name, type, config) do { \
   rigel::profiler::stats[name] = ProfileStat(name, type, config); \
@@ -49,6 +50,8 @@ ProfileStat::init(FILE * fp)
   output_file = fp;
   // Clear retired instruction count.
   retired_instrs = 0;
+  // for memory access tracking, init interval number
+  currentBarrierNum = rigel::event::global_tracker.GetRTMBarrierCount();
   // Allocate the statistic counters (in profile_names.h)
   profiler::stats = new ProfileStat[STATNAME_PROFILE_STAT_COUNT];
 
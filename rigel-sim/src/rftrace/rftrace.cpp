@@ -0,0 +1,155 @@
+////////////////////////////////////////////////////////////////////////////////
+// rftrace.cpp
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Decoder for the binary register-write trace produced by
+//  -regfile-trace-dump (see util/reg_trace.h).  Splits rf.trace.bin back into
+//  one rf.<core>.<thread>.trace text file per hardware thread, in the same
+//  format the simulator used to write directly:
+//
+//    GPR write:   <pc> <reg> <value>       e.g. "00001234 5 0000002a"
+//    SPRF write:  <pc> s<reg> <value>
+//
+//  With -c each line is prefixed with the 12-digit cycle of the write.
+//
+//  usage: rftrace [-c] [-o <outdir>] <rf.trace.bin>
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <inttypes.h>                   // for PRIu64
+#include <stdint.h>                     // for uint32_t, uint64_t
+#include <cerrno>                       // for errno
+#include <cstdio>                       // for FILE, fopen, fprintf, etc
+#include <cstdlib>                      // for exit
+#include <cstring>                      // for memcmp, strcmp, strerror
+#include <string>                       // for string
+#include <vector>                       // for vector
+#include "util/reg_trace.h"
+
+namespace {
+
+// Text is staged per thread and appended to the thread's file in large
+// chunks so that only one output file is open at a time, no matter how many
+// threads the trace covers.
+const size_t FLUSH_BYTES = 1 << 16;
+const size_t READ_RECORDS = 1 << 16;
+
+struct ThreadOutput {
+  std::string text;
+  bool opened;      // file truncated already; append from now on
+  ThreadOutput() : opened(false) { }
+};
+
+void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-c] [-o <outdir>] <rf.trace.bin>\n", prog);
+  fprintf(stderr, "  -c           prefix each line with the cycle of the write\n");
+  fprintf(stderr, "  -o <outdir>  directory for rf.<core>.<thread>.trace (default: .)\n");
+  exit(1);
+}
+
+void flush_thread(ThreadOutput &t, const std::string &outdir, int gtid,
+                  uint32_t threads_per_core)
+{
+  if (t.text.empty() && t.opened) { return; }
+  char name[64];
+  snprintf(name, sizeof(name), "/rf.%u.%u.trace",
+    gtid / threads_per_core, gtid % threads_per_core);
+  std::string path = outdir + name;
+  FILE *f = fopen(path.c_str(), t.opened ? "a" : "w");
+  if (f == NULL) {
+    fprintf(stderr, "Error: unable to open '%s': %s\n", path.c_str(), strerror(errno));
+    exit(1);
+  }
+  fwrite(t.text.data(), 1, t.text.size(), f);
+  fclose(f);
+  t.text.clear();
+  t.opened = true;
+}
+
+} // end anonymous namespace
+
+int main(int argc, char *argv[])
+{
+  bool print_cycle = false;
+  std::string outdir(".");
+  const char *infile = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp(argv[i], "-c")) {
+      print_cycle = true;
+    } else if (0 == strcmp(argv[i], "-o")) {
+      if (++i >= argc) { usage(argv[0]); }
+      outdir = argv[i];
+    } else if (argv[i][0] == '-' || infile != NULL) {
+      usage(argv[0]);
+    } else {
+      infile = argv[i];
+    }
+  }
+  if (infile == NULL) { usage(argv[0]); }
+
+  FILE *in = fopen(infile, "rb");
+  if (in == NULL) {
+    fprintf(stderr, "Error: unable to open '%s': %s\n", infile, strerror(errno));
+    return 1;
+  }
+
+  RegTraceFileHeader hdr;
+  if (fread(&hdr, sizeof(hdr), 1, in) != 1
+      || 0 != memcmp(hdr.magic, rigel::regtrace::MAGIC, sizeof(hdr.magic))) {
+    fprintf(stderr, "Error: '%s' is not a register trace\n", infile);
+    return 1;
+  }
+  if (hdr.version != rigel::regtrace::VERSION
+      || hdr.record_size != sizeof(RegTraceRecord)
+      || hdr.threads_per_core == 0) {
+    fprintf(stderr, "Error: '%s' has unsupported version %u (record size %u)\n",
+      infile, hdr.version, hdr.record_size);
+    return 1;
+  }
+
+  std::vector<ThreadOutput> threads(hdr.threads_total);
+  std::vector<RegTraceRecord> recs(READ_RECORDS);
+  uint64_t total = 0;
+  size_t n;
+  while ((n = fread(&recs[0], sizeof(RegTraceRecord), READ_RECORDS, in)) > 0) {
+    for (size_t i = 0; i < n; i++) {
+      const RegTraceRecord &r = recs[i];
+      if (r.gtid >= hdr.threads_total) {
+        fprintf(stderr, "Error: record %" PRIu64 " has invalid gtid %u\n", total + i, r.gtid);
+        return 1;
+      }
+      char line[64];
+      int len = 0;
+      if (print_cycle) {
+        len += snprintf(line, sizeof(line), "%012" PRIu64 " ", r.cycle);
+      }
+      if (r.reg & rigel::regtrace::SPRF_FLAG) {
+        len += snprintf(line + len, sizeof(line) - len, "%08x s%u %08x\n",
+          r.pc, r.reg & ~rigel::regtrace::SPRF_FLAG, r.value);
+      } else {
+        len += snprintf(line + len, sizeof(line) - len, "%08x %u %08x\n",
+          r.pc, r.reg, r.value);
+      }
+      ThreadOutput &t = threads[r.gtid];
+      t.text.append(line, len);
+      if (t.text.size() >= FLUSH_BYTES) {
+        flush_thread(t, outdir, r.gtid, hdr.threads_per_core);
+      }
+    }
+    total += n;
+  }
+  fclose(in);
+
+  // Threads that never wrote a register get no file.
+  int files = 0;
+  for (size_t g = 0; g < threads.size(); g++) {
+    if (threads[g].text.empty() && !threads[g].opened) { continue; }
+    flush_thread(threads[g], outdir, g, hdr.threads_per_core);
+    files++;
+  }
+
+  fprintf(stderr, "rftrace: %" PRIu64 " records, %d thread files\n", total, files);
+  return 0;
+}
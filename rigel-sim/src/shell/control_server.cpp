@@ -0,0 +1,645 @@
+////////////////////////////////////////////////////////////////////////////////
+// control_server.cpp
+////////////////////////////////////////////////////////////////////////////////
+//
+//  ControlServer implementation.  See shell/control_server.h.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>                      // for errno, EAGAIN, EINTR
+#include <fcntl.h>                      // for fcntl, O_NONBLOCK
+#include <inttypes.h>                   // for PRIu64, PRIx64
+#include <poll.h>                       // for poll, pollfd
+#include <stdint.h>                     // for uint32_t, uint64_t
+#include <sys/socket.h>                 // for socket, bind, listen, accept
+#include <sys/un.h>                     // for sockaddr_un
+#include <unistd.h>                     // for close, unlink, dup, dup2
+#include <cstdio>                       // for fprintf, snprintf, tmpfile
+#include <cstdlib>                      // for exit, strtoull
+#include <cstring>                      // for strerror, strncpy
+#include <iostream>                     // for cout, cerr
+#include <stdexcept>                    // for out_of_range
+#include <string>                       // for string
+#include "instr/pipe_packet.h"          // for PipePacket::setBreakpoint
+#include "memory/backing_store.h"       // for BackingStore::set_watchpoint
+#include "profile/profile.h"            // for ProfileStat
+#include "profile/profile_names.h"      // for STATNAME_PROFILE_STAT_COUNT
+#include "rapidjson/document.h"         // for Document
+#include "rapidjson/stringbuffer.h"     // for StringBuffer
+#include "rapidjson/writer.h"           // for Writer
+#include "shell/control_server.h"
+#include "sim.h"                        // for CURR_CYCLE, RETIRED_INSTRS_TOTAL
+#include "sim/component_base.h"         // for ComponentBase
+#include "util/util.h"                  // for ExitSim
+
+ControlServer *rigel::CONTROL = NULL;
+
+typedef rapidjson::Writer<rapidjson::StringBuffer> JSONWriter;
+
+////////////////////////////////////////////////////////////////////////////////
+// helpers
+////////////////////////////////////////////////////////////////////////////////
+
+static std::string
+helper_error(const std::string &msg) {
+  rapidjson::StringBuffer sb;
+  JSONWriter w(sb);
+  w.StartObject();
+  w.String("ok");    w.Bool(false);
+  w.String("error"); w.String(msg.c_str());
+  w.EndObject();
+  return sb.GetString();
+}
+
+/// a PC, address or count given as a number or a string ("0x1000")
+static bool
+helper_get_u64(const rapidjson::Value &v, uint64_t &out) {
+  if (v.IsUint64()) {
+    out = v.GetUint64();
+    return true;
+  }
+  if (v.IsString()) {
+    const char *s = v.GetString();
+    char *end;
+    errno = 0;
+    out = strtoull(s, &end, 0);
+    return *s != '\0' && *end == '\0' && errno == 0;
+  }
+  return false;
+}
+
+static void helper_dump_one(ComponentBase *c) { c->Dump(); }
+
+static void helper_print_roots(ComponentBase *) {
+  for (int i = 0; ComponentBase::rootComponent(i) != 0; ++i) {
+    ComponentBase::rootComponent(i)->printHierarchy();
+  }
+}
+
+/// run fn(c) with stdout and stderr sent to a temporary file; its contents
+static std::string
+helper_capture(void (*fn)(ComponentBase *), ComponentBase *c) {
+  std::string out;
+  FILE *tmp = tmpfile();
+  if (tmp == NULL) {
+    return out;
+  }
+  fflush(stdout); fflush(stderr); std::cout.flush(); std::cerr.flush();
+  const int saved_out = dup(1);
+  const int saved_err = dup(2);
+  dup2(fileno(tmp), 1);
+  dup2(fileno(tmp), 2);
+  fn(c);
+  fflush(stdout); fflush(stderr); std::cout.flush(); std::cerr.flush();
+  dup2(saved_out, 1);
+  dup2(saved_err, 2);
+  close(saved_out);
+  close(saved_err);
+
+  rewind(tmp);
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), tmp)) > 0) {
+    out.append(buf, n);
+  }
+  fclose(tmp);
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ControlServer()
+////////////////////////////////////////////////////////////////////////////////
+ControlServer::ControlServer(const std::string &_path, uint64_t _poll_interval,
+                             bool wait) :
+  path(_path),
+  poll_interval(_poll_interval),
+  listen_fd(-1),
+  client_fd(-1),
+  running(!wait),
+  next_check(wait ? 0 : _poll_interval),
+  step_until(0),
+  stop_reason(wait ? "--control-wait" : ""),
+  next_id(1)
+{
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Error: --control-socket path too long: %s\n", path.c_str());
+    exit(1);
+  }
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+  listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0) {
+    fprintf(stderr, "Error: control socket: %s\n", strerror(errno));
+    exit(1);
+  }
+  unlink(path.c_str());
+  if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(listen_fd, 1) != 0) {
+    fprintf(stderr, "Error: control socket %s: %s\n", path.c_str(), strerror(errno));
+    exit(1);
+  }
+  fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+  fprintf(stderr, "control: listening on %s\n", path.c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ~ControlServer()
+////////////////////////////////////////////////////////////////////////////////
+ControlServer::~ControlServer() {
+  if (client_fd >= 0) {
+    rapidjson::StringBuffer sb;
+    JSONWriter w(sb);
+    w.StartObject();
+    w.String("event"); w.String("exit");
+    w.String("cycle"); w.Uint64(rigel::CURR_CYCLE);
+    w.EndObject();
+    Send(sb.GetString());
+    close(client_fd);
+  }
+  close(listen_fd);
+  unlink(path.c_str());
+  // Watched words stay out of the fast path, but nobody is told any more.
+  if (rigel::GLOBAL_BACKING_STORE_PTR) {
+    rigel::GLOBAL_BACKING_STORE_PTR->set_watch_callback(NULL);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Check()
+////////////////////////////////////////////////////////////////////////////////
+void
+ControlServer::Check() {
+  Accept();
+  if (client_fd >= 0 && !Receive()) {
+    Disconnect();
+  }
+  Dispatch();
+
+  if (step_until != 0 && rigel::CURR_CYCLE >= step_until) {
+    step_until = 0;
+    if (stop_reason.empty()) { stop_reason = "step"; }
+  }
+  if (cycle_breaks.count(rigel::CURR_CYCLE)) {
+    for (std::map<int, Breakpoint>::iterator it = breakpoints.begin();
+         it != breakpoints.end(); ++it) {
+      if (it->second.kind == "cycle" && it->second.value == rigel::CURR_CYCLE) {
+        it->second.hits++;
+      }
+    }
+    if (stop_reason.empty()) { stop_reason = "cycle breakpoint"; }
+  }
+  if (!stop_reason.empty()) {
+    Stop(stop_reason);
+    stop_reason.clear();
+  }
+
+  // Stopped: wait for the client to let us go.
+  while (!running) {
+    struct pollfd fds[2];
+    int nfds = 0;
+    fds[nfds].fd = listen_fd; fds[nfds].events = POLLIN; fds[nfds].revents = 0; nfds++;
+    if (client_fd >= 0) {
+      fds[nfds].fd = client_fd; fds[nfds].events = POLLIN; fds[nfds].revents = 0; nfds++;
+    }
+    if (poll(fds, nfds, -1) < 0 && errno != EINTR) {
+      fprintf(stderr, "control: poll: %s\n", strerror(errno));
+      running = true; // do not hang the simulation on a broken socket
+      break;
+    }
+    Accept();
+    if (client_fd >= 0 && !Receive()) {
+      Disconnect();
+    }
+    Dispatch();
+  }
+  Reschedule();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Hit()
+////////////////////////////////////////////////////////////////////////////////
+void
+ControlServer::Hit(const std::string &reason) {
+  if (stop_reason.empty()) {
+    stop_reason = reason;
+  }
+  next_check = rigel::CURR_CYCLE; // stop at the top of the next cycle
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// PCHit() / watch_hit()
+////////////////////////////////////////////////////////////////////////////////
+void
+ControlServer::PCHit(int gtid, uint32_t pc) {
+  bool hit = false;
+  for (std::map<int, Breakpoint>::iterator it = breakpoints.begin();
+       it != breakpoints.end(); ++it) {
+    Breakpoint &b = it->second;
+    if (b.kind == "pc" && b.value == pc && (b.thread < 0 || b.thread == gtid)) {
+      b.hits++;
+      hit = true;
+    }
+  }
+  if (hit) {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "pc breakpoint 0x%08" PRIx32 " thread %d",
+             pc, gtid);
+    Hit(buf);
+  }
+}
+
+void
+ControlServer::watch_hit(uint32_t addr, bool write) {
+  const unsigned int access = write ? rigel::GlobalBackingStoreType::WATCH_WRITE
+                                    : rigel::GlobalBackingStoreType::WATCH_READ;
+  for (std::map<int, Breakpoint>::iterator it = breakpoints.begin();
+       it != breakpoints.end(); ++it) {
+    Breakpoint &b = it->second;
+    if (b.kind == "addr" && b.value == (addr & ~3U) && (b.access & access)) {
+      b.hits++;
+    }
+  }
+  char buf[96];
+  snprintf(buf, sizeof(buf), "addr breakpoint 0x%08" PRIx32 " (%s)",
+           addr, write ? "write" : "read");
+  Hit(buf);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Stop()
+////////////////////////////////////////////////////////////////////////////////
+void
+ControlServer::Stop(const std::string &reason) {
+  running = false;
+  step_until = 0;
+  if (client_fd < 0) {
+    fprintf(stderr, "control: stopped at cycle %" PRIu64 " (%s), waiting on %s\n",
+            rigel::CURR_CYCLE, reason.c_str(), path.c_str());
+    return;
+  }
+  rapidjson::StringBuffer sb;
+  JSONWriter w(sb);
+  w.StartObject();
+  w.String("event");  w.String("stopped");
+  w.String("cycle");  w.Uint64(rigel::CURR_CYCLE);
+  w.String("reason"); w.String(reason.c_str());
+  w.EndObject();
+  Send(sb.GetString());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reschedule()
+////////////////////////////////////////////////////////////////////////////////
+void
+ControlServer::Reschedule() {
+  uint64_t next = rigel::CURR_CYCLE + poll_interval;
+  if (step_until != 0 && step_until < next) {
+    next = step_until;
+  }
+  std::multiset<uint64_t>::const_iterator c =
+    cycle_breaks.lower_bound(rigel::CURR_CYCLE + 1);
+  if (c != cycle_breaks.end() && *c < next) {
+    next = *c;
+  }
+  next_check = next;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Accept()
+////////////////////////////////////////////////////////////////////////////////
+void
+ControlServer::Accept() {
+  int fd;
+  while ((fd = accept(listen_fd, NULL, NULL)) >= 0) {
+    if (client_fd >= 0) {
+      // One client at a time.
+      const std::string err = helper_error("another client is connected") + "\n";
+      if (send(fd, err.data(), err.size(), MSG_NOSIGNAL) < 0) { /* closing anyway */ }
+      close(fd);
+      continue;
+    }
+    // accept() does not inherit O_NONBLOCK on Linux; replies block, reads
+    // use MSG_DONTWAIT.
+    client_fd = fd;
+    inbuf.clear();
+    rapidjson::StringBuffer sb;
+    JSONWriter w(sb);
+    w.StartObject();
+    w.String("event");   w.String("connected");
+    w.String("cycle");   w.Uint64(rigel::CURR_CYCLE);
+    w.String("running"); w.Bool(running);
+    w.EndObject();
+    Send(sb.GetString());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Receive()
+////////////////////////////////////////////////////////////////////////////////
+bool
+ControlServer::Receive() {
+  char buf[4096];
+  for (;;) {
+    const ssize_t n = recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (n > 0) {
+      inbuf.append(buf, n);
+    } else if (n == 0) {
+      return false;
+    } else if (errno == EINTR) {
+      continue;
+    } else {
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Disconnect()
+////////////////////////////////////////////////////////////////////////////////
+void
+ControlServer::Disconnect() {
+  close(client_fd);
+  client_fd = -1;
+  inbuf.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Dispatch()
+////////////////////////////////////////////////////////////////////////////////
+void
+ControlServer::Dispatch() {
+  size_t eol;
+  while (client_fd >= 0 && (eol = inbuf.find('\n')) != std::string::npos) {
+    std::string line = inbuf.substr(0, eol);
+    inbuf.erase(0, eol + 1);
+    if (!line.empty() && line[line.size() - 1] == '\r') {
+      line.erase(line.size() - 1);
+    }
+    if (!line.empty()) {
+      Handle(line);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Send()
+////////////////////////////////////////////////////////////////////////////////
+void
+ControlServer::Send(const std::string &json) {
+  if (client_fd < 0) {
+    return;
+  }
+  const std::string msg = json + "\n";
+  size_t off = 0;
+  while (off < msg.size()) {
+    const ssize_t n = send(client_fd, msg.data() + off, msg.size() - off, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      Disconnect();
+      return;
+    }
+    off += n;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// AddBreakpoint() / DeleteBreakpoint()
+////////////////////////////////////////////////////////////////////////////////
+int
+ControlServer::AddBreakpoint(const Breakpoint &b) {
+  const int id = next_id++;
+  breakpoints[id] = b;
+  if (b.kind == "cycle") {
+    cycle_breaks.insert(b.value);
+  } else if (b.kind == "pc") {
+    pc_breaks.insert((uint32_t)b.value);
+    PipePacket::setBreakpoint((uint32_t)b.value, true);
+  } else {
+    UpdateWatch((uint32_t)b.value);
+  }
+  return id;
+}
+
+bool
+ControlServer::DeleteBreakpoint(int id) {
+  std::map<int, Breakpoint>::iterator it = breakpoints.find(id);
+  if (it == breakpoints.end()) {
+    return false;
+  }
+  const Breakpoint b = it->second;
+  breakpoints.erase(it);
+  if (b.kind == "cycle") {
+    cycle_breaks.erase(cycle_breaks.find(b.value));
+  } else if (b.kind == "pc") {
+    const uint32_t pc = (uint32_t)b.value;
+    pc_breaks.erase(pc_breaks.find(pc));
+    if (pc_breaks.count(pc) == 0) {
+      PipePacket::setBreakpoint(pc, false);
+    }
+  } else {
+    UpdateWatch((uint32_t)b.value);
+  }
+  return true;
+}
+
+void
+ControlServer::UpdateWatch(uint32_t word) {
+  unsigned int mask = 0;
+  for (std::map<int, Breakpoint>::const_iterator it = breakpoints.begin();
+       it != breakpoints.end(); ++it) {
+    if (it->second.kind == "addr" && it->second.value == word) {
+      mask |= it->second.access;
+    }
+  }
+  rigel::GLOBAL_BACKING_STORE_PTR->set_watch_callback(this);
+  rigel::GLOBAL_BACKING_STORE_PTR->set_watchpoint(word, mask);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Handle()
+////////////////////////////////////////////////////////////////////////////////
+// Run one request line and send its reply.
+////////////////////////////////////////////////////////////////////////////////
+void
+ControlServer::Handle(const std::string &line) {
+  rapidjson::Document doc;
+  doc.Parse<0>(line.c_str());
+  if (doc.HasParseError() || !doc.IsObject() ||
+      !doc.HasMember("cmd") || !doc["cmd"].IsString()) {
+    Send(helper_error("expected {\"cmd\":\"...\", ...}"));
+    return;
+  }
+  const std::string cmd = doc["cmd"].GetString();
+
+  rapidjson::StringBuffer sb;
+  JSONWriter w(sb);
+  w.StartObject();
+  w.String("ok"); w.Bool(true);
+
+  if (cmd == "status") {
+    w.String("cycle");       w.Uint64(rigel::CURR_CYCLE);
+    w.String("running");     w.Bool(running);
+    w.String("retired");     w.Uint64(rigel::RETIRED_INSTRS_TOTAL);
+    w.String("breakpoints"); w.Uint64(breakpoints.size());
+  } else if (cmd == "pause") {
+    if (running) {
+      w.EndObject();
+      Send(sb.GetString());
+      Stop("pause");
+      return;
+    }
+  } else if (cmd == "continue") {
+    running = true;
+  } else if (cmd == "step") {
+    uint64_t cycles = 1;
+    if (doc.HasMember("cycles") &&
+        (!helper_get_u64(doc["cycles"], cycles) || cycles == 0)) {
+      Send(helper_error("step: \"cycles\" must be a positive integer"));
+      return;
+    }
+    step_until = rigel::CURR_CYCLE + cycles;
+    running = true;
+    w.String("until"); w.Uint64(step_until);
+  } else if (cmd == "break") {
+    static const char *kinds[] = { "cycle", "pc", "addr" };
+    const char *kind = NULL;
+    uint64_t value = 0;
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+      if (doc.HasMember(kinds[k])) {
+        kind = kinds[k];
+        if (!helper_get_u64(doc[kinds[k]], value)) {
+          Send(helper_error(std::string("break: bad \"") + kind + "\" value"));
+          return;
+        }
+        break;
+      }
+    }
+    if (kind == NULL) {
+      Send(helper_error("break: need one of \"cycle\", \"pc\", \"addr\""));
+      return;
+    }
+    if (kind != kinds[0] && value > 0xFFFFFFFFULL) {
+      Send(helper_error(std::string("break: ") + kind + " is a 32-bit address"));
+      return;
+    }
+    Breakpoint b;
+    b.kind = kind;
+    b.value = value;
+    b.thread = -1;
+    b.access = 0;
+    b.hits = 0;
+    if (doc.HasMember("thread")) {
+      uint64_t t;
+      if (kind != kinds[1] || !helper_get_u64(doc["thread"], t) ||
+          t >= (uint64_t)rigel::THREADS_TOTAL) {
+        Send(helper_error("break: \"thread\" is a global thread id, pc only"));
+        return;
+      }
+      b.thread = (int)t;
+    }
+    if (kind == kinds[2]) {
+      const std::string access = !doc.HasMember("access") ? "rw"
+                               : doc["access"].IsString() ? doc["access"].GetString()
+                               : "";
+      if (access == "r" || access == "rw") {
+        b.access |= rigel::GlobalBackingStoreType::WATCH_READ;
+      }
+      if (access == "w" || access == "rw") {
+        b.access |= rigel::GlobalBackingStoreType::WATCH_WRITE;
+      }
+      if (b.access == 0) {
+        Send(helper_error("break: \"access\" must be \"r\", \"w\" or \"rw\""));
+        return;
+      }
+      if (rigel::GLOBAL_BACKING_STORE_PTR == NULL) {
+        Send(helper_error("break: no memory to watch yet"));
+        return;
+      }
+      b.value &= ~3ULL; // watchpoints cover whole words
+    } else if (doc.HasMember("access")) {
+      Send(helper_error("break: \"access\" is for addr breakpoints"));
+      return;
+    }
+    w.String("id"); w.Int(AddBreakpoint(b));
+  } else if (cmd == "delete") {
+    uint64_t id;
+    if (!doc.HasMember("id") || !helper_get_u64(doc["id"], id) ||
+        !DeleteBreakpoint((int)id)) {
+      Send(helper_error("delete: no such breakpoint"));
+      return;
+    }
+  } else if (cmd == "breakpoints") {
+    w.String("breakpoints");
+    w.StartArray();
+    for (std::map<int, Breakpoint>::const_iterator it = breakpoints.begin();
+         it != breakpoints.end(); ++it) {
+      w.StartObject();
+      w.String("id");   w.Int(it->first);
+      w.String("kind"); w.String(it->second.kind.c_str());
+      w.String(it->second.kind.c_str()); w.Uint64(it->second.value);
+      if (it->second.thread >= 0) {
+        w.String("thread"); w.Int(it->second.thread);
+      }
+      if (it->second.kind == "addr") {
+        const unsigned int a = it->second.access;
+        w.String("access");
+        w.String(a == rigel::GlobalBackingStoreType::WATCH_READ  ? "r" :
+                 a == rigel::GlobalBackingStoreType::WATCH_WRITE ? "w" : "rw");
+      }
+      w.String("hits"); w.Uint64(it->second.hits);
+      w.EndObject();
+    }
+    w.EndArray();
+  } else if (cmd == "hierarchy") {
+    const std::string out = helper_capture(&helper_print_roots, NULL);
+    w.String("output"); w.String(out.c_str(), out.size());
+  } else if (cmd == "dump") {
+    uint64_t id;
+    ComponentBase *c = NULL;
+    if (doc.HasMember("component") && helper_get_u64(doc["component"], id)) {
+      try {
+        c = ComponentBase::component((unsigned int)id);
+      } catch (std::out_of_range &) {
+        c = NULL;
+      }
+    }
+    if (c == NULL) {
+      Send(helper_error("dump: no such component (see \"hierarchy\")"));
+      return;
+    }
+    const std::string out = helper_capture(&helper_dump_one, c);
+    w.String("name");   w.String(c->name().c_str());
+    w.String("output"); w.String(out.c_str(), out.size());
+  } else if (cmd == "stats") {
+    std::string prefix;
+    if (doc.HasMember("prefix") && doc["prefix"].IsString()) {
+      prefix = doc["prefix"].GetString();
+    }
+    w.String("cycle");   w.Uint64(rigel::CURR_CYCLE);
+    w.String("retired"); w.Uint64(rigel::RETIRED_INSTRS_TOTAL);
+    w.String("stats");
+    w.StartObject();
+    for (int i = 0; i < STATNAME_PROFILE_STAT_COUNT; i++) {
+      ProfileStat &s = rigel::profiler::stats[i];
+      if (s.total() != 0 && s.name().compare(0, prefix.size(), prefix) == 0) {
+        w.String(s.name().c_str()); w.Uint64(s.total());
+      }
+    }
+    w.EndObject();
+  } else if (cmd == "exit") {
+    w.EndObject();
+    Send(sb.GetString());
+    throw ExitSim((char *)"Exit requested on control socket");
+  } else {
+    Send(helper_error("unknown command '" + cmd + "'"));
+    return;
+  }
+
+  w.EndObject();
+  Send(sb.GetString());
+}
@@ -24,6 +24,8 @@
 #include <cstdlib>                      // for exit, srand
 #include <cstring>                      // for strncpy
 #include <time.h>                       // for time
+#include <sys/resource.h>               // for getrusage
+#include <sys/time.h>                   // for gettimeofday
 #include <fstream>                      // for operator<<, basic_ostream, etc
 #include <iomanip>                      // for operator<<, setfill, setw, etc
 #include <iostream>                     // for cerr, cout, dec, hex
@@ -46,10 +48,18 @@
 #include "util/task_queue.h"     // for TaskSystemBaseline
 #include "tile.h"           // for Tile, etc
 #include "util/util.h"           // for CommandLineArgs, ExitSim
-#include "util/value_tracker.h"  // for ZeroTracker
+#include "util/value_tracker.h"  // for ZeroTracker, LineValueTracker
+#include "util/reg_trace.h"      // for RegTraceWriter
+#include "util/cosim_checker.h"  // for CosimChecker
+#include "shell/control_server.h" // for ControlServer
+#include "util/sweep.h"          // for RunSweep, SweepResult
+#include "util/startup_timer.h"  // for StartupPhase, startup::report
+#include "core/core_trace_player.h" // for TracePlayerSource
 #include "memory_timing.h"       // for MemoryTimingType definition
 #include <google/protobuf/stubs/common.h> // for GOOGLE_PROTOBUF_VERIFY_VERSION macro
 #include "rigelsim.h"
+#include "rapidjson/stringbuffer.h"  // for StringBuffer
+#include "rapidjson/writer.h"        // for Writer
 ////////////////////////////////////////////////////////////////////////////////
 
 InstrLegacy TempInstr(0xF000000F,           // PC
@@ -76,6 +86,11 @@ static void helper_setup_fileio(CommandLineArgs &cmdline);
 static void helper_init_rng();
 static void helper_init_profiler(TileBase **tiles);
 static void helper_close_files();
+static double helper_host_seconds();
+static void helper_write_run_summary(const std::string &file, double setup_seconds,
+                                     double sim_seconds, const SweepResult &result);
+static int run_simulation(CommandLineArgs &cmdline, int argc, char * argv[],
+                          SweepResult &result);
 
 void sigint_handler(int sig);
 void sigsegv_handler(int sig);
@@ -98,7 +113,6 @@ void timestamp_greeting() {
 // RETURNS: Never since proper simulation ends with an ExitSim() call.
 //
 ////////////////////////////////////////////////////////////////////////////////
-// FIXME: OMFG this is too long!
 int main(int argc, char * argv[])
 {
   // Verify that the version of the library that we linked against is
@@ -116,11 +130,38 @@ int main(int argc, char * argv[])
   // TODO: use getopts package instead... 
   CommandLineArgs cmdline(argc, argv);
 
+  // --sweep: fork one simulation per parameter point instead
+  if (!cmdline.get_val((char *)"SWEEP_FILE").empty()) {
+    return rigel::RunSweep(cmdline, argv[0], run_simulation);
+  }
+
+  SweepResult result;
+  return run_simulation(cmdline, argc, argv, result);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// run_simulation()
+////////////////////////////////////////////////////////////////////////////////
+//
+// Build the simulator from a parsed command line and run it to completion.
+// Called once from main(), or once per point in each child of a sweep.
+//
+// RETURNS: exit status for the process; fills in result.
+//
+////////////////////////////////////////////////////////////////////////////////
+// FIXME: OMFG this is too long!
+static int
+run_simulation(CommandLineArgs &cmdline, int argc, char * argv[], SweepResult &result)
+{
+  const double setup_start = helper_host_seconds();
+
   // Initialize parameters
   // FIXME: move this or reorg, horribly messy inside
-  helper_setup_other(cmdline, argv);
+  { StartupPhase t("setup"); helper_setup_other(cmdline, argv); }
 
+  rigel::startup::begin("RigelSim");
   RigelSim sim( &cmdline );      // instantiate main simulator
+  rigel::startup::end();
 
   // finished with sim setup, aux setup stuff follows
 
@@ -132,35 +173,53 @@ int main(int argc, char * argv[])
   }
 
   // Open the file that will get the CSV memory trace for the clusters
-  helper_setup_fileio(cmdline);
+  { StartupPhase t("file io"); helper_setup_fileio(cmdline); }
 
   helper_init_rng(); // init random number generator
   GLOBAL_ZERO_TRACKER_PTR = new ZeroTracker;
+  if (rigel::TRACK_LINE_VALUES) {
+    GLOBAL_LINE_TRACKER_PTR = new LineValueTracker;
+  }
 
   // initialize profiler objects
-  helper_init_profiler( sim.chip()->tiles() );
+  { StartupPhase t("profiler"); helper_init_profiler( sim.chip()->tiles() ); }
 
   // SIMULATOR Components that should be handled elsewhere
   // Initialize the hybrid directory. FIXME: conditional
-  hybrid_directory.init();
+  { StartupPhase t("hybrid directory"); hybrid_directory.init(); }
 
   // Needs to be initialized after we know how many cores we have (3096!)
   // FIXME: conditional
-  GlobalTaskQueue = new TaskSystemBaseline;
+  { StartupPhase t("task queue"); GlobalTaskQueue = new TaskSystemBaseline; }
   // end SIM Components which should be handled elsewhere
 
-  // print out our object tree before we start
-  sim.chip()->printHierarchy();
+  // every port is built by now; make sure no two share a name
+  { StartupPhase t("port check"); PortManager<Packet*>::CheckUnique(); }
 
-  PortManager<Packet*>::Dump();
+  // print out our object tree and port connections before we start
+  if (rigel::DUMP_HIERARCHY) {
+    StartupPhase t("dump hierarchy");
+    sim.chip()->printHierarchy();
+    PortManager<Packet*>::Dump();
+  }
+
+  if (rigel::STARTUP_REPORT) {
+    rigel::startup::report(stderr);
+  }
 
   ////////////////////////////////////////////////////////////////////////////// 
   // Start simulation proper
   ////////////////////////////////////////////////////////////////////////////// 
   bool caught_exitsim = false; // set to true when we catch
+  const double sim_start = helper_host_seconds();
+  double sim_end = sim_start;
   try {
     for (rigel::CURR_CYCLE = 0; ; rigel::CURR_CYCLE++) {
       using namespace rigel;
+      // Commands and breakpoints from the control socket
+      if (CONTROL) {
+        CONTROL->Tick();
+      }
       // TODO: interactive mode should be handled here
       if (RIGEL_CFG_NUM != 1) {
         sim.do_shell_loop();
@@ -181,6 +240,7 @@ int main(int argc, char * argv[])
 
     caught_exitsim = true; 
 
+    sim_end = helper_host_seconds();
     rigel::SIM_END_TIME = time(NULL);
 
     // finish up sim for tiles and contained objects
@@ -195,6 +255,10 @@ int main(int argc, char * argv[])
     delete [] InstrLegacy::LAST_INSTR_NUMBER;
 
 		std::cerr << "EXIT REASON, " << e.reason << "\n";
+
+    result.finished = true;
+    result.cycles = rigel::CURR_CYCLE;
+    result.exit_reason = e.reason;
   }
   //////////////////////////////////////////////////////////////////////////////
   // end catch ExitSim
@@ -205,6 +269,12 @@ int main(int argc, char * argv[])
 	  std::cerr << std::dec << rigel::CURR_CYCLE << " !!!" << std::endl;
   }
 
+  std::string summary_file = cmdline.get_val((char *)"RUN_SUMMARY_FILE");
+  if (!summary_file.empty()) {
+    helper_write_run_summary(summary_file, sim_start - setup_start,
+                             sim_end - sim_start, result);
+  }
+
   helper_close_files(); // close any open files
 
   return 0;
@@ -227,6 +297,75 @@ static void helper_close_files() {
   if (rigel::GENERATE_DIREVICTTRACE) {
     fclose(rigel::memory::direvicttrace_out);
   }
+  if (rigel::REG_TRACE) {
+    delete rigel::REG_TRACE; // flushes outstanding records
+    rigel::REG_TRACE = NULL;
+  }
+  if (rigel::CONTROL) {
+    delete rigel::CONTROL; // tells the client, removes the socket
+    rigel::CONTROL = NULL;
+  }
+  if (rigel::COSIM) {
+    delete rigel::COSIM; // checks outstanding records, prints the verdict
+    rigel::COSIM = NULL;
+  }
+  if (rigel::TRACE_PLAYER) {
+    delete rigel::TRACE_PLAYER;
+    rigel::TRACE_PLAYER = NULL;
+  }
+}
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// host wall-clock time in seconds
+////////////////////////////////////////////////////////////////////////////////
+static double helper_host_seconds() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// helper_write_run_summary()
+////////////////////////////////////////////////////////////////////////////////
+// Append one JSON line describing how fast this run simulated to file
+// (--run-summary).  setup_seconds covers everything before the first cycle,
+// sim_seconds the cycle loop.  exit_reason and cycles are null if the run did
+// not end with an ExitSim.
+////////////////////////////////////////////////////////////////////////////////
+static void helper_write_run_summary(const std::string &file, double setup_seconds,
+                                     double sim_seconds, const SweepResult &result) {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  const double sim_div = (sim_seconds > 0.0) ? sim_seconds : 1e-9;
+
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> w(sb);
+  w.StartObject();
+  w.String("binary");        w.String(rigel::BENCHMARK_BINARY_PATH.c_str());
+  w.String("config");        w.Int(RIGEL_CFG_NUM);
+  w.String("exit_reason");
+  if (result.finished) { w.String(result.exit_reason.c_str()); } else { w.Null(); }
+  w.String("cycles");
+  if (result.finished) { w.Uint64(result.cycles); } else { w.Null(); }
+  w.String("instructions");  w.Uint64(rigel::RETIRED_INSTRS_TOTAL);
+  w.String("setup_seconds"); w.Double(setup_seconds);
+  w.String("sim_seconds");   w.Double(sim_seconds);
+  w.String("peak_rss_kb");   w.Int64(ru.ru_maxrss);  // KiB on Linux
+  w.String("cycles_per_sec"); w.Double(rigel::CURR_CYCLE / sim_div);
+  w.String("mips");          w.Double(rigel::RETIRED_INSTRS_TOTAL / sim_div / 1e6);
+  w.EndObject();
+
+  FILE *f = fopen(file.c_str(), "a");
+  if (f == NULL) {
+    fprintf(stderr, "Warning: unable to open run summary '%s'\n", file.c_str());
+    return;
+  }
+  fprintf(f, "%s\n", sb.GetString());
+  fclose(f);
 }
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -406,6 +545,22 @@ helper_setup_other(CommandLineArgs &cmdline, char * argv[])
          << "  Try 'single' or 'perbank'.\n";
     assert(0);
   }
+  std::string dram_model = cmdline.get_val((char *)"DRAM_MODEL");
+  if(dram_model.compare("command") == 0)
+    rigel::DRAM::MODEL = rigel::DRAM::dram_model_command;
+  else if(dram_model.compare("analytic") == 0)
+    rigel::DRAM::MODEL = rigel::DRAM::dram_model_analytic;
+  else if(dram_model.compare("ideal") == 0)
+  {
+    rigel::DRAM::MODEL = rigel::DRAM::dram_model_ideal;
+    rigel::CMDLINE_ENABLE_IDEALIZED_DRAM = true;
+  }
+  else
+  {
+    std::cerr << "Error: " << dram_model << " is not a valid --dram-model value."
+         << "  Try 'command', 'analytic' or 'ideal'.\n";
+    assert(0);
+  }
 
   // ??
 	std::string rowcache_rep = cmdline.get_val((char *)"ROW_CACHE_REPLACEMENT_POLICY");
@@ -485,6 +640,54 @@ helper_setup_other(CommandLineArgs &cmdline, char * argv[])
   // Initialize any remaining runtime constants
   CYC_COUNT_MAX = cmdline.get_val_int((char *)"instr_count");
 
+  // One binary register trace for the whole run.  Must exist before the cores
+  // are constructed.
+  if (DUMP_REGISTER_TRACE) {
+    REG_TRACE = new RegTraceWriter(DUMPFILE_PATH + "/rf.trace.bin",
+                                   THREADS_TOTAL, THREADS_PER_CORE);
+  }
+
+  // Golden-model checker for the legacy core, fed from writeback.
+  if (COSIM_CHECK) {
+    if (RIGEL_CFG_NUM != 1) {
+      fprintf(stderr, "Error: --cosim checks the legacy core "
+                      "(RIGEL_CFG_NUM 1 in user.config)\n");
+      exit(1);
+    }
+    if (NONBLOCKING_MEM) {
+      fprintf(stderr, "Error: --cosim needs in-order commit, "
+                      "drop -nbl\n");
+      exit(1);
+    }
+    COSIM = new CosimChecker(THREADS_TOTAL, THREADS_PER_CORE);
+  }
+
+  // Remote control over a Unix socket, polled from the main loop.
+  std::string control_socket = cmdline.get_val((char *)"CONTROL_SOCKET");
+  if (!control_socket.empty()) {
+    int poll_interval = cmdline.get_val_int((char *)"CONTROL_POLL_INTERVAL");
+    if (poll_interval <= 0) {
+      fprintf(stderr, "Error: --control-poll must be > 0\n");
+      exit(1);
+    }
+    CONTROL = new ControlServer(control_socket, poll_interval, CONTROL_WAIT);
+  } else if (CONTROL_WAIT) {
+    fprintf(stderr, "Error: --control-wait needs --control-socket\n");
+    exit(1);
+  }
+
+  // Replay a memory trace instead of executing the binary.  Must exist before
+  // the cores are constructed, since the clusters pick the core type from it.
+  std::string trace_player_file = cmdline.get_val((char *)"TRACE_PLAYER_FILE");
+  if (!trace_player_file.empty()) {
+    if (RIGEL_CFG_NUM == 1) {
+      fprintf(stderr, "Error: --trace-player needs the functional or structural cluster "
+                      "(RIGEL_CFG_NUM 2 or 3 in user.config)\n");
+      exit(1);
+    }
+    TRACE_PLAYER = new TracePlayerSource(trace_player_file);
+  }
+
   InstrLegacy::LAST_INSTR_NUMBER = new uint64_t[THREADS_TOTAL];
   for (int i = 0; i < THREADS_TOTAL; i++) {
     InstrLegacy::LAST_INSTR_NUMBER[i] = 0;
@@ -0,0 +1,218 @@
+////////////////////////////////////////////////////////////////////////////////
+// build_slot.cpp
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Parallel construction of identical component subtrees; see
+//  sim/build_slot.h.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "sim/build_slot.h"
+#include "sim/component_base.h"
+#include "util/util.h"          // for ExitSim
+
+#include <pthread.h>
+#include <cassert>
+#include <cstdio>
+
+using namespace rigel;
+
+/// slot being built on this host thread, NULL outside build()
+static __thread BuildSlot *current_slot = NULL;
+
+namespace {
+
+  /// one host thread's share of a build: items first, first+stride, ...
+  struct WorkerArgs {
+    std::vector<BuildSlot *> *slots;
+    ComponentBase **out;
+    BuildSlot::make_fn_t make;
+    void *ctx;
+    int first;
+    int stride;
+  };
+
+}
+
+void
+BuildSlot::build(ComponentBase **out, int n, make_fn_t make, void *ctx,
+                 int threads) {
+  if (threads <= 1 || n <= 1) {
+    for (int i = 0; i < n; i++) {
+      out[i] = make(ctx, i);
+    }
+    return;
+  }
+  if (threads > n - 1) {
+    threads = n - 1;
+  }
+
+  // item 0, serially, recording what it draws
+  std::vector<BuildSlot *> slots(n);
+  BuildSlot *shape = new BuildSlot(0, NULL);
+  slots[0] = shape;
+  shape->first_component_ = ComponentBase::COMPONENT_ID_COUNT;
+  current_slot = shape;
+  try {
+    out[0] = make(ctx, 0);
+  } catch (...) {
+    current_slot = NULL;
+    delete shape;
+    throw;
+  }
+  current_slot = NULL;
+  shape->num_components_ =
+    ComponentBase::COMPONENT_ID_COUNT - shape->first_component_;
+
+  // every other item's components land at a known index
+  ComponentBase::components.resize(
+    shape->first_component_ + (size_t)n * shape->num_components_, NULL);
+  for (int i = 1; i < n; i++) {
+    slots[i] = new BuildSlot(i, shape);
+  }
+
+  std::vector<pthread_t> tids(threads);
+  std::vector<WorkerArgs> args(threads);
+  for (int t = 0; t < threads; t++) {
+    WorkerArgs w = { &slots, out, make, ctx, 1 + t, threads };
+    args[t] = w;
+    if (0 != pthread_create(&tids[t], NULL, workerMain, &args[t])) {
+      // build the rest of this thread's share here
+      workerMain(&args[t]);
+      tids[t] = pthread_self();
+    }
+  }
+  for (int t = 0; t < threads; t++) {
+    if (!pthread_equal(tids[t], pthread_self())) {
+      pthread_join(tids[t], NULL);
+    }
+  }
+
+  // replay side effects in item order and check every item matched item 0
+  std::string error;
+  for (int i = 1; i < n; i++) {
+    BuildSlot *slot = slots[i];
+    if (error.empty() && !slot->error_.empty()) {
+      error = slot->error_;
+    }
+    if (error.empty() && !slot->sameShape()) {
+      char buf[128];
+      snprintf(buf, sizeof(buf),
+               "parallel build: item %d differs in shape from item 0 "
+               "(use --startup-threads 1)", i);
+      error = buf;
+    }
+    if (error.empty()) {
+      for (size_t a = 0; a < slot->deferred_.size(); a++) {
+        slot->deferred_[a].f(slot->deferred_[a].a, slot->deferred_[a].b);
+      }
+    }
+  }
+
+  // counters continue as if the items had been built serially
+  ComponentBase::COMPONENT_ID_COUNT =
+    shape->first_component_ + n * shape->num_components_;
+  std::map<ComponentCount *, Range>::const_iterator it;
+  for (it = shape->counts_.begin(); it != shape->counts_.end(); ++it) {
+    it->first->ID_COUNT = it->second.first + n * it->second.draws;
+  }
+
+  for (int i = 0; i < n; i++) {
+    delete slots[i];
+  }
+  if (!error.empty()) {
+    throw ExitSim(error.c_str());
+  }
+}
+
+void *
+BuildSlot::workerMain(void *arg) {
+  WorkerArgs *w = static_cast<WorkerArgs *>(arg);
+  for (int i = w->first; i < (int)w->slots->size(); i += w->stride) {
+    BuildSlot *slot = (*w->slots)[i];
+    current_slot = slot;
+    try {
+      w->out[i] = w->make(w->ctx, i);
+    } catch (ExitSim &e) {
+      slot->error_ = e.reason;
+    } catch (...) {
+      slot->error_ = "parallel build: exception while building an item";
+    }
+    current_slot = NULL;
+  }
+  return NULL;
+}
+
+void
+BuildSlot::run(action_fn_t f, void *a, void *b) {
+  if (worker()) {
+    Action act = { f, a, b };
+    current_slot->deferred_.push_back(act);
+  } else {
+    f(a, b);
+  }
+}
+
+bool
+BuildSlot::building() {
+  return current_slot != NULL;
+}
+
+bool
+BuildSlot::worker() {
+  return current_slot != NULL && current_slot->index_ > 0;
+}
+
+int
+BuildSlot::draw(ComponentCount &count) {
+  BuildSlot *slot = current_slot;
+  assert(slot != NULL);
+  Range &mine = slot->counts_[&count];
+  if (slot->shape_ == NULL) {
+    // recording: item 0 draws from the real counter
+    if (mine.draws == 0) {
+      mine.first = count.ID_COUNT;
+    }
+    mine.draws++;
+    return count.ID_COUNT++;
+  }
+  std::map<ComponentCount *, Range>::const_iterator s =
+    slot->shape_->counts_.find(&count);
+  if (s == slot->shape_->counts_.end() || mine.draws >= s->second.draws) {
+    slot->mismatch_ = true;
+    return -1;
+  }
+  return s->second.first + slot->index_ * s->second.draws + mine.draws++;
+}
+
+void
+BuildSlot::place(ComponentBase *c) {
+  BuildSlot *slot = current_slot;
+  assert(slot != NULL && slot->shape_ != NULL);
+  const BuildSlot *shape = slot->shape_;
+  if (slot->num_components_ >= shape->num_components_) {
+    slot->mismatch_ = true;
+    c->component_id = (uint32_t)-1;
+    return;
+  }
+  c->component_id = shape->first_component_
+                  + slot->index_ * shape->num_components_
+                  + slot->num_components_++;
+  ComponentBase::components[c->component_id] = c;
+}
+
+bool
+BuildSlot::sameShape() const {
+  if (mismatch_ || num_components_ != shape_->num_components_
+      || counts_.size() != shape_->counts_.size()) {
+    return false;
+  }
+  std::map<ComponentCount *, Range>::const_iterator mine, s;
+  for (mine = counts_.begin(), s = shape_->counts_.begin();
+       mine != counts_.end(); ++mine, ++s) {
+    if (mine->first != s->first || mine->second.draws != s->second.draws) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -12,19 +12,23 @@ ComponentBase::ComponentBase(
   const char* cname,                    /// a string name for this object, with default
   ComponentCount& idf                   /// assigns user-definable per-class object ID for this component
 ) : 
-  component_id(ComponentBase::COMPONENT_ID_COUNT++),
+  component_id(rigel::BuildSlot::worker() ? 0 : ComponentBase::COMPONENT_ID_COUNT++),
   id_(idf()),
   name_(cname),
   parent_(parent_component),
   children_()
 { 
   // get a globally unique id for this component 
-  assert(component_id == components.size()); // make sure id==index at insertion
-  components.push_back(this);
+  if (rigel::BuildSlot::worker()) {
+    rigel::BuildSlot::place(this); // from this tile's range
+  } else {
+    assert(component_id == components.size()); // make sure id==index at insertion
+    components.push_back(this);
+  }
 
   // if this object has a parent, add this child to its list
   if (parent_ != NULL) {
-    parent_->addChild(this); 
+    rigel::BuildSlot::run(&ComponentBase::adopt, parent_, this);
   } else {
     printf("Warning: object %s %d has NULL parent \n", name_.c_str(), component_id);
   } 
@@ -59,6 +63,12 @@ ComponentBase::addChild( ComponentBase* c ) {
   children_.push_back(c);
 }
 
+/// addChild() with untyped arguments, for BuildSlot::run()
+void 
+ComponentBase::adopt( void* parent, void* child ) {
+  static_cast<ComponentBase*>(parent)->addChild(static_cast<ComponentBase*>(child));
+}
+
 /// call Dump() down entire hierarchy
 void
 ComponentBase::dumpHierarchy() {
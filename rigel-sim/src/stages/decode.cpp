@@ -18,6 +18,7 @@
 #include "core.h"           // for CoreInOrderLegacy, ::DC2EX, ::IF2DC
 #include "define.h"
 #include "instr.h"          // for InstrLegacy
+#include "instr/decode_table.h"  // for rigel::DECODE_TABLE
 #include "instrstats.h"     // for InstrStats
 #include "profile/profile.h"        // for InstrStat, Profile
 #include "core/regfile_legacy.h"        // for RegisterBase
@@ -76,18 +77,46 @@ DecodeStage::decode(InstrSlot instr, int pipe) {
     if (!instr->is_done_decode()) {
       // This was already counted as active in the cycle before it stalled
       //using namespace simconst;
-      // Big nested switch statement covers all instructions
-      // in autogenerated decoder_switch.h
-      if (!sim_decode(instr)) {
-				std::cerr << "Decoder Error: Thread " << instr->thread_id  
-               << " encountered a bad opcode " << std::hex 
-               << instr->get_raw_instr() << " @ PC 0x" << instr->get_currPC() 
-               << "\n";
+      // Words decoded before (by any core) replay the register numbers and
+      // type recorded in the shared decode table instead of walking the
+      // big nested switch statement in autogenerated decoder_switch.h
+      StaticDecodeInfo &sdi =
+        rigel::DECODE_TABLE.lookup(instr->get_currPC(), instr->get_raw_instr());
+      const bool fresh = (instr->get_type() == I_PRE_DECODE);
+      if (fresh && sdi.legacyValid()) {
+        const LegacyDecode &ld = sdi.legacy();
+        if (ld.has_acc) {
+          instr->set_regs(ld.acc_src, ld.sreg0, ld.sreg1, ld.dreg, ld.acc_dest);
+        } else {
+          instr->set_regs(ld.sreg0, ld.sreg1, ld.dreg);
+        }
+        instr->update_type(ld.type);
+        instr->set_sb_masks(ld.sb);
+      } else {
+        const uint32_t acc_src = instr->get_sacc().addr;
+        const uint32_t acc_dest = instr->get_dacc().addr;
+        if (!sim_decode(instr)) {
+          std::cerr << "Decoder Error: Thread " << instr->thread_id
+                    << " encountered a bad opcode " << std::hex
+                    << instr->get_raw_instr() << " @ PC 0x" << instr->get_currPC()
+                    << "\n";
           char str[128];
           sprintf(str, "Unknown opcode: 0x%08x", instr->get_raw_instr());
           //ExitSim(str, 1);
           //assert(0 && "Unreachable");
           return instr;
+        }
+        if (fresh) {
+          LegacyDecode ld;
+          ld.type     = instr->get_type();
+          ld.sreg0    = instr->get_sreg0().addr;
+          ld.sreg1    = instr->get_sreg1().addr;
+          ld.dreg     = instr->get_dreg().addr;
+          ld.acc_src  = instr->get_sacc().addr;
+          ld.acc_dest = instr->get_dacc().addr;
+          ld.has_acc  = (ld.acc_src != acc_src || ld.acc_dest != acc_dest);
+          sdi.setLegacy(ld);
+        }
       }
     }
     // Called from inside
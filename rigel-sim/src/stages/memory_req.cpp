@@ -234,6 +234,11 @@ MemoryStage::memaccess(InstrSlot instr, int pipe) {
 
       instr->TQ_Data.retval =
         GlobalTaskQueue->TQ_Dequeue(CORE_NUM, tdesc);
+      // Let the cluster put the core to sleep until the queue changes.
+      if (rigel::SLEEPY_CORES && instr->TQ_Data.retval == TQ_RET_BLOCK
+          && GlobalTaskQueue->TQ_CoreState[CORE_NUM].NextState == TQ_STATE_BLOCKING) {
+        core->set_blocked_on_task_queue();
+      }
       instr->TQ_Data.v1 = tdesc.v1;
       instr->TQ_Data.v2 = tdesc.v2;
       instr->TQ_Data.v3 = tdesc.v3;
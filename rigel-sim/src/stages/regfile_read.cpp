@@ -26,6 +26,91 @@
 #include "include/stage_base.h"  // for ExecuteStage
 #include "core/scoreboard.h"     // for ScoreBoard (in included scoreboard*.h)
 #include "util/util.h"           // for ExitSim (in included scoreboard*.h)
+#include "instr/decode_table.h"  // for DECODE_TABLE, LegacySBMasks
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// ScoreBoardRecorder
+////////////////////////////////////////////////////////////////////////////////
+// Stands in for a scoreboard while record_sb_masks() runs the generated
+// switches: every check passes and the registers it names are collected.
+////////////////////////////////////////////////////////////////////////////////
+struct ScoreBoardRecorder {
+  ScoreBoardRecorder() : src(0), dst(0) { }
+
+  bool check_reg(uint32_t reg, bool skip_reg_zero = true) {
+    src |= bit(reg);
+    return true;
+  }
+  bool check_reg(uint32_t reg0, uint32_t reg1) {
+    src |= bit(reg0) | bit(reg1);
+    return true;
+  }
+  bool isLocked(uint32_t reg, bool skip_reg_zero = true) {
+    dst |= bit(reg);
+    return false;
+  }
+
+  bool used() const { return (src | dst) != 0; }
+
+  static ScoreBoard::mask_t bit(uint32_t reg) {
+    assert(reg < ScoreBoard::MAX_REGS && "scoreboard register out of range");
+    return (ScoreBoard::mask_t)1 << reg;
+  }
+
+  ScoreBoard::mask_t src;
+  ScoreBoard::mask_t dst;
+};
+
+// what scoreboards[], sp_sbs[] and ac_sbs[] index in the switches
+struct RecorderArray {
+  explicit RecorderArray(ScoreBoardRecorder *r) : rec(r) { }
+  ScoreBoardRecorder *operator[](int tid) const { return rec; }
+  ScoreBoardRecorder *rec;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// record_sb_masks()
+////////////////////////////////////////////////////////////////////////////////
+// Run scoreboard_read.h and scoreboard_write.h on a copy of instr (so the
+// vector cases' register setup does not stick) and return the checks they
+// make.  Only instructions whose checks all go to the general-register
+// scoreboard, and that are not vector operations, become LEGACY_SB_MASKS.
+////////////////////////////////////////////////////////////////////////////////
+LegacySBMasks
+record_sb_masks(const InstrLegacy &orig) {
+  using namespace simconst;
+  InstrLegacy probe(orig);
+  InstrSlot instr = &probe;
+  ScoreBoardRecorder gp_rec, sp_rec, ac_rec;
+  RecorderArray scoreboards(&gp_rec), sp_sbs(&sp_rec), ac_sbs(&ac_rec);
+  LegacySBMasks m;
+
+  {
+    #include "autogen/scoreboard_read.h"
+  }
+  m.read_ports = instr->get_num_read_ports();
+  {
+    #include "autogen/scoreboard_write.h"
+  }
+
+  if (instr->get_is_vec_op() || sp_rec.used() || ac_rec.used()) {
+    m.state = LEGACY_SB_SWITCH;
+  } else {
+    m.state = LEGACY_SB_MASKS;
+    m.src = gp_rec.src;
+    m.dst = gp_rec.dst;
+  }
+  return m;
+
+ExecuteStalledReturn:
+  assert(0 && "record_sb_masks: a recorded check failed");
+  m.state = LEGACY_SB_SWITCH;
+  return m;
+}
+
+} // namespace
 
 InstrSlot CoreInOrderLegacy::regfile_read(InstrSlot instr, int pipe) {
   if (!instr->GetDoneRegRead()) {
@@ -37,10 +122,29 @@ InstrSlot CoreInOrderLegacy::regfile_read(InstrSlot instr, int pipe) {
     if (instr_type == I_ATOMCAS) {
       instr->set_sreg2(instr->get_dreg());
     }
-    // Vector operations have their proper registers set inside
-    // scoreboard_read.h and scoreboard_write.h for sources and destinations,
-    // respectively.
-    #include "autogen/scoreboard_read.h"
+    // The first time a word issues, record which registers the generated
+    // switches check; the decode table keeps that for the word and DecodeStage
+    // copies it into later instances.  Instructions with masks then test all
+    // of their sources, and below all of their destinations, with one mask
+    // each.
+    if (instr->get_sb_masks().state == LEGACY_SB_UNKNOWN) {
+      instr->set_sb_masks(record_sb_masks(*instr));
+      rigel::DECODE_TABLE.lookup(instr->get_currPC(), instr->get_raw_instr())
+        .setLegacySB(instr->get_sb_masks());
+    }
+    const LegacySBMasks &sb = instr->get_sb_masks();
+    if (sb.state == LEGACY_SB_MASKS) {
+      instr->set_num_read_ports(sb.read_ports);
+      if (sb.src != 0
+          && !scoreboards[instr->get_core_thread_id()]->check_mask(sb.src)) {
+        goto ExecuteStalledReturn;
+      }
+    } else {
+      // Vector operations have their proper registers set inside
+      // scoreboard_read.h and scoreboard_write.h for sources and destinations,
+      // respectively.
+      #include "autogen/scoreboard_read.h"
+    }
     // Check whether we have enough register ports free to issue (issues with
     // 3-operand instructions like FMAC)
     if(get_regfile(instr->get_core_thread_id())->get_num_free_read_ports() < instr->get_num_read_ports()) {
@@ -74,8 +178,13 @@ InstrSlot CoreInOrderLegacy::regfile_read(InstrSlot instr, int pipe) {
     // Check if destination register is locked.  If so, we cannot issue this
     // instruction this cycle.  We are being a bit conservative here.  The list
     // seen here is copied from writeback stage
-     
-    #include "autogen/scoreboard_write.h"
+    if (sb.state == LEGACY_SB_MASKS) {
+      if (scoreboards[instr->get_core_thread_id()]->any_locked(sb.dst)) {
+        goto ExecuteStalledReturn;
+      }
+    } else {
+      #include "autogen/scoreboard_write.h"
+    }
     // FIXME: insert scoreboard_write() instead of inline include...
 
     //if(get_core_num_global() == 0) printf("Pipe %d Made it past SB write\n", pipe);
@@ -29,6 +29,8 @@
 #include "core/scoreboard.h"     // for ScoreBoard
 #include "sim.h"            // for stats, etc
 #include "util/util.h"           // for ExitSim
+#include "util/cosim_checker.h"  // for CosimChecker
+#include "shell/control_server.h" // for ControlServer
 #include "stage_base.h"  // for WriteBackStage
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -44,9 +46,22 @@ WriteBackStage::Update()
   using namespace rigel;
 
   for (int j = 0; j < rigel::ISSUE_WIDTH; j++) {
+    // Report the retiring instruction to the co-simulation checker: sources
+    // are read before it commits, its destination after.
+    InstrSlot retiring = core->latches[CC2WB][j];
+    RegisterFileLegacy *cosim_rf = NULL;
+    if (rigel::COSIM && retiring != rigel::NullInstr && retiring->get_type() != I_NULL) {
+      cosim_rf = core->get_regfile(retiring->get_core_thread_id());
+      rigel::COSIM->Begin(retiring, cosim_rf);
+    }
+
     // Only place where instructions die
     core->latches[WB][j] = writeback(core->latches[CC2WB][j], j);
 
+    if (cosim_rf != NULL) {
+      rigel::COSIM->Commit(retiring, cosim_rf);
+    }
+
     if (core->latches[WB][j] != rigel::NullInstr ) { 
       assert(core->latches[WB][j] != NULL && "Trying to delete a NULL InstrSlot");
       // Sanity check that we are committing in order
@@ -75,6 +90,10 @@ WriteBackStage::Update()
       // Handle per-instruction  profiling.
       InstrSlot instr = core->latches[WB][j];
       UpdateWBStats(instr, temp_thread_id);
+      // PC breakpoints set on the control socket.
+      if (rigel::CONTROL && instr->get_type() != I_NULL) {
+        rigel::CONTROL->Retire(temp_thread_id, instr->get_currPC());
+      }
 
 
       #ifdef DUMP_WB_TRACE
@@ -135,6 +154,7 @@ void WriteBackStage::UpdateWBStats(InstrSlot instr, int temp_thread_id )
     profiler::stats[STATNAME_RETIRED_INSTRUCTIONS].inc();
     // Global instruction count used internally.
     ProfileStat::inc_retired_instrs(temp_thread_id);
+    rigel::RETIRED_INSTRS_TOTAL++;
 
     // Profile atomics.
     if (instr->stats.is_global_atomic()) {
@@ -155,8 +175,8 @@ void WriteBackStage::UpdateWBStats(InstrSlot instr, int temp_thread_id )
 
 
     //Per-instruction stall profiling
-    if (rigel::profiler::CMDLINE_DUMP_PER_PC_STATS)
-      Profile::per_pc_stat_add_stalls(instr->get_currPC(), instr->stats.cycles);
+    if (Profile::per_pc_exact())
+      core->get_cluster()->getProfiler()->per_pc_stat_add_stalls(instr->get_currPC(), instr->stats.cycles);
     else
     {
       Profile::accumulate_stall_cycles(instr->stats.cycles);
@@ -180,7 +200,7 @@ void WriteBackStage::UpdateWBStats(InstrSlot instr, int temp_thread_id )
     // Update the per-PC profiler statistics.
     uint32_t instr_latency = rigel::CURR_CYCLE - instr->get_fetch_cycle();
     // L1D/L2D hits tallyed in WB stage
-    Profile::per_pc_stat_add_latency(instr->get_currPC(), instr_latency);
+    core->get_cluster()->getProfiler()->per_pc_stat_add_latency(instr->get_currPC(), instr_latency);
   } 
 }
 
@@ -199,7 +219,7 @@ WriteBackStage::update_memaccess_stats(InstrSlot instr)
 
   bool l1i_hit = instr->stats.cache.l1i_hit();
   bool l2i_hit = !l1i_hit ? instr->stats.cache.l2i_hit() : false ;
-  Profile::per_pc_stat_add_icache(instr->get_currPC(), l1i_hit, l2i_hit);
+  core->get_cluster()->getProfiler()->per_pc_stat_add_icache(instr->get_currPC(), l1i_hit, l2i_hit);
   // Instead of using latency, which might include time blocking on a
   // previous memory operation, we are going to use the number of retries
   // at the memory system.
@@ -235,7 +255,7 @@ WriteBackStage::update_memaccess_stats(InstrSlot instr)
     bool l2d_hit = instr->stats.cache.l2d_hit();
     bool l3d_hit = instr->stats.cache.l3d_hit();
     // Update per-PC profiler.  
-    Profile::per_pc_stat_add_dcache(instr->get_currPC(), l1d_hit, l2d_hit, l3d_hit);
+    core->get_cluster()->getProfiler()->per_pc_stat_add_dcache(instr->get_currPC(), l1d_hit, l2d_hit, l3d_hit);
     // L2D updates only on L1D misses.
     if (!instr->stats.cache.l1d_hit()) {
       if (instr->stats.cache.l2d_hit()) {
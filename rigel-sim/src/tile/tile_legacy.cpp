@@ -54,8 +54,12 @@ TileLegacy::TileLegacy(rigel::ConstructionPayload cp) :
     //some combination of making Tiles be explicitly represented entities in
     //the protobuf with their own ID numbers, and/or putting ID numbers in the
     //Cluster-level protobuf state.
-    cp.cluster_state = cp.chip_state->add_clusters();
+    //A parallel tile build (see sim/build_slot.h) adds every cluster's
+    //state before the tiles are built.
     cp.component_index = (rigel::CLUSTERS_PER_TILE*id + i);
+    cp.cluster_state = (cp.component_index < cp.chip_state->clusters_size())
+                     ? cp.chip_state->mutable_clusters(cp.component_index)
+                     : cp.chip_state->add_clusters();
     clusters[i] = new ClusterLegacy(cp);
   }
 
@@ -107,7 +111,8 @@ TileLegacy::PerCycle()
     idx = (idx + 1) % rigel::CLUSTERS_PER_TILE;
   }
 
-  return halted();
+  // Each cluster reports whether it is halted; no need to walk them again.
+  return (halted_clusters == rigel::CLUSTERS_PER_TILE);
 }
 
 int
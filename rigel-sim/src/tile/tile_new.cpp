@@ -24,9 +24,9 @@ TileNew::TileNew(
 
   // contruct ports with outside world
   // TODO: relocate construction?
-  from_gnet = new InPortBase<Packet*>( PortName(name(), id(), "memside_in") );
+  from_gnet = new InPortBase<Packet*>( PortName(this, "memside_in") );
   from_gnet->owner(this);
-  to_gnet   = new OutPortBase<Packet*>( PortName(name(), id(), "memside_out") );
+  to_gnet   = new OutPortBase<Packet*>( PortName(this, "memside_out") );
   to_gnet->owner(this);
   //< end contruction of ports
 
@@ -35,9 +35,12 @@ TileNew::TileNew(
 
   clusters = new rigel::ClusterType *[numclusters];
   for (int i = 0; i < numclusters; ++i) {
-    // creates a new ClusterState for each new cluster
-    cp.cluster_state = cp.chip_state->add_clusters();
     cp.component_index = numclusters * id() + i; // remove this, cluster ID assigned via ComponentCounter
+    // creates a new ClusterState for each new cluster, unless a parallel
+    // tile build (see sim/build_slot.h) already added them all
+    cp.cluster_state = (cp.component_index < cp.chip_state->clusters_size())
+                     ? cp.chip_state->mutable_clusters(cp.component_index)
+                     : cp.chip_state->add_clusters();
     clusters[i] = new rigel::ClusterType(cp);
     // connect to tree network
     interconnect->get_inport(i)->attach( clusters[i]->get_outport() );
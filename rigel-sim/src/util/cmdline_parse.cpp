@@ -28,6 +28,7 @@
 #include "util/util.h"
 #include "profile/profile.h"
 #include "RandomLib/Random.hpp"  // for Random
+#include "util/json_config.h"  // for LoadJSONFile, FlagsToTokens
 
 static std::string tq_type_string("-tq_type [default|baseline|interval|int_lifo|recent|recent_v2|rand]");
 
@@ -53,6 +54,7 @@ FILE * rigel::RIGEL_PRINT_FILEP;
 namespace rigel {
   uint64_t CYC_COUNT_MAX;
   uint64_t CURR_CYCLE;
+  uint64_t RETIRED_INSTRS_TOTAL = 0;
   char MEM_DUMP_FILE[1024];
 	std::string DUMPFILE_PATH;
 	std::string RIGELSIM_BINARY_PATH;
@@ -87,6 +89,7 @@ namespace rigel {
   bool START_AWAKE_NOT_ASLEEP;
 	bool SINGLE_THREADED_MODE;
   bool TRACK_BIT_PATTERNS;
+  bool TRACK_LINE_VALUES;
   PipelineBypassPaths PIPELINE_BYPASS_PATHS;
   bool SIGINT_STATS;
   bool PRINT_GLOBAL_TIMING_STATS;
@@ -94,6 +97,12 @@ namespace rigel {
   bool DUMP_REGISTER_FILE;
   bool DUMP_REGISTER_TRACE;
   bool DUMP_ELF_IMAGE;
+  bool LOCKSTEP_FUNCTIONAL;
+  bool DUMP_HIERARCHY;
+  bool STARTUP_REPORT;
+  int STARTUP_THREADS;
+  bool COSIM_CHECK;
+  bool CONTROL_WAIT;
   bool LOAD_CHECKPOINT;
   size_t NUM_BTB_ENTRIES;
   bool CMDLINE_MODEL_CONTENTION;
@@ -151,6 +160,7 @@ namespace rigel {
     unsigned int DRAM_BATCHING_CAP;
     int PENDING_PER_BANK;
     bool MONOLITHIC_SCHEDULER;
+    bool LOCALITY_AWARE_SCHEDULING;
   };
   namespace cache {
     int GCACHE_ACCESS_LATENCY;
@@ -228,6 +238,95 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
 
   CommandLineArgs::exec_name = std::string(argv[0]);
 
+  std::vector<std::string> tokens;
+  //If first parameter is -argfile, we know to parse command-line args
+  //from the file whose name is given by the following argument,
+  //rather than from the rest of argv
+	std::string firstArg(argv[1]);
+  bool fromArgFile = (firstArg.compare("-argfile") == 0);
+
+  if(fromArgFile)
+  {
+    std::ifstream argfile(argv[2]);
+    if(!argfile.is_open()) //opening argv[2] failed
+    {
+      printf("Error opening argfile %s\n", argv[2]);
+      exit(1);
+    }
+    while(!argfile.eof())
+    {
+			std::string tmpstr;
+      argfile >> tmpstr;
+      if(tmpstr.length() > 0)
+      {
+        tokens.push_back(tmpstr);
+      }
+    }
+  }
+  else
+  {
+    for(int i = 1; i < argc; i++)
+    {
+      tokens.push_back(argv[i]);
+    }
+  }
+
+  parse(tokens);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CommandLineArgs Constructor
+////////////////////////////////////////////////////////////////////////////////
+// Parse an already-split command line (no program name, no -argfile).  The
+// sweep runner uses this to re-parse the base command line plus the flags of
+// one parameter point.
+////////////////////////////////////////////////////////////////////////////////
+CommandLineArgs::CommandLineArgs(const std::vector<std::string> &tokens) {
+  parse(tokens);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CommandLineArgs::expand_configs
+////////////////////////////////////////////////////////////////////////////////
+// Copy tokens to out, replacing each "--config <file.json>" with the flags in
+// that file (see util/json_config.h), in place.  Flags after a --config on the
+// command line therefore override the ones it sets.  Config files may name
+// further config files.
+////////////////////////////////////////////////////////////////////////////////
+void
+CommandLineArgs::expand_configs(const std::vector<std::string> &tokens,
+                                std::vector<std::string> &out, int depth) {
+  for (size_t i = 0; i < tokens.size(); i++) {
+    if (tokens[i].compare("--config") != 0) {
+      out.push_back(tokens[i]);
+      continue;
+    }
+    if (i + 1 == tokens.size()) {
+      throw CommandLineError("--config <file.json>");
+    }
+    const std::string &path = tokens[++i];
+    if (depth >= MAX_CONFIG_DEPTH) {
+      throw CommandLineError("--config " + path + ": config files nested too deeply");
+    }
+    rapidjson::Document doc;
+    std::vector<std::string> flags;
+    std::string err;
+    if (!rigel::config::LoadJSONFile(path, doc, err)
+        || !rigel::config::FlagsToTokens(doc, flags, err)) {
+      throw CommandLineError("--config " + path + ": " + err);
+    }
+    expand_configs(flags, out, depth + 1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CommandLineArgs::parse
+////////////////////////////////////////////////////////////////////////////////
+// Reset every parameter to its default, then apply tokens.
+////////////////////////////////////////////////////////////////////////////////
+void
+CommandLineArgs::parse(const std::vector<std::string> &tokens) {
+
   /* Initial key settings */
   this->cmdline_table["instr_count"] = "-1"; // Run forever
   this->cmdline_table["interactive"] = "0";    // Not interactive
@@ -243,6 +342,7 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
   rigel::SLEEPY_CORES = false; //Do not turn cores off on C$ misses by default
   rigel::START_AWAKE_NOT_ASLEEP = false; // all cores start in sleep mode by default (FIXME: we probably want this the opposite way...)
   rigel::TRACK_BIT_PATTERNS = false; //Don't track bit patterns by default, it's expensive.
+  rigel::TRACK_LINE_VALUES = false;
   rigel::PIPELINE_BYPASS_PATHS = rigel::pipeline_bypass_full;
   /******* BEGIN ACTUAL SIMULATION PARAMETERS ******/
   this->cmdline_table["NUM_CLUSTERS"] = "1";
@@ -251,13 +351,30 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
   this->cmdline_table["MEMCHANNELS"] = "-1";
   this->cmdline_table["PENDING_PER_BANK"] = "16";
   rigel::mem_sched::MONOLITHIC_SCHEDULER = false;
+  rigel::mem_sched::LOCALITY_AWARE_SCHEDULING = false;
   this->cmdline_table["DRAM_SCHEDULING_POLICY"] = rigel::DRAM::DRAM_SCHEDULING_POLICY_DEFAULT;
   this->cmdline_table["DRAM_BATCHING_POLICY"] = rigel::DRAM::DRAM_BATCHING_POLICY_DEFAULT;
   //TODO: Some of these defaults are in sim.h, some in dram.h.  Clean this up.
   this->cmdline_table["ROW_CACHE_REPLACEMENT_POLICY"] = rigel::mem_sched::ROW_CACHE_REPLACEMENT_POLICY_DEFAULT;
   this->cmdline_table["DRAM_OPEN_ROWS"] = rigel::DRAM::DRAM_OPEN_ROWS_DEFAULT;
+  this->cmdline_table["DRAM_MODEL"] = rigel::DRAM::DRAM_MODEL_DEFAULT;
   this->cmdline_table["DRAM_BATCHING_CAP"] = "0";
   this->cmdline_table["HEARTBEAT_INTERVAL"] = "100000";
+  // cohtest (standalone coherence stress driver) parameters.
+  this->cmdline_table["COHTEST_OPS"] = "1000000";
+  this->cmdline_table["COHTEST_LINES"] = "1024";
+  this->cmdline_table["COHTEST_MAX_LATENCY"] = "8";
+  // Directory for cached, ready-to-load ELF memory images ("" = disabled)
+  this->cmdline_table["ELF_CACHE_DIR"] = "";
+  // gzipped memory trace to replay with CoreTracePlayer ("" = run the binary)
+  this->cmdline_table["TRACE_PLAYER_FILE"] = "";
+  // JSON parameter sweep to run by forking after startup ("" = single run)
+  this->cmdline_table["SWEEP_FILE"] = "";
+  // Unix socket for remote control ("" = none) and cycles between polls
+  this->cmdline_table["CONTROL_SOCKET"] = "";
+  this->cmdline_table["CONTROL_POLL_INTERVAL"] = "100000";
+  // Append host speed and memory use to this file at exit ("" = don't)
+  this->cmdline_table["RUN_SUMMARY_FILE"] = "";
 
   // In Profile::global_dump_profile() perform the check
   this->cmdline_table["PRINT_GLOBAL_TIMING_STATS"] = "1";
@@ -282,6 +399,22 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
   this->cmdline_table["DUMP_ELF_IMAGE"] = "0";
   rigel::DUMP_ELF_IMAGE = false;
 
+  // Functional cores execute independently unless --lockstep
+  rigel::LOCKSTEP_FUNCTIONAL = false;
+
+  // Component tree, port connections and startup times are not printed
+  rigel::DUMP_HIERARCHY = false;
+  rigel::STARTUP_REPORT = false;
+
+  // Tiles are built one at a time
+  rigel::STARTUP_THREADS = 1;
+
+  // Retired instructions are not checked against the functional ISA
+  rigel::COSIM_CHECK = false;
+
+  // With a control socket, run until a client stops us
+  rigel::CONTROL_WAIT = false;
+
   // By default, do not profile memory operations at the global cache
   rigel::profiler::PROFILE_HIST_GCACHEOPS = false;
   rigel::profiler::gcacheops_histogram_bin_size = 10000;
@@ -299,6 +432,8 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
   rigel::STDIN_AS_STRING_SHORT_ENOUGH = true;
   // By default, do not print per-pc stats
   rigel::profiler::CMDLINE_DUMP_PER_PC_STATS = true;
+  // Exact per-PC stalls unless -per-pc-sample is given
+  rigel::profiler::PER_PC_SAMPLE_PERIOD = 0;
 
   // Default is no prefix for output file names
   rigel::profiler::DUMPFILE_PREFIX = std::string("");
@@ -428,45 +563,15 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
   }
   /******* END ACTUAL SIMULATION PARAMETERS ******/
 
-  std::vector<char *> argList;
-  //If first parameter is -argfile, we know to parse command-line args
-  //from the file whose name is given by the following argument,
-  //rather than from the rest of argv
-	std::string firstArg(argv[1]);
-  bool fromArgFile = (firstArg.compare("-argfile") == 0);
+  // Flags that accumulate must start out empty when re-parsing.
+  rigel::SIM_TAGS.clear();
+  rigel::TARGET_ARGS.clear();
 
-  if(fromArgFile)
-  {
-    std::ifstream argfile(argv[2]);
-    if(!argfile.is_open()) //opening argv[2] failed
-    {
-      printf("Error opening argfile %s\n", argv[2]);
-      exit(1);
-    }
-    while(!argfile.eof())
-    {
-      char *tmp = (char *)malloc(1000*sizeof(*tmp));
-      if(tmp == NULL)
-      {
-        printf("Error allocating temporary string for -argfile\n");
-        exit(1);
-      }
-			std::string tmpstr;
-      argfile >> tmpstr;
-      if(tmpstr.length() > 0)
-      {
-        strncpy(tmp, tmpstr.c_str(), 1000);
-        argList.push_back(tmp);
-        //printf("Arg: |%s|\n", tmp);
-      }
-    }
-  }
-  else
-  {
-    for(int i = 1; i < argc; i++)
-    {
-      argList.push_back(argv[i]);
-    }
+  arg_tokens.clear();
+  expand_configs(tokens, arg_tokens, 0);
+  std::vector<char *> argList;
+  for (size_t i = 0; i < arg_tokens.size(); i++) {
+    argList.push_back(const_cast<char *>(arg_tokens[i].c_str()));
   }
 
   //After initialization, we parse the commandline for arguments
@@ -519,6 +624,30 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
       rigel::cache::MAX_LIMITED_PTRS = atoi(argList[i++]);
       continue;
     }
+    if (0 == key.compare("--cohtest-ops")) {
+      /* Number of memory operations issued by cohtest */
+      if (i == argList.size()) {
+        throw CommandLineError("--cohtest-ops <N>");
+      }
+      this->cmdline_table["COHTEST_OPS"] = std::string(argList[i++]);
+      continue;
+    }
+    if (0 == key.compare("--cohtest-lines")) {
+      /* Number of shared lines cohtest spreads its operations over */
+      if (i == argList.size()) {
+        throw CommandLineError("--cohtest-lines <N>");
+      }
+      this->cmdline_table["COHTEST_LINES"] = std::string(argList[i++]);
+      continue;
+    }
+    if (0 == key.compare("--cohtest-latency")) {
+      /* Maximum network latency between a cluster and a G$ bank in cohtest */
+      if (i == argList.size()) {
+        throw CommandLineError("--cohtest-latency <N>");
+      }
+      this->cmdline_table["COHTEST_MAX_LATENCY"] = std::string(argList[i++]);
+      continue;
+    }
     if (0 == key.compare("--no-coherence")) {
       rigel::ENABLE_EXPERIMENTAL_DIRECTORY = false;
       continue;
@@ -591,6 +720,79 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
       rigel::DUMP_ELF_IMAGE = true;
       continue;
     }
+    if (0 == key.compare("--elf-cache")) {
+      /* Cache loaded ELF memory images here, keyed by a hash of the binary */
+      if (i == argList.size()) {
+        throw CommandLineError("--elf-cache <directory>");
+      }
+      this->cmdline_table["ELF_CACHE_DIR"] = std::string(argList[i++]);
+      continue;
+    }
+    if (0 == key.compare("--trace-player")) {
+      if (i == argList.size()) {
+        throw CommandLineError("--trace-player <trace.gz>");
+      }
+      this->cmdline_table["TRACE_PLAYER_FILE"] = std::string(argList[i++]);
+      continue;
+    }
+    if (0 == key.compare("--lockstep")) {
+      rigel::LOCKSTEP_FUNCTIONAL = true;
+      continue;
+    }
+    if (0 == key.compare("--dump-hierarchy")) {
+      rigel::DUMP_HIERARCHY = true;
+      continue;
+    }
+    if (0 == key.compare("--startup-report")) {
+      rigel::STARTUP_REPORT = true;
+      continue;
+    }
+    if (0 == key.compare("--startup-threads")) {
+      if (i == argList.size()) {
+        throw CommandLineError("--startup-threads <num host threads>");
+      }
+      rigel::STARTUP_THREADS = atoi(argList[i++]);
+      if (rigel::STARTUP_THREADS < 1) {
+        throw CommandLineError("--startup-threads <num host threads>");
+      }
+      continue;
+    }
+    if (0 == key.compare("--cosim")) {
+      rigel::COSIM_CHECK = true;
+      continue;
+    }
+    if (0 == key.compare("--control-socket")) {
+      if (i == argList.size()) {
+        throw CommandLineError("--control-socket <path>");
+      }
+      this->cmdline_table["CONTROL_SOCKET"] = std::string(argList[i++]);
+      continue;
+    }
+    if (0 == key.compare("--control-poll")) {
+      if (i == argList.size()) {
+        throw CommandLineError("--control-poll <cycles>");
+      }
+      this->cmdline_table["CONTROL_POLL_INTERVAL"] = std::string(argList[i++]);
+      continue;
+    }
+    if (0 == key.compare("--control-wait")) {
+      rigel::CONTROL_WAIT = true;
+      continue;
+    }
+    if (0 == key.compare("--sweep")) {
+      if (i == argList.size()) {
+        throw CommandLineError("--sweep <sweep.json>");
+      }
+      this->cmdline_table["SWEEP_FILE"] = std::string(argList[i++]);
+      continue;
+    }
+    if (0 == key.compare("--run-summary")) {
+      if (i == argList.size()) {
+        throw CommandLineError("--run-summary <file>");
+      }
+      this->cmdline_table["RUN_SUMMARY_FILE"] = std::string(argList[i++]);
+      continue;
+    }
     /*XXX Don't dump stats*/
     if (0 == key.compare("-no-stats-dump")) {
       this->cmdline_table["PRINT_GLOBAL_TIMING_STATS"] = "0";
@@ -602,6 +804,21 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
       rigel::profiler::CMDLINE_DUMP_PER_PC_STATS = true;
       continue;
     }
+    if (0 == key.compare("-no-per-pc-stats")) {
+      rigel::profiler::CMDLINE_DUMP_PER_PC_STATS = false;
+      continue;
+    }
+    if (0 == key.compare("-per-pc-sample")) {
+      if (i == argList.size()) {
+        throw CommandLineError("-per-pc-sample <cycles between samples>");
+      }
+      rigel::profiler::PER_PC_SAMPLE_PERIOD = strtoull(argList[i++], NULL, 0);
+      if (rigel::profiler::PER_PC_SAMPLE_PERIOD == 0) {
+        throw CommandLineError("-per-pc-sample: period must be at least 1 cycle");
+      }
+      rigel::profiler::CMDLINE_DUMP_PER_PC_STATS = true;
+      continue;
+    }
     //////// XXX: Turn off printing RigelPrints XXX ////////
     if (0 == key.compare("-no-rigelprint")) {
       rigel::CMDLINE_SUPPRESS_RIGELPRINT = true;
@@ -806,6 +1023,11 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
       rigel::mem_sched::MONOLITHIC_SCHEDULER = true;
       continue;
     }
+    if (0 == key.compare("-mem-sched-locality")) {
+      /* Open the row with the most recent demand when there is no row hit */
+      rigel::mem_sched::LOCALITY_AWARE_SCHEDULING = true;
+      continue;
+    }
     /*XXX*/
     if (0 == key.compare("--row-cache")) {
       /*Number of entries in per-DRAM-bank row cache (WCDRAM) */
@@ -1128,6 +1350,15 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
     //////// XXX: Enable idealized DRAM model XXX ////////
     if (0 == key.compare("--ideal-dram")) {
       rigel::CMDLINE_ENABLE_IDEALIZED_DRAM = true;
+      this->cmdline_table["DRAM_MODEL"] = std::string("ideal");
+      continue;
+    }
+    if (0 == key.compare("--dram-model")) {
+      /* Timing model behind the memory controllers */
+      if (i == argList.size()) {
+        throw CommandLineError("--dram-model <command|analytic|ideal>");
+      }
+      this->cmdline_table["DRAM_MODEL"] = std::string(argList[i++]);
       continue;
     }
     //////// XXX: Change default latency for ideal DRAM XXX /////////
@@ -1144,6 +1375,10 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
       rigel::TRACK_BIT_PATTERNS = true;
       continue;
     }
+    if (0 == key.compare("--track-line-values")) {
+      rigel::TRACK_LINE_VALUES = true;
+      continue;
+    }
     /*XXX*/
     if (0 == key.compare("--pipeline-bypass")) {
       if(i == argList.size())
@@ -1288,11 +1523,6 @@ CommandLineArgs::CommandLineArgs(int argc, char *argv[]) {
     throw CommandLineError(err);
   }
 
-  //Free dynamically-allocated strings, if they were read from a file.
-  if(fromArgFile)
-    for(std::vector<char *>::iterator it = argList.begin(); it != argList.end(); ++it)
-      free(*it);
-
 #ifndef _MSC_VER
   // Make dumpfile directory.
   if (mkdir(rigel::DUMPFILE_PATH.c_str(), S_IRWXU | S_IRGRP | S_IWGRP)) {
@@ -1325,6 +1555,18 @@ void CommandLineArgs::print_help() {
   std::cout << std::setw(40) << "  -argfile <ARGFILE>" << "\n" << "      "
     << "Read in arguments from ARGFILE instead of argv.  "
     << "-argfile must be passed as first argument." << "\n";
+  std::cout << std::setw(40) << "  --config <file.json>" << "\n" << "      "
+    << "Read flags from a JSON object, e.g. {\"-t\": 2, \"-regfile-dump\": true}, "
+    << "as if they appeared on the command line at this point; later flags override them.  "
+    << "Arrays give a flag several values, false/null omit it." << "\n";
+  std::cout << std::setw(40) << "  --sweep <sweep.json>" << "\n" << "      "
+    << "Load the binary once, then fork one simulation per parameter point in the sweep "
+    << "file (see include/util/sweep.h), each with its own dump directory, and collect "
+    << "one JSON result line per point." << "\n";
+  std::cout << std::setw(40) << "  --run-summary <file>" << "\n" << "      "
+    << "At exit, append one JSON line to <file> with the simulated cycles and retired "
+    << "instructions, host setup and simulation time, peak RSS, cycles/sec and MIPS "
+    << "(used by test/bench.sh)." << "\n";
   std::cout << std::setw(40) << "  -i" << "\n" <<  "      " << "Enable interactive mode." << "\n";
   std::cout << std::setw(40) << "  -m <filename>" << "\n" <<  "      "
     << "Dump memory after run to 'filename'." << "\n";
@@ -1359,6 +1601,9 @@ void CommandLineArgs::print_help() {
   std::cout << std::setw(40) << "  -mem-monolithic-scheduler" << "\n" << "      "
     << "Memory controller has one monolithic buffer of -mem-sched-pend-count requests"
     << "Default: off (per-DRAM-bank buffers)" << "\n";
+  std::cout << std::setw(40) << "  -mem-sched-locality" << "\n" << "      "
+    << "With no row hit pending in a bank, schedule the request whose row is most "
+    << "common among the bank's recent requests.  Default: off" << "\n";
   std::cout << std::setw(40) << "  --row-cache <N>" << "\n" << "      "
     << "Size of the per-DRAM-bank row cache (WCDRAM).  "
     << "Default: 1 (no row cache, traditional DRAM interface)" << "\n";
@@ -1372,9 +1617,45 @@ void CommandLineArgs::print_help() {
   std::cout << std::setw(40) << "  -regfile-dump" << "\n" <<  "      "
     << "Print the contents of each register file at exit" << "\n";
   std::cout << std::setw(40) << "  -regfile-trace-dump" << "\n" <<  "      "
-    << "Dump the contents of each register file write into a file named rf.<coreid>.<tid>.trace" << "\n";
+    << "Dump the contents of each register file write into a file named rf.<coreid>.<tid>.trace "
+    << "(functional core: one binary rf.trace.bin, split it with 'rftrace rf.trace.bin')" << "\n";
   std::cout << std::setw(40) << "  -dump-elf-image" << "\n" <<  "      "
     << "Dump dump the ELF image in <ADDR,DATA> pairs to a elfimage.hex" << "\n";
+  std::cout << std::setw(40) << "  --elf-cache <dir>" << "\n" <<  "      "
+    << "Save the loaded memory image of the binary in <dir> and reuse it on later runs "
+    << "of the same binary (keyed by a hash of the ELF file)" << "\n";
+  std::cout << std::setw(40) << "  --trace-player <trace.gz>" << "\n" <<  "      "
+    << "Replace every core with a trace player that replays the loads and stores of a "
+    << "gzipped memory trace (the dramtest format) into the cluster caches, handing the "
+    << "trace's software threads to hardware threads as they finish.  Functional and "
+    << "structural cluster models only" << "\n";
+  std::cout << std::setw(40) << "  --lockstep" << "\n" <<  "      "
+    << "Each cycle, run the register-only ALU, shift, compare and FPU instructions of "
+    << "functional cores that are at the same PC together, one operand array per group "
+    << "(see core/lockstep_engine.h).  Results and cycle counts are unchanged.  "
+    << "Functional and structural cluster models only" << "\n";
+  std::cout << std::setw(40) << "  --dump-hierarchy" << "\n" <<  "      "
+    << "Print the component tree and every port connection before cycle 0" << "\n";
+  std::cout << std::setw(40) << "  --startup-report" << "\n" <<  "      "
+    << "Print the host time spent in each phase of simulator construction to "
+    << "STDERR before cycle 0 (see util/startup_timer.h)" << "\n";
+  std::cout << std::setw(40) << "  --startup-threads <n>" << "\n" <<  "      "
+    << "Build the tiles on up to n host threads (default 1).  Component IDs, "
+    << "the component tree and cycle counts are the same as with 1 (see "
+    << "sim/build_slot.h).  Ignored with --trace-player" << "\n";
+  std::cout << std::setw(40) << "  --cosim" << "\n" <<  "      "
+    << "Replay every instruction the legacy core retires through the functional "
+    << "ISA on a separate host thread and stop with a report at the first "
+    << "divergence (see util/cosim_checker.h).  Legacy cluster model only, "
+    << "not with -nbl" << "\n";
+  std::cout << std::setw(40) << "  --control-socket <path>" << "\n" <<  "      "
+    << "Accept line-based JSON commands (pause, step, breakpoints, dump, stats) "
+    << "on a Unix domain socket at path (see shell/control_server.h)" << "\n";
+  std::cout << std::setw(40) << "  --control-poll <cycles>" << "\n" <<  "      "
+    << "Cycles between checks of the control socket while running. "
+    << "Default: 100000" << "\n";
+  std::cout << std::setw(40) << "  --control-wait" << "\n" <<  "      "
+    << "Stop before cycle 0 until a control socket client continues" << "\n";
   std::cout << std::setw(40) << "  -load-checkpoint" << "\n" <<  "      "
     << "Load a Checkpoint (ALPHA status)" << "\n";
   std::cout << std::setw(40) << "  -memprof <bin size in cycles>" << "\n" <<  "      "
@@ -1390,6 +1671,12 @@ void CommandLineArgs::print_help() {
     << "Enable dumping of per-pc data. Default: "
     << rigel::profiler::CMDLINE_DUMP_PER_PC_STATS
     << " File: " << rigel::profiler::per_pc_filename << "\n";
+  std::cout << std::setw(40) << "  -no-per-pc-stats" << "\n" <<  "      "
+    << "Disable per-pc profiling." << "\n";
+  std::cout << std::setw(40) << "  -per-pc-sample <N>" << "\n" <<  "      "
+    << "Profile per-pc by sampling each core's oldest instruction every N "
+    << "cycles instead of recording every retirement.  Much cheaper; only "
+    << rigel::profiler::per_pc_folded_filename << " is written." << "\n";
   std::cout << std::setw(40) << "  -dumpfile-prefix" << "\n" <<  "      "
     << "Prefix value to put on output files. Default: "
     << rigel::profiler::DUMPFILE_PREFIX << "\n";
@@ -1495,7 +1782,7 @@ void CommandLineArgs::print_help() {
     << "Dump all profile information when SIGINT (Ctrl+C) is caught."
     << "Default: off" << "\n";
   std::cout << std::setw(40) << "  --sleepy-cores " << "\n" <<  "      "
-    << "Turn cores off when they are stalling on a C$ MSHR "
+    << "Turn cores off when they are stalling on a C$ MSHR or blocked on an empty task queue "
     << "(will affect timing and yield inaccurate core-level statistics) "
     << "Default: off" << "\n";
   std::cout << std::setw(40) << "  --start-awake-not-asleep " << "\n" <<  "      "
@@ -1531,6 +1818,15 @@ void CommandLineArgs::print_help() {
   std::cout << std::setw(40) << "  --max-bcasts <N>" << "\n" <<  "      "
     << "Set the number of broadcasts to allow outstanding at a time.  0 is infinite."
     << "Default: (disabled)" << "\n";
+  std::cout << std::setw(40) << "  --cohtest-ops <N>" << "\n" <<  "      "
+    << "cohtest only: number of random memory operations to issue. "
+    << "Default: 1000000" << "\n";
+  std::cout << std::setw(40) << "  --cohtest-lines <N>" << "\n" <<  "      "
+    << "cohtest only: number of shared cache lines to stress. "
+    << "Default: 1024" << "\n";
+  std::cout << std::setw(40) << "  --cohtest-latency <N>" << "\n" <<  "      "
+    << "cohtest only: maximum cluster<->G$ message latency in cycles. "
+    << "Default: 8" << "\n";
 
   //std::cout << std::setw(40) << "  --enable-incoherent-malloc" << "\n" <<  "      "
   //  << "Enable malloc that is not tracked by coherence. "
@@ -1547,8 +1843,13 @@ void CommandLineArgs::print_help() {
   std::cout << std::setw(40) << "  --dram-batch-perchannel <N>" << "\n" << "      "
     << "Batch DRAM requests w/ max of N requests per channel. "
     << "Default: No batching" << "\n";
+  std::cout << std::setw(40) << "  --dram-model <command|analytic|ideal>" << "\n" << "      "
+    << "DRAM timing model.  command: cycle-level controller and channel model.  "
+    << "analytic: per-bank open-row and data bus state, latency computed once per request "
+    << "(no tFAW/tWTR, row cache or scheduling policies).  ideal: as --ideal-dram.  "
+    << "Default: command" << "\n";
   std::cout << std::setw(40) << "  --ideal-dram" << "\n" << "      "
-    << "Enable ideal DRAM (fixed BW/latency) "
+    << "Enable ideal DRAM (fixed BW/latency), same as --dram-model ideal "
     << "Default: Off (real model)" << "\n";
   std::cout << std::setw(40) << "  --ideal-dram-lat <N>" << "\n" << "      "
     << "All DRAM requests take N DRAMClk cycles. "
@@ -1557,6 +1858,11 @@ void CommandLineArgs::print_help() {
     << "Track the bit patterns of values written into RFs and caches to "
     << "evaluate e.g. dynamic zero compression "
     << "Default: Off" << "\n";
+  std::cout << std::setw(40) << "  --track-line-values" << "\n" << "      "
+    << "Measure how well the lines moved by G$ fills, DRAM reads and writes, and cluster "
+    << "cache writebacks compress under zero-line, base-delta-immediate and "
+    << "frequent-pattern compression, and report the potential DRAM bandwidth savings at exit.  "
+    << "Default: Off" << "\n";
     std::cout << std::setw(40) << "  --pipeline-bypass <full|none>" << "\n" << "      "
     << "Specify the set of bypass paths available in all core pipelines.  "
     << "Options are full bypassing ('full') and no bypassing ('none') "
@@ -0,0 +1,428 @@
+////////////////////////////////////////////////////////////////////////////////
+// cosim_checker.cpp
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Golden-model co-simulation checker for the legacy core.  See
+//  util/cosim_checker.h.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <inttypes.h>                   // for PRIu64
+#include <cstdio>                       // for fprintf, snprintf
+#include <cstdlib>                      // for exit
+#include <cstring>                      // for memset
+#include "core/regfile_legacy.h"        // for RegisterFileLegacy
+#include "instr.h"                      // for InstrLegacy
+#include "instr/pipe_packet.h"          // for PipePacket
+#include "isa/rigel_isa.h"              // for RigelISA
+#include "sim.h"                        // for CURR_CYCLE, NUM_REGS
+#include "util/util.h"                  // for ExitSim
+#include "util/cosim_checker.h"
+
+CosimChecker *rigel::COSIM = NULL;
+
+namespace {
+
+/// GPR read through operand slot op, simconst::NULL_REG if none
+uint32_t source_reg(const StaticDecodeInfo &sdi, int op) {
+  if (sdi.is(SD_SPRF_SRC)) {
+    return simconst::NULL_REG;
+  }
+  return (uint32_t)sdi.input_deps[op];
+}
+
+/// GPR written, simconst::NULL_REG if none
+uint32_t dest_reg(const StaticDecodeInfo &sdi) {
+  if (sdi.is(SD_STORE_LINK_REG)) {
+    return rigel::regs::LINK_REG;
+  }
+  if (sdi.is(SD_SPRF_DEST)) {
+    return simconst::NULL_REG;
+  }
+  return (uint32_t)sdi.output_deps[DREG];
+}
+
+/// unmodelled instructions that may write registers other than DREG
+bool clobbers_many(instr_t type) {
+  switch (type) {
+    case I_TQ_LOOP:
+    case I_TQ_INIT:
+    case I_TQ_END:
+    case I_TQ_ENQUEUE:
+    case I_TQ_DEQUEUE:
+    case I_VADD:
+    case I_VSUB:
+    case I_VFADD:
+    case I_VFSUB:
+    case I_VFMUL:
+    case I_VLDW:
+    case I_VADDI:
+    case I_VSUBI:
+    case I_SYSCALL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // end anonymous namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// CosimChecker()
+////////////////////////////////////////////////////////////////////////////////
+CosimChecker::CosimChecker(int threads_total, int threads_per_core) :
+  threads_per_core(threads_per_core),
+  buffers(threads_total),
+  shadows(threads_total),
+  checked(0),
+  adopted(0),
+  done(false),
+  diverged(false),
+  reported(false)
+{
+  for (size_t i = 0; i < buffers.size(); i++) {
+    buffers[i].recs  = new CosimRecord[BUFFER_RECORDS];
+    buffers[i].count = 0;
+  }
+  for (size_t i = 0; i < shadows.size(); i++) {
+    memset(&shadows[i], 0, sizeof(Shadow));
+    shadows[i].known = 1U; // r0
+  }
+
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&work_ready, NULL);
+  pthread_cond_init(&work_done, NULL);
+  if (0 != pthread_create(&checker, NULL, CheckerMain, this)) {
+    fprintf(stderr, "Error: unable to start co-simulation checker thread\n");
+    exit(1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ~CosimChecker()
+////////////////////////////////////////////////////////////////////////////////
+CosimChecker::~CosimChecker()
+{
+  // Hand over whatever is left, in gtid order.  Never waits or throws.
+  pthread_mutex_lock(&lock);
+  for (size_t i = 0; i < buffers.size(); i++) {
+    if (buffers[i].count != 0) {
+      pending.push_back(buffers[i]);
+      buffers[i].recs  = NULL;
+      buffers[i].count = 0;
+    }
+  }
+  done = true;
+  pthread_cond_signal(&work_ready);
+  pthread_mutex_unlock(&lock);
+  pthread_join(checker, NULL);
+
+  if (diverged) {
+    if (!reported) { fputs(report.c_str(), stderr); }
+  } else {
+    fprintf(stderr, "cosim: no divergence, %" PRIu64 " instructions checked, "
+      "%" PRIu64 " unmodelled\n", checked, adopted);
+  }
+
+  for (size_t i = 0; i < buffers.size(); i++) { delete [] buffers[i].recs; }
+  for (size_t i = 0; i < free_bufs.size(); i++) { delete [] free_bufs[i]; }
+  pthread_cond_destroy(&work_done);
+  pthread_cond_destroy(&work_ready);
+  pthread_mutex_destroy(&lock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Begin() / Commit()
+////////////////////////////////////////////////////////////////////////////////
+// the record is filled in place in the thread's buffer and only counted once
+// Commit() has the destination value.
+void
+CosimChecker::Begin(InstrLegacy *instr, RegisterFileLegacy *rf)
+{
+  const int gtid = instr->get_global_thread_id();
+  CosimRecord &r = buffers[gtid].recs[buffers[gtid].count];
+  r.cycle       = rigel::CURR_CYCLE;
+  r.gtid        = gtid;
+  r.pc          = instr->get_currPC();
+  r.raw         = instr->get_raw_instr();
+  r.ea          = 0;
+  r.store_value = 0;
+  r.dest_value  = 0;
+
+  const StaticDecodeInfo &sdi = decode.lookup(r.pc, r.raw);
+  for (int op = 0; op < NUM_ISA_OPERAND_REGS; op++) {
+    uint32_t reg = source_reg(sdi, op);
+    r.src[op] = (reg < rigel::NUM_REGS) ? rf->read(reg).data.u32 : 0;
+  }
+  r.dest_reg = dest_reg(sdi);
+}
+
+void
+CosimChecker::Commit(InstrLegacy *instr, RegisterFileLegacy *rf)
+{
+  ThreadBuffer &b = buffers[instr->get_global_thread_id()];
+  CosimRecord &r = b.recs[b.count];
+  r.ea          = instr->get_result_ea();
+  r.store_value = instr->get_result_reg().data.u32; // stores only
+  if (r.dest_reg < rigel::NUM_REGS) {
+    r.dest_value = rf->read(r.dest_reg).data.u32;
+  }
+  if (++b.count == BUFFER_RECORDS) { Submit(b); }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Submit()
+////////////////////////////////////////////////////////////////////////////////
+// queue a thread's buffer for checking and give the thread an empty one.  Only
+// waits if the checker has fallen MAX_PENDING buffers behind.  This is where
+// the simulator learns of a divergence.
+void
+CosimChecker::Submit(ThreadBuffer &b)
+{
+  pthread_mutex_lock(&lock);
+  while (pending.size() >= MAX_PENDING && !diverged) {
+    pthread_cond_wait(&work_done, &lock);
+  }
+  if (diverged) {
+    reported = true;
+    std::string what(report);
+    pthread_mutex_unlock(&lock);
+    b.count = 0;
+    fputs(what.c_str(), stderr);
+    throw ExitSim("co-simulation divergence");
+  }
+  pending.push_back(b);
+  pthread_cond_signal(&work_ready);
+
+  CosimRecord *fresh = NULL;
+  if (!free_bufs.empty()) {
+    fresh = free_bufs.back();
+    free_bufs.pop_back();
+  }
+  pthread_mutex_unlock(&lock);
+
+  b.recs  = (fresh != NULL) ? fresh : new CosimRecord[BUFFER_RECORDS];
+  b.count = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CheckerLoop()
+////////////////////////////////////////////////////////////////////////////////
+// checker thread body: replay pending buffers until told to stop.  Buffers
+// arriving after a divergence are dropped.
+void *
+CosimChecker::CheckerMain(void *arg)
+{
+  static_cast<CosimChecker *>(arg)->CheckerLoop();
+  return NULL;
+}
+
+void
+CosimChecker::CheckerLoop()
+{
+  pthread_mutex_lock(&lock);
+  while (true) {
+    while (pending.empty() && !done) {
+      pthread_cond_wait(&work_ready, &lock);
+    }
+    if (pending.empty()) { break; }
+
+    ThreadBuffer b = pending.front();
+    pending.pop_front();
+    const bool skip = diverged;
+    pthread_mutex_unlock(&lock);
+
+    for (size_t i = 0; !skip && i < b.count; i++) {
+      if (!Check(b.recs[i])) { break; }
+    }
+
+    pthread_mutex_lock(&lock);
+    free_bufs.push_back(b.recs);
+    pthread_cond_signal(&work_done);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Check()
+////////////////////////////////////////////////////////////////////////////////
+// replay r against its thread's shadow state.  Runs on the checker thread, so
+// it decodes through check_decode rather than PipePacket's shared table.
+bool
+CosimChecker::Check(const CosimRecord &r)
+{
+  Shadow &s = shadows[r.gtid];
+  const StaticDecodeInfo &sdi = check_decode.lookup(r.pc, r.raw);
+  char what[256];
+
+  if (s.started && s.pc_known && r.pc != s.next_pc) {
+    snprintf(what, sizeof(what), "retired PC 0x%08x, expected 0x%08x",
+      r.pc, s.next_pc);
+    Diverge(r, what);
+    return false;
+  }
+  s.started = true;
+
+  // Sources must hold what the shadow last saw written to them.  Registers
+  // the shadow has not seen yet are learned here.
+  PipePacket p(r.pc, r.raw, r.gtid, sdi);
+  for (int op = 0; op < NUM_ISA_OPERAND_REGS; op++) {
+    uint32_t reg = source_reg(sdi, op);
+    if (reg >= rigel::NUM_REGS) {
+      continue;
+    }
+    if (s.known & (1U << reg)) {
+      if (s.rf[reg] != r.src[op]) {
+        snprintf(what, sizeof(what), "source r%u is 0x%08x, expected 0x%08x "
+          "(last written at PC 0x%08x)", reg, r.src[op], s.rf[reg], s.writer[reg]);
+        Diverge(r, what);
+        return false;
+      }
+    } else {
+      s.rf[reg] = r.src[op];
+      s.known |= 1U << reg;
+    }
+    p.setRegVal((isa_reg_t)op, regval32_t(r.src[op]));
+  }
+
+  uint32_t next_pc = r.pc + 4;
+  bool pc_known = true;
+  bool modelled = true;
+  bool check_dest = true;
+
+  switch (sdi.type()) {
+    case I_ADD:   case I_SUB:   case I_MUL:
+    case I_ADDI:  case I_SUBI:  case I_ADDIU: case I_SUBIU:
+    case I_AND:   case I_OR:    case I_XOR:   case I_NOR:
+    case I_ANDI:  case I_ORI:   case I_XORI:
+    case I_ZEXTB: case I_ZEXTS: case I_SEXTB: case I_SEXTS:
+    case I_MVUI:  case I_CLZ:
+      RigelISA::execALU(&p);
+      break;
+
+    case I_SLL:  case I_SRL:  case I_SRA:
+    case I_SLLI: case I_SRLI: case I_SRAI:
+      RigelISA::execShift(&p);
+      break;
+
+    case I_CEQ: case I_CLT: case I_CLE: case I_CLTU: case I_CLEU:
+      RigelISA::execCompare(&p);
+      break;
+
+    case I_FADD: case I_FSUB: case I_FMUL: case I_FABS:
+    case I_I2F:  case I_F2I:
+    case I_CEQF: case I_CLTF: case I_CLTEF:
+      RigelISA::execFPU(&p);
+      break;
+
+    case I_BE:  case I_BN:  case I_BEQ: case I_BNE:
+    case I_BLT: case I_BGT: case I_BLE: case I_BGE:
+    case I_JAL: case I_JALR: case I_JMP: case I_JMPR:
+    case I_LJ:  case I_LJL:
+      RigelISA::execBranch(&p);
+      if (p.branch_predicate()) {
+        next_pc = p.target_addr();
+      }
+      check_dest = sdi.is(SD_STORE_LINK_REG);
+      break;
+
+    // the loaded value is taken from the stream
+    case I_LDW: case I_GLDW: case I_STW: case I_GSTW:
+      RigelISA::execAddressGen(&p);
+      if (p.target_addr() != r.ea) {
+        snprintf(what, sizeof(what), "address 0x%08x, expected 0x%08x",
+          r.ea, p.target_addr());
+        Diverge(r, what);
+        return false;
+      }
+      if (sdi.is(SD_STORE) && r.store_value != r.src[DREG]) {
+        snprintf(what, sizeof(what), "stored 0x%08x, expected 0x%08x (r%u)",
+          r.store_value, r.src[DREG], source_reg(sdi, DREG));
+        Diverge(r, what);
+        return false;
+      }
+      check_dest = false;
+      break;
+
+    default:
+      modelled = false;
+      check_dest = false;
+      if (clobbers_many(sdi.type())) {
+        s.known = 1U;
+      }
+      if (sdi.type() == I_RFE) {
+        pc_known = false;
+      }
+      break;
+  }
+
+  // writes to r0 are dropped by the register file
+  if (check_dest && r.dest_reg != 0 && r.dest_reg < rigel::NUM_REGS &&
+      p.regval(DREG).u32() != r.dest_value) {
+    snprintf(what, sizeof(what), "wrote r%u = 0x%08x, expected 0x%08x",
+      r.dest_reg, r.dest_value, p.regval(DREG).u32());
+    Diverge(r, what);
+    return false;
+  }
+
+  if (r.dest_reg != 0 && r.dest_reg < rigel::NUM_REGS) {
+    s.rf[r.dest_reg] = r.dest_value;
+    s.known |= 1U << r.dest_reg;
+    s.writer[r.dest_reg] = r.pc;
+  }
+  s.next_pc  = next_pc;
+  s.pc_known = pc_known;
+  s.history[s.retired % HISTORY] = r;
+  s.retired++;
+  if (modelled) { checked++; } else { adopted++; }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Diverge()
+////////////////////////////////////////////////////////////////////////////////
+// format the report for the first divergence and flag it for Submit()
+void
+CosimChecker::Diverge(const CosimRecord &r, const std::string &what)
+{
+  const Shadow &s = shadows[r.gtid];
+  const StaticDecodeInfo &sdi = check_decode.lookup(r.pc, r.raw);
+  std::string out;
+  char line[256];
+
+  snprintf(line, sizeof(line), "cosim: DIVERGENCE at cycle %" PRIu64 ", core %u "
+    "thread %u (gtid %u), instruction %" PRIu64 " of the thread\n", r.cycle,
+    r.gtid / threads_per_core, r.gtid % threads_per_core, r.gtid, s.retired);
+  out += line;
+  snprintf(line, sizeof(line), "  PC 0x%08x  raw 0x%08x  %s\n", r.pc, r.raw,
+    instr::instr_string[sdi.type()]);
+  out += line;
+  out += "  " + what + "\n";
+  for (int op = 0; op < NUM_ISA_OPERAND_REGS; op++) {
+    uint32_t reg = source_reg(sdi, op);
+    if (reg < rigel::NUM_REGS) {
+      snprintf(line, sizeof(line), "  source r%-2u = 0x%08x\n", reg, r.src[op]);
+      out += line;
+    }
+  }
+  if (r.dest_reg < rigel::NUM_REGS) {
+    snprintf(line, sizeof(line), "  dest   r%-2u = 0x%08x\n", r.dest_reg,
+      r.dest_value);
+    out += line;
+  }
+  out += "  previously retired by this thread:\n";
+  uint64_t first = (s.retired > HISTORY) ? s.retired - HISTORY : 0;
+  for (uint64_t i = first; i < s.retired; i++) {
+    const CosimRecord &h = s.history[i % HISTORY];
+    snprintf(line, sizeof(line), "    cycle %12" PRIu64 "  PC 0x%08x  raw 0x%08x  %s\n",
+      h.cycle, h.pc, h.raw,
+      instr::instr_string[check_decode.lookup(h.pc, h.raw).type()]);
+    out += line;
+  }
+
+  pthread_mutex_lock(&lock);
+  diverged = true;
+  report = out;
+  pthread_cond_signal(&work_done);
+  pthread_mutex_unlock(&lock);
+}
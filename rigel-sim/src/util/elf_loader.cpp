@@ -12,7 +12,8 @@
 //in the backng store, etc.
 
 #include <elf.h>                        // for Elf32_Shdr, Elf32_Ehdr, etc
-#include <fcntl.h>                      // for SEEK_SET
+#include <errno.h>                      // for errno, EEXIST
+#include <fcntl.h>                      // for open, O_RDONLY
 #include <libelf.h>              // for Elf_Data, elf32_getehdr, etc
 #include <gelf.h>
 #include <stdint.h>                     // for uint32_t
@@ -20,7 +21,9 @@
 #include <stdio.h>                      // for fprintf, stderr, fclose, etc
 #include <stdlib.h>                     // for NULL, exit, free
 #include <string.h>                     // for strcmp, strlen, strncmp
-#include <algorithm>                    // for max
+#include <sys/stat.h>                   // for mkdir
+#include <unistd.h>                     // for pread, getpid, close
+#include <algorithm>                    // for max, stable_sort
 #include <string>                       // for string
 #include <vector>
 #include "sim.h"            // for DUMP_ELF_IMAGE, etc
@@ -34,43 +37,111 @@ uint32_t rigel::CODEPAGE_LIBPAR_END = 0x0;
 uint32_t rigel::LOCKS_REGION_BEGIN = 0x0;
 uint32_t rigel::LOCKS_REGION_END = 0x0;
 
-////////////////////////////////////////////////////////////////////////////////
-// LoadELF
-// 
-// Put binary into memory at the proper location as stipulated by the ELF file.
-// Uses the GNU libelf to do the dirty work
-// 
-// PARAMETERS:
-// bin_name:	Name of file to open and load
-// 
-////////////////////////////////////////////////////////////////////////////////
-void ELFAccess::LoadELF(std::string bin_name, rigel::GlobalBackingStoreType *mem) {
-  Elf *elf;
-  FILE *fp;
-  Elf_Scn *scn;
-  Elf32_Ehdr *ehdr;
-  Elf32_Shdr *shdr;
-	GElf_Phdr phdr;
-  size_t num_static_instructions = 0;
-  // Ignore LoadELF on dumps
+namespace {
 
-  if ((fp = fopen(bin_name.c_str(), "rb")) == NULL) {
-    throw ExitSim("ELFAccess::LoadELF(): fopen() Failed", 1);
+// Everything LoadELF() derives from the ELF file, recorded so that it can be
+// saved to and replayed from the image cache without libelf or a walk of the
+// section and symbol tables.
+enum ELFRegionKind {
+  ELF_REGION_READABLE,
+  ELF_REGION_WRITABLE,
+  ELF_REGION_EXECUTABLE
+};
+
+struct ELFRegion {
+  uint32_t kind;
+  uint32_t low;
+  uint32_t high;
+};
+
+struct ELFSegment {
+  uint32_t addr;
+  uint32_t filesz;
+  uint32_t memsz;
+  uint32_t pad;
+  uint64_t offset;    // file offset of the initialized data
+};
+
+struct ELFImage {
+  uint32_t entry;
+  uint64_t num_static_instructions;
+  std::vector<ELFSegment> segments;
+  std::vector<ELFRegion> regions;
+};
+
+// Image cache file: header, segment table, region table, then segment data.
+// Cache files are named <cache dir>/<ELF hash>.elfimg.
+const char     ELF_CACHE_MAGIC[8] = { 'R','G','L','E','L','F','I','M' };
+const uint32_t ELF_CACHE_VERSION  = 1;
+
+struct ELFCacheHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t entry;
+  uint64_t elf_hash;
+  uint64_t elf_size;
+  uint64_t num_static_instructions;
+  uint32_t num_segments;
+  uint32_t num_regions;
+};
+
+// 64-bit FNV-1a over the whole file.
+uint64_t hash_file(int fd, uint64_t &size) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  std::vector<unsigned char> buf(1 << 16);
+  size = 0;
+  ssize_t n;
+  while ((n = pread(fd, &buf[0], buf.size(), size)) > 0) {
+    for (ssize_t i = 0; i < n; i++) {
+      h = (h ^ buf[i]) * 0x100000001b3ULL;
+    }
+    size += n;
   }
+  return h;
+}
 
-  elf_version(EV_CURRENT);
-  if ((elf = elf_begin(fileno(fp), ELF_C_READ, NULL)) == NULL) {
-    std::string s("ELFAccess::LoadELF(): elf_begin() Failed -- ");
-    s += elf_errmsg(-1);
-    throw ExitSim(s.c_str(), 1);
+void apply_region(rigel::GlobalBackingStoreType *mem, const ELFRegion &r) {
+  switch (r.kind) {
+    case ELF_REGION_READABLE:   mem->set_readable_region(r.low, r.high);   break;
+    case ELF_REGION_WRITABLE:   mem->set_writable_region(r.low, r.high);   break;
+    case ELF_REGION_EXECUTABLE: mem->set_executable_region(r.low, r.high); break;
   }
+}
 
-  FILE *dump_elf_img = NULL;
-  if( rigel::DUMP_ELF_IMAGE ) {
-    if ((dump_elf_img = fopen("elfimage.hex", "w")) == NULL) {
-      throw ExitSim("elfimage.hex: fopen() Failed", 1);
-    }
+void add_region(ELFImage &img, uint32_t kind, uint32_t low, uint32_t high) {
+  ELFRegion r = { kind, low, high };
+  img.regions.push_back(r);
+}
+
+// Zero the rest of a segment after its initialized bytes (through the end of
+// the last word, as the word-at-a-time loader did).  The BSS tail does not
+// allocate any backing store.
+void zero_bss(rigel::GlobalBackingStoreType *mem, const ELFSegment &seg) {
+  const uint32_t mem_bytes = ((seg.memsz + 3) / 4) * 4;
+  if (mem_bytes > seg.filesz) {
+    mem->zero_bytes(seg.addr + seg.filesz, mem_bytes - seg.filesz);
   }
+}
+
+// Copy a segment's initialized bytes from fd into memory in bulk and zero the
+// rest of it.
+void install_segment(rigel::GlobalBackingStoreType *mem, int fd,
+                     const ELFSegment &seg) {
+  int64_t bytes_read = mem->read_from_fd(fd, seg.addr, seg.filesz, seg.offset);
+  if (bytes_read != (int64_t)seg.filesz) {
+    fprintf(stderr, "Error: load_elf() read %" PRId64 " of %u bytes\n", bytes_read, seg.filesz);
+    exit(1);
+  }
+  zero_bss(mem, seg);
+}
+
+// Record the segments, permission regions and entry point of an ELF file in
+// img without touching target memory.
+void scan_elf(Elf *elf, ELFImage &img) {
+  Elf_Scn *scn;
+  Elf32_Ehdr *ehdr;
+  Elf32_Shdr *shdr;
+	GElf_Phdr phdr;
   int i = 0;
 
 	while(1) {
@@ -78,47 +149,19 @@ void ELFAccess::LoadELF(std::string bin_name, rigel::GlobalBackingStoreType *mem
 			break;
 	  //printf("p_type %08x p_offset %08"PRIx64" p_vaddr %08"PRIx64" p_paddr %08"PRIx64" p_filesz %08"PRIx64" p_memsz %08"PRIx64" p_flags %08x p_align %08"PRIx64"\n", phdr.p_type, phdr.p_offset, phdr.p_vaddr, phdr.p_paddr, phdr.p_filesz, phdr.p_memsz, phdr.p_flags, phdr.p_align);
 
-	  uint32_t *buf = new uint32_t[(phdr.p_filesz+sizeof(uint32_t)-1)/sizeof(uint32_t)];
-    fseek(fp, phdr.p_offset, SEEK_SET);
-    unsigned int bytes_read = fread((void *)buf, 1, phdr.p_filesz, fp);
-    if (bytes_read != phdr.p_filesz)
-    {
-      fprintf(stderr, "Error: load_elf() read %u of %"PRIu64" bytes\n", bytes_read, phdr.p_filesz);
-      exit(1);
-    }
-    // Fix endianness... FIXME should probably check ELF header for this first
-    for ( uint32_t j = 0; j < (phdr.p_memsz+3)/4; j++) 
-    {
-      uint32_t write_addr = phdr.p_paddr + 4*j;
-      // Write the data to memory.
-      uint32_t wdata;
-      if(j >= ((phdr.p_filesz+3)/4))
-        wdata = 0;
-      else
-        wdata = buf[j];
-      mem->write_word( write_addr, wdata );
-      if ( rigel::DUMP_ELF_IMAGE ) {
-        fprintf( dump_elf_img, "%08x %08x\n", write_addr, wdata );
-      }
-
-    }
-  
-    delete [] buf;
-    buf = NULL;
-
+    ELFSegment seg;
+    seg.addr   = phdr.p_paddr;
+    seg.filesz = phdr.p_filesz;
+    seg.memsz  = phdr.p_memsz;
+    seg.pad    = 0;
+    seg.offset = phdr.p_offset;
+    img.segments.push_back(seg);
 
     i++;
 	}
 
   ehdr = elf32_getehdr(elf);
-  printf("Start address is 0x%08x\n", ehdr->e_entry);
-
-  //FIXME Support multiprogramming by only applying this entry point to certain threads.
-	//rigel::ENTRY_POINTS.resize(rigel::THREADS_TOTAL);	
-	for(int i = 0; i < rigel::THREADS_TOTAL; i++) {
-    //rigel::ENTRY_POINTS[i] = ehdr->e_entry;
-		rigel::ENTRY_POINTS.push_back(ehdr->e_entry);
-	}
+  img.entry = ehdr->e_entry;
 
 	scn = NULL;
   while((scn = elf_nextscn(elf, scn)) != NULL) {
@@ -132,17 +175,17 @@ void ELFAccess::LoadELF(std::string bin_name, rigel::GlobalBackingStoreType *mem
       //the structural core speculatively fetches instructions before resolving a
       //branch.  Let's say 3 stages * issue width
       //FIXME MEM_WORD_SIZE is a bad name in the wrong place, colocate it with the rigel_word_t typedef
-      mem->set_executable_region(shdr->sh_addr,
-                                 shdr->sh_addr + shdr->sh_size + (3*rigel::ISSUE_WIDTH*rigel::MEM_WORD_SIZE) - 1);
+      add_region(img, ELF_REGION_EXECUTABLE, shdr->sh_addr,
+                 shdr->sh_addr + shdr->sh_size + (3*rigel::ISSUE_WIDTH*rigel::MEM_WORD_SIZE) - 1);
 
-			num_static_instructions += (shdr->sh_size / rigel::MEM_WORD_SIZE);
+			img.num_static_instructions += (shdr->sh_size / rigel::MEM_WORD_SIZE);
     }
     else if(shdr->sh_flags & SHF_WRITE) {
-      mem->set_writable_region(shdr->sh_addr, shdr->sh_addr + shdr->sh_size - 1);
-      mem->set_readable_region(shdr->sh_addr, shdr->sh_addr + shdr->sh_size - 1);
+      add_region(img, ELF_REGION_WRITABLE, shdr->sh_addr, shdr->sh_addr + shdr->sh_size - 1);
+      add_region(img, ELF_REGION_READABLE, shdr->sh_addr, shdr->sh_addr + shdr->sh_size - 1);
     }
     else if(shdr->sh_flags & SHF_ALLOC) {
-      mem->set_readable_region(shdr->sh_addr, shdr->sh_addr + shdr->sh_size - 1);
+      add_region(img, ELF_REGION_READABLE, shdr->sh_addr, shdr->sh_addr + shdr->sh_size - 1);
     }
     //If none of the above conditions is satisfied, this section does not allocate space in memory (e.g., symbol/string table)
 
@@ -166,20 +209,259 @@ void ELFAccess::LoadELF(std::string bin_name, rigel::GlobalBackingStoreType *mem
           if(symbol_name != NULL && strcmp(symbol_name, "_end") == 0) {
             //We found the _end symbol
             printf("_end is at 0x%08x, setting the rest of memory to RW- permissions\n", s->st_value);
-            mem->set_readable_region(s->st_value, 0xFFFFFFFFU); //FIXME Should use a constant tied to Rigel's address type
-            mem->set_writable_region(s->st_value, 0xFFFFFFFFU);  
+            add_region(img, ELF_REGION_READABLE, s->st_value, 0xFFFFFFFFU); //FIXME Should use a constant tied to Rigel's address type
+            add_region(img, ELF_REGION_WRITABLE, s->st_value, 0xFFFFFFFFU);  
           }
           s++; //go to next symbol
         }
       }
     }
 	}
-  
-	//Heuristic to reserve the appropriate amount of space in the hash map of static instructions
-	PipePacket::rehashInstrTable(num_static_instructions);
 
     //fprintf(stderr, "sh_type %08X sh_flags %08X sh_addr %08X sh_offset %08X sh_size %08X sh_link %08X sh_info %08X sh_addralign %08X sh_entsize %08X\n", shdr->sh_type, shdr->sh_flags, shdr->sh_addr, shdr->sh_offset, shdr->sh_size, shdr->sh_link, shdr->sh_info, shdr->sh_addralign, shdr->sh_entsize);
     //fprintf(stderr, "p_type %08X p_offset %08X p_vaddr %08X p_paddr %08X p_filesz %08X p_memsz %08X p_flags %08X p_align %08X\n", shdr->p_type, shdr->p_offset, shdr->p_vaddr, shdr->p_paddr, shdr->p_filesz, shdr->p_memsz, shdr->p_flags, shdr->p_align);   
+}
+
+bool symbol_addr_less(const ELFSymbol &a, const ELFSymbol &b) {
+  return a.addr < b.addr;
+}
+
+void finish_load(const ELFImage &img) {
+  printf("Start address is 0x%08x\n", img.entry);
+
+  //FIXME Support multiprogramming by only applying this entry point to certain threads.
+	//rigel::ENTRY_POINTS.resize(rigel::THREADS_TOTAL);	
+	for(int i = 0; i < rigel::THREADS_TOTAL; i++) {
+    //rigel::ENTRY_POINTS[i] = ehdr->e_entry;
+		rigel::ENTRY_POINTS.push_back(img.entry);
+	}
+
+	//Heuristic to reserve the appropriate amount of space in the table of static instructions
+	PipePacket::reserveDecodeTable(img.num_static_instructions);
+}
+
+// An ELF file read into host memory by ELFAccess::Preload().  A later
+// LoadELF() of the same file installs it from here; processes forked after
+// the preload (the sweep runner's children) share the pages copy-on-write.
+struct PreloadedELF {
+  std::string bin_name;
+  ELFImage img;
+  std::vector<std::vector<char> > data;  // initialized bytes of each segment
+};
+
+PreloadedELF *preloaded_elf = NULL;
+
+void install_preloaded(rigel::GlobalBackingStoreType *mem) {
+  const ELFImage &img = preloaded_elf->img;
+  for (size_t i = 0; i < img.segments.size(); i++) {
+    const ELFSegment &seg = img.segments[i];
+    if (seg.filesz != 0) {
+      mem->write_bytes(seg.addr, &preloaded_elf->data[i][0], seg.filesz);
+    }
+    zero_bss(mem, seg);
+  }
+  for (size_t i = 0; i < img.regions.size(); i++) {
+    apply_region(mem, img.regions[i]);
+  }
+  printf("Loaded preloaded ELF image of %s\n", preloaded_elf->bin_name.c_str());
+  finish_load(img);
+}
+
+std::string cache_file_name(const std::string &cache_dir, uint64_t hash) {
+  char name[32];
+  snprintf(name, sizeof(name), "/%016" PRIx64 ".elfimg", hash);
+  return cache_dir + name;
+}
+
+// Returns false (and leaves memory untouched) if there is no usable cached
+// image for this ELF.
+bool load_cached_image(const std::string &path, uint64_t hash, uint64_t size,
+                       rigel::GlobalBackingStoreType *mem) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) { return false; }
+
+  ELFImage img;
+  ELFCacheHeader hdr;
+  bool ok = (pread(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr))
+         && (0 == memcmp(hdr.magic, ELF_CACHE_MAGIC, sizeof(hdr.magic)))
+         && (hdr.version == ELF_CACHE_VERSION)
+         && (hdr.elf_hash == hash)
+         && (hdr.elf_size == size);
+  if (ok) {
+    img.entry = hdr.entry;
+    img.num_static_instructions = hdr.num_static_instructions;
+    img.segments.resize(hdr.num_segments);
+    img.regions.resize(hdr.num_regions);
+    off_t off = sizeof(hdr);
+    size_t seg_bytes = hdr.num_segments * sizeof(ELFSegment);
+    size_t reg_bytes = hdr.num_regions * sizeof(ELFRegion);
+    ok = (seg_bytes == 0 || pread(fd, &img.segments[0], seg_bytes, off) == (ssize_t)seg_bytes)
+      && (reg_bytes == 0 || pread(fd, &img.regions[0], reg_bytes, off + seg_bytes) == (ssize_t)reg_bytes);
+  }
+  if (!ok) {
+    close(fd);
+    return false;
+  }
+
+  for (size_t i = 0; i < img.segments.size(); i++) {
+    install_segment(mem, fd, img.segments[i]);
+  }
+  close(fd);
+  for (size_t i = 0; i < img.regions.size(); i++) {
+    apply_region(mem, img.regions[i]);
+  }
+  printf("Loaded ELF image from cache %s\n", path.c_str());
+  finish_load(img);
+  return true;
+}
+
+// Best effort: failures only cost the next run a full load.  Written to a
+// temporary name and renamed so concurrent runs never see a partial file.
+void write_cached_image(const std::string &cache_dir, const std::string &path,
+                        uint64_t hash, uint64_t size, int elf_fd,
+                        const ELFImage &img) {
+  mkdir(cache_dir.c_str(), S_IRWXU | S_IRGRP | S_IXGRP);
+
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".tmp.%d", (int)getpid());
+  std::string tmp = path + suffix;
+  FILE *out = fopen(tmp.c_str(), "wb");
+  if (out == NULL) {
+    fprintf(stderr, "Warning: unable to write ELF image cache %s: %s\n", tmp.c_str(), strerror(errno));
+    return;
+  }
+
+  ELFCacheHeader hdr;
+  memcpy(hdr.magic, ELF_CACHE_MAGIC, sizeof(hdr.magic));
+  hdr.version = ELF_CACHE_VERSION;
+  hdr.entry = img.entry;
+  hdr.elf_hash = hash;
+  hdr.elf_size = size;
+  hdr.num_static_instructions = img.num_static_instructions;
+  hdr.num_segments = img.segments.size();
+  hdr.num_regions = img.regions.size();
+
+  // Segment data follows the tables, in order.
+  std::vector<ELFSegment> segs(img.segments);
+  uint64_t data_off = sizeof(hdr) + segs.size() * sizeof(ELFSegment)
+                    + img.regions.size() * sizeof(ELFRegion);
+  for (size_t i = 0; i < segs.size(); i++) {
+    segs[i].offset = data_off;
+    data_off += segs[i].filesz;
+  }
+
+  bool ok = (fwrite(&hdr, sizeof(hdr), 1, out) == 1);
+  if (ok && !segs.empty()) {
+    ok = (fwrite(&segs[0], sizeof(ELFSegment), segs.size(), out) == segs.size());
+  }
+  if (ok && !img.regions.empty()) {
+    ok = (fwrite(&img.regions[0], sizeof(ELFRegion), img.regions.size(), out) == img.regions.size());
+  }
+  std::vector<char> buf(1 << 20);
+  for (size_t i = 0; ok && i < img.segments.size(); i++) {
+    uint64_t done = 0;
+    while (ok && done < img.segments[i].filesz) {
+      size_t want = std::min<uint64_t>(buf.size(), img.segments[i].filesz - done);
+      ok = (pread(elf_fd, &buf[0], want, img.segments[i].offset + done) == (ssize_t)want)
+        && (fwrite(&buf[0], 1, want, out) == want);
+      done += want;
+    }
+  }
+  ok = (0 == fclose(out)) && ok;
+
+  if (!ok || 0 != rename(tmp.c_str(), path.c_str())) {
+    fprintf(stderr, "Warning: unable to write ELF image cache %s\n", path.c_str());
+    remove(tmp.c_str());
+  }
+}
+
+} // end anonymous namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// LoadELF
+// 
+// Put binary into memory at the proper location as stipulated by the ELF file.
+// Uses the GNU libelf to do the dirty work.  Segments are installed in bulk;
+// BSS is zeroed without allocating backing store.
+//
+// If cache_dir is non-empty, the loaded image (segment data, permission
+// regions, entry point) is saved there keyed by a hash of the ELF file, and
+// later runs of the same binary load it from the cache instead.  A binary
+// read in ahead of time by Preload() is installed from host memory.
+// 
+// PARAMETERS:
+// bin_name:	Name of file to open and load
+// mem:       Backing store to load into
+// cache_dir: ELF image cache directory, or "" to disable
+// 
+////////////////////////////////////////////////////////////////////////////////
+void ELFAccess::LoadELF(std::string bin_name, rigel::GlobalBackingStoreType *mem,
+                        const std::string &cache_dir) {
+  Elf *elf;
+  FILE *fp;
+  ELFImage img;
+  img.num_static_instructions = 0;
+  // Ignore LoadELF on dumps
+
+  if (preloaded_elf != NULL && preloaded_elf->bin_name == bin_name
+      && !rigel::DUMP_ELF_IMAGE) {
+    install_preloaded(mem);
+    return;
+  }
+
+  if ((fp = fopen(bin_name.c_str(), "rb")) == NULL) {
+    throw ExitSim("ELFAccess::LoadELF(): fopen() Failed", 1);
+  }
+
+  // The cache is bypassed when dumping the image, which needs every word.
+  const bool use_cache = !cache_dir.empty() && !rigel::DUMP_ELF_IMAGE;
+  uint64_t elf_hash = 0, elf_size = 0;
+  std::string cache_path;
+  if (use_cache) {
+    elf_hash = hash_file(fileno(fp), elf_size);
+    cache_path = cache_file_name(cache_dir, elf_hash);
+    if (load_cached_image(cache_path, elf_hash, elf_size, mem)) {
+      fclose(fp);
+      return;
+    }
+  }
+
+  elf_version(EV_CURRENT);
+  if ((elf = elf_begin(fileno(fp), ELF_C_READ, NULL)) == NULL) {
+    std::string s("ELFAccess::LoadELF(): elf_begin() Failed -- ");
+    s += elf_errmsg(-1);
+    throw ExitSim(s.c_str(), 1);
+  }
+
+  scan_elf(elf, img);
+
+  FILE *dump_elf_img = NULL;
+  if( rigel::DUMP_ELF_IMAGE ) {
+    if ((dump_elf_img = fopen("elfimage.hex", "w")) == NULL) {
+      throw ExitSim("elfimage.hex: fopen() Failed", 1);
+    }
+  }
+
+  for (size_t i = 0; i < img.segments.size(); i++) {
+    const ELFSegment &seg = img.segments[i];
+    install_segment(mem, fileno(fp), seg);
+
+    if ( rigel::DUMP_ELF_IMAGE ) {
+      for ( uint32_t j = 0; j < (seg.memsz+3)/4; j++) {
+        uint32_t write_addr = seg.addr + 4*j;
+        fprintf( dump_elf_img, "%08x %08x\n", write_addr, mem->read_host_word(write_addr) );
+      }
+    }
+  }
+  for (size_t i = 0; i < img.regions.size(); i++) {
+    apply_region(mem, img.regions[i]);
+  }
+
+  finish_load(img);
+
+  if (use_cache) {
+    write_cached_image(cache_dir, cache_path, elf_hash, elf_size, fileno(fp), img);
+  }
  
   free(elf); elf = NULL;
   fclose(fp);
@@ -191,3 +473,112 @@ void ELFAccess::LoadELF(std::string bin_name, rigel::GlobalBackingStoreType *mem
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Preload
+//
+// Read bin_name's segments, permission regions and entry point into host
+// memory without loading them into any target memory.  A later LoadELF() of
+// the same file (in this process or a child forked after this call) installs
+// the preloaded image directly.
+//
+// PARAMETERS:
+// bin_name:	Name of file to open and read
+//
+////////////////////////////////////////////////////////////////////////////////
+void ELFAccess::Preload(const std::string &bin_name) {
+  Elf *elf;
+  FILE *fp;
+
+  if ((fp = fopen(bin_name.c_str(), "rb")) == NULL) {
+    throw ExitSim("ELFAccess::Preload(): fopen() Failed", 1);
+  }
+  elf_version(EV_CURRENT);
+  if ((elf = elf_begin(fileno(fp), ELF_C_READ, NULL)) == NULL) {
+    std::string s("ELFAccess::Preload(): elf_begin() Failed -- ");
+    s += elf_errmsg(-1);
+    throw ExitSim(s.c_str(), 1);
+  }
+
+  PreloadedELF *p = new PreloadedELF;
+  p->bin_name = bin_name;
+  p->img.num_static_instructions = 0;
+  scan_elf(elf, p->img);
+  elf_end(elf);
+
+  p->data.resize(p->img.segments.size());
+  for (size_t i = 0; i < p->img.segments.size(); i++) {
+    const ELFSegment &seg = p->img.segments[i];
+    p->data[i].resize(seg.filesz);
+    if (seg.filesz != 0
+        && pread(fileno(fp), &p->data[i][0], seg.filesz, seg.offset) != (ssize_t)seg.filesz) {
+      throw ExitSim("ELFAccess::Preload(): short read", 1);
+    }
+  }
+  fclose(fp);
+
+  delete preloaded_elf;
+  preloaded_elf = p;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ReadFunctionSymbols
+//
+// Collect the STT_FUNC symbols of bin_name for the per-PC profile dump.
+//
+// PARAMETERS:
+// bin_name:	Name of file to open and read
+// syms:	Filled with the binary's functions, sorted by address
+//
+////////////////////////////////////////////////////////////////////////////////
+bool ELFAccess::ReadFunctionSymbols(const std::string &bin_name,
+                                    std::vector<ELFSymbol> &syms) {
+  Elf *elf;
+  FILE *fp;
+
+  syms.clear();
+  if ((fp = fopen(bin_name.c_str(), "rb")) == NULL) {
+    return false;
+  }
+  elf_version(EV_CURRENT);
+  if ((elf = elf_begin(fileno(fp), ELF_C_READ, NULL)) == NULL) {
+    fclose(fp);
+    return false;
+  }
+
+  Elf_Scn *scn = NULL;
+  Elf32_Shdr *shdr;
+  while((scn = elf_nextscn(elf, scn)) != NULL) {
+    if((shdr = elf32_getshdr(scn)) == NULL || shdr->sh_type != SHT_SYMTAB) {
+      continue;
+    }
+    Elf_Data *edata = NULL;
+    while((edata = elf_getdata(scn, edata)) != NULL) {
+      int num_symbols = edata->d_size / shdr->sh_entsize;
+      Elf32_Sym *s = (Elf32_Sym *)edata->d_buf;
+      for(int i = 0; i < num_symbols; i++, s++) {
+        if(ELF32_ST_TYPE(s->st_info) != STT_FUNC) {
+          continue;
+        }
+        const char *symbol_name = elf_strptr(elf, shdr->sh_link, s->st_name);
+        if(symbol_name == NULL || symbol_name[0] == '\0') {
+          continue;
+        }
+        ELFSymbol sym;
+        sym.addr = s->st_value;
+        sym.size = s->st_size;
+        sym.name = symbol_name;
+        syms.push_back(sym);
+      }
+    }
+  }
+  elf_end(elf);
+  fclose(fp);
+
+  std::stable_sort(syms.begin(), syms.end(), symbol_addr_less);
+  for (size_t i = 0; i < syms.size(); i++) {
+    if (syms[i].size == 0 && i + 1 < syms.size()) {
+      syms[i].size = syms[i + 1].addr - syms[i].addr;
+    }
+  }
+  return true;
+}
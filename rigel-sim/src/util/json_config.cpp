@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////
+// json_config.cpp
+////////////////////////////////////////////////////////////////////////////////
+//
+//  JSON configuration files.  See util/json_config.h.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <inttypes.h>                   // for PRId64
+#include <stdint.h>                     // for int64_t
+#include <cerrno>                       // for errno
+#include <cstdio>                       // for FILE, fopen, snprintf, etc
+#include <cstring>                      // for strerror
+#include <string>                       // for string
+#include <vector>                       // for vector
+#include "util/json_config.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// LoadJSONFile()
+////////////////////////////////////////////////////////////////////////////////
+bool
+rigel::config::LoadJSONFile(const std::string &path, rapidjson::Document &doc,
+                            std::string &err)
+{
+  FILE *f = fopen(path.c_str(), "rb");
+  if (f == NULL) {
+    err = "unable to open '" + path + "': " + strerror(errno);
+    return false;
+  }
+  std::string text;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    text.append(buf, n);
+  }
+  fclose(f);
+
+  doc.Parse<0>(text.c_str());
+  if (doc.HasParseError()) {
+    char where[32];
+    snprintf(where, sizeof(where), "%u", (unsigned)doc.GetErrorOffset());
+    err = "'" + path + "' byte " + where + ": " + doc.GetParseError();
+    return false;
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ScalarToToken()
+////////////////////////////////////////////////////////////////////////////////
+bool
+rigel::config::ScalarToToken(const rapidjson::Value &v, std::string &token)
+{
+  char buf[32];
+  if (v.IsString()) {
+    token = v.GetString();
+  } else if (v.IsInt64()) {
+    snprintf(buf, sizeof(buf), "%" PRId64, (int64_t)v.GetInt64());
+    token = buf;
+  } else if (v.IsNumber()) {
+    // doubles, and (inexactly) integers too large for an int64_t
+    snprintf(buf, sizeof(buf), "%.15g", v.GetDouble());
+    token = buf;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// FlagToTokens()
+////////////////////////////////////////////////////////////////////////////////
+bool
+rigel::config::FlagToTokens(const std::string &flag, const rapidjson::Value &v,
+                            std::vector<std::string> &tokens, std::string &err)
+{
+  std::string token;
+  if (v.IsNull() || v.IsFalse()) {
+    return true;
+  } else if (v.IsTrue()) {
+    tokens.push_back(flag);
+  } else if (v.IsArray()) {
+    tokens.push_back(flag);
+    for (rapidjson::SizeType i = 0; i < v.Size(); i++) {
+      if (!ScalarToToken(v[i], token)) {
+        err = "'" + flag + "': array elements must be numbers or strings";
+        return false;
+      }
+      tokens.push_back(token);
+    }
+  } else if (ScalarToToken(v, token)) {
+    tokens.push_back(flag);
+    tokens.push_back(token);
+  } else {
+    err = "'" + flag + "': value must be a bool, number, string or array";
+    return false;
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// FlagsToTokens()
+////////////////////////////////////////////////////////////////////////////////
+bool
+rigel::config::FlagsToTokens(const rapidjson::Value &flags,
+                             std::vector<std::string> &tokens, std::string &err)
+{
+  if (!flags.IsObject()) {
+    err = "expected an object of flags";
+    return false;
+  }
+  for (rapidjson::Value::ConstMemberIterator m = flags.MemberBegin();
+       m != flags.MemberEnd(); ++m) {
+    if (!FlagToTokens(m->name.GetString(), m->value, tokens, err)) {
+      return false;
+    }
+  }
+  return true;
+}
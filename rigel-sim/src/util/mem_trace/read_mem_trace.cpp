@@ -1,82 +1,303 @@
+////////////////////////////////////////////////////////////////////////////////
+// read_mem_trace.cpp
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Reader for gzipped memory access traces (see read_mem_trace_c.h).
+//
+//  A background thread decompresses the trace in BLOCK_BYTES chunks into two
+//  blocks that it fills alternately, so inflating the next block overlaps
+//  with parsing the current one.  The simulation thread parses records
+//  straight out of the blocks.  Records buffered for hardware threads are
+//  demultiplexed into one contiguous array per thread and handed out by
+//  pointer.
+//
+////////////////////////////////////////////////////////////////////////////////
+
 #include "read_mem_trace_c.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
-#include <deque>
+#include <pthread.h>
 #include <zlib.h>
 
 struct mem_trace_reader {
-public:
-  mem_trace_reader(char* filename);
-  ~mem_trace_reader();
+  public:
+    // Decompressed bytes per block.
+    static const size_t BLOCK_BYTES = 1 << 20;
+    // Consumed records a thread queue may hold before it is compacted.
+    static const size_t COMPACT_RECORDS = 4096;
+
+    mem_trace_reader(gzFile f);
+    ~mem_trace_reader();
+
+    // sequential stream read
+    bool get_next_access(extended_info& ei);
+    // threaded stream reads, see read_mem_trace_c.h
+    int buffer_threads_min(int num_hw_threads, int min_insts);
+    int buffer_a_thread_max(int hw_thread, int max_insts);
+    int buffer_one_sw_thread(int hw_thread);
+    const extended_info* next_thread_access(int thread);
+    // every byte of the trace has been parsed
+    bool eof();
+
+  private:
+    struct Block {
+      std::vector<char> data;
+      size_t len;
+      bool full;  // filled by the inflater, not yet consumed
+      bool last;  // no data follows this block
+    };
+
+    // per hardware thread records; [head, recs.size()) are still queued
+    struct ThreadQueue {
+      std::vector<extended_info> recs;
+      size_t head;
+      ThreadQueue() : head(0) { }
+    };
+
+    // consumer side
+    bool read(void* dst, size_t n);
+    bool next_block();
+    bool read_access(extended_info& ei, unsigned& interval, bool stop_at_thread);
+    bool skip_to_thread_boundary();
+    void ensure_threads(int n);
+    void push(int hw_thread, const extended_info& ei);
+
+    // inflater side
+    static void* InflaterMain(void* arg);
+    void InflaterLoop();
 
-  // sequential stream read
-  bool get_next_access(extended_info& ei);
-  // threaded stream read 
-  // HW threads plus total insts per thread
-  int buffer_threads(int num_threads, int num_insts);
-  bool get_next_access(int thread, extended_info& ei);
+    gzFile infile;
+    Block blocks[2];
+    int cur;       // block being parsed
+    size_t pos;    // parse offset in blocks[cur]
+    bool started;  // blocks[cur] has been received
+    std::vector<ThreadQueue> threaded_buffer;
 
-private:
-  gzFile infile;
-  std::vector<std::deque<extended_info> > threaded_buffer;
+    // shared with the inflater thread, protected by lock
+    pthread_t inflater;
+    pthread_mutex_t lock;
+    pthread_cond_t block_full;
+    pthread_cond_t block_empty;
+    bool stop;
 
+    // No copies.
+    mem_trace_reader(const mem_trace_reader&);
+    mem_trace_reader& operator=(const mem_trace_reader&);
 };
 
-extern "C" mem_trace_reader* init_trace_reader(const char* filename) 
+////////////////////////////////////////////////////////////////////////////////
+// C interface
+////////////////////////////////////////////////////////////////////////////////
+
+extern "C" mem_trace_reader* init_trace_reader(const char* filename)
 {
-  mem_trace_reader* retval = new mem_trace_reader(filename);
-  return retval;
+  gzFile f = gzopen(filename, "rb");
+  if (f == NULL) { return NULL; }
+  mem_trace_reader* mtr = new mem_trace_reader(f);
+  mtr->buffer_a_thread_max(0, 1);
+  return mtr;
 }
 
-extern "C" void destroy_mem_trace_reader(mem_trace_reader* mtr) 
+extern "C" void destroy_mem_trace_reader(mem_trace_reader* mtr)
 {
   delete mtr;
 }
 
-extern "C" int get_next_access(mem_trace_reader* mtr, extended_info* ei) 
+extern "C" int get_next_access(mem_trace_reader* mtr, extended_info* ei)
 {
   return mtr->get_next_access(*ei);
 }
 
-extern "C" int buffer_threads(mem_trace_reader* mtr, int num_threads, int num_insts) 
+extern "C" int buffer_threads_min(mem_trace_reader* mtr, int num_hw_threads, int min_insts)
+{
+  return mtr->buffer_threads_min(num_hw_threads, min_insts);
+}
+
+extern "C" int buffer_threads_max(mem_trace_reader* mtr, int num_hw_threads, int max_insts)
 {
-  return mtr->buffer_threads(num_threads, num_insts);
+  int thi;
+  for (thi = 0; thi < num_hw_threads; ++thi) {
+    if (mtr->buffer_a_thread_max(thi, max_insts) == 0) { break; }
+  }
+  return thi;
 }
 
-extern "C" int get_next_thread_access(mem_trace_reader* mtr, int thread, extended_info* ei) 
+extern "C" int buffer_one_sw_thread(mem_trace_reader* mtr, int hw_thread)
 {
-  return mtr->get_next_access(thread, *ei);
+  return mtr->buffer_one_sw_thread(hw_thread);
 }
 
-mem_trace_reader::mem_trace_reader(char* filename)
+extern "C" int buffer_a_thread_max(mem_trace_reader* mtr, int hw_thread, int max_insts)
 {
-  infile = gzopen(filename, "rb");
+  return mtr->buffer_a_thread_max(hw_thread, max_insts);
+}
+
+extern "C" const extended_info* next_thread_access(mem_trace_reader* mtr, int thread)
+{
+  return mtr->next_thread_access(thread);
+}
+
+extern "C" int get_next_thread_access(mem_trace_reader* mtr, int thread, extended_info* ei)
+{
+  const extended_info* p = mtr->next_thread_access(thread);
+  if (p == NULL) { return 0; }
+  *ei = *p;
+  return 1;
+}
+
+extern "C" int trace_reader_eof(mem_trace_reader* mtr)
+{
+  return mtr->eof();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// mem_trace_reader
+////////////////////////////////////////////////////////////////////////////////
+
+mem_trace_reader::mem_trace_reader(gzFile f) :
+  infile(f),
+  cur(0),
+  pos(0),
+  started(false),
+  stop(false)
+{
+  for (int i = 0; i < 2; i++) {
+    blocks[i].data.resize(BLOCK_BYTES);
+    blocks[i].len  = 0;
+    blocks[i].full = false;
+    blocks[i].last = false;
+  }
+  // a bigger zlib buffer means fewer, larger reads of the compressed file
+  gzbuffer(infile, 256 * 1024);
+
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&block_full, NULL);
+  pthread_cond_init(&block_empty, NULL);
+  if (0 != pthread_create(&inflater, NULL, InflaterMain, this)) {
+    fprintf(stderr, "Error: unable to start memory trace reader thread\n");
+    exit(1);
+  }
 }
 
 mem_trace_reader::~mem_trace_reader()
 {
+  pthread_mutex_lock(&lock);
+  stop = true;
+  pthread_cond_signal(&block_empty);
+  pthread_mutex_unlock(&lock);
+  pthread_join(inflater, NULL);
+
   gzclose(infile);
+  pthread_cond_destroy(&block_empty);
+  pthread_cond_destroy(&block_full);
+  pthread_mutex_destroy(&lock);
 }
 
-bool mem_trace_reader::get_next_access(extended_info& ei)
+void* mem_trace_reader::InflaterMain(void* arg)
+{
+  static_cast<mem_trace_reader*>(arg)->InflaterLoop();
+  return NULL;
+}
+
+// fill the two blocks alternately until the trace ends or we are stopped
+void mem_trace_reader::InflaterLoop()
+{
+  for (int i = 0; ; i ^= 1) {
+    Block& b = blocks[i];
+    pthread_mutex_lock(&lock);
+    while (b.full && !stop) {
+      pthread_cond_wait(&block_empty, &lock);
+    }
+    if (stop) {
+      pthread_mutex_unlock(&lock);
+      return;
+    }
+    pthread_mutex_unlock(&lock);
+
+    int n = gzread(infile, &b.data[0], BLOCK_BYTES);
+
+    pthread_mutex_lock(&lock);
+    b.len  = (n > 0) ? n : 0;
+    b.last = (n < (int)BLOCK_BYTES);
+    b.full = true;
+    pthread_cond_signal(&block_full);
+    pthread_mutex_unlock(&lock);
+    if (b.last) { return; }
+  }
+}
+
+// hand blocks[cur] back to the inflater and wait for the other one.  returns
+// false at the end of the trace
+bool mem_trace_reader::next_block()
+{
+  pthread_mutex_lock(&lock);
+  if (started) {
+    if (blocks[cur].last) {
+      pthread_mutex_unlock(&lock);
+      return false;
+    }
+    blocks[cur].full = false;
+    pthread_cond_signal(&block_empty);
+    cur ^= 1;
+  }
+  while (!blocks[cur].full) {
+    pthread_cond_wait(&block_full, &lock);
+  }
+  started = true;
+  pthread_mutex_unlock(&lock);
+  pos = 0;
+  return true;
+}
+
+// copy the next n bytes of the trace into dst; false on a short read
+bool mem_trace_reader::read(void* dst, size_t n)
+{
+  char* out = static_cast<char*>(dst);
+  while (n > 0) {
+    if (!started || pos == blocks[cur].len) {
+      if (!next_block()) { return false; }
+      continue;
+    }
+    size_t chunk = blocks[cur].len - pos;
+    if (chunk > n) { chunk = n; }
+    memcpy(out, &blocks[cur].data[pos], chunk);
+    pos += chunk;
+    out += chunk;
+    n -= chunk;
+  }
+  return true;
+}
+
+bool mem_trace_reader::eof()
+{
+  while (!started || pos == blocks[cur].len) {
+    if (!next_block()) { return true; }
+  }
+  return false;
+}
+
+// read up to and including the next access, adding the non-memory
+// instructions passed on the way to interval.  With stop_at_thread set, a
+// thread change ends the search (returns false with ei untouched); otherwise
+// thread changes are skipped over.  returns false at the end of the trace
+bool mem_trace_reader::read_access(extended_info& ei, unsigned& interval, bool stop_at_thread)
 {
-  int nread = 0;
-  unsigned interval = 0;
   stream_entry se1;
   access_info ai1;
   int temp;
   while (true) {
-    nread = gzread(infile, &se1, sizeof(stream_entry));
-    if (nread < sizeof(stream_entry)) {return false;}
+    if (!read(&se1, sizeof(stream_entry))) { return false; }
     if (se1.code == thread_change) {
+      if (!read(&temp, sizeof(int))) { return false; }
+      if (stop_at_thread) { return false; }
       interval += se1.interval;
-      nread = gzread(infile, &temp, sizeof(int)); 
-      if (nread < sizeof(int)) {return false;}
-   } else if (se1.code == skip) {
+    } else if (se1.code == skip) {
       interval += se1.interval;
     } else {
       interval += se1.interval;
-      nread = gzread(infile, &ai1, sizeof(access_info));
-      if (nread < sizeof(access_info)) {return false;}
+      if (!read(&ai1, sizeof(access_info))) { return false; }
       ei.interval = interval;
       ei.read = (se1.code == mem_read) ? 1 : 0;
       ei.ai = ai1;
@@ -85,119 +306,100 @@ bool mem_trace_reader::get_next_access(extended_info& ei)
   }
 }
 
-int mem_trace_reader::buffer_threads(int num_threads, int num_insts)
+// discard the rest of the current SW thread.  returns false at the end of the
+// trace
+bool mem_trace_reader::skip_to_thread_boundary()
 {
-  int nread;
   stream_entry se1;
   access_info ai1;
-  extended_info ei;
   int temp;
-  threaded_buffer.resize(num_threads);
-  for (int thi = 0; thi < num_threads; ++thi) {
-    int insti = 0;
-    // enqueue instructions for a HW thread
-    while (insti < num_insts) {
-      unsigned interval = 0;
-      while (true) {
-	nread = gzread(infile, &se1, sizeof(stream_entry));
-	if (nread < sizeof(stream_entry)) {return thi;}
-	if (se1.code == thread_change) {
-	  // new SW thread
-	  interval += se1.interval;
-	  nread = gzread(infile, &temp, sizeof(int));
-	  if (nread < sizeof(int)) {return thi;}
-	} else if (se1.code == skip) {
-	  interval += se1.interval;
-	} else {
-	  interval += se1.interval;
-	  nread = gzread(infile, &ai1, sizeof(access_info));
-	  if (nread < sizeof(access_info)) {return thi;}
-	  ei.interval = interval;
-	  ei.read = (se1.code == mem_read) ? 1 : 0;
-	  ei.ai = ai1;
-	  break;
-	}
-      }
-      // enqueue access info
-      threaded_buffer[thi].push_back(ei);
-      insti += interval;
-    }
-    // find the next thread boundary
-    while (true) {
-      nread = gzread(infile, &se1, sizeof(stream_entry));
-      if (nread < sizeof(stream_entry)) {
-	return thi;
-      }
-      if (se1.code == thread_change) {
-	nread = gzread(infile, &temp, sizeof(int));
-	if (nread < sizeof(int)) {return thi;}
-	break;
-      } else if (se1.code != skip) {
-	nread = gzread(infile, &ai1, sizeof(access_info));
-	if (nread < sizeof(access_info)) {return thi;}
-      }
+  while (true) {
+    if (!read(&se1, sizeof(stream_entry))) { return false; }
+    if (se1.code == thread_change) {
+      return read(&temp, sizeof(int));
+    } else if (se1.code != skip) {
+      if (!read(&ai1, sizeof(access_info))) { return false; }
     }
   }
-  return num_threads;
 }
 
-bool mem_trace_reader::get_next_access(int thread, extended_info& ei)
+void mem_trace_reader::ensure_threads(int n)
 {
-  if (threaded_buffer.size() > thread &&
-      threaded_buffer[thread].size() > 0) {
-    ei = threaded_buffer[thread].front();
-    threaded_buffer[thread].pop_front();
-    return true;
-  } else {
-    return false;
+  if ((int)threaded_buffer.size() < n) {
+    threaded_buffer.resize(n);
   }
 }
 
-int buffer_one_sw_thread(struct mem_trace_reader* mtr, int hw_thread)
+void mem_trace_reader::push(int hw_thread, const extended_info& ei)
 {
-  int nread;
-  struct stream_entry se1;
-  struct access_info ai1;
-  struct extended_info ei;
-  int temp;
-  int interval;
-  struct extended_info_q* newbuf;
-
-  //NOTE: This code should never be used
-  if (mtr->thread_count <= hw_thread) {
-    newbuf = (struct extended_info_q*)calloc(sizeof(struct extended_info_q), hw_thread+1);
-    if (mtr->thread_count) {
-      // copy over old buffer
-      memcpy(newbuf, mtr->threaded_buffer, mtr->thread_count * sizeof(struct extended_info_q));
-      // free old buffer
-      free(mtr->threaded_buffer);
-    }
-    mtr->threaded_buffer = newbuf;
-    mtr->thread_count = hw_thread+1;
+  ThreadQueue& q = threaded_buffer[hw_thread];
+  if (q.head == q.recs.size()) {
+    // drained: start over at the front, keeping the allocation
+    q.recs.clear();
+    q.head = 0;
+  } else if (q.head >= COMPACT_RECORDS && q.head * 2 >= q.recs.size()) {
+    // mostly consumed: drop the consumed front rather than growing
+    q.recs.erase(q.recs.begin(), q.recs.begin() + q.head);
+    q.head = 0;
   }
+  q.recs.push_back(ei);
+}
 
-  // enqueue instructions for one SW thread
-  while (1) {
-    nread = gzread(mtr->infile, &se1, sizeof(struct stream_entry));
-    if (nread < sizeof(struct stream_entry)) {return interval;}
-    if (se1.code == thread_change) {
-      // new SW thread
-      nread = gzread(mtr->infile, &temp, sizeof(int));
-      if (nread < sizeof(int)) {return interval;}
-      return interval;
-    } else if (se1.code == skip) {
-      interval += se1.interval;
-    } else {
-      interval += se1.interval;
-      nread = gzread(mtr->infile, &ai1, sizeof(struct access_info));
-      if (nread < sizeof(struct access_info)) {return interval;}
-      ei.interval = se1.interval;
-      ei.read = (se1.code == mem_read) ? 1 : 0;
-      ei.ai = ai1;
-      push_back(&mtr->threaded_buffer[hw_thread], &ei);
-      break;
+bool mem_trace_reader::get_next_access(extended_info& ei)
+{
+  unsigned interval = 0;
+  return read_access(ei, interval, false);
+}
+
+int mem_trace_reader::buffer_threads_min(int num_hw_threads, int min_insts)
+{
+  extended_info ei;
+  ensure_threads(num_hw_threads);
+  for (int thi = 0; thi < num_hw_threads; ++thi) {
+    int insti = 0;
+    // enqueue instructions for a HW thread, crossing SW threads as needed
+    while (insti < min_insts) {
+      unsigned interval = 0;
+      if (!read_access(ei, interval, false)) { return thi; }
+      push(thi, ei);
+      insti += interval;
     }
+    if (!skip_to_thread_boundary()) { return thi; }
+  }
+  return num_hw_threads;
+}
+
+int mem_trace_reader::buffer_a_thread_max(int hw_thread, int max_insts)
+{
+  extended_info ei;
+  ensure_threads(hw_thread + 1);
+  int insti = 0;
+  // enqueue instructions for a HW thread, stopping at the SW thread's end
+  while (insti < max_insts) {
+    unsigned interval = 0;
+    if (!read_access(ei, interval, true)) { return insti; }
+    push(hw_thread, ei);
+    insti += interval;
+  }
+  skip_to_thread_boundary();
+  return insti;
+}
+
+int mem_trace_reader::buffer_one_sw_thread(int hw_thread)
+{
+  extended_info ei;
+  ensure_threads(hw_thread + 1);
+  unsigned interval = 0;
+  if (read_access(ei, interval, true)) {
+    push(hw_thread, ei);
   }
   return interval;
 }
 
+const extended_info* mem_trace_reader::next_thread_access(int thread)
+{
+  if ((int)threaded_buffer.size() <= thread) { return NULL; }
+  ThreadQueue& q = threaded_buffer[thread];
+  if (q.head == q.recs.size()) { return NULL; }
+  return &q.recs[q.head++];
+}
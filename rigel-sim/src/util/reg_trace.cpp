@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////
+// reg_trace.cpp
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Buffered binary register-write trace writer.  See util/reg_trace.h.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>                      // for assert
+#include <cerrno>                       // for errno
+#include <cstdlib>                      // for exit
+#include <cstring>                      // for memcpy, strerror
+#include "util/reg_trace.h"
+
+RegTraceWriter *rigel::REG_TRACE = NULL;
+
+////////////////////////////////////////////////////////////////////////////////
+// RegTraceWriter()
+////////////////////////////////////////////////////////////////////////////////
+RegTraceWriter::RegTraceWriter(const std::string &filename, int threads_total,
+                               int threads_per_core) :
+  buffers(threads_total),
+  done(false)
+{
+  out = fopen(filename.c_str(), "wb");
+  if (out == NULL) {
+    fprintf(stderr, "Error: unable to open register trace '%s': %s\n",
+      filename.c_str(), strerror(errno));
+    exit(1);
+  }
+
+  RegTraceFileHeader hdr;
+  memcpy(hdr.magic, rigel::regtrace::MAGIC, sizeof(hdr.magic));
+  hdr.version          = rigel::regtrace::VERSION;
+  hdr.record_size      = sizeof(RegTraceRecord);
+  hdr.threads_per_core = threads_per_core;
+  hdr.threads_total    = threads_total;
+  fwrite(&hdr, sizeof(hdr), 1, out);
+
+  for (size_t i = 0; i < buffers.size(); i++) {
+    buffers[i].recs  = new RegTraceRecord[BUFFER_RECORDS];
+    buffers[i].count = 0;
+  }
+
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&work_ready, NULL);
+  pthread_cond_init(&work_done, NULL);
+  if (0 != pthread_create(&writer, NULL, WriterMain, this)) {
+    fprintf(stderr, "Error: unable to start register trace writer thread\n");
+    exit(1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ~RegTraceWriter()
+////////////////////////////////////////////////////////////////////////////////
+RegTraceWriter::~RegTraceWriter()
+{
+  // Hand over whatever is left, in gtid order.
+  for (size_t i = 0; i < buffers.size(); i++) {
+    if (buffers[i].count != 0) { Submit(buffers[i]); }
+  }
+
+  pthread_mutex_lock(&lock);
+  done = true;
+  pthread_cond_signal(&work_ready);
+  pthread_mutex_unlock(&lock);
+  pthread_join(writer, NULL);
+
+  fclose(out);
+
+  for (size_t i = 0; i < buffers.size(); i++) { delete [] buffers[i].recs; }
+  for (size_t i = 0; i < free_bufs.size(); i++) { delete [] free_bufs[i]; }
+  pthread_cond_destroy(&work_done);
+  pthread_cond_destroy(&work_ready);
+  pthread_mutex_destroy(&lock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Submit()
+////////////////////////////////////////////////////////////////////////////////
+// queue a thread's buffer for writing and give the thread an empty one.  Only
+// waits if the writer has fallen MAX_PENDING buffers behind.
+void
+RegTraceWriter::Submit(ThreadBuffer &b)
+{
+  pthread_mutex_lock(&lock);
+  while (pending.size() >= MAX_PENDING) {
+    pthread_cond_wait(&work_done, &lock);
+  }
+  pending.push_back(b);
+  pthread_cond_signal(&work_ready);
+
+  RegTraceRecord *fresh = NULL;
+  if (!free_bufs.empty()) {
+    fresh = free_bufs.back();
+    free_bufs.pop_back();
+  }
+  pthread_mutex_unlock(&lock);
+
+  b.recs  = (fresh != NULL) ? fresh : new RegTraceRecord[BUFFER_RECORDS];
+  b.count = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// WriterLoop()
+////////////////////////////////////////////////////////////////////////////////
+// writer thread body: drain pending buffers to the file until told to stop.
+void *
+RegTraceWriter::WriterMain(void *arg)
+{
+  static_cast<RegTraceWriter *>(arg)->WriterLoop();
+  return NULL;
+}
+
+void
+RegTraceWriter::WriterLoop()
+{
+  pthread_mutex_lock(&lock);
+  while (true) {
+    while (pending.empty() && !done) {
+      pthread_cond_wait(&work_ready, &lock);
+    }
+    if (pending.empty()) { break; }
+
+    ThreadBuffer b = pending.front();
+    pending.pop_front();
+    pthread_mutex_unlock(&lock);
+
+    if (fwrite(b.recs, sizeof(RegTraceRecord), b.count, out) != b.count) {
+      fprintf(stderr, "Error: short write to register trace: %s\n", strerror(errno));
+      exit(1);
+    }
+
+    pthread_mutex_lock(&lock);
+    free_bufs.push_back(b.recs);
+    pthread_cond_signal(&work_done);
+  }
+  pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+// startup_timer.cpp
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Startup phase timing.  See util/startup_timer.h.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <sys/time.h>                   // for gettimeofday
+#include <cassert>                      // for assert
+#include <cstddef>                      // for NULL, size_t
+#include <cstdio>                       // for fprintf, FILE
+#include <vector>                       // for vector
+#include "util/startup_timer.h"
+
+namespace {
+
+struct Phase {
+  const char *name;
+  int depth;
+  double start;
+  double seconds;  // < 0 while open
+};
+
+std::vector<Phase> phases;   // in the order they were opened
+std::vector<size_t> open;    // indices of the open phases, innermost last
+double first_start = -1.0;
+
+double now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+} // end anonymous namespace
+
+void
+rigel::startup::begin(const char *name) {
+  Phase p = { name, (int)open.size(), now(), -1.0 };
+  if (first_start < 0.0) {
+    first_start = p.start;
+  }
+  open.push_back(phases.size());
+  phases.push_back(p);
+}
+
+void
+rigel::startup::end() {
+  assert(!open.empty() && "startup::end() without begin()");
+  Phase &p = phases[open.back()];
+  p.seconds = now() - p.start;
+  open.pop_back();
+}
+
+void
+rigel::startup::report(FILE *out) {
+  const double total = (first_start < 0.0) ? 0.0 : now() - first_start;
+  const double div = (total > 0.0) ? total : 1e-9;
+  fprintf(out, "startup: %.3f s before cycle 0\n", total);
+  for (size_t i = 0; i < phases.size(); i++) {
+    const Phase &p = phases[i];
+    if (p.seconds < 0.0) {
+      continue;
+    }
+    int indent = 2 * (p.depth + 1);
+    fprintf(out, "%*s%-*s %8.3f s %5.1f%%\n", indent, "", 30 - indent, p.name,
+      p.seconds, 100.0 * p.seconds / div);
+  }
+}
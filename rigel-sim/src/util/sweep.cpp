@@ -0,0 +1,329 @@
+////////////////////////////////////////////////////////////////////////////////
+// sweep.cpp
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Fork-per-point parameter sweep runner.  See util/sweep.h.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>                      // for errno, EEXIST, EINTR
+#include <inttypes.h>                   // for PRIu64
+#include <stdint.h>                     // for uint64_t
+#include <stdio.h>                      // for fprintf, fopen, snprintf, etc
+#include <stdlib.h>                     // for exit
+#include <string.h>                     // for strerror
+#include <sys/stat.h>                   // for mkdir
+#include <sys/time.h>                   // for gettimeofday
+#include <sys/wait.h>                   // for waitpid, WIFEXITED, etc
+#include <unistd.h>                     // for fork, pipe, dup2, etc
+#include <map>                          // for map
+#include <string>                       // for string
+#include <vector>                       // for vector
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "util/json_config.h"
+#include "util/sweep.h"
+#include "util/util.h"
+
+namespace {
+
+typedef std::vector<std::string> Tokens;
+
+struct SweepSpec {
+  std::string output;
+  unsigned jobs;
+  Tokens base;
+  std::vector<Tokens> points;   // flags each point adds to base
+};
+
+// A running point.
+struct SweepJob {
+  unsigned point;
+  int result_fd;                // read end of the child's result pipe
+  double start;
+};
+
+double now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+void sweep_error(const std::string &file, const std::string &msg) {
+  fprintf(stderr, "Error: sweep file '%s': %s\n", file.c_str(), msg.c_str());
+  exit(1);
+}
+
+void make_dir(const std::string &path) {
+  if (mkdir(path.c_str(), S_IRWXU | S_IRGRP | S_IXGRP) && errno != EEXIST) {
+    fprintf(stderr, "Error: unable to create '%s': %s\n", path.c_str(), strerror(errno));
+    exit(1);
+  }
+}
+
+std::string point_dir(const SweepSpec &spec, unsigned point) {
+  char name[32];
+  snprintf(name, sizeof(name), "/p%04u", point);
+  return spec.output + name;
+}
+
+void read_sweep(const std::string &file, SweepSpec &spec) {
+  rapidjson::Document doc;
+  std::string err;
+  if (!rigel::config::LoadJSONFile(file, doc, err)) {
+    sweep_error(file, err);
+  }
+  if (!doc.IsObject()) {
+    sweep_error(file, "expected an object");
+  }
+
+  spec.output = "SWEEP_OUTPUT";
+  spec.jobs = 1;
+  std::vector<Tokens> points(1);          // no "points": one empty point
+  std::vector<std::string> axis_names;
+  std::vector<std::vector<Tokens> > axes; // per axis, tokens of each value
+
+  for (rapidjson::Value::ConstMemberIterator m = doc.MemberBegin();
+       m != doc.MemberEnd(); ++m) {
+    const std::string key(m->name.GetString());
+    const rapidjson::Value &v = m->value;
+    if (key == "output") {
+      if (!v.IsString()) { sweep_error(file, "\"output\" must be a string"); }
+      spec.output = v.GetString();
+    } else if (key == "jobs") {
+      if (!v.IsUint() || v.GetUint() == 0) {
+        sweep_error(file, "\"jobs\" must be a positive integer");
+      }
+      spec.jobs = v.GetUint();
+    } else if (key == "base") {
+      if (!rigel::config::FlagsToTokens(v, spec.base, err)) {
+        sweep_error(file, "\"base\": " + err);
+      }
+    } else if (key == "points") {
+      if (!v.IsArray() || v.Size() == 0) {
+        sweep_error(file, "\"points\" must be a non-empty array of objects");
+      }
+      points.assign(v.Size(), Tokens());
+      for (rapidjson::SizeType i = 0; i < v.Size(); i++) {
+        if (!rigel::config::FlagsToTokens(v[i], points[i], err)) {
+          sweep_error(file, "\"points\": " + err);
+        }
+      }
+    } else if (key == "axes") {
+      if (!v.IsObject()) { sweep_error(file, "\"axes\" must be an object"); }
+      for (rapidjson::Value::ConstMemberIterator a = v.MemberBegin();
+           a != v.MemberEnd(); ++a) {
+        const std::string flag(a->name.GetString());
+        if (!a->value.IsArray() || a->value.Size() == 0) {
+          sweep_error(file, "axis '" + flag + "' must be a non-empty array");
+        }
+        axis_names.push_back(flag);
+        axes.push_back(std::vector<Tokens>(a->value.Size()));
+        for (rapidjson::SizeType i = 0; i < a->value.Size(); i++) {
+          if (!rigel::config::FlagToTokens(flag, a->value[i], axes.back()[i], err)) {
+            sweep_error(file, "\"axes\": " + err);
+          }
+        }
+      }
+    } else {
+      sweep_error(file, "unknown key \"" + key + "\"");
+    }
+  }
+
+  // Cross the points with every combination of axis values, last axis
+  // fastest, by counting in a mixed-radix number.
+  for (size_t p = 0; p < points.size(); p++) {
+    std::vector<size_t> digit(axes.size(), 0);
+    while (true) {
+      Tokens t(points[p]);
+      for (size_t a = 0; a < axes.size(); a++) {
+        t.insert(t.end(), axes[a][digit[a]].begin(), axes[a][digit[a]].end());
+      }
+      spec.points.push_back(t);
+
+      size_t a = axes.size();
+      while (a > 0 && ++digit[a - 1] == axes[a - 1].size()) {
+        digit[--a] = 0;
+      }
+      if (a == 0) { break; }
+    }
+  }
+}
+
+// Child side of one point: never returns.
+void run_child(CommandLineArgs &base, const char *argv0, SweepPointFn run_point,
+               const SweepSpec &spec, unsigned point, int result_fd) {
+  const std::string dir = point_dir(spec, point);
+  make_dir(dir);
+  const std::string log = dir + "/sim.log";
+  if (freopen(log.c_str(), "w", stdout) == NULL) {
+    fprintf(stderr, "Error: unable to open '%s': %s\n", log.c_str(), strerror(errno));
+    _exit(1);
+  }
+  dup2(fileno(stdout), fileno(stderr));
+
+  // base command line minus --sweep and the binary, then the point's flags,
+  // then the binary (which must come last)
+  const Tokens &args = base.args();
+  Tokens tokens;
+  for (size_t i = 0; i + 1 < args.size(); i++) {
+    if (args[i] == "--sweep") { i++; continue; }
+    tokens.push_back(args[i]);
+  }
+  tokens.push_back("-dumpfile-path");
+  tokens.push_back(dir);
+  tokens.insert(tokens.end(), spec.base.begin(), spec.base.end());
+  tokens.insert(tokens.end(), spec.points[point].begin(), spec.points[point].end());
+  tokens.push_back(args.back());
+
+  std::vector<char *> argv;
+  argv.push_back(const_cast<char *>(argv0));
+  for (size_t i = 0; i < tokens.size(); i++) {
+    argv.push_back(const_cast<char *>(tokens[i].c_str()));
+  }
+  argv.push_back(NULL);
+
+  CommandLineArgs cmdline(tokens);
+  SweepResult result;
+  int status = run_point(cmdline, argv.size() - 1, &argv[0], result);
+
+  if (result.finished) {
+    char head[64];
+    int len = snprintf(head, sizeof(head), "%" PRIu64 " ", result.cycles);
+    std::string msg = std::string(head, len) + result.exit_reason;
+    if (write(result_fd, msg.data(), msg.size()) != (ssize_t)msg.size()) {
+      perror("sweep: write(result)");
+    }
+  }
+  close(result_fd);
+  fflush(stdout);
+  exit(status);
+}
+
+// Parent side of a finished point: log its result line.
+void record_result(FILE *results, const SweepSpec &spec, const SweepJob &job,
+                   int wait_status) {
+  std::string msg;
+  char buf[512];
+  ssize_t n;
+  while ((n = read(job.result_fd, buf, sizeof(buf))) > 0) {
+    msg.append(buf, n);
+  }
+  close(job.result_fd);
+
+  int status = WIFEXITED(wait_status) ? WEXITSTATUS(wait_status)
+                                      : -WTERMSIG(wait_status);
+
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> w(sb);
+  w.StartObject();
+  w.String("point");  w.Uint(job.point);
+  w.String("args");
+  w.StartArray();
+  const Tokens &args = spec.points[job.point];
+  for (size_t i = 0; i < args.size(); i++) {
+    w.String(args[i].c_str());
+  }
+  w.EndArray();
+  w.String("status"); w.Int(status);
+  size_t space = msg.find(' ');
+  if (space == std::string::npos) {
+    w.String("exit_reason"); w.Null();
+    w.String("cycles");      w.Null();
+  } else {
+    w.String("exit_reason"); w.String(msg.c_str() + space + 1);
+    w.String("cycles");      w.Uint64(strtoull(msg.c_str(), NULL, 10));
+  }
+  w.String("seconds"); w.Double(now() - job.start);
+  w.EndObject();
+
+  fprintf(results, "%s\n", sb.GetString());
+  fflush(results);
+  printf("sweep: point %u of %zu finished, status %d\n",
+    job.point, spec.points.size(), status);
+  fflush(stdout);
+}
+
+} // end anonymous namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// RunSweep()
+////////////////////////////////////////////////////////////////////////////////
+int
+rigel::RunSweep(CommandLineArgs &base, const char *argv0, SweepPointFn run_point)
+{
+  const std::string file = base.get_val((char *)"SWEEP_FILE");
+  SweepSpec spec;
+  read_sweep(file, spec);
+
+  make_dir(spec.output);
+  const std::string results_name = spec.output + "/results.jsonl";
+  FILE *results = fopen(results_name.c_str(), "w");
+  if (results == NULL) {
+    fprintf(stderr, "Error: unable to open '%s': %s\n", results_name.c_str(), strerror(errno));
+    exit(1);
+  }
+
+  // Everything done before the fork is shared by all points.  No threads
+  // may be running at that point: fork() only copies the calling thread.
+  ELFAccess::Preload(base.get_val((char *)"objfile"));
+
+  printf("sweep: %zu points, %u at a time, results in %s\n",
+    spec.points.size(), spec.jobs, results_name.c_str());
+
+  std::map<pid_t, SweepJob> running;
+  unsigned next = 0;
+  int failed = 0;
+  while (next < spec.points.size() || !running.empty()) {
+    if (next < spec.points.size() && running.size() < spec.jobs) {
+      int fds[2];
+      if (pipe(fds)) {
+        perror("sweep: pipe");
+        exit(1);
+      }
+      // don't let the child inherit (and re-flush) buffered output
+      fflush(stdout);
+      fflush(stderr);
+      fflush(results);
+      pid_t pid = fork();
+      if (pid < 0) {
+        perror("sweep: fork");
+        exit(1);
+      }
+      if (pid == 0) {
+        close(fds[0]);
+        fclose(results);
+        for (std::map<pid_t, SweepJob>::iterator it = running.begin();
+             it != running.end(); ++it) {
+          close(it->second.result_fd);
+        }
+        run_child(base, argv0, run_point, spec, next, fds[1]);
+      }
+      close(fds[1]);
+      SweepJob job = { next, fds[0], now() };
+      running[pid] = job;
+      next++;
+      continue;
+    }
+
+    int wait_status;
+    pid_t pid = waitpid(-1, &wait_status, 0);
+    if (pid < 0) {
+      if (errno == EINTR) { continue; }
+      perror("sweep: waitpid");
+      exit(1);
+    }
+    std::map<pid_t, SweepJob>::iterator it = running.find(pid);
+    if (it == running.end()) { continue; }
+    record_result(results, spec, it->second, wait_status);
+    if (!WIFEXITED(wait_status) || WEXITSTATUS(wait_status) != 0) {
+      failed++;
+    }
+    running.erase(it);
+  }
+
+  fclose(results);
+  printf("sweep: %zu points run, %d failed\n", spec.points.size(), failed);
+  return failed ? 1 : 0;
+}
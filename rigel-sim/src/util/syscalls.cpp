@@ -10,6 +10,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <cassert>                     // for assert
+#include <cerrno>                      // for errno, EINTR
 #include <fcntl.h>                      // for open, O_CREAT
 #include <cstddef>                     // for size_t, NULL
 #include <stdint.h>                     // for uint32_t, uint8_t
@@ -211,88 +212,24 @@ Syscall::syscall_filemap(struct syscall_struct &syscall_data) {
   // there is a big enough buffer there for all of the data otherwise the host
   // will overwrite what ever is there, even code pages.
   int num_bytes = syscall_data.arg3.i;
-  // The number of bytes we read in which is <= num_bytes
-  int bytes_read = 0;
-  // A buffer that we will use to load in the file data
-  char *buf;
-  // Track offset into read buffer and update after every write to target's
-  // memory.  This will be returned to the target app telling it how big the
-  // actual file is.
-  uint32_t buf_offset = 0;
 
   //cerr << "syscall_filemap: fdesc: " << dec << fdesc << " base_addr " << base_addr << " num_bytes " << num_bytes << endl;
 
   // Do not allow target to slurp in too huge a file
-  assert( (num_bytes < MAX_FILEMAP_SIZE) 
+  assert( (num_bytes >= 0) && (num_bytes < MAX_FILEMAP_SIZE) 
     && "Attempting to read a file that is larger than MAX_FILEMAP_SIZE");
 
-  // Allocate the buffer...remember to be tidy up and delete the memory on exit
-  buf = new char[num_bytes];
-
-  // Read the data in in chunks (probably 16 KiB or so at a time).  If there is
+  // pread() the file from the start straight into target memory.  If there is
   // an error, just kill the simulation since something is funky.
-  while ( (num_bytes - bytes_read) > 0) {
-    int retval = pread(hostfd, buf+bytes_read, num_bytes-bytes_read, bytes_read);
-    if (retval < 0) {
-      perror("read"); 
-      assert(0 && "An error ocurred while trying to filemap a file.");
-    }
-    bytes_read += retval;
-    //cerr << " READ IN " << dec << retval << " bytes" << endl;
-    // It will return zero when finished
-    if (retval == 0) break;
+  int64_t bytes_read = backing_store->read_from_fd(hostfd, base_addr, num_bytes, 0);
+  if (bytes_read < 0) {
+    perror("read"); 
+    assert(0 && "An error ocurred while trying to filemap a file.");
   }
 
-  num_bytes = bytes_read;
-
-  /******** BEGIN SYS_READ() YOINK ***********/
-  // Do unaligned start
-  while ( (base_addr % 4) && (num_bytes > 0) ) {
-    WordByte mem_data;
-
-    mem_data.w = backing_store->read_data_word( base_addr & 0xFFFFFFFC);
-    mem_data.b[base_addr%4] = buf[buf_offset++];
-    //cerr << "base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    backing_store->write_word( base_addr & 0xFFFFFFFC, mem_data.w);
-    num_bytes--;
-    base_addr++;
-  }
-
-  // Do whole-word accesses first and stop when we hit the end
-  while (num_bytes >= 4) {
-    assert((base_addr % 4 == 0) && "base_addr must be aligned here");
-    WordByte mem_data;
-
-    mem_data.b[0] = buf[buf_offset++];
-    mem_data.b[1] = buf[buf_offset++];
-    mem_data.b[2] = buf[buf_offset++];
-    mem_data.b[3] = buf[buf_offset++];
-    backing_store->write_word(base_addr, mem_data.w);
-    //cerr << "base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    // Go to next word
-    base_addr += 4;
-    num_bytes -= 4;
-  }
-
-  // Do unaligned end
-  while (num_bytes > 0) {
-    WordByte mem_data;
-
-    mem_data.w = backing_store->read_data_word( base_addr & 0xFFFFFFFC);
-    //cerr << "(READ) base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    mem_data.b[base_addr%4] = buf[buf_offset++];
-    backing_store->write_word( base_addr & 0xFFFFFFFC, mem_data.w);
-    //cerr << "(WRITE) base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    num_bytes--;
-    base_addr++;
-  }
-  /******** END SYS_READ() YOINK ***********/
-
-  delete [] buf;
-
   // Return the actual number of bytes read in from the file
-  //cerr << "Returning " << buf_offset << " bytes read." << endl;
-  syscall_data.result.u =  buf_offset;
+  //cerr << "Returning " << bytes_read << " bytes read." << endl;
+  syscall_data.result.u =  bytes_read;
 #else
   syscall_data.result.u =  0;
 #endif
@@ -322,88 +259,24 @@ Syscall::syscall_fileslurp(struct syscall_struct &syscall_data) {
   // there is a big enough buffer there for all of the data otherwise the host
   // will overwrite what ever is there, even code pages.
   int num_bytes = syscall_data.arg3.i;
-  // The number of bytes we read in which is <= num_bytes
-  int bytes_read = 0;
-  // A buffer that we will use to load in the file data
-  char *buf;
-  // Track offset into read buffer and update after every write to target's
-  // memory.  This will be returned to the target app telling it how big the
-  // actual file is.
-  uint32_t buf_offset = 0;
 
-  //cerr << "syscall_filemap: fdesc: " << dec << fdesc << " base_addr " << base_addr << " num_bytes " << num_bytes << endl;
+  //cerr << "syscall_fileslurp: fdesc: " << dec << fdesc << " base_addr " << base_addr << " num_bytes " << num_bytes << endl;
 
   // Do not allow target to slurp in too huge a file
-  assert( (num_bytes < MAX_FILEMAP_SIZE) 
+  assert( (num_bytes >= 0) && (num_bytes < MAX_FILEMAP_SIZE) 
     && "Attempting to read a file that is larger than MAX_FILEMAP_SIZE");
 
-  // Allocate the buffer...remember to be tidy up and delete the memory on exit
-  buf = new char[num_bytes];
-
-  // Read the data in in chunks (probably 16 KiB or so at a time).  If there is
-  // an error, just kill the simulation since something is funky.
-  while ( (num_bytes - bytes_read) > 0) {
-    int retval = read(hostfd, buf+bytes_read, num_bytes-bytes_read);
-    if (retval < 0) {
-      perror("Fileslurp"); 
-      assert(0 && "An error ocurred while trying to fileslurp a file.");
-    }
-    bytes_read += retval;
-    //cerr << " READ IN " << dec << retval << " bytes" << endl;
-    // It will return zero when finished
-    if (retval == 0) break;
+  // read() the file from its current position straight into target memory.
+  // If there is an error, just kill the simulation since something is funky.
+  int64_t bytes_read = backing_store->read_from_fd(hostfd, base_addr, num_bytes);
+  if (bytes_read < 0) {
+    perror("Fileslurp"); 
+    assert(0 && "An error ocurred while trying to fileslurp a file.");
   }
 
-  num_bytes = bytes_read;
-
-  /******** BEGIN SYS_READ() YOINK ***********/
-  // Do unaligned start
-  while ( (base_addr % 4) && (num_bytes > 0) ) {
-    WordByte mem_data;
-
-    mem_data.w = backing_store->read_data_word( base_addr & 0xFFFFFFFC);
-    mem_data.b[base_addr%4] = buf[buf_offset++];
-    //cerr << "base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    backing_store->write_word( base_addr & 0xFFFFFFFC, mem_data.w);
-    num_bytes--;
-    base_addr++;
-  }
-
-  // Do whole-word accesses first and stop when we hit the end
-  while (num_bytes >= 4) {
-    assert((base_addr % 4 == 0) && "base_addr must be aligned here");
-    WordByte mem_data;
-
-    mem_data.b[0] = buf[buf_offset++];
-    mem_data.b[1] = buf[buf_offset++];
-    mem_data.b[2] = buf[buf_offset++];
-    mem_data.b[3] = buf[buf_offset++];
-    backing_store->write_word(base_addr, mem_data.w);
-    //cerr << "base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    // Go to next word
-    base_addr += 4;
-    num_bytes -= 4;
-  }
-
-  // Do unaligned end
-  while (num_bytes > 0) {
-    WordByte mem_data;
-
-    mem_data.w = backing_store->read_data_word( base_addr & 0xFFFFFFFC);
-    //cerr << "(READ) base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    mem_data.b[base_addr%4] = buf[buf_offset++];
-    backing_store->write_word( base_addr & 0xFFFFFFFC, mem_data.w);
-    //cerr << "(WRITE) base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    num_bytes--;
-    base_addr++;
-  }
-  /******** END SYS_READ() YOINK ***********/
-
-  delete [] buf;
-
   // Return the actual number of bytes read in from the file
-  //cerr << "Returning " << buf_offset << " bytes read." << endl;
-  syscall_data.result.u = buf_offset;
+  //cerr << "Returning " << bytes_read << " bytes read." << endl;
+  syscall_data.result.u = bytes_read;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -430,62 +303,19 @@ Syscall::syscall_filedump(struct syscall_struct &syscall_data) {
   int bytes_written = 0;
   // A buffer that we will use to load in the data from Rigel
   char *buf;
-  // Track offset into read buffer and update after every write to target's
-  // memory.  This will be returned to the target app telling it how big the
-  // actual file is.
-  uint32_t buf_offset = 0;
 
   //cerr << "syscall_filedump: fdesc: " << dec << fdesc << " base_addr " << base_addr << " num_bytes " << num_bytes << endl;
 
   // Do not allow target to dump in too huge a file
-  assert( (num_bytes < MAX_FILEDUMP_SIZE) 
+  assert( (num_bytes >= 0) && (num_bytes < MAX_FILEDUMP_SIZE) 
     && "Attempting to dump a file that is larger than MAX_FILEDUMP_SIZE");
 
   // Allocate the buffer...remember to be tidy up and delete the memory on exit
   buf = new char[num_bytes];
 
   // Pull data out of Rigel memory and place in buffer
-  /******** BEGIN SYS_READ() YOINK ***********/
-  // Do unaligned start
-  while ( (base_addr % 4) && (num_bytes > 0) ) {
-    WordByte mem_data;
-
-    mem_data.w = backing_store->read_data_word( base_addr & 0xFFFFFFFC);
-    buf[buf_offset] = mem_data.b[base_addr%4];
-    buf_offset++;
-    //cerr << "base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    num_bytes--;
-    base_addr++;
-  }
-
-  // Do whole-word accesses first and stop when we hit the end
-  while (num_bytes >= 4) {
-    assert((base_addr % 4 == 0) && "base_addr must be aligned here");
-    WordByte mem_data;
-    mem_data.w = backing_store->read_data_word(base_addr);
-    buf[buf_offset++] = mem_data.b[0];
-    buf[buf_offset++] = mem_data.b[1];
-    buf[buf_offset++] = mem_data.b[2]; 
-    buf[buf_offset++] = mem_data.b[3];
-    //cerr << "base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    // Go to next word
-    base_addr += 4;
-    num_bytes -= 4;
-  }
-
-  // Do unaligned end
-  while (num_bytes > 0) {
-    WordByte mem_data;
-
-    mem_data.w = backing_store->read_data_word(base_addr & 0xFFFFFFFC);
-    //cerr << "(READ) base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    buf[buf_offset++] = mem_data.b[base_addr%4]; 
-    num_bytes--;
-    base_addr++;
-  }
-  /******** END SYS_READ() YOINK ***********/
+  backing_store->read_bytes(base_addr, buf, num_bytes);
 
-  num_bytes = buf_offset;
   // Write out the buf to the file
   // XXXXXXXXXXXXXXXXXXXXXXX
   // Read the data in in chunks (probably 16 KiB or so at a time).  If there is
@@ -506,8 +336,8 @@ Syscall::syscall_filedump(struct syscall_struct &syscall_data) {
   delete [] buf;
 
   // Return the actual number of bytes written in from the file
-//cerr << "Returning " << buf_offset << " bytes written." << endl;
-  syscall_data.result.u = buf_offset;
+//cerr << "Returning " << num_bytes << " bytes written." << endl;
+  syscall_data.result.u = num_bytes;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -567,46 +397,7 @@ Syscall::syscall_write(struct syscall_struct &syscall_data) {
   }
 
   char *buf = (char *)calloc(bytes_to_write,sizeof(*buf));
-  size_t buf_offset = 0;
-  int num_bytes = bytes_to_write;
-  /******** BEGIN SYS_READ() YOINK ***********/
-  // Do unaligned start
-  while ( (base_addr % 4) && (num_bytes > 0) ) {
-    WordByte mem_data;
-    mem_data.w = backing_store->read_data_word( base_addr & 0xFFFFFFFC);
-    buf[buf_offset] = mem_data.b[base_addr%4];
-    buf_offset++;
-    //cerr << "base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    num_bytes--;
-    base_addr++;
-  }
-
-  // Do whole-word accesses first and stop when we hit the end
-  while (num_bytes >= 4) {
-    assert((base_addr % 4 == 0) && "base_addr must be aligned here");
-    WordByte mem_data;
-    mem_data.w = backing_store->read_data_word(base_addr);
-    buf[buf_offset++] = mem_data.b[0];
-    buf[buf_offset++] = mem_data.b[1];
-    buf[buf_offset++] = mem_data.b[2];
-    buf[buf_offset++] = mem_data.b[3];
-    //cerr << "base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    // Go to next word
-    base_addr += 4;
-    num_bytes -= 4;
-  }
-
-  // Do unaligned end
-  while (num_bytes > 0) {
-    WordByte mem_data;
-
-    mem_data.w = backing_store->read_data_word( base_addr & 0xFFFFFFFC);
-    //cerr << "(READ) base_addr: 0x" << hex << base_addr << " data: 0x" << mem_data.w << endl;
-    buf[buf_offset++] = mem_data.b[base_addr%4];
-    num_bytes--;
-    base_addr++;
-  }
-  /******** END SYS_READ() YOINK ***********/
+  backing_store->read_bytes(base_addr, buf, bytes_to_write);
 
 	//Let's always try to write the whole thing, rather than return a smaller number of bytes and ask the target to retry.
 	//TODO It might be good to have this behavior be configurable, in case we actually want to model I/O timing.
@@ -650,9 +441,6 @@ Syscall::syscall_read(struct syscall_struct &syscall_data) {
   }
 	char *buf = new char[bytes_requested+1]; //+1 for a NULL terminator in the stdin case
   memset(buf, 0x0, bytes_requested+1);
-  // Track offset into read buffer and update after every write to target's
-  // memory
-  uint32_t buf_offset = 0;
 
 	// FIXME I'm not sure I like the idea of only reading in one line unconditionally
 	// if the file descriptor is stdin.  This prevents us from reading a large chunk of a
@@ -660,53 +448,24 @@ Syscall::syscall_read(struct syscall_struct &syscall_data) {
 	// to support interactive mode, where you need to enter parameters after the simulation has started.
 	// I think we can handle this with the stdin-related command line flags to RigelSim instead of
 	// enabling this usage model.
-  bytes_read = read(hostfd, buf, bytes_requested);
-  assert(bytes_read >= 0 && "FIXME: handle errors from read()");
+  do {
+    bytes_read = read(hostfd, buf, bytes_requested);
+  } while(bytes_read < 0 && errno == EINTR);
+  if(bytes_read < 0) {
+    // Hand the error back to the target as read() would, leaving its buffer alone.
+    perror("syscall_read");
+    syscall_data.result.i = -1;
+    delete[] buf;
+    return;
+  }
 
   if(fdesc != STDIN_FILENO) {
 	  //fprintf(stderr, " read %d of %d bytes\n", bytes_read, bytes_requested);
   }
 
-  // Do unaligned start
-  while ( (base_addr % 4 != 0) && (bytes_read > 0) ) {
-    WordByte mem_data;
-    mem_data.w = backing_store->read_data_word(base_addr & 0xFFFFFFFC);
-    mem_data.b[base_addr%4] = buf[buf_offset++];
-    //cerr << "syscall_read(): writing 0x" << std::hex << mem_data.w << " to mem[0x" << base_addr << "]" << std::endl;
-    backing_store->write_word(base_addr & 0xFFFFFFFC, mem_data.w);
-    bytes_read--;
-    base_addr++;
-  }
-
-  // Do whole-word accesses first and stop when we hit the end
-  while (bytes_read >= 4) {
-    assert((base_addr % 4 == 0) && "base_addr must be aligned here");
-    WordByte mem_data;
-
-    mem_data.b[0] = buf[buf_offset++];
-    mem_data.b[1] = buf[buf_offset++];
-    mem_data.b[2] = buf[buf_offset++];
-    mem_data.b[3] = buf[buf_offset++];
-		//cerr << "syscall_read(): writing 0x" << std::hex << mem_data.w << " to mem[0x" << base_addr << "]" << std::endl;
-    backing_store->write_word(base_addr, mem_data.w);
-    // Go to next word
-		bytes_read -= 4;
-    base_addr += 4;
-  }
-
-  // Do unaligned end
-  while (bytes_read > 0) {
-    WordByte mem_data;
-
-    mem_data.w = backing_store->read_data_word( base_addr & 0xFFFFFFFC);
-    mem_data.b[base_addr%4] = buf[buf_offset++];
-		//cerr << "syscall_read(): writing 0x" << std::hex << mem_data.w << " to mem[0x" << base_addr << "]" << std::endl;
-    backing_store->write_word( base_addr & 0xFFFFFFFC, mem_data.w);
-    bytes_read--;
-    base_addr++;
-  }
+  backing_store->write_bytes(base_addr, buf, bytes_read);
 
-  syscall_data.result.u = buf_offset;
+  syscall_data.result.u = bytes_read;
 	delete[] buf;
 }
 
@@ -2,12 +2,16 @@
 #include <stdint.h>                     // for uint32_t
 #include <string.h>                     // for memset
 #include <cassert>                      // for assert
+#include <iomanip>                      // for setw, setprecision
 #include <ostream>                      // for operator<<, basic_ostream, etc
 #include <string>                       // for char_traits
 #include "define.h"         // for rigel_log2
+#include "sim.h"            // for GLOBAL_BACKING_STORE_PTR, LINESIZE
+#include "memory/backing_store.h"  // for read_host_word
 #include "util/value_tracker.h"  // for ZeroTracker, etc
 
 ZeroTracker *GLOBAL_ZERO_TRACKER_PTR;
+LineValueTracker *GLOBAL_LINE_TRACKER_PTR = NULL;
 
 void ZeroTracker::addRead(uint32_t value)
 {
@@ -30,10 +34,14 @@ void ZeroTracker::addWrite(uint32_t readVal, uint32_t writeVal) {
 
 
 void ZeroTracker::addRead(uint32_t *values, size_t numValues) {
-
+  for(size_t i = 0; i < numValues; i++) {
+    addRead(values[i]);
+  }
 }
 void ZeroTracker::addWrite(uint32_t *readvals, uint32_t *writevals, size_t numValues) {
-
+  for(size_t i = 0; i < numValues; i++) {
+    addWrite(readvals[i], writevals[i]);
+  }
 }
 
 void ZeroTracker::report(std::ostream &str) {
@@ -81,3 +89,152 @@ size_t ZeroTracker::countZeros(uint32_t *values, size_t numValues, size_t bitGra
   return zeros;
 }
  
+
+////////////////////////////////////////////////////////////////////////////////
+// LineValueTracker
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+// true if v is the sign extension of its low 'bits' bits
+inline bool fits_signed(int64_t v, unsigned bits) {
+  const unsigned shift = 64 - bits;
+  return ((int64_t)((uint64_t)v << shift) >> shift) == v;
+}
+
+// sign-extend the low 'bytes' bytes of v
+inline int64_t sext(uint64_t v, unsigned bytes) {
+  const unsigned shift = 64 - 8 * bytes;
+  return (int64_t)(v << shift) >> shift;
+}
+
+// BDI size of n 'k'-byte elements as 'd'-byte deltas from the first element
+// that is not itself a small immediate, or from zero; LINE_BYTES if some
+// element fits neither.
+size_t bdi_size(const uint64_t *e, size_t n, unsigned k, unsigned d) {
+  uint64_t base = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (!fits_signed(sext(e[i], k), 8 * d)) { base = e[i]; break; }
+  }
+  bool ok = true;
+  for (size_t i = 0; i < n; i++) {
+    ok &= fits_signed(sext(e[i] - base, k), 8 * d) | fits_signed(sext(e[i], k), 8 * d);
+  }
+  return ok ? k + n * d : LineValueTracker::LINE_BYTES;
+}
+
+// FPC bits for one nonzero word: 3-bit prefix plus the smallest pattern
+inline unsigned fpc_word_bits(uint32_t w) {
+  const int32_t s = (int32_t)w;
+  const uint32_t lo = w & 0xFFFF, hi = w >> 16;
+  const bool bytes_repeat = (w == (w & 0xFF) * 0x01010101U);
+  const bool halves_are_bytes = fits_signed((int16_t)lo, 8) && fits_signed((int16_t)hi, 8);
+  unsigned bits = 3 + 32;                                    // uncompressed
+  bits = (fits_signed(s, 16) || lo == 0 || halves_are_bytes) ? 3 + 16 : bits;
+  bits = (fits_signed(s, 8) || bytes_repeat) ? 3 + 8 : bits;
+  bits = fits_signed(s, 4) ? 3 + 4 : bits;
+  return bits;
+}
+
+} // end anonymous namespace
+
+void LineValueTracker::addLine(source_t src, uint32_t addr) {
+  uint32_t words[LINE_WORDS];
+  addr &= ~(uint32_t)(LINE_BYTES - 1);
+  for (size_t i = 0; i < LINE_WORDS; i++) {
+    words[i] = rigel::GLOBAL_BACKING_STORE_PTR->read_host_word(addr + 4 * i);
+  }
+  addLine(src, words);
+}
+
+void LineValueTracker::addLine(source_t src, const uint32_t *w) {
+  assert(LINE_BYTES == (size_t)rigel::cache::LINESIZE && "LineValueTracker assumes 32-byte lines");
+
+  // the line as 8-, 4- and 2-byte elements (little-endian, as in memory)
+  uint64_t e8[LINE_WORDS / 2], e4[LINE_WORDS], e2[LINE_WORDS * 2];
+  uint32_t any = 0;
+  for (size_t i = 0; i < LINE_WORDS; i++) {
+    e4[i] = w[i];
+    e2[2 * i] = w[i] & 0xFFFF;
+    e2[2 * i + 1] = w[i] >> 16;
+    any |= w[i];
+  }
+  bool repeated = true;
+  for (size_t i = 0; i < LINE_WORDS / 2; i++) {
+    e8[i] = ((uint64_t)w[2 * i + 1] << 32) | w[2 * i];
+    repeated &= (e8[i] == e8[0]);
+  }
+
+  // base-delta-immediate
+  size_t bdi = LINE_BYTES;
+  if (any == 0) {
+    bdi = 1;
+  } else if (repeated) {
+    bdi = 8;
+  } else {
+    const size_t n8 = LINE_WORDS / 2, n4 = LINE_WORDS, n2 = LINE_WORDS * 2;
+    size_t sz;
+    if ((sz = bdi_size(e8, n8, 8, 1)) < bdi) { bdi = sz; }
+    if ((sz = bdi_size(e4, n4, 4, 1)) < bdi) { bdi = sz; }
+    if ((sz = bdi_size(e8, n8, 8, 2)) < bdi) { bdi = sz; }
+    if ((sz = bdi_size(e2, n2, 2, 1)) < bdi) { bdi = sz; }
+    if ((sz = bdi_size(e4, n4, 4, 2)) < bdi) { bdi = sz; }
+    if ((sz = bdi_size(e8, n8, 8, 4)) < bdi) { bdi = sz; }
+  }
+
+  // frequent-pattern compression: each run of zero words is one 6-bit code
+  unsigned bits = 0;
+  for (size_t i = 0; i < LINE_WORDS; i++) {
+    const bool zero = (w[i] == 0);
+    const bool run_start = zero && (i == 0 || w[i - 1] != 0);
+    bits += zero ? (run_start ? 3 + 3 : 0) : fpc_word_bits(w[i]);
+  }
+  size_t fpc = (bits + 7) / 8;
+  if (fpc > LINE_BYTES) { fpc = LINE_BYTES; }
+
+  LineStats &st = stats[src];
+  st.lines++;
+  st.zeroLines += (any == 0);
+  st.bdiLines += (bdi < LINE_BYTES);
+  st.fpcLines += (fpc < LINE_BYTES);
+  st.bdiBytes += bdi;
+  st.fpcBytes += fpc;
+  st.bestBytes += (bdi < fpc) ? bdi : fpc;
+}
+
+void LineValueTracker::report(std::ostream &str) {
+  static const char *names[NUM_SOURCES] = {
+    "G$ fills", "DRAM reads", "DRAM writes", "C$ writebacks"
+  };
+  // compressed size as a percentage of the uncompressed size
+  #define LVT_PCT(bytes, lines) \
+    ((lines) ? 100.0 * (double)(bytes) / ((double)(lines) * LINE_BYTES) : 0.0)
+
+  const std::ios::fmtflags flags = str.flags();
+  const std::streamsize precision = str.precision();
+  str << "Line value compressibility (" << LINE_BYTES << "-byte lines, "
+      << "compressed size as % of uncompressed)" << std::endl;
+  str << std::setw(16) << "" << std::setw(14) << "lines" << std::setw(10) << "zero%"
+      << std::setw(10) << "BDI" << std::setw(10) << "FPC" << std::setw(10) << "best" << std::endl;
+  str << std::fixed << std::setprecision(1);
+  for (int s = 0; s < NUM_SOURCES; s++) {
+    const LineStats &st = stats[s];
+    str << std::setw(16) << names[s] << std::setw(14) << st.lines
+        << std::setw(10) << (st.lines ? 100.0 * st.zeroLines / st.lines : 0.0)
+        << std::setw(10) << LVT_PCT(st.bdiBytes, st.lines)
+        << std::setw(10) << LVT_PCT(st.fpcBytes, st.lines)
+        << std::setw(10) << LVT_PCT(st.bestBytes, st.lines) << std::endl;
+  }
+
+  const uint64_t dram_lines = stats[DRAM_READ].lines + stats[DRAM_WRITE].lines;
+  const uint64_t dram_best = stats[DRAM_READ].bestBytes + stats[DRAM_WRITE].bestBytes;
+  str << "DRAM data traffic: " << dram_lines * LINE_BYTES << " bytes, "
+      << dram_best << " compressed; potential bandwidth savings "
+      << (dram_lines ? 100.0 - LVT_PCT(dram_best, dram_lines) : 0.0) << "%" << std::endl;
+  #undef LVT_PCT
+  str.flags(flags);
+  str.precision(precision);
+}
+
+void LineValueTracker::reset() {
+  memset(stats, 0, sizeof(stats));
+}
@@ -0,0 +1,160 @@
+#!/usr/bin/env bash
+################################################################################
+# bench.sh
+################################################################################
+#
+#  Golden-output regression and simulator speed benchmark.
+#
+#  Runs each test's run_prog under every simulator configuration that has a
+#  binary, checks its golden output as usual, and appends one JSON line per
+#  (config, test) to a history file with the host time, peak RSS, simulated
+#  cycles/sec and host MIPS summed over the test's runs (from rigelsim
+#  --run-summary).  A test is flagged as a performance regression when its
+#  cycles/sec falls more than THRESHOLD percent below the last passing,
+#  unflagged entry for the same config and test in the history.
+#
+#  RIGEL_CFG_NUM is fixed at build time, so each configuration needs its own
+#  rigelsim build:
+#
+#    RIGELSIM_LEGACY      built with RIGEL_CFG_NUM 1 (default: $RIGELSIM or the
+#                         usual ${RIGEL_BUILD}/sim/rigel-sim/rigelsim)
+#    RIGELSIM_FUNCTIONAL  built with RIGEL_CFG_NUM 2 (skipped if unset)
+#    RIGELSIM_STRUCTURAL  built with RIGEL_CFG_NUM 3 (skipped if unset)
+#
+#  usage: bench.sh [-o <history.jsonl>] [-t <threshold %>] [<test dir> ...]
+#
+#  Tests default to every non_rtm and rtm test with a run_prog.  Exits
+#  non-zero if any golden comparison failed or any regression was flagged.
+#
+################################################################################
+
+TESTDIR=$(cd "$(dirname "$0")" && pwd)
+source ${TESTDIR}/common.sh
+
+HISTORY=${TESTDIR}/bench_history.jsonl
+THRESHOLD=10
+
+function usage {
+  echo "usage: $0 [-o <history.jsonl>] [-t <threshold %>] [<test dir> ...]" >&2
+  exit 1
+}
+
+while getopts "o:t:h" opt; do
+  case $opt in
+    o) HISTORY=$OPTARG ;;
+    t) THRESHOLD=$OPTARG ;;
+    *) usage ;;
+  esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -gt 0 ]; then
+  TESTS=("$@")
+else
+  TESTS=()
+  for suite in non_rtm rtm; do
+    for t in $(sed -n 's/^SUBDIRS=//p' ${TESTDIR}/${suite}/Makefile); do
+      [ -x ${TESTDIR}/${suite}/${t}/run_prog ] && TESTS+=("${TESTDIR}/${suite}/${t}")
+    done
+  done
+fi
+
+CONFIGS=()
+CFG_NUMS=()
+SIMS=()
+RIGELSIM_LEGACY=${RIGELSIM_LEGACY:-$RIGELSIM}
+num=1
+for cfg in LEGACY FUNCTIONAL STRUCTURAL; do
+  var=RIGELSIM_${cfg}
+  if [ -n "${!var}" ]; then
+    CONFIGS+=($(echo $cfg | tr 'A-Z' 'a-z'))
+    CFG_NUMS+=($num)
+    SIMS+=("${!var}")
+  fi
+  num=$((num + 1))
+done
+
+GIT_REV=$(cd ${TESTDIR} && git rev-parse --short HEAD 2>/dev/null)
+DATE=$(date -u +%Y-%m-%dT%H:%M:%SZ)
+SUMMARY=$(mktemp /tmp/rigelsim-bench.XXXXXX)
+touch ${HISTORY}
+STATUS=0
+
+# Sum the --run-summary lines of one test into the fields of a history entry.
+function summarize {
+  awk '
+    function num(key,   m) {
+      if (match($0, "\"" key "\":[-0-9.eE+]+")) {
+        m = substr($0, RSTART, RLENGTH); sub(/^[^:]*:/, "", m); return m + 0
+      }
+      return 0
+    }
+    { runs++; cycles += num("cycles"); instrs += num("instructions")
+      setup += num("setup_seconds"); sim += num("sim_seconds")
+      rss = num("peak_rss_kb"); if (rss > peak) peak = rss }
+    END {
+      if (sim <= 0) sim = 1e-9
+      printf "\"runs\":%d,\"cycles\":%.0f,\"instructions\":%.0f,", runs, cycles, instrs
+      printf "\"wall_seconds\":%.3f,\"sim_seconds\":%.3f,\"peak_rss_kb\":%d,", setup + sim, sim, peak
+      printf "\"cycles_per_sec\":%.1f,\"mips\":%.4f", cycles / sim, instrs / sim / 1e6
+    }' $1
+}
+
+# cycles_per_sec of the last passing, unflagged history entry for a config
+# and test (so a regression does not become the new baseline).
+function baseline {
+  grep -F "\"config\":\"$1\",\"test\":\"$2\"," ${HISTORY} | grep -F '"golden_failed":0,' \
+    | grep -F '"regression":false}' | tail -n 1 | sed -n 's/.*"cycles_per_sec":\([-0-9.eE+]*\).*/\1/p'
+}
+
+for c in ${!CONFIGS[@]}; do
+  cfg=${CONFIGS[$c]}
+  echo "[${cfg}: ${SIMS[$c]}]"
+  for t in "${TESTS[@]}"; do
+    name=${t#${TESTDIR}/}
+    rm -f ${SUMMARY}
+    output=$(cd $t && RIGELSIM="${SIMS[$c]} --run-summary ${SUMMARY}" ./run_prog 2>&1)
+    n_passed=$(echo "$output" | grep -c "<PASSED>")
+    n_failed=$(echo "$output" | grep -c "<FAILED>")
+    if [ ! -s ${SUMMARY} ]; then
+      failed "${cfg} ${name}: no simulator runs completed"
+      STATUS=1
+      continue
+    fi
+    built=$(sed -n 's/.*"config":\([0-9]*\).*/\1/p' ${SUMMARY} | head -n 1)
+    if [ "$built" != "${CFG_NUMS[$c]}" ]; then
+      failed "${cfg} ${name}: ${SIMS[$c]} was built with RIGEL_CFG_NUM ${built}"
+      STATUS=1
+      continue
+    fi
+    fields=$(summarize ${SUMMARY})
+    cps=$(echo "$fields" | sed -n 's/.*"cycles_per_sec":\([-0-9.eE+]*\).*/\1/p')
+    base=$(baseline ${cfg} ${name})
+
+    regression=false
+    change=""
+    if [ -n "$base" ]; then
+      change=$(awk -v n=$cps -v o=$base 'BEGIN { printf "%+.1f%%", (o > 0) ? 100 * (n - o) / o : 0 }')
+      if awk -v n=$cps -v o=$base -v t=$THRESHOLD 'BEGIN { exit !(n < o * (1 - t / 100)) }'; then
+        regression=true
+      fi
+    fi
+
+    echo "{\"date\":\"${DATE}\",\"git\":\"${GIT_REV}\",\"config\":\"${cfg}\",\"test\":\"${name}\",\"golden_passed\":${n_passed},\"golden_failed\":${n_failed},${fields},\"regression\":${regression}}" >> ${HISTORY}
+
+    line="${cfg} ${name}: ${n_passed} passed, ${n_failed} failed, ${cps} cycles/sec ${change}"
+    if [ $n_failed -ne 0 ]; then
+      failed "$line"
+      STATUS=1
+    elif $regression; then
+      failed "$line (slower than -${THRESHOLD}% threshold)"
+      STATUS=1
+    else
+      passed "$line"
+    fi
+  done
+done
+
+rm -f ${SUMMARY}
+echo "history: ${HISTORY}"
+exit $STATUS
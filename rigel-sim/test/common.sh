@@ -1,4 +1,4 @@
-RIGELSIM="${RIGEL_BUILD}/sim/rigel-sim/rigelsim"
+RIGELSIM=${RIGELSIM:-"${RIGEL_BUILD}/sim/rigel-sim/rigelsim"}
 MAKE=make
 
 function failed {